@@ -26,9 +26,11 @@
 #include "hts_utils.h"
 #include "utils.h"
 #include "log_tool.h"
+#include "align_workspace.h"
+#include "instrument.h"
 
-#define MAXLEN 1024
-#define MAXLEN_NBITS 10
+//positions and motif counts are held in the 12 bit fields of a track
+#define MAXLEN 4095
 
 #define S       0
 #define M       1
@@ -51,7 +53,7 @@
 #define MATCH 2
 
 /*for indexing single array*/
-#define index(i,j) (((i)<<MAXLEN_NBITS)+(j))
+#define index(i,j) (((i)*stride)+(j))
 
 /*functions for getting trace back information*/
 #define track_get_u(t)      (((t)&0xF8000000)>>27)
@@ -128,13 +130,18 @@ class AHMM
     int32_t optimal_track;
     int32_t optimal_probe_len;
     int32_t *optimal_path;     // for storage
+    int32_t max_path_len;
     int32_t *optimal_path_ptr; //just a pointer
     int32_t optimal_path_len;
 
     float T[NSTATES][NSTATES];
 
+    //matrices of no_rows rows of stride cells from the alignment workspace,
+    //grown to the probe and read lengths of the alignments
     float **V;
     int32_t **U;
+    size_t no_rows;
+    size_t stride;
 
     typedef int32_t (AHMM::*move) (int32_t t, int32_t j);
     move **moves;
@@ -171,6 +178,11 @@ class AHMM
      */
     void initialize_UV();
 
+    /**
+     * Grows the matrices to at least rows x cols cells.
+     */
+    void resize(size_t rows, size_t cols);
+
     /**
      * Sets a model.
      */
@@ -557,7 +569,6 @@ class AHMM
 };
 
 #undef MAXLEN
-#undef MAXLEN_NBITS
 #undef S
 #undef M
 #undef I
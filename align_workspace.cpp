@@ -0,0 +1,128 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "align_workspace.h"
+#include <cstdio>
+
+/**
+ * Returns the arena of the calling thread.
+ */
+AlignmentWorkspace& AlignmentWorkspace::local()
+{
+    static thread_local AlignmentWorkspace workspace;
+    return workspace;
+}
+
+/**
+ * Returns the size class of a block of size bytes.
+ */
+int32_t AlignmentWorkspace::size_class(size_t size)
+{
+    int32_t c = 0;
+    size_t class_size = ((size_t)1)<<AW_MIN_CLASS_NBITS;
+    while (class_size<size)
+    {
+        class_size <<= 1;
+        ++c;
+    }
+
+    return c;
+}
+
+/**
+ * Returns a block of at least size bytes from the arena of the calling thread.
+ */
+void* AlignmentWorkspace::acquire(size_t size)
+{
+    AlignmentWorkspace& w = local();
+    int32_t c = size_class(size);
+
+    size_t class_size = ((size_t)1)<<(c+AW_MIN_CLASS_NBITS);
+
+    if (w.free_blocks[c].size())
+    {
+        void* p = w.free_blocks[c].back();
+        w.free_blocks[c].pop_back();
+        w.held -= class_size;
+        return p;
+    }
+
+    void* p = NULL;
+    if (posix_memalign(&p, AW_ALIGNMENT, class_size))
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot allocate %zu bytes for alignment workspace\n", __FILE__, __LINE__, __FUNCTION__, class_size);
+        exit(1);
+    }
+
+    return p;
+}
+
+/**
+ * Returns a block obtained with acquire(size) to the arena of the calling thread.
+ */
+void AlignmentWorkspace::release(void* p, size_t size)
+{
+    if (p==NULL) return;
+
+    AlignmentWorkspace& w = local();
+    int32_t c = size_class(size);
+
+    if (w.free_blocks[c].size()>=AW_MAX_FREE_BLOCKS)
+    {
+        free(p);
+        return;
+    }
+
+    w.free_blocks[c].push_back(p);
+    w.held += ((size_t)1)<<(c+AW_MIN_CLASS_NBITS);
+}
+
+/**
+ * Returns the number of bytes held on the free lists of the calling thread.
+ */
+size_t AlignmentWorkspace::size()
+{
+    return local().held;
+}
+
+/**
+ * Frees all blocks on the free lists of the calling thread.
+ */
+void AlignmentWorkspace::trim()
+{
+    AlignmentWorkspace& w = local();
+    for (int32_t c=0; c<AW_NO_CLASSES; ++c)
+    {
+        for (size_t i=0; i<w.free_blocks[c].size(); ++i)
+        {
+            free(w.free_blocks[c][i]);
+            w.held -= ((size_t)1)<<(c+AW_MIN_CLASS_NBITS);
+        }
+        w.free_blocks[c].clear();
+    }
+}
+
+AlignmentWorkspace::~AlignmentWorkspace()
+{
+    trim();
+}
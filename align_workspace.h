@@ -0,0 +1,108 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#ifndef ALIGN_WORKSPACE_H
+#define ALIGN_WORKSPACE_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#define AW_ALIGNMENT 64
+#define AW_MIN_CLASS_NBITS 12
+#define AW_NO_CLASSES 40
+#define AW_MAX_FREE_BLOCKS 16
+
+/**
+ * Per thread scratch arena for the dynamic programming matrices of the aligners.
+ *
+ * Blocks are handed out in power of two size classes aligned for SIMD loads,
+ * so a longer repeat tract simply moves up to the next class.  Released blocks
+ * are kept on the free list of their class and reused by the next aligner
+ * constructed on the same thread, each thread owns its own arena so aligners
+ * can be used from parallel workers without locking.  A class keeps at most
+ * AW_MAX_FREE_BLOCKS blocks, further released blocks are freed.
+ */
+class AlignmentWorkspace
+{
+    public:
+
+    /**
+     * Returns a block of at least size bytes from the arena of the calling thread.
+     */
+    static void* acquire(size_t size);
+
+    /**
+     * Returns a block of at least n elements of type T.
+     */
+    template<class T>
+    static T* acquire(size_t n)
+    {
+        return (T*) acquire(n*sizeof(T));
+    };
+
+    /**
+     * Returns a block obtained with acquire(size) to the arena of the calling thread.
+     */
+    static void release(void* p, size_t size);
+
+    /**
+     * Returns a block obtained with acquire<T>(n).
+     */
+    template<class T>
+    static void release(T* p, size_t n)
+    {
+        release((void*) p, n*sizeof(T));
+    };
+
+    /**
+     * Returns the number of bytes held on the free lists of the calling thread.
+     */
+    static size_t size();
+
+    /**
+     * Frees all blocks on the free lists of the calling thread.
+     */
+    static void trim();
+
+    ~AlignmentWorkspace();
+
+    private:
+
+    std::vector<void*> free_blocks[AW_NO_CLASSES];
+    size_t held;
+
+    AlignmentWorkspace() : held(0) {};
+
+    /**
+     * Returns the arena of the calling thread.
+     */
+    static AlignmentWorkspace& local();
+
+    /**
+     * Returns the size class of a block of size bytes.
+     */
+    static int32_t size_class(size_t size);
+};
+
+#endif
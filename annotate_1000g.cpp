@@ -41,18 +41,21 @@ class Igor : Program
     std::string output_vcf_file;
     std::vector<GenomeInterval> intervals;
     std::string interval_list;
+    int32_t no_threads;
 
     ///////
     //i/o//
     ///////
+    ParallelSyncedDriver *driver;
     BCFSyncedReader *sr;
     BCFOrderedWriter *odw;
+    int32_t out;
 
     //////////
     //filter//
     //////////
     std::string fexp;
-    Filter filter;
+    std::vector<Filter*> worker_filters;
     bool filter_exists;
 
     /////////
@@ -60,6 +63,8 @@ class Igor : Program
     /////////
     int32_t no_variants;
     int32_t no_annotated_variants;
+    std::vector<int32_t> worker_no_variants;
+    std::vector<int32_t> worker_no_annotated_variants;
 
     ////////////////
     //common tools//
@@ -83,6 +88,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter expression []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_1000g_vcf_file("d", "d", "1000G data set VCF file []", true, "", "file", cmd);
             TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "file", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the inputs are indexed [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
 
             cmd.parse(argc, argv);
@@ -92,6 +98,7 @@ class Igor : Program
             l000g_vcf_file = arg_1000g_vcf_file.getValue();
             input_vcf_file = arg_input_vcf_file.getValue();
             output_vcf_file = arg_output_vcf_file.getValue();
+            no_threads = arg_no_threads.getValue();
         }
         catch (TCLAP::ArgException &e)
         {
@@ -107,16 +114,22 @@ class Igor : Program
         //////////////////////
         input_vcf_files.push_back(input_vcf_file);
         input_vcf_files.push_back(l000g_vcf_file);
-        sr = new BCFSyncedReader(input_vcf_files, intervals, false);
+        driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+        sr = driver->sr;
         odw = new BCFOrderedWriter(output_vcf_file);
         odw->link_hdr(sr->hdrs[0]);
         bcf_hdr_append(sr->hdrs[0], "##INFO=<ID=1000G,Number=0,Type=Flag,Description=\"1000 Genomes variant\">");
         odw->write_hdr();
+        out = driver->add_writer(odw);
 
         /////////////////////////
         //filter initialization//
         /////////////////////////
-        filter.parse(fexp.c_str());
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            worker_filters.push_back(new Filter());
+            worker_filters[i]->parse(fexp.c_str());
+        }
         filter_exists = fexp!="";
 
         ///////////////////////
@@ -129,9 +142,28 @@ class Igor : Program
         ////////////////////////
         no_variants = 0;
         no_annotated_variants = 0;
+        worker_no_variants.resize(driver->no_workers, 0);
+        worker_no_annotated_variants.resize(driver->no_workers, 0);
     }
 
     void annotate_1000g()
+    {
+        driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { annotate_1000g(worker, region, sr); });
+
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            no_variants += worker_no_variants[i];
+            no_annotated_variants += worker_no_annotated_variants[i];
+        }
+
+        odw->close();
+        sr->close();
+    };
+
+    /**
+     * Annotates the variants of a region.
+     */
+    void annotate_1000g(int32_t worker, int32_t region, BCFSyncedReader* sr)
     {
         std::vector<bcfptr*> crecs;
         int32_t presence[2] = {0,0};
@@ -149,7 +181,7 @@ class Igor : Program
 
                 if (filter_exists)
                 {
-                    if (!filter.apply(crecs[i]->h,crecs[i]->v,&variant))
+                    if (!worker_filters[worker]->apply(crecs[i]->h,crecs[i]->v,&variant))
                     {
                         continue;
                     }
@@ -170,24 +202,21 @@ class Igor : Program
 
             if (presence[0] && presence[1])
             {
-                bcf_update_info_flag(odw->hdr, v, "1000G", "", 1);
+                bcf_update_info_flag(sr->hdrs[0], v, "1000G", "", 1);
 
-                ++no_annotated_variants;
+                ++worker_no_annotated_variants[worker];
             }
 
             if (presence[0])
             {
-                odw->write(v);
+                driver->write(region, out, v);
 
-                ++no_variants;
+                ++worker_no_variants[worker];
             }
 
             presence[0] = 0;
             presence[1] = 0;
         }
-
-        odw->close();
-        sr->close();
     };
 
     void print_options()
@@ -198,6 +227,7 @@ class Igor : Program
         std::clog << "         [o] output VCF file    " << output_vcf_file << "\n";
         print_str_op("         [f] filter             ", fexp);
         std::clog << "         [d] 1000G VCF file     " << l000g_vcf_file << "\n";
+        print_num_op("         [t] no. of threads     ", no_threads);
         print_int_op("         [i] intervals          ", intervals);
         std::clog << "\n";
    }
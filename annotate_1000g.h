@@ -25,6 +25,7 @@
 #define ANNOTATE_1000G_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
 
 void annotate_1000g(int argc, char ** argv);
 
@@ -26,6 +26,21 @@
 namespace
 {
 
+/**
+ * Tools owned by a single annotation worker, none of them are shared between threads.
+ */
+class AnnotationWorker
+{
+    public:
+
+    VariantManip* vm;
+    VNTRAnnotator* va;
+    ReferenceSequence* rs;
+    Filter filter;
+    Variant variant;
+    int32_t no_indels_annotated;
+};
+
 class Igor : Program
 {
     public:
@@ -43,6 +58,9 @@ class Igor : Program
     bool debug;
     bool override_tag;
     bool add_flank_annotation;     //add flank annotation
+    int32_t no_threads;
+    uint32_t cache_capacity;
+    std::string cache_file;
 
     //exact alignment related statistics
     std::string EX_MOTIF;
@@ -106,9 +124,8 @@ class Igor : Program
     ////////////////
     //common tools//
     ////////////////
-    VariantManip* vm;
-    VNTRAnnotator* va;
-    ReferenceSequence* rs;
+    std::vector<AnnotationWorker*> workers;
+    VNTRCache* cache;
 
     Igor(int argc, char **argv)
     {
@@ -128,6 +145,9 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "str", cmd);
             TCLAP::ValueArg<std::string> arg_ref_fasta_file("r", "r", "reference sequence fasta file []", true, "", "str", cmd);
             TCLAP::SwitchArg arg_debug("d", "d", "debug [false]", cmd, false);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of annotation threads [1]", false, 1, "int", cmd);
+            TCLAP::ValueArg<uint32_t> arg_cache_capacity("c", "c", "maximum no. of repeat tracts cached, 0 disables the cache [100000]", false, 100000, "int", cmd);
+            TCLAP::ValueArg<std::string> arg_cache_file("C", "C", "repeat tract cache file, loaded if present and updated at the end []", false, "", "str", cmd);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
             TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter expression []", false, "", "str", cmd);
             TCLAP::SwitchArg arg_override_tag("x", "x", "override tags [false]", cmd, false);
@@ -139,6 +159,9 @@ class Igor : Program
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
             fexp = arg_fexp.getValue();
             debug = arg_debug.getValue();
+            no_threads = arg_no_threads.getValue();
+            cache_capacity = arg_cache_capacity.getValue();
+            cache_file = arg_cache_file.getValue();
             ref_fasta_file = arg_ref_fasta_file.getValue();
         }
         catch (TCLAP::ArgException &e)
@@ -233,9 +256,24 @@ class Igor : Program
         ////////////////////////
         //tools initialization//
         ////////////////////////
-        vm = new VariantManip(ref_fasta_file);
-        va = new VNTRAnnotator(ref_fasta_file, debug);
-        rs = new ReferenceSequence(ref_fasta_file);
+        cache = NULL;
+        if (cache_capacity)
+        {
+            cache = new VNTRCache(cache_capacity);
+            if (cache_file!="") cache->load(cache_file, ref_fasta_file);
+        }
+
+        for (int32_t i=0; i<std::max(no_threads, 1); ++i)
+        {
+            AnnotationWorker* w = new AnnotationWorker();
+            w->vm = new VariantManip(ref_fasta_file);
+            w->va = new VNTRAnnotator(ref_fasta_file, debug);
+            w->va->cache = cache;
+            w->rs = new ReferenceSequence(ref_fasta_file);
+            w->filter.parse(fexp.c_str(), false);
+            w->no_indels_annotated = 0;
+            workers.push_back(w);
+        }
     }
 
     void print_options()
@@ -246,6 +284,9 @@ class Igor : Program
         std::clog << "         [o] output VCF file          " << output_vcf_file << "\n";
         std::clog << "         [k] add_flank_annotation     " << (add_flank_annotation ? "true" : "false") << "\n";
         print_boo_op("         [d] debug                    ", debug);
+        print_num_op("         [t] no. of threads           ", no_threads);
+        print_num_op("         [c] cache capacity           ", cache_capacity);
+        print_str_op("         [C] cache file               ", cache_file);
         print_ref_op("         [r] ref FASTA file           ", ref_fasta_file);
         print_int_op("         [i] intervals                ", intervals);
         std::clog << "\n";
@@ -255,13 +296,18 @@ class Igor : Program
     {
         std::clog << "\n";
         std::cerr << "stats: no. of indels annotated   " << no_indels_annotated << "\n";
+        if (cache)
+        {
+            std::cerr << "       no. of cache hits         " << cache->no_hits << "\n";
+            std::cerr << "       no. of cache misses       " << cache->no_misses << "\n";
+        }
         std::clog << "\n";
     }
 
     /**
      * Updates the FLANKSEQ INFO field.
      */
-    void update_flankseq(bcf_hdr_t* h, bcf1_t *v, const char* chrom, int32_t lflank_beg1, int32_t lflank_end1, int32_t rflank_beg1, int32_t rflank_end1)
+    void update_flankseq(ReferenceSequence* rs, bcf_hdr_t* h, bcf1_t *v, const char* chrom, int32_t lflank_beg1, int32_t lflank_end1, int32_t rflank_beg1, int32_t rflank_end1)
     {
         std::string flanks;
         char* seq = rs->fetch_seq(chrom, lflank_beg1, lflank_end1);
@@ -278,137 +324,179 @@ class Igor : Program
         bcf_update_info_string(h, v, "FLANKSEQ", flanks.c_str());
     }
 
-    void annotate_indels()
+    /**
+     * Annotates a single record with the tools of worker w.
+     * Returns false if the record is to be dropped.
+     */
+    bool annotate(AnnotationWorker* w, bcf1_t* v)
     {
-        odw->write_hdr();
-
-        bcf1_t *v = odw->get_bcf1_from_pool();
         bcf_hdr_t *h = odw->hdr;
-        Variant variant;
-        kstring_t old_alleles = {0,0,0};
+        Variant& variant = w->variant;
 
-        int32_t no_exact = 0;
-        int32_t no_inexact = 0;
+        int32_t vtype = w->vm->classify_variant(odr->hdr, v, variant);
 
-        while (odr->read(v))
+        if (filter_exists)
         {
-            int32_t vtype = vm->classify_variant(odr->hdr, v, variant);
-
-            if (filter_exists)
+            if (!w->filter.apply(h, v, &variant, false))
             {
-                if (!filter.apply(h, v, &variant, false))
-                {
-                    continue;
-                }
+                return false;
             }
+        }
 
-            //require normalization
-            if (!vm->is_normalized(v))
-            {
+        //require normalization
+        if (!w->vm->is_normalized(v))
+        {
 //                std::string var = variant.get_variant_string();
 //                fprintf(stderr, "[%s:%d %s] Variant is not normalized, annotate_indels requires that variants are normalized: %s\n", __FILE__, __LINE__, __FUNCTION__, var.c_str());
 //                odw->write(v);
 //                v = odw->get_bcf1_from_pool();
-                continue;
-            }
-            
-            //variants with N crashes the alignment models!!!!!!  :(
-            if (vm->contains_N(v))
-            {
+            return false;
+        }
+        
+        //variants with N crashes the alignment models!!!!!!  :(
+        if (w->vm->contains_N(v))
+        {
 //                std::string var = variant.get_variant_string();
 //                fprintf(stderr, "[%s:%d %s] Variant contains N bases, skipping annotation: %s\n", __FILE__, __LINE__, __FUNCTION__, var.c_str());
 //                odw->write(v);
 //                v = odw->get_bcf1_from_pool();
-                continue;
-            }
+            return false;
+        }
 
 //            bcf_print_liten(h,v);
-            
-            if (debug)
-            {
-                bcf_print_liten(h,v);
-            }
+        
+        if (debug)
+        {
+            bcf_print_liten(h,v);
+        }
 
-            if (vtype&VT_INDEL)
-            {
-                va->annotate(variant, EXACT|FUZZY);
+        if (vtype&VT_INDEL)
+        {
+            w->va->annotate(variant, EXACT|FUZZY);
 
-                VNTR& vntr = variant.vntr;
+            VNTR& vntr = variant.get_vntr();
 
-                //shared fields
-                bcf_set_rid(v, variant.rid);
-        
-                //exact characteristics
-                bcf_update_info_string(h, v, EX_MOTIF.c_str(), vntr.exact_motif.c_str());
-                bcf_update_info_int32(h, v, EX_MLEN.c_str(), &vntr.exact_mlen, 1);
-                bcf_update_info_string(h, v, EX_RU.c_str(), vntr.exact_ru.c_str());
-                bcf_update_info_string(h, v, EX_BASIS.c_str(), vntr.exact_basis.c_str());
-                bcf_update_info_int32(h, v, EX_BLEN.c_str(), &vntr.exact_blen, 1);
-                int32_t exact_flank_pos1[2] = {vntr.exact_beg1, vntr.exact_end1};
-                bcf_update_info_int32(h, v, EX_REPEAT_TRACT.c_str(), &exact_flank_pos1, 2);
-                bcf_update_info_int32(h, v, EX_COMP.c_str(), &vntr.exact_comp[0], 4);
-                bcf_update_info_float(h, v, EX_ENTROPY.c_str(), &vntr.exact_entropy, 1);
-                bcf_update_info_float(h, v, EX_ENTROPY2.c_str(), &vntr.exact_entropy2, 1);
-                bcf_update_info_float(h, v, EX_KL_DIVERGENCE.c_str(), &vntr.exact_kl_divergence, 1);
-                bcf_update_info_float(h, v, EX_KL_DIVERGENCE2.c_str(), &vntr.exact_kl_divergence2, 1);
-                bcf_update_info_float(h, v, EX_REF.c_str(), &vntr.exact_ref, 1);
-                bcf_update_info_int32(h, v, EX_RL.c_str(), &vntr.exact_rl, 1);
-                bcf_update_info_int32(h, v, EX_LL.c_str(), &vntr.exact_ll, 1);
-                int32_t exact_ru_count[2] = {vntr.exact_no_perfect_ru, vntr.exact_no_ru};
-                bcf_update_info_int32(h, v, EX_RU_COUNTS.c_str(), &exact_ru_count, 2);
-                bcf_update_info_float(h, v, EX_SCORE.c_str(), &vntr.exact_score, 1);
-                bcf_update_info_int32(h, v, EX_TRF_SCORE.c_str(), &vntr.exact_trf_score, 1);
-               
-                if (vntr.exact_ru_ambiguous) bcf_update_info_flag(h, v, "EXACT_RU_AMBIGUOUS", NULL, 1);
-               
-                //fuzzy characteristics
-                bcf_update_info_string(h, v, FZ_MOTIF.c_str(), vntr.fuzzy_motif.c_str());
-                bcf_update_info_int32(h, v, FZ_MLEN.c_str(), &vntr.fuzzy_mlen, 1);
-                bcf_update_info_string(h, v, FZ_RU.c_str(), vntr.fuzzy_ru.c_str());
-                bcf_update_info_string(h, v, FZ_BASIS.c_str(), vntr.fuzzy_basis.c_str());
-                bcf_update_info_int32(h, v, FZ_BLEN.c_str(), &vntr.fuzzy_blen, 1);
-                int32_t fuzzy_flank_pos1[2] = {vntr.fuzzy_beg1, vntr.fuzzy_end1};
-                bcf_update_info_int32(h, v, FZ_REPEAT_TRACT.c_str(), &fuzzy_flank_pos1, 2);
-                bcf_update_info_int32(h, v, FZ_COMP.c_str(), &vntr.fuzzy_comp[0], 4);
-                bcf_update_info_float(h, v, FZ_ENTROPY.c_str(), &vntr.fuzzy_entropy, 1);
-                bcf_update_info_float(h, v, FZ_ENTROPY2.c_str(), &vntr.fuzzy_entropy2, 1);
-                bcf_update_info_float(h, v, FZ_KL_DIVERGENCE.c_str(), &vntr.fuzzy_kl_divergence, 1);
-                bcf_update_info_float(h, v, FZ_KL_DIVERGENCE2.c_str(), &vntr.fuzzy_kl_divergence2, 1);
-                bcf_update_info_float(h, v, FZ_REF.c_str(), &vntr.fuzzy_ref, 1);
-                bcf_update_info_int32(h, v, FZ_RL.c_str(), &vntr.fuzzy_rl, 1);
-                bcf_update_info_int32(h, v, FZ_LL.c_str(), &vntr.fuzzy_ll, 1);
-                int32_t fuzzy_ru_count[2] = {vntr.fuzzy_no_perfect_ru, vntr.fuzzy_no_ru};
-                bcf_update_info_int32(h, v, FZ_RU_COUNTS.c_str(), &fuzzy_ru_count, 2);
-                bcf_update_info_float(h, v, FZ_SCORE.c_str(), &vntr.fuzzy_score, 1);
-                bcf_update_info_int32(h, v, FZ_TRF_SCORE.c_str(), &vntr.fuzzy_trf_score, 1);
-             
-                update_flankseq(h, v, variant.chrom.c_str(),
-                                variant.beg1-10, variant.beg1-1,
-                                variant.end1+1, variant.end1+10);
-                                
-                ++no_indels_annotated;
-            }
-            else if (vtype==VT_VNTR)
+            //shared fields
+            bcf_set_rid(v, variant.rid);
+    
+            //exact characteristics
+            bcf_update_info_string(h, v, EX_MOTIF.c_str(), vntr.exact_motif.c_str());
+            bcf_update_info_int32(h, v, EX_MLEN.c_str(), &vntr.exact_mlen, 1);
+            bcf_update_info_string(h, v, EX_RU.c_str(), vntr.exact_ru.c_str());
+            bcf_update_info_string(h, v, EX_BASIS.c_str(), vntr.exact_basis.c_str());
+            bcf_update_info_int32(h, v, EX_BLEN.c_str(), &vntr.exact_blen, 1);
+            int32_t exact_flank_pos1[2] = {vntr.exact_beg1, vntr.exact_end1};
+            bcf_update_info_int32(h, v, EX_REPEAT_TRACT.c_str(), &exact_flank_pos1, 2);
+            bcf_update_info_int32(h, v, EX_COMP.c_str(), &vntr.exact_comp[0], 4);
+            bcf_update_info_float(h, v, EX_ENTROPY.c_str(), &vntr.exact_entropy, 1);
+            bcf_update_info_float(h, v, EX_ENTROPY2.c_str(), &vntr.exact_entropy2, 1);
+            bcf_update_info_float(h, v, EX_KL_DIVERGENCE.c_str(), &vntr.exact_kl_divergence, 1);
+            bcf_update_info_float(h, v, EX_KL_DIVERGENCE2.c_str(), &vntr.exact_kl_divergence2, 1);
+            bcf_update_info_float(h, v, EX_REF.c_str(), &vntr.exact_ref, 1);
+            bcf_update_info_int32(h, v, EX_RL.c_str(), &vntr.exact_rl, 1);
+            bcf_update_info_int32(h, v, EX_LL.c_str(), &vntr.exact_ll, 1);
+            int32_t exact_ru_count[2] = {vntr.exact_no_perfect_ru, vntr.exact_no_ru};
+            bcf_update_info_int32(h, v, EX_RU_COUNTS.c_str(), &exact_ru_count, 2);
+            bcf_update_info_float(h, v, EX_SCORE.c_str(), &vntr.exact_score, 1);
+            bcf_update_info_int32(h, v, EX_TRF_SCORE.c_str(), &vntr.exact_trf_score, 1);
+           
+            if (vntr.exact_ru_ambiguous) bcf_update_info_flag(h, v, "EXACT_RU_AMBIGUOUS", NULL, 1);
+           
+            //fuzzy characteristics
+            bcf_update_info_string(h, v, FZ_MOTIF.c_str(), vntr.fuzzy_motif.c_str());
+            bcf_update_info_int32(h, v, FZ_MLEN.c_str(), &vntr.fuzzy_mlen, 1);
+            bcf_update_info_string(h, v, FZ_RU.c_str(), vntr.fuzzy_ru.c_str());
+            bcf_update_info_string(h, v, FZ_BASIS.c_str(), vntr.fuzzy_basis.c_str());
+            bcf_update_info_int32(h, v, FZ_BLEN.c_str(), &vntr.fuzzy_blen, 1);
+            int32_t fuzzy_flank_pos1[2] = {vntr.fuzzy_beg1, vntr.fuzzy_end1};
+            bcf_update_info_int32(h, v, FZ_REPEAT_TRACT.c_str(), &fuzzy_flank_pos1, 2);
+            bcf_update_info_int32(h, v, FZ_COMP.c_str(), &vntr.fuzzy_comp[0], 4);
+            bcf_update_info_float(h, v, FZ_ENTROPY.c_str(), &vntr.fuzzy_entropy, 1);
+            bcf_update_info_float(h, v, FZ_ENTROPY2.c_str(), &vntr.fuzzy_entropy2, 1);
+            bcf_update_info_float(h, v, FZ_KL_DIVERGENCE.c_str(), &vntr.fuzzy_kl_divergence, 1);
+            bcf_update_info_float(h, v, FZ_KL_DIVERGENCE2.c_str(), &vntr.fuzzy_kl_divergence2, 1);
+            bcf_update_info_float(h, v, FZ_REF.c_str(), &vntr.fuzzy_ref, 1);
+            bcf_update_info_int32(h, v, FZ_RL.c_str(), &vntr.fuzzy_rl, 1);
+            bcf_update_info_int32(h, v, FZ_LL.c_str(), &vntr.fuzzy_ll, 1);
+            int32_t fuzzy_ru_count[2] = {vntr.fuzzy_no_perfect_ru, vntr.fuzzy_no_ru};
+            bcf_update_info_int32(h, v, FZ_RU_COUNTS.c_str(), &fuzzy_ru_count, 2);
+            bcf_update_info_float(h, v, FZ_SCORE.c_str(), &vntr.fuzzy_score, 1);
+            bcf_update_info_int32(h, v, FZ_TRF_SCORE.c_str(), &vntr.fuzzy_trf_score, 1);
+         
+            update_flankseq(w->rs, h, v, variant.chrom.c_str(),
+                            variant.beg1-10, variant.beg1-1,
+                            variant.end1+1, variant.end1+10);
+                            
+            ++w->no_indels_annotated;
+        }
+        else if (vtype==VT_VNTR)
+        {
+            update_flankseq(w->rs, h, v, variant.chrom.c_str(),
+                            variant.beg1-10, variant.beg1-1,
+                            variant.end1+1, variant.end1+10);
+        }
+        else if (vtype==VT_SNP || vtype==VT_MNP)
+        {
+            update_flankseq(w->rs, h, v, variant.chrom.c_str(),
+                            variant.beg1-10, variant.beg1-1,
+                            variant.end1+1, variant.end1+10);
+        }
+        else //SVs?
+        {
+            //do nothing
+        }
+
+        return true;
+    }
+
+    void annotate_indels()
+    {
+        odw->write_hdr();
+
+        bcf1_t *v = odw->get_bcf1_from_pool();
+
+        if (no_threads<=1)
+        {
+            while (odr->read(v))
             {
-                update_flankseq(h, v, variant.chrom.c_str(),
-                                variant.beg1-10, variant.beg1-1,
-                                variant.end1+1, variant.end1+10);
+                if (annotate(workers[0], v))
+                {
+                    odw->write(v);
+                    v = odw->get_bcf1_from_pool();
+                }
             }
-            else if (vtype==VT_SNP || vtype==VT_MNP)
+        }
+        else
+        {
+            //records are annotated concurrently and written out in input order
+            OrderedWorkerPool pool(no_threads, [this](int32_t i, bcf1_t* v) { return annotate(workers[i], v); });
+            bool keep;
+            while (odr->read(v))
             {
-                update_flankseq(h, v, variant.chrom.c_str(),
-                                variant.beg1-10, variant.beg1-1,
-                                variant.end1+1, variant.end1+10);
+                pool.push(v);
+                while (pool.pop(v, keep, false))
+                {
+                    if (keep) odw->write(v);
+                    else odw->store_bcf1_into_pool(v);
+                }
+                v = odw->get_bcf1_from_pool();
             }
-            else //SVs?
+
+            pool.close();
+            while (pool.pop(v, keep, true))
             {
-                //do nothing
+                if (keep) odw->write(v);
+                else odw->store_bcf1_into_pool(v);
             }
-            
-            odw->write(v);
-            v = odw->get_bcf1_from_pool();
         }
 
+        for (size_t i=0; i<workers.size(); ++i)
+        {
+            no_indels_annotated += workers[i]->no_indels_annotated;
+        }
+
+        if (cache && cache_file!="") cache->save(cache_file, ref_fasta_file);
+
         odw->close();
         odr->close();
     };
@@ -333,7 +333,7 @@ class Igor : Program
             {
                 va->annotate(variant, EXACT|FUZZY);
 
-                VNTR& vntr = variant.vntr;
+                VNTR& vntr = variant.get_vntr();
 
                 //shared fields
                 bcf_set_rid(v, variant.rid);
@@ -133,6 +133,7 @@ class Igor : Program
         //i/o initialization
         ////////////////////
         odr = new BCFOrderedReader(input_vcf_file, intervals);
+        odr->set_required_fields(BCF_UN_STR);
         odw = new BCFOrderedWriter(output_vcf_file);
         odw->link_hdr(odr->hdr);
 
@@ -217,7 +218,6 @@ class Igor : Program
         kstring_t s = {0,0,0};
         while (odr->read(v))
         {
-            bcf_unpack(v, BCF_UN_STR);
             if (filter_exists)
             {
                 vm->classify_variant(h, v, variant);
@@ -227,13 +227,12 @@ class Igor : Program
                 }
             }
 
-            std::string chrom = bcf_get_chrom(odr->hdr,v);
             int32_t beg1 = bcf_get_pos1(v);
             int32_t end1 = bcf_get_end1(v);
 
             if (use_bed)
             {
-                bool overlaps = orom_regions->overlaps_with(chrom, beg1-left_window, end1+right_window);
+                bool overlaps = orom_regions->overlaps_with(odr->hdr, bcf_get_rid(v), beg1-left_window, end1+right_window);
 
                 if (!without_regions && overlaps)
                 {
@@ -264,7 +263,7 @@ class Igor : Program
             }
             else
             {
-                bool overlaps = orom_regions->overlaps_with(chrom, beg1-left_window, end1+right_window);
+                bool overlaps = obom_regions->overlaps_with(odr->hdr, bcf_get_rid(v), beg1-left_window, end1+right_window);
 
                 if (!without_regions && overlaps)
                 {
@@ -42,8 +42,10 @@ class Igor : Program
     std::string interval_list;
     std::string lc_bed_file;
     std::string cds_bed_file;
+    std::string gencode_index_file;
     bool annotate_lc;
     bool annotate_cds;
+    bool annotate_csq;
 
     ///////
     //i/o//
@@ -69,6 +71,7 @@ class Igor : Program
     VariantManip *vm;
     OrderedRegionOverlapMatcher *orom_lc;
     OrderedRegionOverlapMatcher *orom_cds;
+    GENCODEIndex *gci;
 
     Igor(int argc, char **argv)
     {
@@ -90,6 +93,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_ref_fasta_file("r", "r", "reference sequence fasta file []", true, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_lc_bed_file("m", "m", "low complexity regions BED file []", false, "", "file", cmd);
             TCLAP::ValueArg<std::string> arg_cds_bed_file("g", "g", "coding regions BED file []", false, "", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_gencode_index_file("x", "x", "GENCODE index file built with index_gencode []", false, "", "str", cmd);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
 
             cmd.parse(argc, argv);
@@ -104,6 +108,8 @@ class Igor : Program
             annotate_lc = lc_bed_file != "" ? true : false;
             cds_bed_file = arg_cds_bed_file.getValue();
             annotate_cds = cds_bed_file != "" ? true : false;
+            gencode_index_file = arg_gencode_index_file.getValue();
+            annotate_csq = gencode_index_file != "" ? true : false;
         }
         catch (TCLAP::ArgException &e)
         {
@@ -150,6 +156,13 @@ class Igor : Program
             orom_cds = new OrderedRegionOverlapMatcher(cds_bed_file);
         }
 
+        if (annotate_csq)
+        {
+            bcf_hdr_append(odw->hdr, "##INFO=<ID=FUNC,Number=A,Type=String,Description=\"Most severe consequence of each alternative allele over GENCODE transcripts - splice, nonsense, frameshift, stop_lost, inframe, missense, coding, synonymous, UTR, noncoding_exon, intron.\">");
+            bcf_hdr_append(odw->hdr, "##INFO=<ID=GENE,Number=.,Type=String,Description=\"Genes overlapping the variant.\">");
+            gci = GENCODEIndex::acquire(gencode_index_file);
+        }
+
         ////////////////////////
         //stats initialization//
         ////////////////////////
@@ -164,6 +177,7 @@ class Igor : Program
         std::clog << "         [o] output VCF file          " << output_vcf_file << "\n";
         print_str_op("         [m] low complexity BED file  ", lc_bed_file);
         print_str_op("         [g] coding sequence BED file ", cds_bed_file);
+        print_str_op("         [x] GENCODE index file       ", gencode_index_file);
         print_ref_op("         [r] ref FASTA file           ", ref_fasta_file);
         print_int_op("         [i] intervals                ", intervals);
         std::clog << "\n";
@@ -182,6 +196,8 @@ class Igor : Program
 
         bcf1_t *v = bcf_init1();
         std::vector<Interval*> overlaps;
+        std::vector<int32_t> txs;
+        std::vector<std::string> genes;
         Variant variant;
         kstring_t s = {0,0,0};
         while (odr->read(v))
@@ -203,13 +219,13 @@ class Igor : Program
                 bcf_update_info_string(odr->hdr, v, "VT", str.c_str());
             }
 
-            std::string chrom = bcf_get_chrom(odr->hdr,v);
+            const char* chrom = bcf_get_chrom(odr->hdr,v);
             int32_t start1 = bcf_get_pos1(v);
             int32_t end1 = bcf_get_end1(v);
 
             if (annotate_lc)
             {
-                if (orom_lc->overlaps_with(chrom, start1, end1))
+                if (orom_lc->overlaps_with(odr->hdr, bcf_get_rid(v), start1, end1))
                 {
                     bcf_update_info_flag(odr->hdr, v, "LC", "", 1);
                 }
@@ -225,7 +241,7 @@ class Igor : Program
                 if (annotate_cds)
                 {
                     bool overlap = false;
-                    if ((overlap = orom_cds->overlaps_with(chrom, start1, end1)))
+                    if ((overlap = orom_cds->overlaps_with(odr->hdr, bcf_get_rid(v), start1, end1)))
                     {
                         if (abs(variant.alleles[0].dlen)%3!=0)
                         {
@@ -240,11 +256,52 @@ class Igor : Program
                 }
             }
 
+            if (annotate_csq)
+            {
+                gci->search(chrom, start1, end1, txs);
+
+                if (txs.size())
+                {
+                    char** allele = bcf_get_allele(v);
+                    s.l = 0;
+                    for (int32_t i=1; i<bcf_get_n_allele(v); ++i)
+                    {
+                        int32_t csq = GC_CSQ_NONE;
+                        for (uint32_t j=0; j<txs.size(); ++j)
+                        {
+                            csq = std::max(csq, gci->annotate(txs[j], start1, allele[0], allele[i]));
+                        }
+                        if (i>1) kputc(',', &s);
+                        kputs(GENCODEIndex::csq2string(csq), &s);
+                    }
+                    bcf_update_info_string(odr->hdr, v, "FUNC", s.s);
+
+                    genes.clear();
+                    s.l = 0;
+                    for (uint32_t j=0; j<txs.size(); ++j)
+                    {
+                        std::string gene(gci->get_gene(txs[j]));
+                        if (gene!="" && std::find(genes.begin(), genes.end(), gene)==genes.end())
+                        {
+                            if (genes.size()) kputc(',', &s);
+                            kputs(gene.c_str(), &s);
+                            genes.push_back(gene);
+                        }
+                    }
+                    if (genes.size())
+                    {
+                        bcf_update_info_string(odr->hdr, v, "GENE", s.s);
+                    }
+                }
+            }
+
             ++no_variants_annotated;
             odw->write(v);
         }
 
         odw->close();
+        if (annotate_csq) GENCODEIndex::release(gci);
+        if (s.m) free(s.s);
     };
 
     private:
@@ -25,6 +25,7 @@
 #define ANNOTATE_VARIANTS_H
 
 #include "program.h"
+#include "gencode_index.h"
 
 void annotate_variants(int argc, char ** argv);
 
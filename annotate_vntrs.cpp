@@ -26,6 +26,21 @@
 namespace
 {
 
+/**
+ * Tools owned by a single annotation worker, none of them are shared between threads.
+ */
+class AnnotationWorker
+{
+    public:
+
+    VariantManip* vm;
+    VNTRAnnotator* va;
+    ReferenceSequence* rs;
+    Filter filter;
+    Variant variant;
+    int32_t no_vntrs_annotated;
+};
+
 class Igor : Program
 {
     public:
@@ -47,6 +62,7 @@ class Igor : Program
     bool override_tag;
     bool add_vntr_record;
     bool add_flank_annotation;     //add flank annotation
+    int32_t no_threads;
 
     //motif related
     std::string END;
@@ -89,9 +105,8 @@ class Igor : Program
     ////////////////
     //common tools//
     ////////////////
-    VariantManip* vm;
-    VNTRAnnotator* va;
-    ReferenceSequence* rs;
+    std::vector<AnnotationWorker*> workers;
+    VNTRInfoIDs* vntr_info_ids;
 
     Igor(int argc, char **argv)
     {
@@ -111,6 +126,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "str", cmd);
             TCLAP::ValueArg<std::string> arg_ref_fasta_file("r", "r", "reference sequence fasta file []", true, "", "str", cmd);
             TCLAP::SwitchArg arg_debug("d", "d", "debug [false]", cmd, false);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of annotation threads [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
             TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter expression []", false, "", "str", cmd);
             TCLAP::SwitchArg arg_override_tag("x", "x", "override tags [false]", cmd, false);
@@ -122,6 +138,7 @@ class Igor : Program
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
             fexp = arg_fexp.getValue();
             debug = arg_debug.getValue();
+            no_threads = arg_no_threads.getValue();
             ref_fasta_file = arg_ref_fasta_file.getValue();
         }
         catch (TCLAP::ArgException &e)
@@ -183,9 +200,17 @@ class Igor : Program
         ////////////////////////
         //tools initialization//
         ////////////////////////
-        vm = new VariantManip(ref_fasta_file);
-        va = new VNTRAnnotator(ref_fasta_file, debug);
-        rs = new ReferenceSequence(ref_fasta_file);
+        vntr_info_ids = new VNTRInfoIDs(odr->hdr);
+        for (int32_t i=0; i<std::max(no_threads, 1); ++i)
+        {
+            AnnotationWorker* w = new AnnotationWorker();
+            w->vm = new VariantManip(ref_fasta_file);
+            w->va = new VNTRAnnotator(ref_fasta_file, debug);
+            w->rs = new ReferenceSequence(ref_fasta_file);
+            w->filter.parse(fexp.c_str(), false);
+            w->no_vntrs_annotated = 0;
+            workers.push_back(w);
+        }
     }
 
     void print_options()
@@ -197,6 +222,7 @@ class Igor : Program
         std::clog << "         [v] add VNTR records         " << (add_vntr_record ? "true" : "false") << "\n";
         std::clog << "         [k] add_flank_annotation     " << (add_flank_annotation ? "true" : "false") << "\n";
         print_boo_op("         [d] debug                    ", debug);
+        print_num_op("         [t] no. of threads           ", no_threads);
         print_ref_op("         [r] ref FASTA file           ", ref_fasta_file);
         print_boo_op("         [x] override tag             ", override_tag);
         print_int_op("         [i] intervals                ", intervals);
@@ -213,7 +239,7 @@ class Igor : Program
     /**
      * Updates the FLANKSEQ INFO field.
      */
-    void update_flankseq(bcf_hdr_t* h, bcf1_t *v, const char* chrom, int32_t lflank_beg1, int32_t lflank_end1, int32_t rflank_beg1, int32_t rflank_end1)
+    void update_flankseq(ReferenceSequence* rs, bcf_hdr_t* h, bcf1_t *v, const char* chrom, int32_t lflank_beg1, int32_t lflank_end1, int32_t rflank_beg1, int32_t rflank_end1)
     {
         std::string flanks;
         char* seq = rs->fetch_seq(chrom, lflank_beg1, lflank_end1);
@@ -230,76 +256,120 @@ class Igor : Program
         bcf_update_info_string(h, v, "FLANKSEQ", flanks.c_str());
     }
 
+    /**
+     * Annotates a single record with the tools of worker w.
+     * Returns false if the record is to be dropped.
+     */
+    bool annotate(AnnotationWorker* w, bcf1_t* v)
+    {
+        bcf_hdr_t *h = odw->hdr;
+        Variant& variant = w->variant;
+
+        int32_t vtype = w->vm->classify_variant(odr->hdr, v, variant);
+
+        if (filter_exists)
+        {
+            if (!w->filter.apply(h, v, &variant, false))
+            {
+                return false;
+            }
+        }
+
+        //variants with N crashes the alignment models!!!!!!  :(
+        if (w->vm->contains_N(v))
+        {
+            std::string var = variant.get_variant_string();
+            fprintf(stderr, "[%s:%d %s] Variant contains N bases, skipping annotation: %s\n", __FILE__, __LINE__, __FUNCTION__, var.c_str());
+            return true;
+        }
+
+        if (debug)
+        {
+            bcf_print_liten(h,v);
+        }
+
+        if (vtype==VT_VNTR)
+        {
+            variant.update_vntr_from_info_fields(*vntr_info_ids);
+            VNTR& vntr = variant.get_vntr();
+
+            int32_t beg1 = bcf_get_pos1(v);
+            int32_t end1 = bcf_get_end1(v);
+
+            w->va->annotate(variant, FINAL);
+            //assumes MOTIF is present
+            bcf_update_info_int32(h, v, MLEN.c_str(), &vntr.mlen, 1);
+
+            bcf_update_info_int32(h, v, END.c_str(), &variant.end1, 1);
+            bcf_update_info_string(h, v, RU.c_str(), vntr.ru.c_str());
+            bcf_update_info_string(h, v, BASIS.c_str(), vntr.basis.c_str());
+            bcf_update_info_int32(h, v, BLEN.c_str(), &vntr.blen, 1);
+
+            int32_t repeat_tract[2] = {beg1, end1};
+            bcf_update_info_int32(h, v, REPEAT_TRACT.c_str(), &repeat_tract, 2);
+            bcf_update_info_int32(h, v, COMP.c_str(), &vntr.comp[0], 4);
+            bcf_update_info_float(h, v, ENTROPY.c_str(), &vntr.entropy, 1);
+            bcf_update_info_float(h, v, ENTROPY2.c_str(), &vntr.entropy2, 1);
+            bcf_update_info_int32(h, v, RL.c_str(), &vntr.rl, 1);
+            int32_t ru_count[2] = {vntr.no_perfect_ru, vntr.no_ru};
+            bcf_update_info_int32(h, v, RU_COUNTS.c_str(), &ru_count, 2);
+            bcf_update_info_float(h, v, SCORE.c_str(), &vntr.score, 1);
+            bcf_update_info_int32(h, v, TRF_SCORE.c_str(), &vntr.trf_score, 1);
+
+            update_flankseq(w->rs, h, v, variant.chrom.c_str(),
+                            variant.beg1-10, variant.beg1-1,
+                            variant.end1+1, variant.end1+10);
+
+            ++w->no_vntrs_annotated;
+        }
+
+        return true;
+    }
+
     void annotate_vntrs()
     {
         odw->write_hdr();
 
         bcf1_t *v = odw->get_bcf1_from_pool();
-        bcf_hdr_t *h = odw->hdr;
-        Variant variant;
-        while (odr->read(v))
-        {
-            int32_t vtype = vm->classify_variant(odr->hdr, v, variant);
 
-            if (filter_exists)
+        if (no_threads<=1)
+        {
+            while (odr->read(v))
             {
-                if (!filter.apply(h, v, &variant, false))
+                if (annotate(workers[0], v))
                 {
-                    continue;
+                    odw->write(v);
+                    v = odw->get_bcf1_from_pool();
                 }
             }
-
-            //variants with N crashes the alignment models!!!!!!  :(
-            if (vm->contains_N(v))
+        }
+        else
+        {
+            //records are annotated concurrently and written out in input order
+            OrderedWorkerPool pool(no_threads, [this](int32_t i, bcf1_t* v) { return annotate(workers[i], v); });
+            bool keep;
+            while (odr->read(v))
             {
-                std::string var = variant.get_variant_string();
-                fprintf(stderr, "[%s:%d %s] Variant contains N bases, skipping annotation: %s\n", __FILE__, __LINE__, __FUNCTION__, var.c_str());
-                odw->write(v);
+                pool.push(v);
+                while (pool.pop(v, keep, false))
+                {
+                    if (keep) odw->write(v);
+                    else odw->store_bcf1_into_pool(v);
+                }
                 v = odw->get_bcf1_from_pool();
-                continue;
-            }
-
-            if (debug)
-            {
-                bcf_print_liten(h,v);
             }
 
-            if (vtype==VT_VNTR)
+            pool.close();
+            while (pool.pop(v, keep, true))
             {
-                VNTR& vntr = variant.vntr;
-
-                int32_t beg1 = bcf_get_pos1(v);
-                int32_t end1 = bcf_get_end1(v);
-
-                va->annotate(variant, FINAL);
-                //assumes MOTIF is present
-                bcf_update_info_int32(h, v, MLEN.c_str(), &vntr.mlen, 1);
-
-                bcf_update_info_int32(h, v, END.c_str(), &variant.end1, 1);
-                bcf_update_info_string(h, v, RU.c_str(), vntr.ru.c_str());
-                bcf_update_info_string(h, v, BASIS.c_str(), vntr.basis.c_str());
-                bcf_update_info_int32(h, v, BLEN.c_str(), &vntr.blen, 1);
-
-                int32_t repeat_tract[2] = {beg1, end1};
-                bcf_update_info_int32(h, v, REPEAT_TRACT.c_str(), &repeat_tract, 2);
-                bcf_update_info_int32(h, v, COMP.c_str(), &vntr.comp[0], 4);
-                bcf_update_info_float(h, v, ENTROPY.c_str(), &vntr.entropy, 1);
-                bcf_update_info_float(h, v, ENTROPY2.c_str(), &vntr.entropy2, 1);
-                bcf_update_info_int32(h, v, RL.c_str(), &vntr.rl, 1);
-                int32_t ru_count[2] = {vntr.no_perfect_ru, vntr.no_ru};
-                bcf_update_info_int32(h, v, RU_COUNTS.c_str(), &ru_count, 2);
-                bcf_update_info_float(h, v, SCORE.c_str(), &vntr.score, 1);
-                bcf_update_info_int32(h, v, TRF_SCORE.c_str(), &vntr.trf_score, 1);
-
-                update_flankseq(h, v, variant.chrom.c_str(),
-                                variant.beg1-10, variant.beg1-1,
-                                variant.end1+1, variant.end1+10);
-
-                ++no_vntrs_annotated;
+                if (keep) odw->write(v);
+                else odw->store_bcf1_into_pool(v);
             }
+        }
 
-            odw->write(v);
-            v = odw->get_bcf1_from_pool();
+        for (size_t i=0; i<workers.size(); ++i)
+        {
+            no_vntrs_annotated += workers[i]->no_vntrs_annotated;
         }
 
         odw->close();
@@ -26,6 +26,7 @@
 
 #include "program.h"
 #include "vntr_annotator.h"
+#include "ordered_worker_pool.h"
 
 void annotate_vntrs(int argc, char ** argv);
 
@@ -52,8 +52,6 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
     beg1  = bam_get_pos1(s);
     end1  = beg1;
 
-    uint8_t* seq = bam_get_seq(s);
-
     //CIGAR related variables
     int32_t n_cigar_op = bam_get_n_cigar_op(s);
     uint32_t *cigar = bam_get_cigar(s);
@@ -62,9 +60,9 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
 
     //get MD tag
     uint8_t *md_aux;
-    char* md = 0;
+    md = 0;
     ((md_aux=bam_aux_get(s, "MD")) &&  (md = bam_aux2Z(md_aux)));
-    char* mdp = md; //pointer to md
+    const char* mdp = md; //pointer to md
 
 
     //variables for keep track of CIGAR and MD tag
@@ -86,9 +84,7 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
 
         if (opchr=='S')
         {
-            aug_cigar.push_back(cigar[i]);
-            aug_ref.push_back("");
-            aug_alt.push_back("");
+            add_op(cigar[i], rpos0, -1);
 
             rpos0 += oplen;
         }
@@ -107,9 +103,7 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
                 //to process the next insertion or SNP
                 if (md_mlen_left>mlen)
                 {
-                    aug_cigar.push_back(bam_cigar_gen(mlen, BAM_CEQUAL));
-                    aug_ref.push_back("");
-                    aug_alt.push_back("");
+                    add_op(bam_cigar_gen(mlen, BAM_CEQUAL), rpos0, -1);
 
                     md_mlen_left -= mlen;
                     rpos0 += mlen;
@@ -127,9 +121,7 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
                 //to process the next insertion or SNP
                 else
                 {
-                    aug_cigar.push_back(bam_cigar_gen(md_mlen_left, BAM_CEQUAL));
-                    aug_ref.push_back("");
-                    aug_alt.push_back("");
+                    add_op(bam_cigar_gen(md_mlen_left, BAM_CEQUAL), rpos0, -1);
 
                     mlen -= md_mlen_left;
                     rpos0 += md_mlen_left;
@@ -144,12 +136,7 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
             {
                 if (isalpha(*mdp)) //mismatches
                 {
-                    aug_cigar.push_back(bam_cigar_gen(1, BAM_CDIFF));
-
-//                    std::cerr << "ADDING " << ((char)toupper(*mdp)) << " " << bam_base2char(bam_seqi(seq, rpos0)) << "\n";
-
-                    aug_ref.push_back(std::string(1, toupper(*mdp)));
-                    aug_alt.push_back(std::string(1, bam_base2char(bam_seqi(seq, rpos0))));
+                    add_op(bam_cigar_gen(1, BAM_CDIFF), rpos0, mdp-md);
 
                     ++mdp;
                     ++rpos0;
@@ -166,9 +153,7 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
                         //another I
                         if (len>mlen)
                         {
-                            aug_cigar.push_back(bam_cigar_gen(mlen, BAM_CEQUAL));
-                            aug_ref.push_back("");
-                            aug_alt.push_back("");
+                            add_op(bam_cigar_gen(mlen, BAM_CEQUAL), rpos0, -1);
 
                             md_mlen_left = len - mlen;
                             rpos0 += mlen;
@@ -180,9 +165,7 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
                         //another mismatch
                         else
                         {
-                            aug_cigar.push_back(bam_cigar_gen(len, BAM_CEQUAL));
-                            aug_ref.push_back("");
-                            aug_alt.push_back("");
+                            add_op(bam_cigar_gen(len, BAM_CEQUAL), rpos0, -1);
 
                             mlen -= len;
                             rpos0 += len;
@@ -213,17 +196,12 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
             }
 
             ++mdp;
-            std::string del = "";
+            add_op(cigar[i], rpos0, mdp-md);
 
             while (isalpha(*mdp))
             {
-                del += toupper(*mdp);
                 ++mdp;
             }
-
-            aug_cigar.push_back(cigar[i]);
-            aug_ref.push_back(del);
-            aug_alt.push_back("");
         }
         else if (opchr=='I')
         {
@@ -233,18 +211,14 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
             if (!seenM)
             {
                 //convert to Ss
-                aug_cigar.push_back(bam_cigar_gen(oplen, BAM_CSOFT_CLIP));
-                aug_ref.push_back("");
-                aug_alt.push_back("");
+                add_op(bam_cigar_gen(oplen, BAM_CSOFT_CLIP), rpos0, -1);
 
                 rpos0 += oplen;
             }
             //trailing Is
             else if (i==n_cigar_op-1 || (i+2==n_cigar_op && bam_cigar_opchr(cigar[n_cigar_op-1])=='S'))
             {
-                aug_cigar.push_back(bam_cigar_gen(oplen, BAM_CSOFT_CLIP));
-                aug_ref.push_back("");
-                aug_alt.push_back("");
+                add_op(bam_cigar_gen(oplen, BAM_CSOFT_CLIP), rpos0, -1);
 
                 rpos0 += oplen;
             }
@@ -252,15 +226,7 @@ void AugmentedBAMRecord::initialize(bam_hdr_t* h, bam1_t* s)
             {
                 //insertions are not present in MD tags
                 //may be handled independently of future matches
-                std::string ins = "";
-                for (size_t i=0; i<oplen ; ++i)
-                {
-                    ins += bam_base2char(bam_seqi(seq, rpos0+i));
-                }
-
-                aug_cigar.push_back(bam_cigar_gen(oplen, BAM_CINS));
-                aug_ref.push_back("");
-                aug_alt.push_back(ins);
+                add_op(bam_cigar_gen(oplen, BAM_CINS), rpos0, -1);
 
                 rpos0 += oplen;
             }
@@ -339,6 +305,108 @@ bool AugmentedBAMRecord::right_align()
     return true;
 }
 
+/**
+ * Returns the length of the reference sequence of the ith operation.
+ */
+int32_t AugmentedBAMRecord::get_ref_len(uint32_t i)
+{
+    char opchr = bam_cigar_opchr(aug_cigar[i]);
+    return opchr=='X' ? 1 : (opchr=='D' ? bam_cigar_oplen(aug_cigar[i]) : 0);
+}
+
+/**
+ * Returns the length of the read sequence of the ith operation.
+ */
+int32_t AugmentedBAMRecord::get_alt_len(uint32_t i)
+{
+    char opchr = bam_cigar_opchr(aug_cigar[i]);
+    return opchr=='X' ? 1 : (opchr=='I' ? bam_cigar_oplen(aug_cigar[i]) : 0);
+}
+
+/**
+ * Returns the jth reference base of the ith operation.
+ */
+char AugmentedBAMRecord::get_ref_base(uint32_t i, int32_t j)
+{
+    return toupper(md[aug_spans[i].mdpos+j]);
+}
+
+/**
+ * Returns the jth read base of the ith operation.
+ */
+char AugmentedBAMRecord::get_alt_base(uint32_t i, int32_t j)
+{
+    return bam_base2char(bam_seqi(bam_get_seq(s), aug_spans[i].rpos0+j));
+}
+
+/**
+ * Checks if the reference sequence of the ith operation is seq.
+ */
+bool AugmentedBAMRecord::ref_equals(uint32_t i, const std::string& seq)
+{
+    int32_t len = get_ref_len(i);
+    if ((int32_t)seq.size()!=len)
+    {
+        return false;
+    }
+
+    for (int32_t j=0; j<len; ++j)
+    {
+        if (get_ref_base(i, j)!=seq[j])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Checks if the read sequence of the ith operation is seq.
+ */
+bool AugmentedBAMRecord::alt_equals(uint32_t i, const std::string& seq)
+{
+    int32_t len = get_alt_len(i);
+    if ((int32_t)seq.size()!=len)
+    {
+        return false;
+    }
+
+    for (int32_t j=0; j<len; ++j)
+    {
+        if (get_alt_base(i, j)!=seq[j])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Appends the reference sequence of the ith operation to seq.
+ */
+void AugmentedBAMRecord::append_ref(uint32_t i, std::string& seq)
+{
+    int32_t len = get_ref_len(i);
+    for (int32_t j=0; j<len; ++j)
+    {
+        seq.append(1, get_ref_base(i, j));
+    }
+}
+
+/**
+ * Appends the read sequence of the ith operation to seq.
+ */
+void AugmentedBAMRecord::append_alt(uint32_t i, std::string& seq)
+{
+    int32_t len = get_alt_len(i);
+    for (int32_t j=0; j<len; ++j)
+    {
+        seq.append(1, get_alt_base(i, j));
+    }
+}
+
 /**
  * Clear.
  */
@@ -346,8 +414,8 @@ void AugmentedBAMRecord::clear()
 {
     s = NULL;
     aug_cigar.clear();
-    aug_ref.clear();
-    aug_alt.clear();
+    aug_spans.clear();
+    md = NULL;
     no_mismatches = 0;
 }
 
@@ -498,8 +566,8 @@ void AugmentedBAMRecord::print()
         {
             //assume oplen is always 1.
 
-            ref.append(aug_ref[i]);
-            seq.append(aug_alt[i]);
+            append_ref(i, ref);
+            append_alt(i, seq);
             align.append(1, 'X');
             quals.append(1, qual[spos0]+33);
 
@@ -508,7 +576,7 @@ void AugmentedBAMRecord::print()
         else if (opchr=='I')
         {
             ref.append(oplen, '-');
-            seq.append(aug_alt[i]);
+            append_alt(i, seq);
             align.append( oplen, 'I');
 
             for (uint32_t j=0; j<oplen; ++j)
@@ -520,7 +588,7 @@ void AugmentedBAMRecord::print()
         }
         else if (opchr=='D')
         {
-            ref.append(aug_ref[i]);
+            append_ref(i, ref);
             seq.append(oplen, '-');
             align.append(oplen, 'D');
         }
@@ -27,6 +27,19 @@
 #include "hts_utils.h"
 #include "utils.h"
 
+/**
+ * Locates the sequences of an augmented cigar operation.
+ *
+ * Read bases of a mismatch or insertion start at rpos0 in the packed
+ * read sequence, reference bases of a mismatch or deletion start at
+ * mdpos in the MD tag.
+ */
+typedef struct
+{
+    int32_t rpos0;
+    int32_t mdpos;
+} aug_span_t;
+
 /**
  * The augmented BAM record adds functionalities to process the
  * cigar and MD5 tag in an integrated fashion.
@@ -47,12 +60,16 @@
  * 3. cigar from bam1_t
  * 4. MD from bam1_t (or reconstructed)
  * 5. aux_cigar that includes mismatches
- * 6. aux_seq that points to
- *    a. base substitution in MD
+ * 6. aug_spans that point to
+ *    a. base substitution in MD and seq (X)
  *    b. inserted sequence in seq (I)
  *    c. deleted sequence in MD (D)
  *
  * For ease of left alignment of indels, and extracting a SNP
+ *
+ * The sequences are never copied out of the BAM record, the augmented
+ * cigar and spans are reused across reads so that initializing a record
+ * does not allocate once the buffers have grown.
  */
 class AugmentedBAMRecord
 {
@@ -66,10 +83,10 @@ class AugmentedBAMRecord
     std::vector<uint32_t> aug_cigar;
 
     //points to mismatch, deleted and inserted sequences
-    std::vector<std::string> aug_ref;
+    std::vector<aug_span_t> aug_spans;
 
-    //points to mismatch, deleted and inserted sequences
-    std::vector<std::string> aug_alt;
+    //MD tag of s
+    const char* md;
 
     //statistics
     uint32_t no_mismatches;
@@ -109,6 +126,46 @@ class AugmentedBAMRecord
      */
     bool right_align();
 
+    /**
+     * Returns the length of the reference sequence of the ith operation.
+     */
+    int32_t get_ref_len(uint32_t i);
+
+    /**
+     * Returns the length of the read sequence of the ith operation.
+     */
+    int32_t get_alt_len(uint32_t i);
+
+    /**
+     * Returns the jth reference base of the ith operation.
+     */
+    char get_ref_base(uint32_t i, int32_t j);
+
+    /**
+     * Returns the jth read base of the ith operation.
+     */
+    char get_alt_base(uint32_t i, int32_t j);
+
+    /**
+     * Checks if the reference sequence of the ith operation is seq.
+     */
+    bool ref_equals(uint32_t i, const std::string& seq);
+
+    /**
+     * Checks if the read sequence of the ith operation is seq.
+     */
+    bool alt_equals(uint32_t i, const std::string& seq);
+
+    /**
+     * Appends the reference sequence of the ith operation to seq.
+     */
+    void append_ref(uint32_t i, std::string& seq);
+
+    /**
+     * Appends the read sequence of the ith operation to seq.
+     */
+    void append_alt(uint32_t i, std::string& seq);
+
     /**
      * Clear.
      */
@@ -118,6 +175,20 @@ class AugmentedBAMRecord
      * Prints alignment of record.
      */
     void print();
+
+    private:
+
+    /**
+     * Appends an operation to the augmented cigar.
+     */
+    void add_op(uint32_t op, int32_t rpos0, int32_t mdpos)
+    {
+        aug_cigar.push_back(op);
+        aug_spans.push_back(aug_span_t());
+        aug_span_t& span = aug_spans.back();
+        span.rpos0 = rpos0;
+        span.mdpos = mdpos;
+    };
 };
 
 #endif
\ No newline at end of file
@@ -37,6 +37,7 @@ BCFGenotypingBufferedReader::BCFGenotypingBufferedReader(std::string filename, s
     //options initialization//
     //////////////////////////
     output_annotations = false;
+    realign_indels = false;
 
     ////////////////////////
     //stats initialization//
@@ -124,11 +125,14 @@ void BCFGenotypingBufferedReader::process_read(bam_hdr_t *h, bam1_t *s)
     while (odr->read(v))
     {
         int32_t vtype = vm->classify_variant(odr->hdr, v, variant);
-        
-        if (vtype==VT_INDEL)
-        {    
-            g = new GenotypingRecord(odr->hdr, v, 10, 2);
+
+        //only indels are genotyped by this reader
+        if (vtype!=VT_INDEL)
+        {
+            continue;
         }
+
+        g = new IndelGenotypingRecord(odr->hdr, v, 10, 2);
         buffer.push_back(g);
 
         if (tid==g->rid)
@@ -631,8 +635,6 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
             int32_t cycle = 0;
 
             std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-            std::vector<std::string>& aug_ref = as.aug_ref;
-            std::vector<std::string>& aug_alt = as.aug_alt;
 
             int32_t vpos1 = g->pos1;
             int32_t cpos1 = bam_get_pos1(s);
@@ -670,7 +672,7 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
                     {
 //                        std::cerr << i << ") " << vpos1 << "," << cpos1 << "," << rpos0 << " : " << aug_ref[i] << "/" << aug_alt[i] << " vs " <<bcf_get_allele(g->v)[1][0] << "\n";
 
-                        allele = aug_alt[i].at(0) == bcf_get_allele(g->v)[1][0] ? 1 : -1;
+                        allele = as.get_alt_base(i, 0) == bcf_get_allele(g->v)[1][0] ? 1 : -1;
                         q = qual[rpos0];
                         cycle = rpos0<(rlen>>1) ? (rpos0+1) : -(rlen - rpos0 + 1);
 
@@ -761,8 +763,6 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
             int32_t cycle = 0;
 
             std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-            std::vector<std::string>& aug_ref = as.aug_ref;
-            std::vector<std::string>& aug_alt = as.aug_alt;
 
             int32_t vpos1 = g->pos1;
             int32_t cpos1 = bam_get_pos1(s);
@@ -800,7 +800,7 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
                     {
 //                        std::cerr << i << ") " << vpos1 << "," << cpos1 << "," << rpos0 << " : " << aug_ref[i] << "/" << aug_alt[i] << " vs " <<bcf_get_allele(g->v)[1][0] << "\n";
 
-                        allele = aug_alt[i].at(0) == bcf_get_allele(g->v)[1][0] ? 1 : -1;
+                        allele = as.get_alt_base(i, 0) == bcf_get_allele(g->v)[1][0] ? 1 : -1;
                         q = qual[rpos0];
                         cycle = rpos0<(rlen>>1) ? (rpos0+1) : -(rlen - rpos0 + 1);
 
@@ -881,7 +881,11 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
     {
         if (bcf_get_n_allele(g->v)==2)
         {
-            if (as.beg1 <= g->beg1 && g->end1 <= as.end1)
+            if (realign_indels)
+            {
+                add_realignment_read(g, as);
+            }
+            else if (as.beg1 <= g->beg1 && g->end1 <= as.end1)
             {
                 bam1_t *s = as.s;
 
@@ -900,8 +904,6 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
                 uint32_t cycle = 10;
 
                 std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-                std::vector<std::string>& aug_ref = as.aug_ref;
-                std::vector<std::string>& aug_alt = as.aug_alt;
 
                 int32_t vpos1 = g->pos1;
 
@@ -1068,7 +1070,7 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
 
                         if (cpos1-1==end1)
                         {
-                            observed_allele.append(aug_alt[i]);
+                            as.append_alt(i, observed_allele);
                             cycle = strand == 'F' ? (rpos0+1) : (rlen - rpos0);
                         }
 
@@ -1185,8 +1187,6 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
                 uint32_t cycle = 10;
 
                 std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-                std::vector<std::string>& aug_ref = as.aug_ref;
-                std::vector<std::string>& aug_alt = as.aug_alt;
 
                 int32_t vpos1 = g->pos1;
 
@@ -1353,7 +1353,7 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
 
                         if (cpos1-1==end1)
                         {
-                            observed_allele.append(aug_alt[i]);
+                            as.append_alt(i, observed_allele);
                             cycle = strand == 'F' ? (rpos0+1) : (rlen - rpos0);
                         }
 
@@ -1463,8 +1463,6 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
         uint8_t mapq = bam_get_mapq(s);
 
         std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-        std::vector<std::string>& aug_ref = as.aug_ref;
-        std::vector<std::string>& aug_alt = as.aug_alt;
 
         //genomic bookend positions of VNTR
         int32_t vpos1 = g->beg1-1;
@@ -1577,8 +1575,6 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
                 uint32_t cycle = 10;
 
                 std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-                std::vector<std::string>& aug_ref = as.aug_ref;
-                std::vector<std::string>& aug_alt = as.aug_alt;
 
                 int32_t vpos1 = g->pos1;
 
@@ -1745,7 +1741,7 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
 
                         if (cpos1-1==end1)
                         {
-                            observed_allele.append(aug_alt[i]);
+                            as.append_alt(i, observed_allele);
                             cycle = strand == 'F' ? (rpos0+1) : (rlen - rpos0);
                         }
 
@@ -1847,6 +1843,188 @@ void BCFGenotypingBufferedReader::collect_sufficient_statistics(GenotypingRecord
     }
 }
 
+/**
+ * Keeps the aligned part of a read for realignment against the
+ * candidate haplotypes of an indel.
+ */
+void BCFGenotypingBufferedReader::add_realignment_read(GenotypingRecord *g, AugmentedBAMRecord& as)
+{
+    bam1_t *s = as.s;
+    uint8_t* seq = bam_get_seq(s);
+    uint8_t* qual = bam_get_qual(s);
+    uint32_t* cigar = bam_get_cigar(s);
+    int32_t n_cigar_op = bam_get_n_cigar_op(s);
+    int32_t rlen = bam_get_l_qseq(s);
+    char strand = bam_is_rev(s) ? 'R' : 'F';
+
+    //soft clips are not scored against the haplotypes
+    int32_t qbeg0 = 0;
+    int32_t qend0 = rlen;
+    int32_t cpos1 = bam_get_pos1(s);
+    int32_t vpos0 = -1;
+    for (int32_t i=0; i<n_cigar_op; ++i)
+    {
+        if (bam_cigar_opchr(cigar[i])=='S')
+        {
+            if (i==0)
+            {
+                qbeg0 = bam_cigar_oplen(cigar[i]);
+            }
+            else
+            {
+                qend0 = rlen - bam_cigar_oplen(cigar[i]);
+            }
+        }
+    }
+
+    //read offset of the variant for the cycle
+    int32_t rpos0 = 0;
+    for (int32_t i=0; i<n_cigar_op && vpos0==-1; ++i)
+    {
+        char opchr = bam_cigar_opchr(cigar[i]);
+        int32_t oplen = bam_cigar_oplen(cigar[i]);
+
+        if (opchr=='S' || opchr=='I')
+        {
+            rpos0 += oplen;
+        }
+        else if (opchr=='M' || opchr=='=' || opchr=='X')
+        {
+            if (g->pos1>=cpos1 && g->pos1<=cpos1+oplen-1)
+            {
+                vpos0 = rpos0 + g->pos1 - cpos1;
+            }
+            cpos1 += oplen;
+            rpos0 += oplen;
+        }
+        else if (opchr=='D' || opchr=='N')
+        {
+            if (g->pos1>=cpos1 && g->pos1<=cpos1+oplen-1)
+            {
+                vpos0 = rpos0;
+            }
+            cpos1 += oplen;
+        }
+    }
+    if (vpos0==-1) vpos0 = rpos0 ? rpos0-1 : 0;
+
+    if (qend0<=qbeg0)
+    {
+        return;
+    }
+
+    g->rl_reads.push_back(std::string());
+    g->rl_quals.push_back(std::string());
+    std::string& bases = g->rl_reads.back();
+    std::string& quals = g->rl_quals.back();
+    bases.resize(qend0-qbeg0);
+    quals.resize(qend0-qbeg0);
+    for (int32_t i=qbeg0; i<qend0; ++i)
+    {
+        bases[i-qbeg0] = bam_base2char(bam_seqi(seq, i));
+        quals[i-qbeg0] = qual[0]==0xFF ? 30 : qual[i];
+    }
+
+    if (as.beg1<g->rl_beg1) g->rl_beg1 = as.beg1;
+    if (as.end1>g->rl_end1) g->rl_end1 = as.end1;
+
+    g->cys.push_back(strand == 'F' ? (vpos0+1) : (rlen - vpos0));
+    g->sts.append(1, strand);
+    g->nms.push_back(as.no_mismatches);
+}
+
+/**
+ * Scores the kept reads against the reference and alternative
+ * haplotypes of a biallelic indel with the pair HMM and updates the
+ * allele statistics of the record.
+ *
+ * Returns false if there is nothing to realign.
+ */
+bool BCFGenotypingBufferedReader::realign_indel(GenotypingRecord *g, std::vector<uint32_t>& pls)
+{
+    if (!realign_indels || g->rl_reads.empty() || bcf_get_n_allele(g->v)!=2)
+    {
+        return false;
+    }
+
+    char** alleles = bcf_get_allele(g->v);
+    int32_t ref_len = strlen(alleles[0]);
+
+    //reference window covering all the reads with some padding
+    const char* chrom = bcf_get_chrom(odr->hdr, g->v);
+    int32_t wbeg1 = std::max(1, std::min(g->rl_beg1, g->pos1) - 10);
+    int32_t wend1 = std::max(g->rl_end1, g->pos1+ref_len-1) + 10;
+    int32_t wlen = 0;
+    char* window = faidx_fetch_uc_seq(fai, chrom, wbeg1-1, wend1-1, &wlen);
+    if (!window || wlen<g->pos1-wbeg1+ref_len)
+    {
+        if (window) free(window);
+        return false;
+    }
+
+    std::string haps[2];
+    haps[0].assign(window, wlen);
+    haps[1].assign(window, g->pos1-wbeg1);
+    haps[1].append(alleles[1]);
+    haps[1].append(window+g->pos1-wbeg1+ref_len, wlen-(g->pos1-wbeg1+ref_len));
+    for (size_t i=0; i<haps[1].size(); ++i) haps[1][i] = toupper(haps[1][i]);
+    free(window);
+
+    size_t no_reads = g->rl_reads.size();
+    std::vector<float> lls[2];
+    for (int32_t a=0; a<2; ++a)
+    {
+        lls[a].resize(no_reads);
+        phmm.forward(haps[a].c_str(), haps[a].size(), g->rl_reads, g->rl_quals, &lls[a][0]);
+    }
+
+    double pRR = 0;
+    double pRA = 0;
+    double pAA = 0;
+    for (size_t i=0; i<no_reads; ++i)
+    {
+        double l0 = lls[0][i];
+        double l1 = lls[1][i];
+
+        pRR += l0;
+        pRA += -0.30103+lt.log10sum(l0,l1);
+        pAA += l1;
+
+        //reads that do not discriminate between the haplotypes are not assigned
+        int32_t allele = -1;
+        double diff = fabs(l0-l1);
+        if (diff>=0.2)
+        {
+            allele = l1>l0 ? 1 : 0;
+        }
+
+        uint32_t q = std::min(60, (int32_t)(10*diff+0.5));
+        bool fwd = g->sts[i]=='F';
+
+        ++g->depth;
+        if (fwd) ++g->depth_fwd; else ++g->depth_rev;
+        if (allele>=0)
+        {
+            if (fwd) ++g->allele_depth_fwd[allele]; else ++g->allele_depth_rev[allele];
+        }
+        if (allele==1)
+        {
+            ++g->no_nonref;
+        }
+
+        g->base_qualities_sum += q;
+        g->aqs.push_back(q);
+        g->als.push_back(allele);
+        g->dls.append(1, allele==-1 ? '?' : 'A'+allele);
+    }
+
+    pls[0] = -10*pRR;
+    pls[1] = -10*pRA;
+    pls[2] = -10*pAA;
+
+    return true;
+}
+
 /**
  * Flush records.
  */
@@ -1859,12 +2037,12 @@ void BCFGenotypingBufferedReader::flush(BCFOrderedWriter* odw, bam_hdr_t *h, bam
         while (odr->read(v))
         {
             int32_t vtype = vm->classify_variant(odr->hdr, v, variant);
-            GenotypingRecord* g;
-            if (vtype==VT_INDEL)
+            if (vtype!=VT_INDEL)
             {
-                g = new IndelGenotypingRecord(odr->hdr, v, 10, 2);
+                continue;
             }
-            buffer.push_back(g);
+
+            buffer.push_back(new IndelGenotypingRecord(odr->hdr, v, 10, 2));
             v = bcf_init();
         }
         bcf_destroy(v);
@@ -2490,7 +2668,10 @@ void BCFGenotypingBufferedReader::genotype_and_print(BCFOrderedWriter* odw, Geno
         }
 
         std::vector<uint32_t> pls(3);
-        compute_indel_pl(g->als, g->aqs, 2, 2, pls);
+        if (!realign_indel(g, pls))
+        {
+            compute_indel_pl(g->als, g->aqs, 2, 2, pls);
+        }
 
         uint32_t min_pl = pls[0];
         uint32_t min_gt_index = 0;
@@ -33,7 +33,8 @@
 #include "variant_manip.h"
 #include "log_tool.h"
 #include "augmented_bam_record.h"
-#
+#include "pair_hmm.h"
+
 /**
  * Wrapper for BCFOrderedReader.
  *
@@ -57,12 +58,13 @@ class BCFGenotypingBufferedReader
     std::string chrom;
     AugmentedBAMRecord as;
 
-    Variant variant;
+    VariantClass variant;
 
     ///////////
     //options//
     ///////////
     bool output_annotations;
+    bool realign_indels;
 
     /////////
     //stats//
@@ -77,6 +79,7 @@ class BCFGenotypingBufferedReader
     VariantManip *vm;
     LogTool lt;
     faidx_t *fai;
+    PairHMM phmm;
 
     /**
      * Constructor.
@@ -121,6 +124,21 @@ class BCFGenotypingBufferedReader
      */
     void collect_sufficient_statistics(GenotypingRecord *g,  AugmentedBAMRecord& as);
 
+    /**
+     * Keeps the aligned part of a read for realignment against the
+     * candidate haplotypes of an indel.
+     */
+    void add_realignment_read(GenotypingRecord *g, AugmentedBAMRecord& as);
+
+    /**
+     * Scores the kept reads against the reference and alternative
+     * haplotypes of a biallelic indel with the pair HMM and updates the
+     * allele statistics of the record.
+     *
+     * Returns false if there is nothing to realign.
+     */
+    bool realign_indel(GenotypingRecord *g, std::vector<uint32_t>& pls);
+
     /**
      * Flush records.
      */
@@ -23,6 +23,9 @@
 
 #include "bcf_ordered_reader.h"
 
+VT_TIMER_STAT(read_stat, "bcf_ordered_reader.read");
+VT_COUNTER_STAT(records_stat, "bcf_ordered_reader.records");
+
 /**
  * Initialize files and intervals.
  *
@@ -50,13 +53,42 @@ BCFOrderedReader::BCFOrderedReader(std::string file_name, std::vector<GenomeInte
     idx = NULL;
     tbx = NULL;
     itr = NULL;
+    pipe = NULL;
 
     last_rid = -1;
     last_pos1 = 0;
 
+    unpack = 0;
+    max_unpack = 0;
+
+    parse_pool_checked = false;
+    parse_pool = NULL;
+    batch = NULL;
+    batch_index = 0;
+    lines_exhausted = false;
+
     this->intervals = intervals;
     interval_index = 0;
     index_loaded = false;
+    s = {0, 0, 0};
+    intervals_present =  intervals.size()!=0;
+
+    if (BCFPipe::is_pipe(this->file_name))
+    {
+        pipe = BCFPipe::get(this->file_name);
+        hdr = pipe->read_hdr();
+        ftype.format = bcf;
+        ftype.compression = no_compression;
+
+        if (intervals_present)
+        {
+            fprintf(stderr, "[%s:%d %s] no random access support for pipe: %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+            exit(1);
+        }
+
+        random_access_enabled = false;
+        return;
+    }
 
     file = hts_open(this->file_name.c_str(), "r");
     if (!file)
@@ -72,15 +104,17 @@ BCFOrderedReader::BCFOrderedReader(std::string file_name, std::vector<GenomeInte
         exit(1);
     }
 
-    s = {0, 0, 0};
+    if (VCFTextPool::threaded() && ftype.compression==bgzf)
+    {
+        hts_set_threads(file, VCFTextPool::no_threads);
+    }
+
     hdr = bcf_alt_hdr_read(file);
     if (!hdr) 
     {
         fprintf(stderr, "[%s:%d %s] Unable to read in header: %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
         exit(1);
     }
-   
-    intervals_present =  intervals.size()!=0;
 
     if (ftype.format==bcf)
     {
@@ -139,6 +173,8 @@ BCFOrderedReader::~BCFOrderedReader()
  */
 bool BCFOrderedReader::jump_to_interval(GenomeInterval& interval)
 {
+    reset_parse_pool();
+
     if (index_loaded)
     {
         intervals_present = true;
@@ -237,6 +273,34 @@ bool BCFOrderedReader::initialize_next_interval()
  */
 bool BCFOrderedReader::read(bcf1_t *v)
 {
+    VT_TIME(read_stat);
+    v->max_unpack = max_unpack;
+
+    //VCF lines are parsed by a pool of threads if --vcf-threads is set
+    if (ftype.format==vcf && !pipe)
+    {
+        if (!parse_pool_checked)
+        {
+            parse_pool_checked = true;
+            if (hdr->dirty && bcf_hdr_sync(hdr)<0)
+            {
+                fprintf(stderr, "[%s:%d %s] Cannot update header of %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+                exit(1);
+            }
+            parse_pool = VCFTextPool::create(hdr, true, max_unpack);
+        }
+
+        if (parse_pool)
+        {
+            if (read_parsed(v))
+            {
+                VT_COUNT(records_stat, 1);
+                return true;
+            }
+            return false;
+        }
+    }
+
     if (random_access_enabled)
     {
         if (ftype.format==bcf)
@@ -245,6 +309,10 @@ bool BCFOrderedReader::read(bcf1_t *v)
             {
                 if (itr && bcf_itr_next(file, itr, v)>=0)
                 {
+                    //bcf_itr_next does not subset samples
+                    if (hdr->keep_samples) bcf_subset_format(hdr, v);
+                    if (unpack) bcf_unpack(v, unpack);
+                    VT_COUNT(records_stat, 1);
                     return true;
                 }
                 else if (!initialize_next_interval())
@@ -260,6 +328,8 @@ bool BCFOrderedReader::read(bcf1_t *v)
                 if (itr && tbx_itr_next(file, tbx, itr, &s)>=0)
                 {
                     vcf_parse1(&s, hdr, v);
+                    if (unpack) bcf_unpack(v, unpack);
+                    VT_COUNT(records_stat, 1);
                     return true;
                 }
                 else if (!initialize_next_interval())
@@ -269,6 +339,19 @@ bool BCFOrderedReader::read(bcf1_t *v)
             }
         }
     }
+    else if (pipe)
+    {
+        if (pipe->read(v))
+        {
+            if (unpack) bcf_unpack(v, unpack);
+            VT_COUNT(records_stat, 1);
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
     else
     {
         if (bcf_read(file, hdr, v)==0)
@@ -285,7 +368,9 @@ bool BCFOrderedReader::read(bcf1_t *v)
 //                last_rid = bcf_get_rid(v);
 //                last_pos1 = bcf_get_pos1(v);
 //            }    
-            
+
+            if (unpack) bcf_unpack(v, unpack);
+            VT_COUNT(records_stat, 1);
             return true;
         }
         else
@@ -297,11 +382,161 @@ bool BCFOrderedReader::read(bcf1_t *v)
     return false;
 };
 
+/**
+ * Reads the next VCF line of the file or of the intervals.
+ */
+bool BCFOrderedReader::read_line(kstring_t *line)
+{
+    if (random_access_enabled)
+    {
+        while(true)
+        {
+            if (itr && tbx_itr_next(file, tbx, itr, line)>=0)
+            {
+                return true;
+            }
+            else if (!initialize_next_interval())
+            {
+                return false;
+            }
+        }
+    }
+
+    return hts_getline(file, KS_SEP_LINE, line)>=0;
+}
+
+/**
+ * Returns next vcf record parsed by the parse pool.
+ *
+ * The lines are read ahead in batches and parsed by the workers, the
+ * lines they flag are parsed here with the header of the tool.
+ */
+bool BCFOrderedReader::read_parsed(bcf1_t *v)
+{
+    while (true)
+    {
+        if (batch && batch_index<batch->n)
+        {
+            int32_t i = batch_index++;
+            bcf1_t *u = batch->records[i];
+
+            if (batch->failed[i])
+            {
+                int32_t no_ids = hdr->n[BCF_DT_ID];
+                int32_t no_contigs = hdr->n[BCF_DT_CTG];
+                u->max_unpack = max_unpack;
+                int32_t ret = vcf_parse1(&batch->lines[i], hdr, u);
+
+                if (hdr->n[BCF_DT_ID]!=no_ids || hdr->n[BCF_DT_CTG]!=no_contigs)
+                {
+                    parse_pool->update_hdr(hdr);
+                }
+
+                //as with bcf_read, a broken line ends the reading of an unindexed file
+                if (ret<0 && !random_access_enabled)
+                {
+                    return false;
+                }
+            }
+
+            //swap the contents so that the caller keeps its bcf1_t
+            bcf1_t t = *v;
+            *v = *u;
+            *u = t;
+
+            if (unpack) bcf_unpack(v, unpack);
+            return true;
+        }
+
+        if (batch)
+        {
+            parse_pool->recycle(batch);
+            batch = NULL;
+        }
+
+        while (!lines_exhausted && !parse_pool->full())
+        {
+            VCFTextBatch *b = parse_pool->get_batch();
+            size_t bytes = 0;
+            while (b->n<parse_pool->batch_size && bytes<parse_pool->batch_bytes)
+            {
+                if (!read_line(&b->lines[b->n]))
+                {
+                    lines_exhausted = true;
+                    break;
+                }
+                bytes += b->lines[b->n].l;
+                ++b->n;
+            }
+
+            if (b->n)
+            {
+                parse_pool->submit(b);
+            }
+            else
+            {
+                parse_pool->recycle(b);
+            }
+        }
+
+        batch = parse_pool->next();
+        batch_index = 0;
+        if (!batch)
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * Discards the lines read ahead into the parse pool.
+ */
+void BCFOrderedReader::reset_parse_pool()
+{
+    if (!parse_pool) return;
+
+    if (batch) parse_pool->recycle(batch);
+    batch = NULL;
+    while ((batch = parse_pool->next()))
+    {
+        parse_pool->recycle(batch);
+    }
+    lines_exhausted = false;
+}
+
+/**
+ * Declares the fields of a record that the tool uses.
+ */
+void BCFOrderedReader::set_required_fields(int32_t which, bool samples)
+{
+    unpack = which;
+    max_unpack = 0;
+
+    //records from a pipe are passed on with their samples
+    if (!samples && !(which&BCF_UN_FMT) && !pipe)
+    {
+        if (bcf_hdr_set_samples(hdr, NULL, 0))
+        {
+            fprintf(stderr, "[%s:%d %s] Cannot drop samples from %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+            exit(1);
+        }
+
+        //VCF lines are parsed only up to the required fields
+        max_unpack = which ? which : BCF_UN_STR;
+    }
+}
+
 /**
  * Closes the file.
  */
 void BCFOrderedReader::close()
 {
+    if (parse_pool)
+    {
+        reset_parse_pool();
+        delete parse_pool;
+        parse_pool = NULL;
+    }
     if (file && bcf_close(file))
     {
         fprintf(stderr, "[%s:%d %s] Cannot close %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
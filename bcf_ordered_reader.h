@@ -27,6 +27,10 @@
 #include "hts_utils.h"
 #include "utils.h"
 #include "genome_interval.h"
+#include "bcf_pipe.h"
+#include "vcf_text_pool.h"
+#include "htslib/kseq.h"
+#include "instrument.h"
 
 /**
  * A class for reading ordered VCF/BCF files.
@@ -45,6 +49,7 @@
  *
  * 1) Input is an unindexed file which is not necessarily ordered.
  * 2) Input is an indexed file
+ * 3) Input is a pipe from another tool within vt pipe
  *
  * This class hides the handling of indices from
  * the user and also allows for the selection of
@@ -64,6 +69,7 @@ class BCFOrderedReader
     hts_idx_t *idx;
     tbx_t *tbx;
     hts_itr_t *itr;
+    BCFPipe *pipe;
     bcf1_t *v;
 
     //for control
@@ -86,6 +92,17 @@ class BCFOrderedReader
     //shared objects for string manipulation
     kstring_t s;
 
+    //fields required by the tool, see set_required_fields
+    int32_t unpack;
+    int32_t max_unpack;
+
+    //parallel parsing of VCF lines, see VCFTextPool
+    bool parse_pool_checked;
+    VCFTextPool *parse_pool;
+    VCFTextBatch *batch;
+    int32_t batch_index;
+    bool lines_exhausted;
+
     /**
      * Initialize files and intervals.
      *
@@ -99,6 +116,22 @@ class BCFOrderedReader
      */
     ~BCFOrderedReader();
 
+    /**
+     * Declares the fields of a record that the tool uses.
+     *
+     * @which   - BCF_UN_STR, BCF_UN_FLT, BCF_UN_INFO, BCF_UN_SHR or BCF_UN_ALL,
+     *            records returned by read are unpacked up to this level.
+     * @samples - true if the per sample data is to be kept.  If false and
+     *            BCF_UN_FMT is not required, the header and records have no
+     *            samples: VCF lines are not parsed beyond the declared fields
+     *            and the per sample block of BCF records is dropped on reading.
+     *            Tools that write records out with their genotypes should
+     *            keep the samples, the FORMAT fields are then left packed.
+     *
+     * This must be called before the first record is read.
+     */
+    void set_required_fields(int32_t which, bool samples=true);
+
     /**
      * Jump to interval. Returns false if not successful.
      *
@@ -138,6 +171,21 @@ class BCFOrderedReader
     void close();
 
     private:
+
+    /**
+     * Reads the next VCF line of the file or of the intervals.
+     */
+    bool read_line(kstring_t *line);
+
+    /**
+     * Returns next vcf record parsed by the parse pool.
+     */
+    bool read_parsed(bcf1_t *v);
+
+    /**
+     * Discards the lines read ahead into the parse pool.
+     */
+    void reset_parse_pool();
 };
 
 #endif
@@ -23,11 +23,28 @@
 
 #include "bcf_ordered_writer.h"
 
+VT_TIMER_STAT(write_stat, "bcf_ordered_writer.write");
+VT_TIMER_STAT(encode_stat, "bcf_ordered_writer.encode");
+
 BCFOrderedWriter::BCFOrderedWriter(std::string output_vcf_file_name, int32_t window, int32_t compression)
 {
     this->file_name = output_vcf_file_name;
     this->window = window;
     file = NULL;
+    pipe = NULL;
+    format_pool_checked = false;
+    format_pool = NULL;
+    batch = NULL;
+    batch_bytes = 0;
+    hdr = bcf_hdr_init("w");
+    bcf_hdr_set_version(hdr, "VCFv4.2");
+    linked_hdr = false;
+
+    if (BCFPipe::is_pipe(file_name))
+    {
+        pipe = BCFPipe::get(file_name);
+        return;
+    }
 
     kstring_t mode = {0,0,0};
     kputc('w', &mode);
@@ -89,9 +106,10 @@ BCFOrderedWriter::BCFOrderedWriter(std::string output_vcf_file_name, int32_t win
         exit(1);
     }
 
-    hdr = bcf_hdr_init("w");
-    bcf_hdr_set_version(hdr, "VCFv4.2");
-    linked_hdr = false;
+    if (VCFTextPool::threaded() && file->format.compression==bgzf)
+    {
+        hts_set_threads(file, VCFTextPool::no_threads);
+    }
 }
 
 /**
@@ -125,7 +143,11 @@ void BCFOrderedWriter::link_hdr(bcf_hdr_t *hdr)
  */
 void BCFOrderedWriter::write_hdr()
 {
-    if (bcf_hdr_write(file, hdr))
+    if (pipe)
+    {
+        pipe->write_hdr(hdr);
+    }
+    else if (bcf_hdr_write(file, hdr))
     {
         fprintf(stderr, "[%s:%d %s] writing of header failed.\n",
                                           __FILE__,
@@ -140,6 +162,8 @@ void BCFOrderedWriter::write_hdr()
  */
 void BCFOrderedWriter::write(bcf1_t *v)
 {
+    VT_TIME(write_stat);
+
     //place into appropriate position in the buffer
     if (window)
     {
@@ -197,14 +221,27 @@ void BCFOrderedWriter::write(bcf1_t *v)
     }
     else
     {
+        //the record remains owned by the caller
+        if (pipe)
+        {
+            pipe->write(bcf_copy(pipe->get_bcf1(), v));
+        }
+        else if (use_format_pool())
+        {
+            write_formatted(v, true);
+        }
         //todo:  add a mechanism to populate header similar to vcf_parse in vcf_format which is called by bcf_write
-        if (bcf_write(file, hdr, v))
+        else
         {
-            fprintf(stderr, "[%s:%d %s] writing of VCF record failed.\n",
-                                              __FILE__,
-                                              __LINE__,
-                                              __FUNCTION__);
-            exit(1);
+            VT_TIME(encode_stat);
+            if (bcf_write(file, hdr, v))
+            {
+                fprintf(stderr, "[%s:%d %s] writing of VCF record failed.\n",
+                                                  __FILE__,
+                                                  __LINE__,
+                                                  __FUNCTION__);
+                exit(1);
+            }
         }
     }
 }
@@ -215,6 +252,7 @@ void BCFOrderedWriter::write(bcf1_t *v)
 void BCFOrderedWriter::flush()
 {
     flush(true);
+    drain_format_pool();
 }
 
 /**
@@ -238,6 +276,10 @@ bcf1_t* BCFOrderedWriter::get_bcf1_from_pool()
         pool.pop_front();
         return v;
     }
+    else if (pipe)
+    {
+        return pipe->get_bcf1();
+    }
     else
     {
         bcf1_t* v = bcf_init();
@@ -255,16 +297,7 @@ void BCFOrderedWriter::flush(bool force)
     {
         while (!buffer.empty())
         {
-            if (bcf_write(file, hdr, buffer.back()))
-            {
-                fprintf(stderr, "[%s:%d %s] writing of VCF record failed.\n",
-                                                  __FILE__,
-                                                  __LINE__,
-                                                  __FUNCTION__);
-                exit(1);
-            }
-            bcf_destroy(buffer.back());
-            //store_bcf1_into_pool(buffer.back());
+            write_buffered(buffer.back());
             buffer.pop_back();
         }
     }
@@ -278,16 +311,7 @@ void BCFOrderedWriter::flush(bool force)
             {
                 if (bcf_get_pos1(buffer.back())<=cutoff_pos1)
                 {
-                    if (bcf_write(file, hdr, buffer.back()))
-                    {
-                        fprintf(stderr, "[%s:%d %s] writing of VCF record failed.\n",
-                                                          __FILE__,
-                                                          __LINE__,
-                                                          __FUNCTION__);
-                        exit(1);
-                    }
-                    bcf_destroy(buffer.back());
-                    //store_bcf1_into_pool(buffer.back());
+                    write_buffered(buffer.back());
                     buffer.pop_back();
                 }
                 else
@@ -299,13 +323,158 @@ void BCFOrderedWriter::flush(bool force)
     }
 }
 
+/**
+ * Writes out a buffered record and frees it.
+ */
+void BCFOrderedWriter::write_buffered(bcf1_t *v)
+{
+    if (pipe)
+    {
+        pipe->write(v);
+        return;
+    }
+
+    if (use_format_pool())
+    {
+        write_formatted(v, false);
+        return;
+    }
+
+    {
+        VT_TIME(encode_stat);
+        if (bcf_write(file, hdr, v))
+        {
+            fprintf(stderr, "[%s:%d %s] writing of VCF record failed.\n",
+                                              __FILE__,
+                                              __LINE__,
+                                              __FUNCTION__);
+            exit(1);
+        }
+    }
+    bcf_destroy(v);
+    //store_bcf1_into_pool(v);
+}
+
+/**
+ * Returns true if records are formatted by the format pool, starts it on the first call.
+ */
+bool BCFOrderedWriter::use_format_pool()
+{
+    if (!format_pool_checked)
+    {
+        format_pool_checked = true;
+        if (file && (file->format.format==vcf || file->format.format==text_format))
+        {
+            if (hdr->dirty && bcf_hdr_sync(hdr)<0)
+            {
+                fprintf(stderr, "[%s:%d %s] Cannot update header of %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+                exit(1);
+            }
+            format_pool = VCFTextPool::create(hdr, false);
+        }
+    }
+
+    return format_pool!=NULL;
+}
+
+/**
+ * Queues a record for the format pool, the record is copied if copy is
+ * true, otherwise its content is taken over and it is freed.
+ */
+void BCFOrderedWriter::write_formatted(bcf1_t *v, bool copy)
+{
+    if (!batch)
+    {
+        batch = format_pool->get_batch();
+        batch_bytes = 0;
+    }
+
+    bcf1_t *u = batch->records[batch->n++];
+    if (copy)
+    {
+        bcf_copy(u, v);
+    }
+    else
+    {
+        bcf1_t t = *v;
+        *v = *u;
+        *u = t;
+        bcf_destroy(v);
+    }
+    batch_bytes += u->shared.l + u->indiv.l;
+
+    if (batch->n==format_pool->batch_size || batch_bytes>=format_pool->batch_bytes)
+    {
+        format_pool->submit(batch);
+        batch = NULL;
+
+        while (format_pool->full())
+        {
+            write_batch(format_pool->next());
+        }
+    }
+}
+
+/**
+ * Writes out the lines of a formatted batch.
+ */
+void BCFOrderedWriter::write_batch(VCFTextBatch *b)
+{
+    VT_TIME(encode_stat);
+    for (int32_t i=0; i<b->n; ++i)
+    {
+        //records the workers could not format are written with the header of the tool
+        if (b->failed[i] ? bcf_write(file, hdr, b->records[i]) : vcf_write_line(file, &b->lines[i]))
+        {
+            fprintf(stderr, "[%s:%d %s] writing of VCF record failed.\n",
+                                              __FILE__,
+                                              __LINE__,
+                                              __FUNCTION__);
+            exit(1);
+        }
+    }
+    format_pool->recycle(b);
+}
+
+/**
+ * Writes out all the records queued in the format pool.
+ */
+void BCFOrderedWriter::drain_format_pool()
+{
+    if (!format_pool) return;
+
+    if (batch)
+    {
+        if (batch->n)
+        {
+            format_pool->submit(batch);
+        }
+        else
+        {
+            format_pool->recycle(batch);
+        }
+        batch = NULL;
+    }
+
+    VCFTextBatch *b;
+    while ((b = format_pool->next()))
+    {
+        write_batch(b);
+    }
+}
+
 /**
  * Closes the file.
  */
 void BCFOrderedWriter::close()
 {
     flush(true);
-    bcf_close(file);
+    drain_format_pool();
+    delete format_pool;
+    format_pool = NULL;
+    //the end of a pipe is signalled by vt pipe when the tool returns
+    if (file) bcf_close(file);
+    file = NULL;
     if (!linked_hdr && hdr) bcf_hdr_destroy(hdr);
 //    while (buffer.size()!=0)
 //    {
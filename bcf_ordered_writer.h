@@ -26,6 +26,9 @@
 
 #include "hts_utils.h"
 #include "utils.h"
+#include "bcf_pipe.h"
+#include "vcf_text_pool.h"
+#include "instrument.h"
 
 /**
  * A class for writing ordered VCF/BCF files.
@@ -35,6 +38,8 @@
  * instead of sorting the VCF wholesale, this class buffers the output
  * and sorts locally in a 10K base pair region before writing the records
  * out.
+ *
+ * The output may also be a pipe to another tool within vt pipe.
  */
 class BCFOrderedWriter
 {
@@ -45,6 +50,7 @@ class BCFOrderedWriter
     ///////
     std::string file_name;
     vcfFile *file;
+    BCFPipe *pipe;
     bcf_hdr_t *hdr;
     bool linked_hdr;
 
@@ -54,6 +60,12 @@ class BCFOrderedWriter
 
     int32_t window;
 
+    //parallel formatting of VCF records, see VCFTextPool
+    bool format_pool_checked;
+    VCFTextPool *format_pool;
+    VCFTextBatch *batch;
+    size_t batch_bytes;
+
     /**
      * Initialize output file.
      * @output_vcf_file
@@ -111,6 +123,32 @@ class BCFOrderedWriter
      * Flush writable records from buffer.
      */
     void flush(bool force);
+
+    /**
+     * Writes out a buffered record and frees it.
+     */
+    void write_buffered(bcf1_t *v);
+
+    /**
+     * Returns true if records are formatted by the format pool, starts it on the first call.
+     */
+    bool use_format_pool();
+
+    /**
+     * Queues a record for the format pool, the record is copied if copy is
+     * true, otherwise its content is taken over and it is freed.
+     */
+    void write_formatted(bcf1_t *v, bool copy);
+
+    /**
+     * Writes out the lines of a formatted batch.
+     */
+    void write_batch(VCFTextBatch *b);
+
+    /**
+     * Writes out all the records queued in the format pool.
+     */
+    void drain_format_pool();
 };
 
 #endif
\ No newline at end of file
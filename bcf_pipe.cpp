@@ -0,0 +1,221 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "bcf_pipe.h"
+
+std::mutex BCFPipe::registry_lock;
+std::map<std::string, BCFPipe*> BCFPipe::registry;
+int32_t BCFPipe::no_pipes = 0;
+
+/**
+ * Creates and registers a pipe, at most capacity records are buffered.
+ */
+BCFPipe::BCFPipe(int32_t capacity)
+{
+    this->capacity = capacity>0 ? capacity : 1;
+    hdr = NULL;
+    closed = false;
+    no_records = 0;
+
+    std::unique_lock<std::mutex> l(registry_lock);
+    kstring_t s = {0,0,0};
+    ksprintf(&s, "pipe:%d", no_pipes++);
+    name = std::string(s.s);
+    free(s.s);
+    registry[name] = this;
+}
+
+/**
+ * Unregisters the pipe and frees the remaining records.
+ */
+BCFPipe::~BCFPipe()
+{
+    {
+        std::unique_lock<std::mutex> l(registry_lock);
+        registry.erase(name);
+    }
+
+    for (size_t i=0; i<records.size(); ++i) bcf_destroy(records[i]);
+    for (size_t i=0; i<recycled.size(); ++i) bcf_destroy(recycled[i]);
+    if (hdr) bcf_hdr_destroy(hdr);
+}
+
+/**
+ * Returns true if name refers to a pipe.
+ */
+bool BCFPipe::is_pipe(const std::string& name)
+{
+    return name.compare(0, 5, "pipe:")==0;
+}
+
+/**
+ * Gets a registered pipe, exits if it does not exist.
+ */
+BCFPipe* BCFPipe::get(const std::string& name)
+{
+    std::unique_lock<std::mutex> l(registry_lock);
+    std::map<std::string, BCFPipe*>::iterator i = registry.find(name);
+    if (i==registry.end())
+    {
+        fprintf(stderr, "[%s:%d %s] %s does not exist, pipes are only available within vt pipe\n", __FILE__, __LINE__, __FUNCTION__, name.c_str());
+        exit(1);
+    }
+
+    return i->second;
+}
+
+/**
+ * Hands over a copy of the header.
+ */
+void BCFPipe::write_hdr(bcf_hdr_t *hdr)
+{
+    if (hdr->dirty && bcf_hdr_sync(hdr)<0)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot update header for %s\n", __FILE__, __LINE__, __FUNCTION__, name.c_str());
+        exit(1);
+    }
+    bcf_hdr_t *h = bcf_hdr_dup(hdr);
+
+    std::unique_lock<std::mutex> l(lock);
+    if (this->hdr)
+    {
+        fprintf(stderr, "[%s:%d %s] header written twice to %s\n", __FILE__, __LINE__, __FUNCTION__, name.c_str());
+        exit(1);
+    }
+    this->hdr = h;
+    not_empty.notify_all();
+}
+
+/**
+ * Blocks until the header is written and returns a copy owned by the caller.
+ */
+bcf_hdr_t* BCFPipe::read_hdr()
+{
+    wait_hdr();
+    std::unique_lock<std::mutex> l(lock);
+    return bcf_hdr_dup(hdr);
+}
+
+/**
+ * Blocks until the header is written.
+ */
+void BCFPipe::wait_hdr()
+{
+    std::unique_lock<std::mutex> l(lock);
+    while (!hdr && !closed)
+    {
+        not_empty.wait(l);
+    }
+
+    if (!hdr)
+    {
+        fprintf(stderr, "[%s:%d %s] no header written to %s\n", __FILE__, __LINE__, __FUNCTION__, name.c_str());
+        exit(1);
+    }
+}
+
+/**
+ * Queues a record, the pipe takes ownership of v.  Blocks while the pipe is full.
+ */
+void BCFPipe::write(bcf1_t *v)
+{
+    std::unique_lock<std::mutex> l(lock);
+    while ((int32_t)records.size()>=capacity)
+    {
+        not_full.wait(l);
+    }
+
+    records.push_back(v);
+    ++no_records;
+    not_empty.notify_one();
+}
+
+/**
+ * Moves the next record into v, the previous content of v is recycled.
+ * Blocks while the pipe is empty, returns false at the end of the records.
+ */
+bool BCFPipe::read(bcf1_t *v)
+{
+    std::unique_lock<std::mutex> l(lock);
+    while (records.empty() && !closed)
+    {
+        not_empty.wait(l);
+    }
+
+    if (records.empty())
+    {
+        return false;
+    }
+
+    bcf1_t *u = records.front();
+    records.pop_front();
+    not_full.notify_one();
+    l.unlock();
+
+    //swap the contents so that the caller keeps its bcf1_t
+    bcf1_t t = *v;
+    *v = *u;
+    *u = t;
+    bcf_clear(u);
+
+    l.lock();
+    if ((int32_t)recycled.size()<capacity)
+    {
+        recycled.push_back(u);
+    }
+    else
+    {
+        bcf_destroy(u);
+    }
+
+    return true;
+}
+
+/**
+ * Gets a recycled record, creates a new record if necessary.
+ */
+bcf1_t* BCFPipe::get_bcf1()
+{
+    {
+        std::unique_lock<std::mutex> l(lock);
+        if (!recycled.empty())
+        {
+            bcf1_t *v = recycled.back();
+            recycled.pop_back();
+            return v;
+        }
+    }
+
+    bcf1_t *v = bcf_init();
+    bcf_clear(v);
+    return v;
+}
+
+/**
+ * Signals the end of the records.
+ */
+void BCFPipe::close()
+{
+    std::unique_lock<std::mutex> l(lock);
+    closed = true;
+    not_empty.notify_all();
+}
@@ -0,0 +1,130 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#ifndef BCF_PIPE_H
+#define BCF_PIPE_H
+
+#include <deque>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include "hts_utils.h"
+
+/**
+ * A bounded in process channel of VCF records between two tools.
+ *
+ * A pipe is registered under a name of the form pipe:<n> which is
+ * accepted in place of a file name by BCFOrderedWriter, BCFOrderedReader
+ * and BCFSyncedReader.  The writer hands over its header and decoded
+ * records, the reader receives them without the records being
+ * serialized, compressed or parsed again.  The records read are
+ * recycled back to the writer.
+ *
+ * The writing tool does not signal the end of the records when it closes
+ * its writer, the owner of the pipe calls close when the writing tool
+ * has returned so that the summaries of the tools are printed in order.
+ */
+class BCFPipe
+{
+    public:
+
+    std::string name;
+
+    //no. of records written
+    uint64_t no_records;
+
+    /**
+     * Creates and registers a pipe, at most capacity records are buffered.
+     */
+    BCFPipe(int32_t capacity=1000);
+
+    /**
+     * Unregisters the pipe and frees the remaining records.
+     */
+    ~BCFPipe();
+
+    /**
+     * Returns true if name refers to a pipe.
+     */
+    static bool is_pipe(const std::string& name);
+
+    /**
+     * Gets a registered pipe, exits if it does not exist.
+     */
+    static BCFPipe* get(const std::string& name);
+
+    /**
+     * Hands over a copy of the header.
+     */
+    void write_hdr(bcf_hdr_t *hdr);
+
+    /**
+     * Blocks until the header is written and returns a copy owned by the caller.
+     */
+    bcf_hdr_t* read_hdr();
+
+    /**
+     * Blocks until the header is written.
+     */
+    void wait_hdr();
+
+    /**
+     * Queues a record, the pipe takes ownership of v.  Blocks while the pipe is full.
+     */
+    void write(bcf1_t *v);
+
+    /**
+     * Moves the next record into v, the previous content of v is recycled.
+     * Blocks while the pipe is empty, returns false at the end of the records.
+     */
+    bool read(bcf1_t *v);
+
+    /**
+     * Gets a recycled record, creates a new record if necessary.
+     */
+    bcf1_t* get_bcf1();
+
+    /**
+     * Signals the end of the records.
+     */
+    void close();
+
+    private:
+
+    int32_t capacity;
+    bcf_hdr_t *hdr;
+    bool closed;
+
+    std::deque<bcf1_t*> records;
+    std::vector<bcf1_t*> recycled;
+
+    std::mutex lock;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+
+    static std::mutex registry_lock;
+    static std::map<std::string, BCFPipe*> registry;
+    static int32_t no_pipes;
+};
+
+#endif
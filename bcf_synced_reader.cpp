@@ -23,6 +23,8 @@
 
 #include "bcf_synced_reader.h"
 
+VT_COUNTER_STAT(records_stat, "bcf_synced_reader.records");
+
 /**
  * Constructor.
  *
@@ -33,6 +35,7 @@ BCFSyncedReader::BCFSyncedReader(std::vector<std::string>& file_names, std::vect
 {
     nfiles = file_names.size();
     files.resize(nfiles, 0);
+    pipes.resize(nfiles, 0);
     hdrs.resize(nfiles, 0);
     idxs.resize(nfiles, 0);
     tbxs.resize(nfiles, 0);
@@ -45,7 +48,13 @@ BCFSyncedReader::BCFSyncedReader(std::vector<std::string>& file_names, std::vect
     buffer.resize(nfiles);
     s = {0, 0, 0};
 
+    unpack = BCF_UN_STR;
+    max_unpack = 0;
+    samples = true;
+
     random_access = (intervals.size()!=0);
+    exclusive = false;
+    interval_start1 = 0;
     for (size_t i=0; i<intervals.size(); ++i)
     {
         intervals_map[intervals[i].to_string()] = i;
@@ -74,35 +83,51 @@ BCFSyncedReader::BCFSyncedReader(std::vector<std::string>& file_names, std::vect
             exit(1);
         }
 
-        files[i] = hts_open(file_names[i].c_str(), "r");
-        if (files[i]==NULL)
+        if (BCFPipe::is_pipe(file_names[i]))
         {
-            fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
-            exit(1);
-//            toexit = true;        
-        }
-        ftypes[i] = files[i]->format;
+            if (random_access)
+            {
+                fprintf(stderr, "[E:%s:%d %s] no random access support for pipe: %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+                exit(1);
+            }
 
-        //check format
-        if (ftypes[i].format!=vcf && ftypes[i].format!=bcf)
-        {
-            fprintf(stderr, "[E:%s:%d %s] %s not a VCF or BCF file\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
-            exit(1);
+            pipes[i] = BCFPipe::get(file_names[i]);
+            hdrs[i] = pipes[i]->read_hdr();
+            ftypes[i].format = bcf;
+            ftypes[i].compression = no_compression;
         }
-
-        //read header
-        hdrs[i] = bcf_alt_hdr_read(files[i]);
-        if (!hdrs[i])
+        else
         {
-            fprintf(stderr, "[E:%s:%d %s] header cannot be read for %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
-            exit(1);
-        }
+            files[i] = hts_open(file_names[i].c_str(), "r");
+            if (files[i]==NULL)
+            {
+                fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+                exit(1);
+//                toexit = true;        
+            }
+            ftypes[i] = files[i]->format;
 
-        //load index if intervals are specified
-        if (random_access && !load_index(i))
-        {
-            fprintf(stderr, "[E:%s:%d %s] index cannot be loaded for %s for random access\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
-            exit(1);
+            //check format
+            if (ftypes[i].format!=vcf && ftypes[i].format!=bcf)
+            {
+                fprintf(stderr, "[E:%s:%d %s] %s not a VCF or BCF file\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+                exit(1);
+            }
+
+            //read header
+            hdrs[i] = bcf_alt_hdr_read(files[i]);
+            if (!hdrs[i])
+            {
+                fprintf(stderr, "[E:%s:%d %s] header cannot be read for %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+                exit(1);
+            }
+
+            //load index if intervals are specified
+            if (random_access && !load_index(i))
+            {
+                fprintf(stderr, "[E:%s:%d %s] index cannot be loaded for %s for random access\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+                exit(1);
+            }
         }
 
         //check contigs consistency
@@ -282,7 +307,7 @@ void BCFSyncedReader::close()
 {
     for (size_t i=0; i<nfiles; ++i)
     {
-        bcf_close(files[i]);
+        if (files[i]) bcf_close(files[i]);
         bcf_hdr_destroy(hdrs[i]);
         if (idxs[i]) hts_idx_destroy(idxs[i]);
         if (tbxs[i]) tbx_destroy(tbxs[i]);
@@ -297,10 +322,67 @@ void BCFSyncedReader::close()
 }
 
 /**
- * Inserts a record into pq.
+ * Declares the fields of a record that the tool uses.
+ */
+void BCFSyncedReader::set_required_fields(int32_t which, bool samples)
+{
+    unpack = which|BCF_UN_STR;
+    max_unpack = 0;
+    this->samples = samples;
+
+    if (!samples && !(which&BCF_UN_FMT))
+    {
+        for (int32_t i=0; i<nfiles; ++i)
+        {
+            if (bcf_hdr_set_samples(hdrs[i], NULL, 0))
+            {
+                fprintf(stderr, "[E:%s:%d %s] cannot drop samples from %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+                exit(1);
+            }
+        }
+
+        //VCF lines are parsed only up to the required fields
+        max_unpack = unpack;
+    }
+}
+
+/**
+ * Restarts reading on a new list of intervals.
+ */
+void BCFSyncedReader::set_intervals(std::vector<GenomeInterval>& intervals, bool exclusive)
+{
+    if (pq.size()!=0)
+    {
+        fprintf(stderr, "[E:%s:%d %s] intervals reset before all records are read\n", __FILE__, __LINE__, __FUNCTION__);
+        exit(1);
+    }
+
+    for (size_t i=0; i<nfiles; ++i)
+    {
+        if (!random_access && (!load_index(i) || (!idxs[i] && !tbxs[i])))
+        {
+            fprintf(stderr, "[E:%s:%d %s] index cannot be loaded for %s for random access\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+            exit(1);
+        }
+    }
+    random_access = true;
+
+    this->intervals = intervals;
+    intervals_map.clear();
+    for (size_t i=0; i<intervals.size(); ++i)
+    {
+        intervals_map[intervals[i].to_string()] = i;
+    }
+    intervals_index = 0;
+    this->exclusive = exclusive;
+}
+
+/**
+ * Inserts a record into pq, every record read passes through here.
  */
 void BCFSyncedReader::insert_into_pq(int32_t i, bcf1_t *v)
 {
+    VT_COUNT(records_stat, 1);
     pq.push(new bcfptr(i, bcf_get_rid(v), bcf_get_pos1(v), hdrs[i], v, sync_by_pos));
 }
 
@@ -314,12 +396,14 @@ bcf1_t* BCFSyncedReader::get_bcf1_from_pool()
         bcf1_t* v = pool.front();
         pool.pop_front();
         bcf_clear(v);
+        v->max_unpack = max_unpack;
         return v;
     }
     else
     {
         bcf1_t* v = bcf_init1();
         bcf_clear(v);
+        v->max_unpack = max_unpack;
         return v;
     }
 }
@@ -423,15 +507,34 @@ bool BCFSyncedReader::read_next_position(std::vector<bcfptr*>& current_recs)
             }
         }
 
+        last_recs = current_recs;
         return true;
     }
     else
     {
         //end of contig or eof for all files
+        last_recs.clear();
         return false;
     }
 }
 
+/**
+ * Returns the index of the file a record of the current position was read from,
+ * -1 if the record was not returned by the last read_next_position.
+ */
+int32_t BCFSyncedReader::get_file_index(bcf1_t* v)
+{
+    for (size_t i=0; i<last_recs.size(); ++i)
+    {
+        if (last_recs[i]->v==v)
+        {
+            return last_recs[i]->file_index;
+        }
+    }
+
+    return -1;
+}
+
 /**
  * Initialize buffer for next interval.
  * This should only be invoked if the buffer is empty.
@@ -444,6 +547,7 @@ bool BCFSyncedReader::initialize_next_interval()
         while (intervals_index < intervals.size())
         {
             GenomeInterval interval = intervals[intervals_index++];
+            interval_start1 = interval.start1;
 
             for (size_t i=0; i<nfiles; ++i)
             {
@@ -511,8 +615,15 @@ void BCFSyncedReader::fill_buffer(int32_t i)
 
             while (itrs[i] && bcf_itr_next(files[i], itrs[i], v)>=0)
             {
+                if (exclusive && bcf_get_pos1(v)<interval_start1)
+                {
+                    continue;
+                }
+
                 populated = true;
-                bcf_unpack(v, BCF_UN_STR);
+                //bcf_itr_next does not subset samples
+                if (hdrs[i]->keep_samples) bcf_subset_format(hdrs[i], v);
+                bcf_unpack(v, unpack);
                 
                 //check to ensure order
                 if (!buffer[i].empty())
@@ -551,7 +662,13 @@ void BCFSyncedReader::fill_buffer(int32_t i)
                 bcf1_t *v = get_bcf1_from_pool();
                 vcf_parse(&s, hdrs[i], v);
 
-                bcf_unpack(v, BCF_UN_STR);
+                if (exclusive && bcf_get_pos1(v)<interval_start1)
+                {
+                    store_bcf1_into_pool(v);
+                    continue;
+                }
+
+                bcf_unpack(v, unpack);
                 
                 //check to ensure order
                 if (!buffer[i].empty())
@@ -586,10 +703,10 @@ void BCFSyncedReader::fill_buffer(int32_t i)
         bcf1_t *v = get_bcf1_from_pool();
         bool populated = false;
 
-        while (bcf_read(files[i], hdrs[i], v)>=0)
+        while (pipes[i] ? pipes[i]->read(v) : bcf_read(files[i], hdrs[i], v)>=0)
         {
             populated = true;
-            bcf_unpack(v, BCF_UN_STR);
+            bcf_unpack(v, unpack);
             
             //check to ensure order
             if (!buffer[i].empty())
@@ -27,6 +27,7 @@
 #include "hts_utils.h"
 #include "utils.h"
 #include "genome_interval.h"
+#include "bcf_pipe.h"
 
 #define SYNC_BY_POS true
 #define SYNC_BY_VAR false
@@ -153,6 +154,7 @@ class BCFSyncedReader
     ///////
     std::vector<std::string> file_names; //file names
     std::vector<vcfFile *> files; //file objects
+    std::vector<BCFPipe *> pipes; //pipes from other tools within vt pipe
     std::vector<bcf_hdr_t *> hdrs; // headers
     std::vector<hts_idx_t *> idxs; // indices
     std::vector<tbx_t *> tbxs; // for tabix
@@ -167,6 +169,10 @@ class BCFSyncedReader
     uint32_t intervals_index;
     bool random_access;
 
+    //only records starting in the current interval are read, see set_intervals
+    bool exclusive;
+    int32_t interval_start1;
+
     //variables for keeping track of status
     std::string current_interval;
     int32_t current_rid;
@@ -178,12 +184,19 @@ class BCFSyncedReader
     //generic useful string
     kstring_t s;
 
+    //fields required by the tool, see set_required_fields
+    int32_t unpack;
+    int32_t max_unpack;
+    bool samples;
+
     //buffer for records in use, this is indexed by the file index
     std::vector<std::list<bcf1_t *> > buffer;
     //empty records that can be reused
     std::list<bcf1_t *> pool;
     //contains the most recent position to process
     std::priority_queue<bcfptr *, std::vector<bcfptr *>, CompareBCFPtr> pq;
+    //records returned by the last read_next_position
+    std::vector<bcfptr *> last_recs;
 
     //useful stuff
 
@@ -197,12 +210,43 @@ class BCFSyncedReader
      */
     int32_t bcfptr_cmp(bcfptr *a, bcfptr *b);
 
+    /**
+     * Declares the fields of a record that the tool uses.
+     *
+     * @which   - BCF_UN_STR, BCF_UN_FLT, BCF_UN_INFO, BCF_UN_SHR or BCF_UN_ALL,
+     *            buffered records are unpacked up to this level, at least BCF_UN_STR.
+     * @samples - true if the per sample data is to be kept.  If false and
+     *            BCF_UN_FMT is not required, the header and records have no
+     *            samples: VCF lines are not parsed beyond the declared fields
+     *            and the per sample block of BCF records is dropped on reading.
+     *            Tools that write records out with their genotypes should
+     *            keep the samples, the FORMAT fields are then left packed.
+     *
+     * This applies to all the files and must be called before the first record is read.
+     */
+    void set_required_fields(int32_t which, bool samples=true);
+
+    /**
+     * Restarts reading on a new list of intervals, the files must be indexed.
+     * If exclusive is true, records overlapping an interval but starting before
+     * it are skipped so that adjacent intervals partition the records.
+     *
+     * This may only be called once all the records of the previous intervals are read.
+     */
+    void set_intervals(std::vector<GenomeInterval>& intervals, bool exclusive=false);
+
     /**
      * Returns list of files that have variants at a certain position.
      *
      */
     bool read_next_position(std::vector<bcfptr*>& current_recs);
 
+    /**
+     * Returns the index of the file a record of the current position was read from,
+     * -1 if the record was not returned by the last read_next_position.
+     */
+    int32_t get_file_index(bcf1_t* v);
+
     /**
      * Populate sequence names from files.
      */
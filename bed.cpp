@@ -98,4 +98,106 @@ std::string BEDRecord::to_string()
     std::string str(s.s);
     if (s.m) free(s.s);
     return str;
-};
\ No newline at end of file
+};
+
+std::map<std::string, BEDTrack*> BEDTrack::tracks;
+std::mutex BEDTrack::tracks_mutex;
+
+/**
+ * Reads all regions of an indexed BED file.
+ */
+BEDTrack::BEDTrack(std::string& file)
+{
+    this->file = file;
+    no_users = 0;
+
+    TBXOrderedReader todr(file, true);
+    int32_t n = 0;
+    const char** names = todr.tbx ? tbx_seqnames(todr.tbx, &n) : NULL;
+    regions.resize(n);
+
+    kstring_t line = {0,0,0};
+    for (int32_t tid=0; tid<n; ++tid)
+    {
+        name2tid[std::string(names[tid])] = tid;
+
+        hts_itr_t* itr = tbx_itr_queryi(todr.tbx, tid, 0, HTS_POS_MAX);
+        if (!itr) continue;
+
+        while (tbx_itr_next(todr.hts, todr.tbx, itr, &line)>=0)
+        {
+            BEDRecord br(&line);
+            regions[tid].push_back(Interval(br.beg1, br.end1));
+        }
+        tbx_itr_destroy(itr);
+    }
+
+    if (line.m) free(line.s);
+    free(names);
+    todr.close();
+};
+
+/**
+ * Returns a shared handle to the track in file, reading it on first use.
+ */
+BEDTrack* BEDTrack::acquire(std::string& file)
+{
+    std::lock_guard<std::mutex> lock(tracks_mutex);
+
+    //the same file may be named by different paths
+    std::string path = canonical_path(file);
+
+    BEDTrack* track;
+    std::map<std::string, BEDTrack*>::iterator i = tracks.find(path);
+    if (i==tracks.end())
+    {
+        track = new BEDTrack(path);
+        tracks[path] = track;
+    }
+    else
+    {
+        track = i->second;
+    }
+
+    ++track->no_users;
+    return track;
+};
+
+/**
+ * Returns a shared handle to the track in file if it is held, NULL otherwise.
+ */
+BEDTrack* BEDTrack::lookup(std::string& file)
+{
+    std::lock_guard<std::mutex> lock(tracks_mutex);
+
+    if (tracks.empty()) return NULL;
+
+    std::map<std::string, BEDTrack*>::iterator i = tracks.find(canonical_path(file));
+    if (i==tracks.end()) return NULL;
+
+    ++i->second->no_users;
+    return i->second;
+};
+
+/**
+ * Releases a handle obtained with acquire or lookup, the track is freed when it is no longer used.
+ */
+void BEDTrack::release(BEDTrack* track)
+{
+    std::lock_guard<std::mutex> lock(tracks_mutex);
+
+    if (--track->no_users==0)
+    {
+        tracks.erase(track->file);
+        delete track;
+    }
+};
+
+/**
+ * Gets the contig of the track named chrom, -1 if absent.
+ */
+int32_t BEDTrack::get_tid(const char* chrom)
+{
+    std::map<std::string, int32_t>::iterator i = name2tid.find(std::string(chrom));
+    return i==name2tid.end() ? -1 : i->second;
+};
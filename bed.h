@@ -24,9 +24,11 @@
 #ifndef BED_H
 #define BED_H
 
+#include <mutex>
 #include "hts_utils.h"
 #include "utils.h"
 #include "interval.h"
+#include "tbx_ordered_reader.h"
 
 class BEDRecord
 {
@@ -67,4 +69,49 @@ class BEDRecord
     private:
 };
 
+/**
+ * Regions of an indexed BED file held in memory by contig.
+ *
+ * vt serve keeps tracks resident with acquire, overlap matchers in its
+ * jobs pick them up with lookup instead of reading the file.
+ */
+class BEDTrack
+{
+    public:
+    std::string file;
+    std::map<std::string, int32_t> name2tid;
+    std::vector<std::vector<Interval> > regions;
+
+    /**
+     * Returns a shared handle to the track in file, reading it on first use.
+     */
+    static BEDTrack* acquire(std::string& file);
+
+    /**
+     * Returns a shared handle to the track in file if it is held, NULL otherwise.
+     */
+    static BEDTrack* lookup(std::string& file);
+
+    /**
+     * Releases a handle obtained with acquire or lookup, the track is freed when it is no longer used.
+     */
+    static void release(BEDTrack* track);
+
+    /**
+     * Gets the contig of the track named chrom, -1 if absent.
+     */
+    int32_t get_tid(const char* chrom);
+
+    private:
+    int32_t no_users;
+
+    static std::map<std::string, BEDTrack*> tracks;
+    static std::mutex tracks_mutex;
+
+    /**
+     * Reads all regions of an indexed BED file.
+     */
+    BEDTrack(std::string& file);
+};
+
 #endif
\ No newline at end of file
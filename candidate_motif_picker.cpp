@@ -60,6 +60,7 @@ void CandidateMotifPicker::generate_candidate_motifs(Variant& variant)
     }
 
     this->v = variant.v;
+    VNTR& vntr = variant.get_vntr();
 
     bool alt_is_longest_allele = false;
     char** alleles = bcf_get_allele(v);
@@ -89,8 +90,8 @@ void CandidateMotifPicker::generate_candidate_motifs(Variant& variant)
         }
         std::cerr << "\n";
 
-        std::cerr << "Repeat Tract Position : [" << variant.vntr.exact_beg1 << "," << variant.vntr.exact_end1 << "]\n";
-        std::cerr << "Repeat Tract          : " << variant.vntr.exact_repeat_tract << "\n";
+        std::cerr << "Repeat Tract Position : [" << vntr.exact_beg1 << "," << vntr.exact_end1 << "]\n";
+        std::cerr << "Repeat Tract          : " << vntr.exact_repeat_tract << "\n";
         std::cerr << "Longest Allele        : " << alleles[longest_allele_index] << "\n";
         std::cerr << "Longest Allele index  : " << longest_allele_index << "\n";
     }
@@ -101,21 +102,21 @@ void CandidateMotifPicker::generate_candidate_motifs(Variant& variant)
         //pairwise left and right alignment of the alternative alleles with the reference allele, it is possible that the
         //tract occurs prior to the position of the multiallelic variant.
         int32_t offset = 0;
-        if (variant.vntr.exact_beg1<pos1)
+        if (vntr.exact_beg1<pos1)
         {
-            offset = bcf_get_pos1(v) - variant.vntr.exact_beg1;
+            offset = bcf_get_pos1(v) - vntr.exact_beg1;
         }
 
-        std::string spiked_seq = variant.vntr.exact_repeat_tract;
+        std::string spiked_seq = vntr.exact_repeat_tract;
         spiked_seq.replace(offset, ref_len, alleles[longest_allele_index]);
         mt->detect_candidate_motifs(spiked_seq);
 
         if (debug)
         {
             //this implictly requires that the variants are left aligned.
-            std::string spiked_seq = variant.vntr.exact_repeat_tract;
-            std::cerr << "\texact repeat tract " << variant.vntr.exact_repeat_tract << "\n";
-            std::cerr << "\trbeg1              " << variant.vntr.exact_beg1 << "\n";
+            std::string spiked_seq = vntr.exact_repeat_tract;
+            std::cerr << "\texact repeat tract " << vntr.exact_repeat_tract << "\n";
+            std::cerr << "\trbeg1              " << vntr.exact_beg1 << "\n";
             std::cerr << "\tpos1               " << bcf_get_pos1(v) << "\n";
             std::cerr << "\toffset             " << offset << "\n";
             std::cerr << "\treplace length     " << ref_len << "\n";
@@ -129,7 +130,7 @@ void CandidateMotifPicker::generate_candidate_motifs(Variant& variant)
     }
     else
     {
-        mt->detect_candidate_motifs(variant.vntr.exact_repeat_tract);
+        mt->detect_candidate_motifs(vntr.exact_repeat_tract);
     }
 }
 
@@ -142,11 +143,12 @@ void CandidateMotifPicker::generate_candidate_motifs(Variant& variant)
  */
 void CandidateMotifPicker::generate_candidate_motifs(char* repeat_tract, Variant& variant)
 {
+    VNTR& vntr = variant.get_vntr();
 //    std::cerr << "INVOKED??\n" ;
-    variant.vntr.fuzzy_repeat_tract.assign(repeat_tract);
+    vntr.fuzzy_repeat_tract.assign(repeat_tract);
 //    std::cerr << "assigned repeat tract"  << repeat_tract << "\n";
 
-    mt->detect_candidate_motifs(variant.vntr.fuzzy_repeat_tract);
+    mt->detect_candidate_motifs(vntr.fuzzy_repeat_tract);
 //    std::cerr << mt->pcm.size() << "\n";
 
 }
@@ -156,7 +158,7 @@ void CandidateMotifPicker::generate_candidate_motifs(char* repeat_tract, Variant
  */
 void CandidateMotifPicker::set_motif_from_info_field(Variant& variant)
 {
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
     char *motif = NULL;
     int32_t n = 0;
     if (bcf_get_info_string(variant.h, variant.v, "MOTIF", &motif, &n)>0)
@@ -232,7 +234,7 @@ bool CandidateMotifPicker::get_indel(std::string ref, std::string alt, std::stri
  */
 void CandidateMotifPicker::update_exact_repeat_unit(Variant& variant)
 {
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
     bcf1_t* v = variant.v;
     char** alleles = bcf_get_allele(v);
     int32_t n_allele = bcf_get_n_allele(v);
@@ -391,7 +393,7 @@ bool CandidateMotifPicker::next_motif(Variant& variant, int32_t mode)
                                                          mt->pcm.top().fit);
                 }
                 
-                VNTR& vntr = variant.vntr;
+                VNTR& vntr = variant.get_vntr();
                 vntr.fuzzy_motif = VNTR::canonicalize2(cm.motif);
                 vntr.fuzzy_basis = VNTR::get_basis(cm.motif);
                 vntr.fuzzy_mlen = vntr.fuzzy_motif.size();
@@ -421,14 +423,15 @@ bool CandidateMotifPicker::next_motif(Variant& variant, int32_t mode)
         if (!mt->pcm.empty())
         {
             CandidateMotif cm = mt->pcm.top();
-            variant.vntr.motif = cm.motif;
-            variant.vntr.basis = VNTR::get_basis(cm.motif);
-            variant.vntr.mlen = cm.motif.size();
-            variant.vntr.blen = variant.vntr.basis.size();
-            variant.vntr.fuzzy_motif = variant.vntr.motif;
-            variant.vntr.fuzzy_basis = variant.vntr.basis;
-            variant.vntr.fuzzy_mlen = variant.vntr.mlen;
-            variant.vntr.fuzzy_blen = variant.vntr.blen;
+            VNTR& vntr = variant.get_vntr();
+            vntr.motif = cm.motif;
+            vntr.basis = VNTR::get_basis(cm.motif);
+            vntr.mlen = cm.motif.size();
+            vntr.blen = vntr.basis.size();
+            vntr.fuzzy_motif = vntr.motif;
+            vntr.fuzzy_basis = vntr.basis;
+            vntr.fuzzy_mlen = vntr.mlen;
+            vntr.fuzzy_blen = vntr.blen;
             mt->pcm.pop();
 
 //            std::cerr << variant.vntr.motif << " " << variant.vntr.motif_score  << "\n";
@@ -59,7 +59,7 @@ void CandidateRegionExtractor::pick_candidate_region(Variant& variant, int32_t m
     {
         if (amode&FINAL)
         {
-            VNTR& vntr = variant.vntr;
+            VNTR& vntr = variant.get_vntr();
             vntr.repeat_tract.assign(bcf_get_ref(v));
             vntr.beg1 = bcf_get_pos1(v);
             vntr.end1 = bcf_get_end1(v);
@@ -69,7 +69,7 @@ void CandidateRegionExtractor::pick_candidate_region(Variant& variant, int32_t m
 
         if (amode&EXACT)
         {
-            VNTR& vntr = variant.vntr;
+            VNTR& vntr = variant.get_vntr();
             vntr.exact_repeat_tract.assign(bcf_get_ref(v));
             vntr.exact_beg1 = bcf_get_pos1(v);
             vntr.exact_end1 = bcf_get_end1(v);
@@ -79,7 +79,7 @@ void CandidateRegionExtractor::pick_candidate_region(Variant& variant, int32_t m
 
         if (amode&FUZZY)
         {
-            VNTR& vntr = variant.vntr;
+            VNTR& vntr = variant.get_vntr();
             vntr.fuzzy_repeat_tract.assign(bcf_get_ref(v));
             vntr.fuzzy_beg1 = bcf_get_pos1(v);
             vntr.fuzzy_end1 = bcf_get_end1(v);
@@ -170,7 +170,7 @@ void CandidateRegionExtractor::extract_regions_by_exact_alignment(Variant& varia
     bcf_hdr_t* h = variant.h;
     bcf1_t* v = variant.v;
 
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
     std::string& chrom = variant.chrom;
 
     int32_t min_beg1 = bcf_get_pos1(v);
@@ -320,7 +320,7 @@ void CandidateRegionExtractor::extract_regions_by_fuzzy_alignment(Variant& varia
         std::cerr << "                   " << seq << "\n";
     }
 
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
     vntr.exact_repeat_tract.assign(seq);
     vntr.exact_beg1 = min_beg1;
 
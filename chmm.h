@@ -27,9 +27,11 @@
 #include <iomanip>
 #include "hts_utils.h"
 #include "log_tool.h"
+#include "align_workspace.h"
+#include "instrument.h"
 
-#define MAXLEN 1024
-#define MAXLEN_NBITS 10
+//positions and motif counts are held in the 12 bit fields of a track
+#define MAXLEN 4095
 
 #define S   0
 #define X   1
@@ -63,7 +65,7 @@
 
 
 /*for indexing single array*/
-#define index(i,j) (((i)<<MAXLEN_NBITS)+(j))
+#define index(i,j) (((i)*stride)+(j))
 
 /*functions for getting trace back information*/
 #define track_get_u(t)    (((t)&0xF8000000)>>27)
@@ -133,6 +135,7 @@ class CHMM
     int32_t optimal_track;
     int32_t optimal_probe_len;
     int32_t *optimal_path;     // for storage
+    int32_t max_path_len;
     int32_t *optimal_path_ptr; //just a pointer
     int32_t optimal_path_len;
     
@@ -140,8 +143,12 @@ class CHMM
 
     float T[NSTATES][NSTATES];
 
+    //matrices of no_rows rows of stride cells from the alignment workspace,
+    //grown to the probe and read lengths of the alignments
     float **V;
     int32_t **U;
+    size_t no_rows;
+    size_t stride;
 
     bool debug;
 
@@ -177,6 +184,11 @@ class CHMM
      * Initializes U and V.
      */
     void initialize_UV();
+
+    /**
+     * Grows the matrices to at least rows x cols cells.
+     */
+    void resize(size_t rows, size_t cols);
     
     /**
      * Sets a model.
@@ -944,7 +956,6 @@ class CHMM
 };
 
 #undef MAXLEN
-#undef MAXLEN_NBITS
 #undef S
 #undef X
 #undef Y
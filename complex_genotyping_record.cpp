@@ -528,8 +528,6 @@ void ComplexGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampl
             uint32_t cycle = 10;
 
             std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-            std::vector<std::string>& aug_ref = as.aug_ref;
-            std::vector<std::string>& aug_alt = as.aug_alt;
 
             int32_t vpos1 = pos1;
 
@@ -567,14 +565,14 @@ void ComplexGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampl
                 {
                     if (dlen>0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_alt[i])
+                        if (as.alt_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
@@ -595,14 +593,14 @@ void ComplexGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampl
                 {
                     if (dlen<0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_ref[i])
+                        if (as.ref_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
@@ -653,8 +651,6 @@ void ComplexGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampl
             uint32_t cycle = 10;
 
             std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-            std::vector<std::string>& aug_ref = as.aug_ref;
-            std::vector<std::string>& aug_alt = as.aug_alt;
 
             int32_t vpos1 = pos1;
 
@@ -692,14 +688,14 @@ void ComplexGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampl
                 {
                     if (dlen>0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_alt[i])
+                        if (as.alt_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
@@ -720,14 +716,14 @@ void ComplexGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampl
                 {
                     if (dlen<0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_ref[i])
+                        if (as.ref_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
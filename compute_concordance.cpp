@@ -99,10 +99,12 @@ class Igor : Program
     std::string interval_list;
     std::string variant_concordance_txt_file;
     std::string sample_concordance_txt_file;
+    int32_t no_threads;
 
     ///////
     //i/o//
     ///////
+    ParallelSyncedDriver *driver;
     htsFile *variant_concordance_txt;
     htsFile *sample_concordance_txt;
 
@@ -113,20 +115,23 @@ class Igor : Program
     //filter//
     //////////
     std::string fexp;
-    Filter filter;
+    std::vector<Filter*> worker_filters;
     bool filter_exists;
 
     /////////
     //stats//
     /////////
     std::vector<ConcordanceStats> stats;
+    std::vector<std::vector<ConcordanceStats> > worker_stats;
+    std::vector<int32_t> a;
+    std::vector<int32_t> b;
     uint32_t no_candidate_snps;
     uint32_t no_candidate_indels;
 
     /////////
     //tools//
     /////////
-    VariantManip *vm;
+    std::vector<VariantManip*> vms;
     
     void intersect_samples(bcf_hdr_t* h1, bcf_hdr_t *h2, std::vector<std::string>& s, std::vector<int32_t>& a, std::vector<int32_t>& b)
     {
@@ -167,6 +172,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_variant_concordance_txt_file("m", "m", "Variant concordance text file [m.txt]", false, "m.txt", "str", cmd);
             TCLAP::ValueArg<std::string> arg_sample_concordance_txt_file("s", "s", "Sample concordance text file [s.txt]", false, "s.txt", "str", cmd);
             TCLAP::ValueArg<std::string> arg_filters("f", "f", "filter expression", false, "", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the inputs are indexed [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledMultiArg<std::string> arg_input_vcf_files("<in1.vcf><in2.vcf>", "Input VCF File", true, "str", cmd);
 
             cmd.parse(argc, argv);
@@ -182,6 +188,7 @@ class Igor : Program
             filters = arg_filters.getValue();
             variant_concordance_txt_file = arg_variant_concordance_txt_file.getValue();
             sample_concordance_txt_file = arg_sample_concordance_txt_file.getValue();
+            no_threads = arg_no_threads.getValue();
         }
         catch (TCLAP::ArgException &e)
         {
@@ -195,14 +202,19 @@ class Igor : Program
         //////////////////////
         //i/o initialization//
         //////////////////////
-        sr = new BCFSyncedReader(input_vcf_files, intervals);
+        driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+        sr = driver->sr;
         variant_concordance_txt = hts_open(variant_concordance_txt_file.c_str(), "w");
         sample_concordance_txt = hts_open(sample_concordance_txt_file.c_str(), "w");
 
         /////////////////////////
         //filter initialization//
         /////////////////////////
-        filter.parse(fexp.c_str());
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            worker_filters.push_back(new Filter());
+            worker_filters[i]->parse(fexp.c_str());
+        }
         filter_exists = fexp=="" ? false : true;
 
         ////////////////////////
@@ -214,7 +226,10 @@ class Igor : Program
         ///////////////////////
         //tool initialization//
         ///////////////////////
-        vm = new VariantManip("");
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            vms.push_back(new VariantManip(""));
+        }
     }
 
     void compute_concordance()
@@ -226,19 +241,69 @@ class Igor : Program
         char** samples2 = bcf_hdr_get_samples(sr->hdrs[1]);
 
         std::vector<std::string> s;
-        std::vector<int32_t> a;
-        std::vector<int32_t> b;
 
         intersect_samples(sr->hdrs[0], sr->hdrs[1], s, a, b);
 
         stats.resize(s.size());
+        worker_stats.resize(driver->no_workers, std::vector<ConcordanceStats>(s.size()));
 
         kstring_t *line = &variant_concordance_txt->line;
 
-        ConcordanceStats variant_stat;
         kputs("variant\tRR_RR\tRR_RA\tRR_AA\tRR_NA\tRA_RR\tRA_RA\tRA_AA\tRA_NA\tAA_RR\tAA_RA\tAA_AA\tAA_NA\tNA_RR\tNA_RA\tNA_AA\tNA_NA\n", line);
         //std::cerr << line.s;
 
+        driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { compute_concordance(worker, region, sr); });
+
+        for (int32_t w=0; w<driver->no_workers; ++w)
+        {
+            for (size_t i=0; i<s.size(); ++i)
+            {
+                for (uint32_t j=0; j<4; ++j)
+                {
+                    for (uint32_t k=0; k<4; ++k)
+                    {
+                        stats[i].concordance[j][k] += worker_stats[w][i].concordance[j][k];
+                    }
+                }
+            }
+        }
+
+        /////////////////////////////////////////////
+        //output concordance matrix for individuals//
+        /////////////////////////////////////////////
+        line = &sample_concordance_txt->line;
+        kputs("sample\tRR_RR\tRR_RA\tRR_AA\tRR_NA\tRA_RR\tRA_RA\tRA_AA\tRA_NA\tAA_RR\tAA_RA\tAA_AA\tAA_NA\tNA_RR\tNA_RA\tNA_AA\tNA_NA\n", line);
+        std::cerr << line->s;
+
+        for (uint32_t i=0; i<s.size(); ++i)
+        {
+            line->l = 0;
+            kputs(s[i].c_str(), line);
+            kputc('\t', line);
+            for (uint32_t j=0; j<4; ++j)
+            {
+                for (uint32_t k=0; k<4; ++k)
+                {
+                    kputw(stats[i].concordance[j][k], line);
+                    kputs("\t", line);
+                }
+            }
+            kputs("\n", line);
+            std::cerr << line->s;
+        }
+
+        hts_close(variant_concordance_txt);
+        hts_close(sample_concordance_txt);
+    };
+
+    /**
+     * Computes the concordance of the genotypes in a region.
+     */
+    void compute_concordance(int32_t worker, int32_t region, BCFSyncedReader* sr)
+    {
+        std::vector<ConcordanceStats>& stats = worker_stats[worker];
+        ConcordanceStats variant_stat;
+
         //for combining the alleles
         std::vector<bcfptr*> current_recs;
         std::map<std::string, bcfptr*> variants;
@@ -249,15 +314,15 @@ class Igor : Program
         {
             if (current_recs.size()==2 && current_recs[0]->file_index!=current_recs[1]->file_index)
             {
-                if (bcf_get_n_allele(v)!=2)
+                if (bcf_get_n_allele(current_recs[0]->v)!=2)
                 {
                     continue;
                 }
                 
                 if (filter_exists)
                 {     
-                    vm->classify_variant(current_recs[0]->h, current_recs[0]->v, variant);
-                    if (!filter.apply(current_recs[0]->h, current_recs[0]->v, &variant))
+                    vms[worker]->classify_variant(current_recs[0]->h, current_recs[0]->v, variant);
+                    if (!worker_filters[worker]->apply(current_recs[0]->h, current_recs[0]->v, &variant))
                     {    
                         continue;
                     }
@@ -271,7 +336,7 @@ class Igor : Program
                 bcf_hdr_t *h2 = sr->hdrs[1];
                 bcf_fmt_t* f2 = bcf_get_fmt(h2, v2, "GT");
 
-                for (size_t i=0; i<s.size(); ++i)
+                for (size_t i=0; i<a.size(); ++i)
                 {
                     int8_t *x1 = (int8_t*)(f1->p + a[i] * f1->size);
                     int8_t *x2 = (int8_t*)(f2->p + b[i] * f2->size);
@@ -331,33 +396,6 @@ class Igor : Program
 //                kputs("\n", line);
             }
         }
-
-        /////////////////////////////////////////////
-        //output concordance matrix for individuals//
-        /////////////////////////////////////////////
-        line = &sample_concordance_txt->line;
-        kputs("sample\tRR_RR\tRR_RA\tRR_AA\tRR_NA\tRA_RR\tRA_RA\tRA_AA\tRA_NA\tAA_RR\tAA_RA\tAA_AA\tAA_NA\tNA_RR\tNA_RA\tNA_AA\tNA_NA\n", line);
-        std::cerr << line->s;
-        for (uint32_t i=0; i<s.size(); ++i)
-        {
-            line->l = 0;
-            kputs(s[i].c_str(), line);
-            kputc('\t', line);
-            for (uint32_t j=0; j<4; ++j)
-            {
-                for (uint32_t k=0; k<4; ++k)
-                {
-                    kputw(stats[i].concordance[j][k], line);
-                    kputs("\t", line);
-                }
-            }
-
-            kputs("\n", line);
-            std::cerr << line->s;
-        }
-      
-        hts_close(variant_concordance_txt);
-        hts_close(sample_concordance_txt);
     };
 
     void print_options()
@@ -370,6 +408,7 @@ class Igor : Program
         std::clog << "             variant concordance  " << sample_concordance_txt_file << "\n";
         
         print_str_op("         [f] filter               ", fexp);
+        print_num_op("         [t] no. of threads       ", no_threads);
         print_int_op("         [i] intervals            ", intervals);
         std::clog << "\n";
     }
@@ -25,6 +25,7 @@
 #define COMPUTE_CONCORDANCE_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
 
 KHASH_MAP_INIT_STR(vdict, bcf_idinfo_t)
 typedef khash_t(vdict) vdict_t;
@@ -105,6 +105,7 @@ class Igor : Program
             bcf_print_liten(h,v);
             
             variant = new Variant(vc->odw->hdr, v);
+            if (variant->type==VT_VNTR) variant->update_vntr_from_info_fields(*vc->vntr_info_ids);
             vc->flush_variant_buffer(variant);
             vc->insert_variant_record_into_buffer(variant);
             v = vc->odw->get_bcf1_from_pool();
@@ -26,16 +26,6 @@
 namespace
 {
 
-/**
- * For detecting overlapping reads.
- */
-typedef struct
-{
-  int32_t start1, end1;
-} interval_t;
-
-KHASH_MAP_INIT_STR(rdict, interval_t)
-
 class Igor : Program
 {
     public:
@@ -52,7 +42,7 @@ class Igor : Program
     int32_t debug;
 
     //options for selecting reads
-    khash_t(rdict) *reads;
+    OverlappingReadTracker mates;
 
     //sample properties
     uint32_t ploidy;
@@ -242,9 +232,6 @@ class Igor : Program
         bcf_hdr_add_sample(odw->hdr, NULL);
         v = bcf_init();
 
-        //for tracking overlapping reads
-        reads = kh_init(rdict);
-
         ////////////////////////
         //stats initialization//
         ////////////////////////
@@ -329,50 +316,12 @@ class Igor : Program
      */
     bool filter_read(bam1_t *s)
     {
-        khiter_t k;
-        int32_t ret;
-
-        if (ignore_overlapping_read)
+        if (ignore_overlapping_read && mates.is_overlapping_mate(s))
         {
-            //this read is part of a mate pair on the same contig
-            if (bam_get_mpos1(s) && (bam_get_tid(s)==bam_get_mtid(s)))
-            {
-                //first mate
-                if (bam_get_mpos1(s)>bam_get_pos1(s))
-                {
-                    //overlapping
-                    if (bam_get_mpos1(s)<=(bam_get_pos1(s) + bam_get_l_qseq(s) - 1))
-                    {
-                        //add read that has overlapping
-                        //duplicate the record and perform the stitching later
-                        char* qname = strdup(bam_get_qname(s));
-                        k = kh_put(rdict, reads, qname, &ret);
-                        if (!ret)
-                        {
-                            //already present
-                            free(qname);
-                        }
-                        kh_val(reads, k) = {bam_get_pos1(s), bam_get_pos1(s)+bam_get_l_qseq(s)-1};
-                    }
-                }
-                else
-                {
-                    //check overlap
-                    if((k = kh_get(rdict, reads, bam_get_qname(s)))!=kh_end(reads))
-                    {
-                        if (kh_exist(reads, k))
-                        {
-                            free((char*)kh_key(reads, k));
-                            kh_del(rdict, reads, k);
-                            ++no_overlapping_reads;
-                        }
-                        //set this on to remove overlapping reads.
-                        return false;
-                    }
-                }
-            }
+            //set this on to remove overlapping reads.
+            ++no_overlapping_reads;
+            return false;
         }
-        //should we join them up?
 
         if(bam_get_flag(s) & read_exclude_flag)
         {
@@ -481,24 +430,6 @@ class Igor : Program
             }
         }
 
-        //check to see that hash should be cleared when encountering new contig.
-        //some bams may not be properly formed and contain orphaned sequences that
-        //can retained in the hash
-        if (bam_get_tid(s)!=tid)
-        {
-            for (k = kh_begin(reads); k != kh_end(reads); ++k)
-            {
-                if (kh_exist(reads, k))
-                {
-                    free((char*)kh_key(reads, k));
-                    kh_del(rdict, reads, k);
-                }
-            }
-
-            //tid is not updated here, it is handled by flush()
-            //kh_destroy(rdict, h);
-        }
-
         return true;
     }
 
@@ -1545,6 +1476,9 @@ class Igor : Program
         std::clog << "       no. low mapq reads           : " << no_low_mapq_reads << "\n";
         std::clog << "       no. passed reads             : " << no_passed_reads << "\n";
         std::clog << "       no. exclude flag reads       : " << no_exclude_flag_reads << "\n";
+        std::clog << "       no. tracked overlapping mates: " << mates.no_tracked << "\n";
+        std::clog << "       no. expired overlapping mates: " << mates.no_expired << "\n";
+        std::clog << "       max. pending mates (KB)      : " << mates.max_pending << " (" << (mates.max_bytes>>10) << ")\n";
         std::clog << "\n";
         std::clog << "       no. unaligned cigars         : " << no_unaligned_cigars << "\n";
         std::clog << "       no. malformed del cigars     : " << no_malformed_del_cigars << "\n";
@@ -1566,15 +1500,6 @@ class Igor : Program
 
     ~Igor()
     {
-        //clear hash of reads
-        for (khiter_t k = kh_begin(reads); k != kh_end(reads); ++k)
-        {
-            if (kh_exist(reads, k))
-            {
-                free((char*)kh_key(reads, k));
-                kh_del(rdict, reads, k);
-            }
-        }
     };
 
     private:
@@ -30,6 +30,7 @@
 #include "bam_ordered_reader.h"
 #include "Rmath/Rmath.h"
 #include "log_tool.h"
+#include "overlapping_read_tracker.h"
 
 void discover(int argc, char ** argv);
 
@@ -23,6 +23,8 @@
 
 #include "filter.h"
 
+VT_TIMER_STAT(apply_stat, "filter.apply");
+
 /**
  * Constructor.
  */
@@ -1516,6 +1518,8 @@ void Filter::parse(const char* exp, bool debug)
  */
 bool Filter::apply(bcf_hdr_t *h, bcf1_t *v, Variant *variant, bool debug) //recursive
 {
+    VT_TIME(apply_stat);
+
     if (tree==NULL)
     {
         return true;
@@ -29,6 +29,7 @@
 #include "hts_utils.h"
 #include "variant.h"
 #include "pregex.h"
+#include "instrument.h"
 
 //TYPES
 //this is defined from the 7th to 13th bit by setting the bit
@@ -97,7 +97,7 @@ FlankDetector::~FlankDetector()
  */
 void FlankDetector::detect_flanks(Variant& variant, uint32_t mode)
 {
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
 
     //simple single base pair clipping of ends
     if (mode==EXACT)
@@ -595,7 +595,7 @@ void FlankDetector::polish_repeat_tract_ends(std::string& repeat_tract, std::str
  */
 void FlankDetector::compute_purity_score(Variant& variant, int32_t amode)
 {
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
 
     if (amode&FINAL)
     {
@@ -723,7 +723,7 @@ void FlankDetector::compute_purity_score(std::string& repeat_tract, std::string&
  */
 void FlankDetector::compute_composition_and_entropy(Variant& variant, int32_t amode)
 {
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
 
     if (amode&FINAL)
     {
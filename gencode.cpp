@@ -103,169 +103,10 @@ void GENCODERecord::feature2string(int32_t feature, kstring_t *s)
  */
 GENCODE::GENCODE(std::string& gencode_gtf_file, std::string& ref_fasta_file, std::vector<GenomeInterval>& intervals)
 {
-    fai = fai_load(ref_fasta_file.c_str());
-    if (fai==NULL) 
-    {
-        fprintf(stderr, "[%s:%d %s] Cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-        exit(1);
-    }
+    rs = new ReferenceSequence(ref_fasta_file);
     this->gencode_gtf_file = gencode_gtf_file;
     initialize(intervals);
-    
-    khiter_t k;
-    int32_t ret;
-    codon2syn = kh_init(aadict);    
-    
-    //constructs the mapping for amino acids
-    //ALA
-    k = kh_put(aadict, codon2syn, "GCA", &ret); 
-    kh_value(codon2syn, k) = (NT_G<<8) & (NT_C<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "GCC", &ret); 
-    kh_value(codon2syn, k) = (NT_G<<8) & (NT_C<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "GCG", &ret); 
-    kh_value(codon2syn, k) = (NT_G<<8) & (NT_C<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "GCT", &ret); 
-    kh_value(codon2syn, k) = (NT_G<<8) & (NT_C<<4) & (NT_A|NT_C|NT_G|NT_T);
-    //ALA
-    k = kh_put(aadict, codon2syn, "CGA", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_C)<<8) & (NT_G<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "CGC", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_C)<<8) & (NT_G<<4) & (NT_A|NT_C|NT_G|NT_T);    
-    k = kh_put(aadict, codon2syn, "CGG", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_C)<<8) & (NT_G<<4) & (NT_A|NT_C|NT_G|NT_T);    
-    k = kh_put(aadict, codon2syn, "CGT", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_C)<<8) & (NT_G<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "AGA", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_C)<<8) & (NT_G<<4) & (NT_A|NT_C|NT_G|NT_T);    
-    k = kh_put(aadict, codon2syn, "AGG", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_C)<<8) & (NT_G<<4) & (NT_A|NT_C|NT_G|NT_T);
-    //ASN
-    k = kh_put(aadict, codon2syn, "AAC", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_A)<<4) & (NT_C|NT_T);
-    k = kh_put(aadict, codon2syn, "AAT", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_A)<<4) & (NT_C|NT_T);
-    //ASP
-    k = kh_put(aadict, codon2syn, "GAC", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_A)<<4) & (NT_C|NT_T);
-    k = kh_put(aadict, codon2syn, "GAT", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_A)<<4) & (NT_C|NT_T);
-    //CYS
-    k = kh_put(aadict, codon2syn, "TGT", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_G)<<4) & (NT_C|NT_T);
-    k = kh_put(aadict, codon2syn, "TGC", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_G)<<4) & (NT_C|NT_T);       
-    //GLN
-    k = kh_put(aadict, codon2syn, "CAA", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_A)<<4) & (NT_A|NT_G);
-    k = kh_put(aadict, codon2syn, "CAG", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_A)<<4) & (NT_A|NT_G);
-    //GLU
-    k = kh_put(aadict, codon2syn, "GAA", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_A)<<4) & (NT_A|NT_G);
-    k = kh_put(aadict, codon2syn, "GAG", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_A)<<4) & (NT_A|NT_G);
-    //GLY
-    k = kh_put(aadict, codon2syn, "GGA", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "GGC", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "GGG", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);
-    k = kh_put(aadict, codon2syn, "GGT", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);        
-    //HIS
-    k = kh_put(aadict, codon2syn, "CAT", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_A)<<4) & (NT_C|NT_T);
-    k = kh_put(aadict, codon2syn, "CAC", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_A)<<4) & (NT_C|NT_T);
-    //ILE
-    k = kh_put(aadict, codon2syn, "ATT", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_T);    
-    k = kh_put(aadict, codon2syn, "ATC", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_T);   
-    k = kh_put(aadict, codon2syn, "ATA", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_T); 
-    //LEU
-    k = kh_put(aadict, codon2syn, "TTA", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_T)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "TTG", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_T)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "CTT", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_T)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "CTC", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_T)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "CTA", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_T)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "CTG", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_T)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    //LYS
-    k = kh_put(aadict, codon2syn, "AAA", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_A)<<8) & ((NT_A)<<4) & (NT_A|NT_G);     
-    k = kh_put(aadict, codon2syn, "AAG", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_A)<<8) & ((NT_A)<<4) & (NT_A|NT_G);      
-    //MET
-    k = kh_put(aadict, codon2syn, "AUG", &ret); 
-    kh_value(codon2syn, k) = ((NT_C|NT_A)<<8) & ((NT_T)<<4) & (NT_G);  
-    //PHE
-    k = kh_put(aadict, codon2syn, "TTT", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_T)<<4) & (NT_T|NT_C);  
-    k = kh_put(aadict, codon2syn, "TTC", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_T)<<4) & (NT_T|NT_C);  
-    //PRO
-    k = kh_put(aadict, codon2syn, "CCA", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "CCC", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "CCT", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "CCG", &ret); 
-    kh_value(codon2syn, k) = ((NT_C)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);          
-    //SER
-    k = kh_put(aadict, codon2syn, "TCT", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_T)<<8) & ((NT_C|NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "TCC", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_T)<<8) & ((NT_C|NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "TCA", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_T)<<8) & ((NT_C|NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);      
-    k = kh_put(aadict, codon2syn, "TCG", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_T)<<8) & ((NT_C|NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "AGT", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_T)<<8) & ((NT_C|NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "AGC", &ret); 
-    kh_value(codon2syn, k) = ((NT_A|NT_T)<<8) & ((NT_C|NT_G)<<4) & (NT_A|NT_C|NT_G|NT_T);   
-    //THR
-    k = kh_put(aadict, codon2syn, "ACA", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "ACC", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    k = kh_put(aadict, codon2syn, "ACG", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);             
-    k = kh_put(aadict, codon2syn, "ACT", &ret); 
-    kh_value(codon2syn, k) = ((NT_A)<<8) & ((NT_C)<<4) & (NT_A|NT_C|NT_G|NT_T);  
-    //TRP
-    k = kh_put(aadict, codon2syn, "TGG", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_G)<<4) & (NT_G); 
-    //TYR
-    k = kh_put(aadict, codon2syn, "TAT", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_A)<<4) & (NT_C|NT_T); 
-    k = kh_put(aadict, codon2syn, "TAC", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_A)<<4) & (NT_C|NT_T); 
-    //VAL
-    k = kh_put(aadict, codon2syn, "GTA", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "GTC", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "GTG", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T); 
-    k = kh_put(aadict, codon2syn, "GTT", &ret); 
-    kh_value(codon2syn, k) = ((NT_G)<<8) & ((NT_T)<<4) & (NT_A|NT_C|NT_G|NT_T);             
-    //STOP
-    k = kh_put(aadict, codon2syn, "TAA", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_A|NT_G)<<4) & (NT_A|NT_G);     
-    k = kh_put(aadict, codon2syn, "TGA", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_A|NT_G)<<4) & (NT_A|NT_G);  
-    k = kh_put(aadict, codon2syn, "TAG", &ret); 
-    kh_value(codon2syn, k) = ((NT_T)<<8) & ((NT_A|NT_G)<<4) & (NT_A|NT_G);                
+    initialize_codon2syn();
 }
 
 /**
@@ -273,13 +114,41 @@ GENCODE::GENCODE(std::string& gencode_gtf_file, std::string& ref_fasta_file, std
  */
 GENCODE::GENCODE(std::string& gencode_gtf_file, std::string& ref_fasta_file)
 {
-    fai = fai_load(ref_fasta_file.c_str());
-    if (fai==NULL) 
+    rs = new ReferenceSequence(ref_fasta_file);
+    this->gencode_gtf_file = gencode_gtf_file;
+    initialize_codon2syn();
+}
+
+/**
+ * Constructs the synonymous base masks of every codon.
+ *
+ * For codon c, bits 8-11, 4-7 and 0-3 of codon2syn[c] hold the NT_* bases
+ * at the first, second and third positions that leave the amino acid unchanged.
+ */
+void GENCODE::initialize_codon2syn()
+{
+    static const char* bases = "TCAG";
+    static const int32_t nt[4] = {NT_T, NT_C, NT_A, NT_G};
+
+    for (int32_t c=0; c<64; ++c)
     {
-        fprintf(stderr, "[%s:%d %s] Cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-        exit(1);
+        char codon[3] = {bases[c>>4], bases[(c>>2)&3], bases[c&3]};
+        char aa = GENCODEIndex::translate(codon);
+
+        codon2syn[c] = 0;
+        for (int32_t i=0; i<3; ++i)
+        {
+            char mcodon[3] = {codon[0], codon[1], codon[2]};
+            for (int32_t b=0; b<4; ++b)
+            {
+                mcodon[i] = bases[b];
+                if (GENCODEIndex::translate(mcodon)==aa)
+                {
+                    codon2syn[c] |= nt[b] << (4*(2-i));
+                }
+            }
+        }
     }
-    this->gencode_gtf_file = gencode_gtf_file;
 }
 
 /**
@@ -344,8 +213,8 @@ void GENCODE::initialize(std::vector<GenomeInterval>& intervals)
     std::map<std::string, std::string> attrib_map;
     kstring_t s = {0,0,0};
 
-    //for storing returned overlapping intervals
-    std::vector<Interval*> overlaps;
+    //start and stop codons
+    std::vector<GENCODERecord*> codons;
 
     while (todr->read(&s))
     {
@@ -422,11 +291,8 @@ void GENCODE::initialize(std::vector<GenomeInterval>& intervals)
                 exon_no = -1;
             }
 
-            int32_t ref_len1 = 0;
-            int32_t ref_len2 = 0;
-
-            char *dnc1 = faidx_fetch_seq(fai, chrom.c_str(), start1-3, start1-2, &ref_len1);
-            char *dnc2 = faidx_fetch_seq(fai, chrom.c_str(), end1, end1+1, &ref_len2);
+            char *dnc1 = rs->fetch_masked_seq(chrom.c_str(), start1-2, start1-1);
+            char *dnc2 = rs->fetch_masked_seq(chrom.c_str(), end1+1, end1+2);
 
             if(strand=='+')
             {
@@ -454,43 +320,22 @@ void GENCODE::initialize(std::vector<GenomeInterval>& intervals)
                 }
             }
 
-            if (ref_len1) free(dnc1);
-            if (ref_len2) free(dnc2);
+            if (dnc1) free(dnc1);
+            if (dnc2) free(dnc2);
 
         }
 
         if (feature=="stop_codon")
         {
             gencode_feature = GC_FT_START_CODON;
-
-            CHROM[chrom]->search(start1, end1, overlaps);
-
-            for (uint32_t i=0; i<overlaps.size(); ++i)
-            {
-                GENCODERecord* record = (GENCODERecord*)overlaps[i];
-                if (record->feature == GC_FT_EXON && record->gene == gene)
-                {
-                    record->containsStopCodon = true;
-                }
-            }
         }
 
         if (feature=="start_codon")
         {
             gencode_feature = GC_FT_STOP_CODON;
+        }
 
-            CHROM[chrom]->search(start1, end1, overlaps);
 
-            for (uint32_t i=0; i<overlaps.size(); ++i)
-            {
-                GENCODERecord* record = (GENCODERecord*)overlaps[i];
-                if (record->feature == GC_FT_EXON && record->gene == gene)
-                {
-                    record->containsStartCodon = true;
-                }
-            }
-        }
-        
         GENCODERecord* record = new GENCODERecord(chrom, start1, end1, strand,
                                              gene, gencode_feature, frame, exon_no,
                                              fivePrimeConservedEssentialSpliceSite, threePrimeConservedEssentialSpliceSite,
@@ -503,6 +348,39 @@ void GENCODE::initialize(std::vector<GenomeInterval>& intervals)
         }
 
         CHROM[chrom]->insert(record);
+
+        //exons containing codons are marked once the trees are indexed
+        if (feature=="start_codon" || feature=="stop_codon")
+        {
+            codons.push_back(record);
+        }
+    }
+
+    for (std::map<std::string, IntervalTree*>::iterator i=CHROM.begin(); i!=CHROM.end(); ++i)
+    {
+        i->second->index();
+    }
+
+    for (size_t i=0; i<codons.size(); ++i)
+    {
+        GENCODERecord* codon = codons[i];
+        bool stop = codon->feature==GC_FT_START_CODON;
+
+        CHROM[codon->chrom]->search(codon->beg1, codon->end1, [codon, stop](Interval* interval)
+        {
+            GENCODERecord* record = (GENCODERecord*)interval;
+            if (record->feature == GC_FT_EXON && record->gene == codon->gene)
+            {
+                if (stop)
+                {
+                    record->containsStopCodon = true;
+                }
+                else
+                {
+                    record->containsStartCodon = true;
+                }
+            }
+        });
     }
 
     std::clog << " done.\n";
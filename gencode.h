@@ -42,8 +42,10 @@
 #include "utils.h"
 #include "interval_tree.h"
 #include "variant_manip.h"
+#include "reference_sequence.h"
 #include "genome_interval.h"
 #include "tbx_ordered_reader.h"
+#include "gencode_index.h"
 
 #define GC_FT_EXON 0
 #define GC_FT_CDS  1
@@ -117,17 +119,15 @@ class GENCODERecord : public Interval
     private:
 };
 
-KHASH_MAP_INIT_STR(aadict, int32_t)
-
 class GENCODE
 {
     public:
     std::string gencode_gtf_file;
     std::string ref_fasta_file;
-    faidx_t *fai;
+    ReferenceSequence *rs;
     std::map<std::string, IntervalTree*> CHROM;
     std::stringstream token;
-    khash_t(aadict) *codon2syn;
+    int32_t codon2syn[64];
 
     /**
      * Constructs and initialize a GENCODE object.
@@ -164,6 +164,11 @@ class GENCODE
      */
     void fill_synonymous(GENCODERecord *g);
 
+    /**
+     * Constructs the synonymous base masks of every codon, codons are indexed in TCAG order.
+     */
+    void initialize_codon2syn();
+
     /**
      * Parses a string to a GENCODERecord
      */
@@ -0,0 +1,776 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "gencode_index.h"
+
+std::map<std::string, GENCODEIndex*> GENCODEIndex::indices;
+std::mutex GENCODEIndex::indices_mutex;
+
+namespace
+{
+
+/**
+ * Transcript as it is collected from the GTF file.
+ */
+class GTFTranscript
+{
+    public:
+    std::string chrom;
+    std::string gene;
+    std::string id;
+    char strand;
+    int32_t phase;
+    int32_t phase_pos1;
+    std::vector<std::pair<int32_t, int32_t> > exons;
+    std::vector<std::pair<int32_t, int32_t> > coding;
+
+    GTFTranscript() : strand('+'), phase(0), phase_pos1(-1) {};
+};
+
+/**
+ * Extracts the value of a key from a GTF attribute field.
+ */
+bool get_gtf_attribute(const std::string& attrib, const char* key, std::string& val)
+{
+    size_t klen = strlen(key);
+    size_t i = 0;
+    while ((i = attrib.find(key, i))!=std::string::npos)
+    {
+        if ((i==0 || attrib[i-1]==' ' || attrib[i-1]==';') && i+klen<attrib.size() && attrib[i+klen]==' ')
+        {
+            size_t b = i+klen+1;
+            if (attrib[b]=='"') ++b;
+            size_t e = b;
+            while (e<attrib.size() && attrib[e]!='"' && attrib[e]!=';') ++e;
+            val.assign(attrib, b, e-b);
+            return true;
+        }
+        i += klen;
+    }
+
+    val.clear();
+    return false;
+}
+
+/**
+ * Appends a string to the string pool and returns its offset.
+ */
+uint32_t add_string(std::string& pool, const std::string& s)
+{
+    uint32_t off = pool.size();
+    pool.append(s);
+    pool.push_back('\0');
+    return off;
+}
+
+/**
+ * Pads a file to 8 byte alignment.
+ */
+uint64_t align8(FILE* fp, uint64_t off)
+{
+    static const char zeros[8] = {0,0,0,0,0,0,0,0};
+    uint64_t pad = (8-(off&7))&7;
+    if (pad) fwrite(zeros, 1, pad, fp);
+    return off+pad;
+}
+
+bool compare_transcripts(const GTFTranscript* a, const GTFTranscript* b)
+{
+    if (a->exons.front().first!=b->exons.front().first)
+    {
+        return a->exons.front().first < b->exons.front().first;
+    }
+    return a->exons.back().second < b->exons.back().second;
+}
+
+}
+
+/**
+ * Constructs and loads a GENCODE index.
+ */
+GENCODEIndex::GENCODEIndex(std::string& index_file)
+{
+    this->index_file = index_file;
+    no_users = 0;
+
+    fd = open(index_file.c_str(), O_RDONLY);
+    if (fd<0)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot open GENCODE index: %s\n", __FILE__, __LINE__, __FUNCTION__, index_file.c_str());
+        exit(1);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size<sizeof(gc_idx_hdr_t))
+    {
+        fprintf(stderr, "[%s:%d %s] Not a GENCODE index: %s\n", __FILE__, __LINE__, __FUNCTION__, index_file.c_str());
+        exit(1);
+    }
+
+    map_len = st.st_size;
+    map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd, 0);
+    if (map==MAP_FAILED)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot map GENCODE index: %s\n", __FILE__, __LINE__, __FUNCTION__, index_file.c_str());
+        exit(1);
+    }
+
+    const char* base = (const char*) map;
+    hdr = (const gc_idx_hdr_t*) base;
+    if (strncmp(hdr->magic, GC_IDX_MAGIC, 8) || hdr->version!=GC_IDX_VERSION || hdr->seq_off+hdr->seq_len>map_len)
+    {
+        fprintf(stderr, "[%s:%d %s] Not a GENCODE index or incompatible version: %s\n", __FILE__, __LINE__, __FUNCTION__, index_file.c_str());
+        exit(1);
+    }
+
+    chroms = (const gc_idx_chrom_t*) (base + hdr->chrom_off);
+    txs = (const gc_idx_tx_t*) (base + hdr->tx_off);
+    exons = (const gc_idx_exon_t*) (base + hdr->exon_off);
+    str = base + hdr->str_off;
+    seq = base + hdr->seq_off;
+
+    for (uint32_t i=0; i<hdr->n_chrom; ++i)
+    {
+        chrom2idx[std::string(&str[chroms[i].name])] = i;
+    }
+}
+
+/**
+ * Unmaps the index.
+ */
+GENCODEIndex::~GENCODEIndex()
+{
+    munmap(map, map_len);
+    close(fd);
+}
+
+/**
+ * Returns a shared handle to the index in index_file, loading it on first use.
+ */
+GENCODEIndex* GENCODEIndex::acquire(std::string& index_file)
+{
+    std::lock_guard<std::mutex> lock(indices_mutex);
+
+    //the same file may be named by different paths
+    std::string path = canonical_path(index_file);
+
+    GENCODEIndex* gci;
+    std::map<std::string, GENCODEIndex*>::iterator i = indices.find(path);
+    if (i==indices.end())
+    {
+        gci = new GENCODEIndex(path);
+        indices[path] = gci;
+    }
+    else
+    {
+        gci = i->second;
+    }
+
+    ++gci->no_users;
+    return gci;
+}
+
+/**
+ * Returns a shared handle to an index of a GENCODE GTF file, built in a
+ * temporary file on first use.  The handle is registered under the GTF
+ * file so that acquire on the GTF file returns it while it is held.
+ */
+GENCODEIndex* GENCODEIndex::acquire(std::string& gencode_gtf_file, std::string& ref_fasta_file)
+{
+    std::lock_guard<std::mutex> lock(indices_mutex);
+
+    std::string path = canonical_path(gencode_gtf_file);
+
+    GENCODEIndex* gci;
+    std::map<std::string, GENCODEIndex*>::iterator i = indices.find(path);
+    if (i==indices.end())
+    {
+        const char* tmp_dir = getenv("TMPDIR");
+        std::string index_file = std::string(tmp_dir && *tmp_dir ? tmp_dir : "/tmp") + "/vt.gencode.XXXXXX";
+        int tmp_fd = mkstemp(&index_file[0]);
+        if (tmp_fd<0)
+        {
+            fprintf(stderr, "[%s:%d %s] Cannot create temporary file %s: %s\n", __FILE__, __LINE__, __FUNCTION__, index_file.c_str(), strerror(errno));
+            exit(1);
+        }
+        close(tmp_fd);
+
+        build(gencode_gtf_file, ref_fasta_file, index_file);
+
+        //the mapping outlives the file
+        gci = new GENCODEIndex(index_file);
+        unlink(index_file.c_str());
+        gci->index_file = path;
+        indices[path] = gci;
+    }
+    else
+    {
+        gci = i->second;
+    }
+
+    ++gci->no_users;
+    return gci;
+}
+
+/**
+ * Releases a handle obtained with acquire, the index is unmapped when it is no longer used.
+ */
+void GENCODEIndex::release(GENCODEIndex* gci)
+{
+    std::lock_guard<std::mutex> lock(indices_mutex);
+
+    if (--gci->no_users==0)
+    {
+        indices.erase(gci->index_file);
+        delete gci;
+    }
+}
+
+/**
+ * Checks if file is a GENCODE index.
+ */
+bool GENCODEIndex::is_index(std::string& file)
+{
+    FILE* fp = fopen(file.c_str(), "rb");
+    if (fp==NULL) return false;
+
+    char magic[8];
+    bool index = fread(magic, 1, 8, fp)==8 && !strncmp(magic, GC_IDX_MAGIC, 8);
+    fclose(fp);
+
+    return index;
+}
+
+/**
+ * Builds a GENCODE index from a GTF file, the CDS sequences are extracted from the reference.
+ * Returns the number of transcripts indexed.
+ */
+int32_t GENCODEIndex::build(std::string& gencode_gtf_file, std::string& ref_fasta_file, std::string& index_file)
+{
+    ReferenceSequence* rs = new ReferenceSequence(ref_fasta_file);
+
+    htsFile* hts = hts_open(gencode_gtf_file.c_str(), "r");
+    if (hts==NULL)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot open GTF file: %s\n", __FILE__, __LINE__, __FUNCTION__, gencode_gtf_file.c_str());
+        exit(1);
+    }
+
+    ///////////////////////////////////////
+    //collect exons and CDS by transcript//
+    ///////////////////////////////////////
+    std::map<std::string, GTFTranscript*> transcripts;
+    std::vector<std::string> chrom_order;
+    std::map<std::string, std::vector<GTFTranscript*> > chrom_txs;
+    std::vector<std::string> fields;
+    std::string tid;
+    kstring_t s = {0,0,0};
+
+    while (hts_getline(hts, '\n', &s)>=0)
+    {
+        if (s.l==0 || s.s[0]=='#') continue;
+
+        split(fields, "\t", s.s);
+        if (fields.size()<9) continue;
+
+        std::string& feature = fields[2];
+        bool is_exon = feature=="exon";
+        bool is_coding = feature=="CDS" || feature=="stop_codon";
+        if (!is_exon && !is_coding) continue;
+
+        if (!get_gtf_attribute(fields[8], "transcript_id", tid)) continue;
+
+        int32_t beg1, end1;
+        if (!str2int32(fields[3], beg1) || !str2int32(fields[4], end1)) continue;
+
+        GTFTranscript* t;
+        std::map<std::string, GTFTranscript*>::iterator i = transcripts.find(tid);
+        if (i==transcripts.end())
+        {
+            t = new GTFTranscript();
+            t->chrom = fields[0]=="M" ? std::string("MT") : fields[0];
+            t->strand = fields[6].at(0);
+            t->id = tid;
+            get_gtf_attribute(fields[8], "gene_name", t->gene);
+            transcripts[tid] = t;
+
+            if (chrom_txs.find(t->chrom)==chrom_txs.end())
+            {
+                chrom_order.push_back(t->chrom);
+            }
+            chrom_txs[t->chrom].push_back(t);
+        }
+        else
+        {
+            t = i->second;
+        }
+
+        if (is_exon)
+        {
+            t->exons.push_back(std::make_pair(beg1, end1));
+        }
+        else
+        {
+            t->coding.push_back(std::make_pair(beg1, end1));
+
+            //the frame of the 5' most CDS marks an incomplete CDS
+            int32_t frame;
+            if (feature=="CDS" && str2int32(fields[7], frame))
+            {
+                int32_t pos1 = t->strand=='+' ? beg1 : end1;
+                if (t->phase_pos1<0 ||
+                    (t->strand=='+' && pos1<t->phase_pos1) ||
+                    (t->strand!='+' && pos1>t->phase_pos1))
+                {
+                    t->phase_pos1 = pos1;
+                    t->phase = frame;
+                }
+            }
+        }
+    }
+    hts_close(hts);
+
+    //////////////////////
+    //serialize sections//
+    //////////////////////
+    std::vector<gc_idx_chrom_t> ichroms;
+    std::vector<gc_idx_tx_t> itxs;
+    std::vector<gc_idx_exon_t> iexons;
+    std::string pool;
+    std::string cds;
+    int32_t no_missing_seq = 0;
+
+    for (uint32_t c=0; c<chrom_order.size(); ++c)
+    {
+        std::vector<GTFTranscript*>& v = chrom_txs[chrom_order[c]];
+        for (uint32_t i=0; i<v.size(); ++i)
+        {
+            std::sort(v[i]->exons.begin(), v[i]->exons.end());
+            std::sort(v[i]->coding.begin(), v[i]->coding.end());
+        }
+
+        //drop transcripts without exons
+        uint32_t k = 0;
+        for (uint32_t i=0; i<v.size(); ++i)
+        {
+            if (v[i]->exons.size()) v[k++] = v[i];
+            else delete v[i];
+        }
+        v.resize(k);
+        std::sort(v.begin(), v.end(), compare_transcripts);
+
+        gc_idx_chrom_t ic;
+        ic.name = add_string(pool, chrom_order[c]);
+        ic.tx_beg = itxs.size();
+        ic.max_tx_len = 0;
+
+        for (uint32_t i=0; i<v.size(); ++i)
+        {
+            GTFTranscript* t = v[i];
+
+            gc_idx_tx_t it;
+            memset(&it, 0, sizeof(gc_idx_tx_t));
+            it.beg1 = t->exons.front().first;
+            it.end1 = t->exons.back().second;
+            it.gene = add_string(pool, t->gene);
+            it.id = add_string(pool, t->id);
+            it.exon_beg = iexons.size();
+            it.n_exon = t->exons.size();
+            it.strand = t->strand;
+            it.coding = t->coding.size() ? 1 : 0;
+            it.phase = t->phase;
+
+            //coding portion of each exon
+            for (uint32_t j=0; j<t->exons.size(); ++j)
+            {
+                gc_idx_exon_t ie;
+                memset(&ie, 0, sizeof(gc_idx_exon_t));
+                ie.beg1 = t->exons[j].first;
+                ie.end1 = t->exons[j].second;
+
+                for (uint32_t l=0; l<t->coding.size(); ++l)
+                {
+                    int32_t b = std::max(ie.beg1, t->coding[l].first);
+                    int32_t e = std::min(ie.end1, t->coding[l].second);
+                    if (b<=e)
+                    {
+                        ie.cds_beg1 = ie.cds_beg1 ? std::min(ie.cds_beg1, b) : b;
+                        ie.cds_end1 = std::max(ie.cds_end1, e);
+                    }
+                }
+
+                iexons.push_back(ie);
+            }
+
+            //CDS offsets and sequence in the direction of transcription
+            it.cds_seq = cds.size();
+            int32_t cds_off = 0;
+            bool seq_ok = rs->fetch_seq_len(t->chrom)>=0;
+            for (uint32_t j=0; j<it.n_exon; ++j)
+            {
+                gc_idx_exon_t& ie = iexons[it.exon_beg + (it.strand=='+' ? j : it.n_exon-1-j)];
+                if (!ie.cds_beg1) continue;
+
+                ie.cds_off = cds_off;
+                cds_off += ie.cds_end1-ie.cds_beg1+1;
+
+                if (!seq_ok) continue;
+
+                char* seg = rs->fetch_seq(t->chrom, ie.cds_beg1, ie.cds_end1);
+                int32_t len = seg ? strlen(seg) : 0;
+                if (seg==NULL || len!=ie.cds_end1-ie.cds_beg1+1)
+                {
+                    seq_ok = false;
+                    if (seg) free(seg);
+                    continue;
+                }
+
+                if (it.strand=='+')
+                {
+                    for (int32_t l=0; l<len; ++l) cds.push_back(toupper(seg[l]));
+                }
+                else
+                {
+                    for (int32_t l=len-1; l>=0; --l)
+                    {
+                        char b = toupper(seg[l]);
+                        cds.push_back(b=='A' ? 'T' : b=='C' ? 'G' : b=='G' ? 'C' : b=='T' ? 'A' : 'N');
+                    }
+                }
+                free(seg);
+            }
+
+            if (seq_ok)
+            {
+                it.cds_len = cds.size() - it.cds_seq;
+            }
+            else
+            {
+                cds.resize(it.cds_seq);
+                it.cds_len = 0;
+                if (it.coding) ++no_missing_seq;
+            }
+
+            ic.max_tx_len = std::max(ic.max_tx_len, it.end1-it.beg1+1);
+            itxs.push_back(it);
+            delete t;
+        }
+
+        ic.tx_end = itxs.size();
+        ichroms.push_back(ic);
+    }
+
+    delete rs;
+    if (s.m) free(s.s);
+
+    if (no_missing_seq)
+    {
+        fprintf(stderr, "[%s:%d %s] CDS sequence not found in reference for %d transcripts\n", __FILE__, __LINE__, __FUNCTION__, no_missing_seq);
+    }
+
+    /////////
+    //write//
+    /////////
+    FILE* fp = fopen(index_file.c_str(), "wb");
+    if (fp==NULL)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot write GENCODE index: %s\n", __FILE__, __LINE__, __FUNCTION__, index_file.c_str());
+        exit(1);
+    }
+
+    gc_idx_hdr_t h;
+    memset(&h, 0, sizeof(gc_idx_hdr_t));
+    memcpy(h.magic, GC_IDX_MAGIC, strlen(GC_IDX_MAGIC));
+    h.version = GC_IDX_VERSION;
+    h.n_chrom = ichroms.size();
+    h.n_tx = itxs.size();
+    h.n_exon = iexons.size();
+    h.chrom_off = (sizeof(gc_idx_hdr_t)+7)&~7ULL;
+    h.tx_off = (h.chrom_off + h.n_chrom*sizeof(gc_idx_chrom_t)+7)&~7ULL;
+    h.exon_off = (h.tx_off + h.n_tx*sizeof(gc_idx_tx_t)+7)&~7ULL;
+    h.str_off = (h.exon_off + h.n_exon*sizeof(gc_idx_exon_t)+7)&~7ULL;
+    h.str_len = pool.size();
+    h.seq_off = (h.str_off + h.str_len+7)&~7ULL;
+    h.seq_len = cds.size();
+
+    uint64_t off = 0;
+    off += fwrite(&h, 1, sizeof(gc_idx_hdr_t), fp);
+    off = align8(fp, off);
+    if (h.n_chrom) off += fwrite(&ichroms[0], 1, h.n_chrom*sizeof(gc_idx_chrom_t), fp);
+    off = align8(fp, off);
+    if (h.n_tx) off += fwrite(&itxs[0], 1, h.n_tx*sizeof(gc_idx_tx_t), fp);
+    off = align8(fp, off);
+    if (h.n_exon) off += fwrite(&iexons[0], 1, h.n_exon*sizeof(gc_idx_exon_t), fp);
+    off = align8(fp, off);
+    off += fwrite(pool.c_str(), 1, pool.size(), fp);
+    off = align8(fp, off);
+    off += fwrite(cds.c_str(), 1, cds.size(), fp);
+
+    if (fclose(fp) || off!=h.seq_off+h.seq_len)
+    {
+        fprintf(stderr, "[%s:%d %s] Error writing GENCODE index: %s\n", __FILE__, __LINE__, __FUNCTION__, index_file.c_str());
+        exit(1);
+    }
+
+    return h.n_tx;
+}
+
+/**
+ * Gets the transcripts overlapping chrom:beg1-end1, including the essential splice sites
+ * flanking their exons.  Transcript indices are stored in tx.
+ */
+void GENCODEIndex::search(const char* chrom, int32_t beg1, int32_t end1, std::vector<int32_t>& tx)
+{
+    tx.clear();
+
+    std::map<std::string, int32_t>::iterator i = chrom2idx.find(chrom);
+    if (i==chrom2idx.end()) return;
+
+    const gc_idx_chrom_t& c = chroms[i->second];
+
+    //first transcript starting after end1
+    uint32_t lo = c.tx_beg, hi = c.tx_end;
+    while (lo<hi)
+    {
+        uint32_t mid = lo + ((hi-lo)>>1);
+        if (txs[mid].beg1<=end1) lo = mid+1;
+        else hi = mid;
+    }
+
+    //transcripts are sorted by start so the scan stops once no transcript can reach beg1
+    for (int64_t j=(int64_t)lo-1; j>=(int64_t)c.tx_beg; --j)
+    {
+        if (txs[j].beg1 + c.max_tx_len <= beg1) break;
+        if (txs[j].end1>=beg1) tx.push_back(j);
+    }
+}
+
+/**
+ * Returns the offset in the CDS of pos1 on transcript t, -1 if pos1 is not coding.
+ */
+int32_t GENCODEIndex::cds_offset(const gc_idx_tx_t& t, int32_t pos1)
+{
+    for (uint32_t i=t.exon_beg; i<t.exon_beg+t.n_exon; ++i)
+    {
+        const gc_idx_exon_t& e = exons[i];
+        if (e.cds_beg1 && pos1>=e.cds_beg1 && pos1<=e.cds_end1)
+        {
+            return t.strand=='+' ? e.cds_off + pos1 - e.cds_beg1 : e.cds_off + e.cds_end1 - pos1;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Returns true if pos1 lies in the 2 intronic bases flanking an internal exon boundary.
+ */
+bool GENCODEIndex::is_splice_site(const gc_idx_tx_t& t, int32_t pos1)
+{
+    for (uint32_t i=t.exon_beg; i<t.exon_beg+t.n_exon; ++i)
+    {
+        const gc_idx_exon_t& e = exons[i];
+        if (i!=t.exon_beg && pos1>=e.beg1-2 && pos1<e.beg1) return true;
+        if (i!=t.exon_beg+t.n_exon-1 && pos1>e.end1 && pos1<=e.end1+2) return true;
+    }
+
+    return false;
+}
+
+/**
+ * Returns true if pos1 lies in an exon.
+ */
+bool GENCODEIndex::is_exonic(const gc_idx_tx_t& t, int32_t pos1)
+{
+    for (uint32_t i=t.exon_beg; i<t.exon_beg+t.n_exon; ++i)
+    {
+        if (pos1>=exons[i].beg1 && pos1<=exons[i].end1) return true;
+    }
+
+    return false;
+}
+
+/**
+ * Returns the consequence of replacing ref with alt at pos1 on transcript t.
+ */
+int32_t GENCODEIndex::annotate(int32_t t, int32_t pos1, const char* ref, const char* alt)
+{
+    const gc_idx_tx_t& tx = txs[t];
+
+    //trim shared bases
+    int32_t rlen = strlen(ref);
+    int32_t alen = strlen(alt);
+    while (rlen && alen && *ref==*alt)
+    {
+        ++ref; ++alt; ++pos1;
+        --rlen; --alen;
+    }
+    while (rlen && alen && ref[rlen-1]==alt[alen-1])
+    {
+        --rlen; --alen;
+    }
+
+    int32_t csq = GC_CSQ_NONE;
+    int32_t exonic_csq = tx.coding ? GC_CSQ_UTR : GC_CSQ_NONCODING_EXON;
+
+    if (rlen==alen)
+    {
+        //substitution, codons are mutated with all changes falling in them
+        std::vector<int32_t> offs(rlen, -1);
+        for (int32_t i=0; i<rlen; ++i)
+        {
+            int32_t p = pos1+i;
+            if (ref[i]==alt[i]) continue;
+
+            if (is_splice_site(tx, p))
+            {
+                csq = std::max(csq, GC_CSQ_SPLICE);
+            }
+            else if (p>=tx.beg1 && p<=tx.end1)
+            {
+                csq = std::max(csq, is_exonic(tx, p) ? exonic_csq : GC_CSQ_INTRON);
+            }
+
+            int32_t o = cds_offset(tx, p);
+            if (o<0) continue;
+
+            o -= tx.phase;
+            if (o<0 || o/3*3+2>=(int32_t)tx.cds_len)
+            {
+                csq = std::max(csq, GC_CSQ_CODING);
+                continue;
+            }
+            offs[i] = o;
+        }
+
+        for (int32_t i=0; i<rlen; ++i)
+        {
+            if (offs[i]<0) continue;
+
+            int32_t c = offs[i]/3;
+            const char* ref_codon = &seq[tx.cds_seq + c*3];
+            char alt_codon[3] = {ref_codon[0], ref_codon[1], ref_codon[2]};
+            for (int32_t j=0; j<rlen; ++j)
+            {
+                if (offs[j]>=0 && offs[j]/3==c)
+                {
+                    char b = toupper(alt[j]);
+                    if (tx.strand!='+') b = b=='A' ? 'T' : b=='C' ? 'G' : b=='G' ? 'C' : b=='T' ? 'A' : 'N';
+                    alt_codon[offs[j]%3] = b;
+                }
+            }
+
+            char ref_aa = translate(ref_codon);
+            char alt_aa = translate(alt_codon);
+            if (ref_aa=='X' || alt_aa=='X')
+                csq = std::max(csq, GC_CSQ_CODING);
+            else if (ref_aa==alt_aa)
+                csq = std::max(csq, GC_CSQ_SYNONYMOUS);
+            else if (alt_aa=='*')
+                csq = std::max(csq, GC_CSQ_NONSENSE);
+            else if (ref_aa=='*')
+                csq = std::max(csq, GC_CSQ_STOP_LOST);
+            else
+                csq = std::max(csq, GC_CSQ_MISSENSE);
+        }
+    }
+    else
+    {
+        //indels affect the deleted bases or the bases flanking an insertion
+        int32_t beg1 = rlen ? pos1 : pos1-1;
+        int32_t end1 = rlen ? pos1+rlen-1 : pos1;
+        bool coding = false;
+        for (int32_t p=beg1; p<=end1; ++p)
+        {
+            if (is_splice_site(tx, p))
+            {
+                csq = std::max(csq, GC_CSQ_SPLICE);
+            }
+            else if (p>=tx.beg1 && p<=tx.end1)
+            {
+                csq = std::max(csq, is_exonic(tx, p) ? exonic_csq : GC_CSQ_INTRON);
+            }
+
+            coding = coding || cds_offset(tx, p)>=0;
+        }
+
+        //an insertion is coding only if both flanks are
+        if (!rlen)
+        {
+            coding = cds_offset(tx, beg1)>=0 && cds_offset(tx, end1)>=0;
+        }
+
+        if (coding)
+        {
+            csq = std::max(csq, (alen-rlen)%3 ? GC_CSQ_FRAMESHIFT : GC_CSQ_INFRAME);
+        }
+    }
+
+    return csq;
+}
+
+/**
+ * Converts a consequence to a string.
+ */
+const char* GENCODEIndex::csq2string(int32_t csq)
+{
+    switch (csq)
+    {
+        case GC_CSQ_INTRON:         return "intron";
+        case GC_CSQ_NONCODING_EXON: return "noncoding_exon";
+        case GC_CSQ_UTR:            return "UTR";
+        case GC_CSQ_SYNONYMOUS:     return "synonymous";
+        case GC_CSQ_CODING:         return "coding";
+        case GC_CSQ_MISSENSE:       return "missense";
+        case GC_CSQ_INFRAME:        return "inframe";
+        case GC_CSQ_STOP_LOST:      return "stop_lost";
+        case GC_CSQ_FRAMESHIFT:     return "frameshift";
+        case GC_CSQ_NONSENSE:       return "nonsense";
+        case GC_CSQ_SPLICE:         return "splice";
+        default:                    return ".";
+    }
+}
+
+/**
+ * Translates a codon in the standard genetic code, stop codons are translated to '*'.
+ */
+char GENCODEIndex::translate(const char* codon)
+{
+    //codons are ordered TCAG at each position
+    static const char* aa = "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+
+    int32_t c = 0;
+    for (int32_t i=0; i<3; ++i)
+    {
+        switch (codon[i])
+        {
+            case 'T': case 't': c = c*4;   break;
+            case 'C': case 'c': c = c*4+1; break;
+            case 'A': case 'a': c = c*4+2; break;
+            case 'G': case 'g': c = c*4+3; break;
+            default: return 'X';
+        }
+    }
+
+    return aa[c];
+}
@@ -0,0 +1,247 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#ifndef GENCODE_INDEX_H
+#define GENCODE_INDEX_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "htslib/faidx.h"
+#include "htslib/kstring.h"
+#include "hts_utils.h"
+#include "utils.h"
+#include "reference_sequence.h"
+
+#define GC_IDX_MAGIC "VTGCIDX"
+#define GC_IDX_VERSION 1
+
+//consequence classes, ordered from most to least severe
+#define GC_CSQ_NONE           0
+#define GC_CSQ_INTRON         1
+#define GC_CSQ_NONCODING_EXON 2
+#define GC_CSQ_UTR            3
+#define GC_CSQ_SYNONYMOUS     4
+#define GC_CSQ_CODING         5
+#define GC_CSQ_MISSENSE       6
+#define GC_CSQ_INFRAME        7
+#define GC_CSQ_STOP_LOST      8
+#define GC_CSQ_FRAMESHIFT     9
+#define GC_CSQ_NONSENSE       10
+#define GC_CSQ_SPLICE         11
+
+/**
+ * On disk layout of the GENCODE index.
+ *
+ * header | chromosomes | transcripts | exons | string pool | CDS sequence pool
+ *
+ * All sections are 8 byte aligned and the file is mapped read only,
+ * records are read in place without deserialization.
+ */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t n_chrom;
+    uint32_t n_tx;
+    uint32_t n_exon;
+    uint64_t chrom_off;
+    uint64_t tx_off;
+    uint64_t exon_off;
+    uint64_t str_off;
+    uint64_t str_len;
+    uint64_t seq_off;
+    uint64_t seq_len;
+} gc_idx_hdr_t;
+
+typedef struct
+{
+    uint32_t name;        //offset into string pool
+    uint32_t tx_beg;      //first transcript of this chromosome
+    uint32_t tx_end;      //one past the last transcript of this chromosome
+    int32_t max_tx_len;   //longest transcript, bounds the backward scan in search
+} gc_idx_chrom_t;
+
+typedef struct
+{
+    int32_t beg1;
+    int32_t end1;
+    uint32_t gene;        //offset into string pool
+    uint32_t id;          //offset into string pool
+    uint32_t exon_beg;    //first exon, exons are sorted by genomic position
+    uint32_t n_exon;
+    uint64_t cds_seq;     //offset into sequence pool, CDS in the direction of transcription
+    uint32_t cds_len;
+    char strand;
+    uint8_t coding;
+    uint8_t phase;        //bases preceding the first complete codon of a 5' incomplete CDS
+    uint8_t pad;
+} gc_idx_tx_t;
+
+typedef struct
+{
+    int32_t beg1;
+    int32_t end1;
+    int32_t cds_beg1;     //coding portion of the exon, 0 if the exon is not coding
+    int32_t cds_end1;
+    int32_t cds_off;      //offset in the CDS of the first coding base in the direction of transcription
+    int32_t pad;
+} gc_idx_exon_t;
+
+/**
+ * Compact memory mapped GENCODE transcript index.
+ *
+ * The index is built once from a GENCODE GTF file and a reference
+ * with GENCODEIndex::build and can then be loaded in constant time.
+ */
+class GENCODEIndex
+{
+    public:
+
+    std::string index_file;
+
+    /**
+     * Constructs and loads a GENCODE index.
+     */
+    GENCODEIndex(std::string& index_file);
+
+    /**
+     * Unmaps the index.
+     */
+    ~GENCODEIndex();
+
+    /**
+     * Returns a shared handle to the index in index_file, loading it on first use.
+     */
+    static GENCODEIndex* acquire(std::string& index_file);
+
+    /**
+     * Returns a shared handle to an index of a GENCODE GTF file, built in a
+     * temporary file on first use.  The handle is registered under the GTF
+     * file so that acquire on the GTF file returns it while it is held.
+     */
+    static GENCODEIndex* acquire(std::string& gencode_gtf_file, std::string& ref_fasta_file);
+
+    /**
+     * Releases a handle obtained with acquire, the index is unmapped when it is no longer used.
+     */
+    static void release(GENCODEIndex* gci);
+
+    /**
+     * Builds a GENCODE index from a GTF file, the CDS sequences are extracted from the reference.
+     * Returns the number of transcripts indexed.
+     */
+    static int32_t build(std::string& gencode_gtf_file, std::string& ref_fasta_file, std::string& index_file);
+
+    /**
+     * Checks if file is a GENCODE index.
+     */
+    static bool is_index(std::string& file);
+
+    /**
+     * Gets the transcripts overlapping chrom:beg1-end1, including the essential splice sites
+     * flanking their exons.  Transcript indices are stored in tx.
+     */
+    void search(const char* chrom, int32_t beg1, int32_t end1, std::vector<int32_t>& tx);
+
+    /**
+     * Returns the consequence of replacing ref with alt at pos1 on transcript t.
+     */
+    int32_t annotate(int32_t t, int32_t pos1, const char* ref, const char* alt);
+
+    /**
+     * Returns the transcript record for t.
+     */
+    const gc_idx_tx_t* get_transcript(int32_t t) { return &txs[t]; };
+
+    /**
+     * Returns the gene name of transcript t.
+     */
+    const char* get_gene(int32_t t) { return &str[txs[t].gene]; };
+
+    /**
+     * Returns the transcript ID of transcript t.
+     */
+    const char* get_transcript_id(int32_t t) { return &str[txs[t].id]; };
+
+    /**
+     * Returns number of transcripts.
+     */
+    uint32_t size() { return hdr->n_tx; };
+
+    /**
+     * Converts a consequence to a string.
+     */
+    static const char* csq2string(int32_t csq);
+
+    /**
+     * Translates a codon in the standard genetic code, stop codons are translated to '*'.
+     */
+    static char translate(const char* codon);
+
+    private:
+
+    int fd;
+    void* map;
+    size_t map_len;
+
+    const gc_idx_hdr_t* hdr;
+    const gc_idx_chrom_t* chroms;
+    const gc_idx_tx_t* txs;
+    const gc_idx_exon_t* exons;
+    const char* str;
+    const char* seq;
+
+    std::map<std::string, int32_t> chrom2idx;
+
+    int32_t no_users;
+
+    static std::map<std::string, GENCODEIndex*> indices;
+    static std::mutex indices_mutex;
+
+    /**
+     * Returns the offset in the CDS of pos1 on transcript t, -1 if pos1 is not coding.
+     */
+    int32_t cds_offset(const gc_idx_tx_t& t, int32_t pos1);
+
+    /**
+     * Returns true if pos1 lies in the 2 intronic bases flanking an internal exon boundary.
+     */
+    bool is_splice_site(const gc_idx_tx_t& t, int32_t pos1);
+
+    /**
+     * Returns true if pos1 lies in an exon.
+     */
+    bool is_exonic(const gc_idx_tx_t& t, int32_t pos1);
+};
+
+#endif
@@ -26,16 +26,6 @@
 namespace
 {
 
-/**
- * For detecting overlapping reads.
- */
-typedef struct
-{
-  int32_t start1, end1;
-} interval_t;
-
-KHASH_MAP_INIT_STR(rdict, interval_t)
-
 class Igor : Program
 {
     public:
@@ -52,6 +42,7 @@ class Igor : Program
     std::string ref_fasta_file;
     std::string mode;
     bool ignore_md;
+    bool realign_indels;
     int32_t debug;
 
     //variables for keeping track of chromosome
@@ -74,7 +65,7 @@ class Igor : Program
     std::vector<GenomeInterval> intervals;
 
     //options for selecting reads
-    khash_t(rdict) *reads;
+    OverlappingReadTracker mates;
 
     /////////
     //stats//
@@ -127,6 +118,7 @@ class Igor : Program
                  "              s : iterate by sites for sparse genotyping.\n"
                  "                 (e.g. 100 variants scattered over the genome).",
                  false, "d", "str", cmd);
+            TCLAP::SwitchArg arg_realign_indels("x", "x", "realign reads against candidate indel haplotypes with a pair HMM [false]", cmd, false);
             TCLAP::ValueArg<std::string> arg_ref_fasta_file("r", "r", "reference FASTA file []", true, "", "string", cmd);
             TCLAP::ValueArg<uint32_t> arg_debug("d", "d", "debug [0]", false, 0, "int", cmd);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
@@ -134,6 +126,7 @@ class Igor : Program
             cmd.parse(argc, argv);
 
             mode = arg_mode.getValue();
+            realign_indels = arg_realign_indels.getValue();
             input_vcf_file = arg_input_vcf_file.getValue();
             input_sam_file = arg_input_sam_file.getValue();
             output_vcf_file = arg_output_vcf_file.getValue();
@@ -169,6 +162,7 @@ class Igor : Program
 
         //input vcf
         gbr = new BCFGenotypingBufferedReader(input_vcf_file, intervals, ref_fasta_file);
+        gbr->realign_indels = realign_indels;
 
         //output vcf
         odw = new BCFOrderedWriter(output_vcf_file);
@@ -254,9 +248,6 @@ class Igor : Program
         no_indels_genotyped = 0;
         no_vntrs_genotyped = 0;
 
-        //for tracking overlapping reads
-        reads = kh_init(rdict);
-
         //////////////////////////////////////
         //discovery variables initialization//
         //////////////////////////////////////
@@ -278,48 +269,11 @@ class Igor : Program
      */
     bool filter_read(bam1_t *s)
     {
-        khiter_t k;
-        int32_t ret;
-
-        if (ignore_overlapping_read)
+        if (ignore_overlapping_read && mates.is_overlapping_mate(s))
         {
-            //this read is part of a mate pair on the same contig
-            if (bam_get_mpos1(s) && (bam_get_tid(s)==bam_get_mtid(s)))
-            {
-                //first mate
-                if (bam_get_mpos1(s)>bam_get_pos1(s))
-                {
-                    //overlapping
-                    if (bam_get_mpos1(s)<=(bam_get_pos1(s) + bam_get_l_qseq(s) - 1))
-                    {
-                        //add read that has overlapping
-                        //duplicate the record and perform the stitching later
-                        char* qname = strdup(bam_get_qname(s));
-                        k = kh_put(rdict, reads, qname, &ret);
-                        if (!ret)
-                        {
-                            //already present
-                            free(qname);
-                        }
-                        kh_val(reads, k) = {bam_get_pos1(s), bam_get_pos1(s)+bam_get_l_qseq(s)-1};
-                    }
-                }
-                else
-                {
-                    //check overlap
-                    if((k = kh_get(rdict, reads, bam_get_qname(s)))!=kh_end(reads))
-                    {
-                        if (kh_exist(reads, k))
-                        {
-                            free((char*)kh_key(reads, k));
-                            kh_del(rdict, reads, k);
-                            ++no_overlapping_reads;
-                        }
-                        //set this on to remove overlapping reads.
-                        return false;
-                    }
-                }
-            }
+            //set this on to remove overlapping reads.
+            ++no_overlapping_reads;
+            return false;
         }
 
         if(bam_get_flag(s) & read_exclude_flag)
@@ -424,22 +378,7 @@ class Igor : Program
             }
         }
 
-        //check to see that hash should be cleared when encountering new contig.
-        //some bams may not be properly formed and contain orphaned sequences that
-        //can be retained in the hash
-        if (bam_get_tid(s)!=tid)
-        {
-            for (k = kh_begin(reads); k != kh_end(reads); ++k)
-            {
-                if (kh_exist(reads, k))
-                {
-                    free((char*)kh_key(reads, k));
-                    kh_del(rdict, reads, k);
-                }
-            }
-
-            tid = bam_get_tid(s);
-        }
+        tid = bam_get_tid(s);
 
         return true;
     }
@@ -538,6 +477,7 @@ class Igor : Program
         std::clog << "         [r] reference FASTA File                 " << ref_fasta_file << "\n";
         std::clog << "         [z] ignore MD tags                       " << (ignore_md ? "true": "false") << "\n";
         std::clog << "         [m] mode of genotyping                   " << mode << "\n";
+        std::clog << "         [x] realign indels                       " << (realign_indels ? "true" : "false") << "\n";
         print_int_op("         [i] intervals                            ", intervals);
         std::clog << "\n";
         std::clog << "         [t] read mapping quality cutoff          " << read_mapq_cutoff << "\n";
@@ -556,6 +496,9 @@ class Igor : Program
         std::clog << "       no. low mapq reads           : " << no_low_mapq_reads << "\n";
         std::clog << "       no. passed reads             : " << no_passed_reads << "\n";
         std::clog << "       no. exclude flag reads       : " << no_exclude_flag_reads << "\n";
+        std::clog << "       no. tracked overlapping mates: " << mates.no_tracked << "\n";
+        std::clog << "       no. expired overlapping mates: " << mates.no_expired << "\n";
+        std::clog << "       max. pending mates (KB)      : " << mates.max_pending << " (" << (mates.max_bytes>>10) << ")\n";
         std::clog << "\n";
         std::clog << "       no. unaligned cigars         : " << no_unaligned_cigars << "\n";
         std::clog << "       no. malformed del cigars     : " << no_malformed_del_cigars << "\n";
@@ -570,7 +513,6 @@ class Igor : Program
 
     ~Igor()
     {
-        kh_destroy(rdict, reads);
     };
 
     private:
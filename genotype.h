@@ -32,6 +32,7 @@
 #include "htslib/vcf.h"
 #include "hts_utils.h"
 #include "log_tool.h"
+#include "overlapping_read_tracker.h"
 #include "program.h"
 #include "utils.h"
 #include "variant_manip.h"
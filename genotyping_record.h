@@ -91,6 +91,11 @@ class GenotypingRecord
     std::vector<uint32_t> allele_depth_rev;
     uint32_t depth, depth_fwd, depth_rev;
     uint32_t base_qualities_sum;
+
+    //aligned bases and qualities of reads kept for haplotype realignment
+    std::vector<std::string> rl_reads;
+    std::vector<std::string> rl_quals;
+    int32_t rl_beg1, rl_end1;
     
 
     //vntr specific record
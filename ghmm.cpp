@@ -23,6 +23,8 @@
 
 #include "ghmm.h"
 
+VT_TIMER_STAT(align_stat, "ghmm.align");
+
 #include <algorithm>
 #include <iostream>
 #include <string>
@@ -30,35 +32,52 @@
 GHMM::GHMM(bool debug)
 {
     this->debug = debug;
+    matrix = NULL;
+    matrix_size = 0;
+    stride = 0;
+}
+
+GHMM::~GHMM()
+{
+    AlignmentWorkspace::release(matrix, matrix_size);
 }
 
 void GHMM::align(const char* ref, const char* read)
 {
+    VT_TIME(align_stat);
+
     this->ref = ref;
     this->read = read;
     this->len_ref = strlen(ref);
     this->len_read = strlen(read);
 
-    matrix.clear();
-    matrix.resize((len_ref + 1) * (len_read + 1), EMPTY);
+    stride = len_read + 1;
+    size_t size = (len_ref + 1) * stride;
+    if (size>matrix_size)
+    {
+        AlignmentWorkspace::release(matrix, matrix_size);
+        matrix_size = size;
+        matrix = AlignmentWorkspace::acquire<Traceback>(matrix_size);
+    }
+    std::fill(matrix, matrix + size, EMPTY);
 
     // fill first column and row
     scores.resize(len_read + 1);
     for (unsigned i = 0; i <= len_ref; ++i)
-        matrix.at(i * (len_read + 1)) = CIGAR_D;
+        matrix[i * stride] = CIGAR_D;
     for (unsigned i = 0; i <= len_read; ++i)
     {
-        matrix.at(i) = CIGAR_I;
+        matrix[i] = CIGAR_I;
         scores.at(i) = i * params.score_gap;
     }
-    matrix.at(0) = CIGAR_M;
+    matrix[0] = CIGAR_M;
 
     // fill remainder of the matrix
     int offset = 0;
     int score_n = 0;
     for (unsigned i = 1; i <= len_ref; ++i)
     {
-        offset += len_read + 1;
+        offset += stride;
         score_n += params.score_gap;
         int best_score = 0;
         for (unsigned j = 1; j <= len_read; ++j)
@@ -94,7 +113,7 @@ void GHMM::align(const char* ref, const char* read)
 
             scores.at(j - 1) = score_n;
             score_n = best_score;
-            matrix.at(offset + j) = best_dir;
+            matrix[offset + j] = best_dir;
         }
         scores.back() = best_score;
     }
@@ -105,20 +124,20 @@ void GHMM::trace_path()
 {
     int i = len_ref;
     int j = len_read;
-    int k = (len_read + 1) * (len_ref + 1) - 1;
+    int k = (len_ref + 1) * stride - 1;
 
     trace.clear();
 
     while (i>0 || j>0)
     {
-        trace.push_back(matrix.at(k));
-        switch ((int32_t) matrix.at(k))
+        trace.push_back(matrix[k]);
+        switch ((int32_t) matrix[k])
         {
             case CIGAR_X:
             case CIGAR_M:
                 --i;
                 --j;
-                k -= len_read + 2;
+                k -= stride + 1;
                 break;
             case CIGAR_I:
                 --j;
@@ -126,7 +145,7 @@ void GHMM::trace_path()
                 break;
             case CIGAR_D:
                 --i;
-                k -= len_read + 1;
+                k -= stride;
                 break;
         }
     }
@@ -25,6 +25,8 @@
 
 #include <vector>
 #include "log_tool.h"
+#include "align_workspace.h"
+#include "instrument.h"
 
 class GHMMParameters
 {
@@ -53,7 +55,12 @@ class GHMM
     int len_read;
 
     std::vector<int> scores;
-    std::vector<Traceback> matrix;
+
+    //traceback matrix of len_ref+1 rows of stride cells from the alignment workspace
+    Traceback* matrix;
+    size_t matrix_size;
+    size_t stride;
+
     std::vector<Traceback> trace;
 
     GHMMParameters params;
@@ -63,6 +70,11 @@ class GHMM
      */
     GHMM(bool debug=false);
 
+    /**
+     * Destructor.
+     */
+    ~GHMM();
+
     /**
      * Constructor.
      */
@@ -24,6 +24,9 @@
 #include "hts_utils.h"
 #include "Rmath/Rmath.h"
 
+VT_TIMER_STAT(fetch_stat, "faidx.fetch");
+VT_COUNTER_STAT(fetch_bases_stat, "faidx.bases");
+
 /********
  *General
  ********/
@@ -40,13 +43,16 @@ typedef khash_t(vdict) vdict_t;
  */
 char *faidx_fetch_uc_seq(const faidx_t *fai, const char *c_name, int p_beg_i, int p_end_i, int *len)
 {
+    VT_TIME(fetch_stat);
+
     char* seq = faidx_fetch_seq(fai, c_name, p_beg_i, p_end_i, len);
    
     for (int32_t i=0; i<*len; ++i)
     {
         if (isgraph(seq[i])) seq[i] = toupper(seq[i]);
     }
-    
+    VT_COUNT(fetch_bases_stat, *len>0 ? *len : 0);
+
     return seq;
 }
 
@@ -1235,20 +1241,7 @@ void bcf_set_info_flg(bcf_hdr_t *h, bcf1_t *v, const char* tag, bool value)
  */
 int32_t bcf_get_info_int(bcf_hdr_t *h, bcf1_t *v, const char* tag, int32_t default_value)
 {
-    int32_t i = 0;
-    int32_t* temp_i = NULL;
-    int32_t n = 0;
-    if (bcf_get_info_int32(h, v, tag, &temp_i, &n)>0)
-    {
-        i = *temp_i;
-        free(temp_i);
-    }
-    else
-    {
-        return default_value;
-    }
-
-    return i;
+    return bcf_get_info_int(v, bcf_hdr_get_info_id(h, tag, BCF_HT_INT), default_value);
 }
 
 /**
@@ -1265,18 +1258,7 @@ void bcf_set_info_int(bcf_hdr_t *h, bcf1_t *v, const char* tag, int32_t value)
 std::vector<int32_t> bcf_get_info_int_vec(bcf_hdr_t *h, bcf1_t *v, const char* tag, int32_t default_size, int32_t default_value)
 {
     std::vector<int32_t> i_vec;
-    int32_t* temp_i = NULL;
-    int32_t n = 0;
-    if (bcf_get_info_int32(h, v, tag, &temp_i, &n)>0)
-    {
-        for (int32_t j=0; j<n; ++j) i_vec.push_back(temp_i[j]);
-        free(temp_i);
-    }
-    else
-    {
-        i_vec.resize(default_size, default_value);
-    }
-
+    bcf_get_info_int_vec(v, bcf_hdr_get_info_id(h, tag, BCF_HT_INT), i_vec, default_size, default_value);
     return i_vec;
 }
 
@@ -1301,20 +1283,7 @@ void bcf_set_info_int(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::vector<int3
  */
 float bcf_get_info_flt(bcf_hdr_t *h, bcf1_t *v, const char* tag, float default_value)
 {
-    float f = 0;
-    float* temp_f = NULL;
-    int32_t n = 0;
-    if (bcf_get_info_float(h, v, tag, &temp_f, &n)>0)
-    {
-        f = *temp_f;
-        free(temp_f);
-    }
-    else
-    {
-        return default_value;
-    }
-
-    return f;
+    return bcf_get_info_flt(v, bcf_hdr_get_info_id(h, tag, BCF_HT_REAL), default_value);
 }
 
 /**
@@ -1331,7 +1300,7 @@ void bcf_set_info_flt(bcf_hdr_t *h, bcf1_t *v, const char* tag, float value)
 std::vector<float> bcf_get_info_flt_vec(bcf_hdr_t *h, bcf1_t *v, const char* tag, int32_t default_size, float default_value)
 {
     std::vector<float> vec;
-
+    bcf_get_info_flt_vec(v, bcf_hdr_get_info_id(h, tag, BCF_HT_REAL), vec, default_size, default_value);
     return vec;
 }
 
@@ -1347,20 +1316,9 @@ void bcf_set_info_flt_vec(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::vector<
  */
 std::string bcf_get_info_str(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::string default_value)
 {
-    std::string str = "";
-    char* s = NULL;
-    int32_t n = 0;
-    if (bcf_get_info_string(h, v, tag, &s, &n)>0)
-    {
-        str.assign(s);
-        free(s);
-    }
-    else
-    {
-        return default_value;
-    }
-
-    return str;
+    const char* s = NULL;
+    int32_t len = bcf_get_info_str(v, bcf_hdr_get_info_id(h, tag, BCF_HT_STR), &s);
+    return len<0 ? default_value : std::string(s, len);
 }
 
 /**
@@ -1376,28 +1334,215 @@ void bcf_set_info_str(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::string defa
 std::vector<std::string> bcf_get_info_str_vec(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::string default_value)
 {
     std::vector<std::string> vec;
-    std::string str = "";
-    char* s = NULL;
+    const char* s = NULL;
+    int32_t len = bcf_get_info_str(v, bcf_hdr_get_info_id(h, tag, BCF_HT_STR), &s);
+    vec.push_back(len<0 ? default_value : std::string(s, len));
+    return vec;
+}
+/**
+ * Sets an info string vector.
+ */
+void bcf_set_info_str_vec(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::vector<std::string> values)
+{
+}
+
+/**
+ * Gets the ID of an INFO field of type BCF_HT_INT, BCF_HT_REAL or BCF_HT_STR,
+ * -1 if the header does not define the field with that type.
+ */
+int32_t bcf_hdr_get_info_id(const bcf_hdr_t *h, const char* tag, int32_t type)
+{
+    int32_t id = bcf_hdr_id2int(h, BCF_DT_ID, tag);
+    if (!bcf_hdr_idinfo_exists(h, BCF_HL_INFO, id) || bcf_hdr_id2type(h, BCF_HL_INFO, id)!=type)
+    {
+        return -1;
+    }
+
+    return id;
+}
+
+/**
+ * Gets an info field of an unpacked record by ID, NULL if absent or marked for removal.
+ */
+static inline bcf_info_t* bcf_get_info_field(bcf1_t *v, int32_t id)
+{
+    if (id<0) return NULL;
+    bcf_info_t* info = bcf_get_info_id(v, id);
+    return (info && info->vptr) ? info : NULL;
+}
+
+/**
+ * Decodes the first n integers of an info field into values, values beyond the field are set to default_value.
+ * Returns the number of values before the end of vector marker.
+ */
+static int32_t bcf_decode_info_int(bcf_info_t* info, int32_t* values, int32_t n, int32_t default_value)
+{
+    int32_t len = 0;
+    int32_t m = std::min(n, info->len);
+
+    #define DECODE(type_t, convert, missing, vector_end) \
+    { \
+        for (len=0; len<info->len; ++len) \
+        { \
+            type_t p = convert(info->vptr + len*sizeof(type_t)); \
+            if (p==vector_end) break; \
+            if (len<m) values[len] = p==missing ? bcf_int32_missing : p; \
+        } \
+    }
+
+    switch (info->type)
+    {
+        case BCF_BT_INT8: DECODE(int8_t, le_to_i8, bcf_int8_missing, bcf_int8_vector_end); break;
+        case BCF_BT_INT16: DECODE(int16_t, le_to_i16, bcf_int16_missing, bcf_int16_vector_end); break;
+        case BCF_BT_INT32: DECODE(int32_t, le_to_i32, bcf_int32_missing, bcf_int32_vector_end); break;
+        default: break;
+    }
+
+    #undef DECODE
+
+    for (int32_t i=std::min(len, n); i<n; ++i) values[i] = default_value;
+    return len;
+}
+
+/**
+ * Decodes the first n floats of an info field into values, values beyond the field are set to default_value.
+ * Returns the number of values before the end of vector marker.
+ */
+static int32_t bcf_decode_info_flt(bcf_info_t* info, float* values, int32_t n, float default_value)
+{
+    int32_t len = 0;
+    if (info->type==BCF_BT_FLOAT)
+    {
+        //copied bitwise to keep the missing value marker
+        for (len=0; len<info->len; ++len)
+        {
+            uint32_t p = le_to_u32(info->vptr + len*sizeof(float));
+            if (p==bcf_float_vector_end) break;
+            if (len<n) bcf_float_set(&values[len], p);
+        }
+    }
+
+    for (int32_t i=std::min(len, n); i<n; ++i) values[i] = default_value;
+    return len;
+}
+
+/**
+ * Gets an info integer by ID.
+ */
+int32_t bcf_get_info_int(bcf1_t *v, int32_t id, int32_t default_value)
+{
+    int32_t value = default_value;
+    bcf_info_t* info = bcf_get_info_field(v, id);
+    if (info) bcf_decode_info_int(info, &value, 1, default_value);
+    return value;
+}
+
+/**
+ * Gets the first n integers of an info field by ID into values, values beyond the field are set to default_value.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_int_vec(bcf1_t *v, int32_t id, int32_t* values, int32_t n, int32_t default_value)
+{
+    bcf_info_t* info = bcf_get_info_field(v, id);
+    if (info) return bcf_decode_info_int(info, values, n, default_value);
+
+    for (int32_t i=0; i<n; ++i) values[i] = default_value;
+    return 0;
+}
+
+/**
+ * Gets an info integer vector by ID into values, default_size default_values if absent.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_int_vec(bcf1_t *v, int32_t id, std::vector<int32_t>& values, int32_t default_size, int32_t default_value)
+{
+    bcf_info_t* info = bcf_get_info_field(v, id);
     int32_t n = 0;
-    int32_t ret = 0;
-    if ((ret=bcf_get_info_string(h, v, tag, &s, &n))>0)
+    if (info)
     {
-        str.assign(s);
-        free(s);
-        vec.push_back(str);
+        values.resize(info->len);
+        n = bcf_decode_info_int(info, values.data(), info->len, default_value);
     }
-    else
+
+    if (n) values.resize(n);
+    else values.assign(default_size, default_value);
+
+    return n;
+}
+
+/**
+ * Gets an info float by ID.
+ */
+float bcf_get_info_flt(bcf1_t *v, int32_t id, float default_value)
+{
+    float value = default_value;
+    bcf_info_t* info = bcf_get_info_field(v, id);
+    if (info) bcf_decode_info_flt(info, &value, 1, default_value);
+    return value;
+}
+
+/**
+ * Gets the first n floats of an info field by ID into values, values beyond the field are set to default_value.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_flt_vec(bcf1_t *v, int32_t id, float* values, int32_t n, float default_value)
+{
+    bcf_info_t* info = bcf_get_info_field(v, id);
+    if (info) return bcf_decode_info_flt(info, values, n, default_value);
+
+    for (int32_t i=0; i<n; ++i) values[i] = default_value;
+    return 0;
+}
+
+/**
+ * Gets an info float vector by ID into values, default_size default_values if absent.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_flt_vec(bcf1_t *v, int32_t id, std::vector<float>& values, int32_t default_size, float default_value)
+{
+    bcf_info_t* info = bcf_get_info_field(v, id);
+    int32_t n = 0;
+    if (info)
     {
-        vec.push_back(default_value);
+        values.resize(info->len);
+        n = bcf_decode_info_flt(info, values.data(), info->len, default_value);
     }
 
-    return vec;
+    if (n) values.resize(n);
+    else values.assign(default_size, default_value);
+
+    return n;
 }
+
 /**
- * Sets an info string vector.
+ * Gets a read only view of an info string by ID, valid until the record is modified.
+ * Returns the length of the string, -1 if absent.
  */
-void bcf_set_info_str_vec(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::vector<std::string> values)
+int32_t bcf_get_info_str(bcf1_t *v, int32_t id, const char** s)
+{
+    bcf_info_t* info = bcf_get_info_field(v, id);
+    if (!info || info->type!=BCF_BT_CHAR || !info->len) return -1;
+
+    *s = (const char*) info->vptr;
+    return strnlen(*s, info->len);
+}
+
+/**
+ * Gets an info string by ID into s.
+ * Returns false if absent, s is then set to default_value.
+ */
+bool bcf_get_info_str(bcf1_t *v, int32_t id, std::string& s, const char* default_value)
 {
+    const char* str = NULL;
+    int32_t len = bcf_get_info_str(v, id, &str);
+    if (len<0)
+    {
+        s.assign(default_value);
+        return false;
+    }
+
+    s.assign(str, len);
+    return true;
 }
 
 /**
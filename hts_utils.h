@@ -34,7 +34,9 @@
 #include "htslib/faidx.h"
 #include "htslib/tbx.h"
 #include "htslib/hfile.h"
+#include "htslib/hts_endian.h"
 #include "utils.h"
+#include "instrument.h"
 
 /**********
  *FAI UTILS
@@ -546,6 +548,61 @@ std::vector<std::string> bcf_get_info_str_vec(bcf_hdr_t *h, bcf1_t *v, const cha
  */
 void bcf_set_info_str_vec(bcf_hdr_t *h, bcf1_t *v, const char* tag, std::vector<std::string> values);
 
+/**
+ * Gets the ID of an INFO field of type BCF_HT_INT, BCF_HT_REAL or BCF_HT_STR,
+ * -1 if the header does not define the field with that type.
+ *
+ * The ID based accessors below read the unpacked record in place and do not
+ * allocate, resolve the IDs once per header and reuse the buffers across records.
+ */
+int32_t bcf_hdr_get_info_id(const bcf_hdr_t *h, const char* tag, int32_t type);
+
+/**
+ * Gets an info integer by ID.
+ */
+int32_t bcf_get_info_int(bcf1_t *v, int32_t id, int32_t default_value = 0);
+
+/**
+ * Gets the first n integers of an info field by ID into values, values beyond the field are set to default_value.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_int_vec(bcf1_t *v, int32_t id, int32_t* values, int32_t n, int32_t default_value = 0);
+
+/**
+ * Gets an info integer vector by ID into values, default_size default_values if absent.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_int_vec(bcf1_t *v, int32_t id, std::vector<int32_t>& values, int32_t default_size = 0, int32_t default_value = 0);
+
+/**
+ * Gets an info float by ID.
+ */
+float bcf_get_info_flt(bcf1_t *v, int32_t id, float default_value = 0);
+
+/**
+ * Gets the first n floats of an info field by ID into values, values beyond the field are set to default_value.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_flt_vec(bcf1_t *v, int32_t id, float* values, int32_t n, float default_value = 0);
+
+/**
+ * Gets an info float vector by ID into values, default_size default_values if absent.
+ * Returns the number of values of the field, 0 if absent.
+ */
+int32_t bcf_get_info_flt_vec(bcf1_t *v, int32_t id, std::vector<float>& values, int32_t default_size = 0, float default_value = 0);
+
+/**
+ * Gets a read only view of an info string by ID, valid until the record is modified.
+ * Returns the length of the string, -1 if absent.
+ */
+int32_t bcf_get_info_str(bcf1_t *v, int32_t id, const char** s);
+
+/**
+ * Gets an info string by ID into s.
+ * Returns false if absent, s is then set to default_value.
+ */
+bool bcf_get_info_str(bcf1_t *v, int32_t id, std::string& s, const char* default_value = ".");
+
 /**
  * Get allele
  */
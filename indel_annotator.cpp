@@ -30,13 +30,6 @@ IndelAnnotator::IndelAnnotator(std::string& ref_fasta_file, bool debug)
 {
     vm = new VariantManip(ref_fasta_file.c_str());
 
-    fai = fai_load(ref_fasta_file.c_str());
-    if (fai==NULL)
-    {
-        fprintf(stderr, "[%s:%d %s] Cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-        exit(1);
-    }
-
     cre = new CandidateRegionExtractor(ref_fasta_file, debug);
     cmp = new CandidateMotifPicker(debug);
     fd = new FlankDetector(ref_fasta_file, debug);
@@ -50,7 +43,6 @@ IndelAnnotator::IndelAnnotator(std::string& ref_fasta_file, bool debug)
 IndelAnnotator::~IndelAnnotator()
 {
     delete vm;
-    fai_destroy(fai);
 }
 
 /**
@@ -61,7 +53,7 @@ IndelAnnotator::~IndelAnnotator()
  */
 void IndelAnnotator::annotate(Variant& variant)
 {
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
 
     bcf_hdr_t* h = variant.h;
     bcf1_t* v = variant.v;
@@ -119,7 +111,7 @@ void IndelAnnotator::annotate(Variant& variant)
         if (!cmp->next_motif(variant, CHECK_MOTIF_PRESENCE_IN_ALLELE))
         {
             //fall back on exact motif chosen.
-            VNTR& vntr = variant.vntr;
+            VNTR& vntr = variant.get_vntr();
             vntr.fuzzy_motif = vntr.exact_motif;
             vntr.fuzzy_ru = vntr.exact_ru;
             vntr.fuzzy_basis = vntr.exact_basis;
@@ -104,7 +104,6 @@ class IndelAnnotator
     //tools
     ///////
     VariantManip *vm;
-    faidx_t* fai;
     CandidateRegionExtractor* cre;
     CandidateMotifPicker* cmp;
     FlankDetector* fd;
@@ -32,6 +32,8 @@ IndelGenotypingRecord::IndelGenotypingRecord(bcf_hdr_t *h, bcf1_t *v, int32_t ns
     clear();
 
     this->h = h;
+    this->v = v;
+    this->vtype = VT_INDEL;
     this->rid = bcf_get_rid(v);
     this->pos1 = bcf_get_pos1(v);
     this->nsamples = nsamples;
@@ -47,6 +49,14 @@ IndelGenotypingRecord::IndelGenotypingRecord(bcf_hdr_t *h, bcf1_t *v, int32_t ns
 
     n_filter = 0;
 
+    no_nonref = 0;
+    depth = depth_fwd = depth_rev = 0;
+    base_qualities_sum = 0;
+    allele_depth_fwd.resize(bcf_get_n_allele(v), 0);
+    allele_depth_rev.resize(bcf_get_n_allele(v), 0);
+    rl_beg1 = INT32_MAX;
+    rl_end1 = 0;
+
     //rid = bcf_get_rid(v);
     dlen = strlen(tmp_alleles[1])-strlen(tmp_alleles[0]);
     len = abs(dlen);
@@ -492,8 +502,6 @@ void IndelGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleI
             uint32_t cycle = 10;
 
             std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-            std::vector<std::string>& aug_ref = as.aug_ref;
-            std::vector<std::string>& aug_alt = as.aug_alt;
 
             int32_t vpos1 = pos1;
 
@@ -531,14 +539,14 @@ void IndelGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleI
                 {
                     if (dlen>0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_alt[i])
+                        if (as.alt_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
@@ -559,14 +567,14 @@ void IndelGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleI
                 {
                     if (dlen<0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_ref[i])
+                        if (as.ref_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
@@ -617,8 +625,6 @@ void IndelGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleI
             uint32_t cycle = 10;
 
             std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-            std::vector<std::string>& aug_ref = as.aug_ref;
-            std::vector<std::string>& aug_alt = as.aug_alt;
 
             int32_t vpos1 = pos1;
 
@@ -656,14 +662,14 @@ void IndelGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleI
                 {
                     if (dlen>0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_alt[i])
+                        if (as.alt_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
@@ -684,14 +690,14 @@ void IndelGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleI
                 {
                     if (dlen<0 && cpos1-1==vpos1)
                     {
-                        if (indel==aug_ref[i])
+                        if (as.ref_equals(i, indel))
                         {
                             q = len*30;
                             allele = 1;
                         }
                         else
                         {
-                            q = abs(len-(int32_t)aug_ref[i].size())*30;
+                            q = abs(len-(int32_t)as.get_ref_len(i))*30;
                             allele = -1;
                         }
 
@@ -0,0 +1,120 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "index_gencode.h"
+
+namespace
+{
+
+class Igor : Program
+{
+    public:
+
+    ///////////
+    //options//
+    ///////////
+    std::string gencode_gtf_file;
+    std::string ref_fasta_file;
+    std::string output_index_file;
+
+    /////////
+    //stats//
+    /////////
+    int32_t no_transcripts;
+
+    Igor(int argc, char **argv)
+    {
+        version = "0.5";
+
+        //////////////////////////
+        //options initialization//
+        //////////////////////////
+        try
+        {
+            std::string desc = "Builds a memory mapped GENCODE transcript index for annotate_variants.";
+
+            TCLAP::CmdLine cmd(desc, ' ', version);
+            VTOutput my;
+            cmd.setOutput(&my);
+            TCLAP::ValueArg<std::string> arg_ref_fasta_file("r", "r", "reference sequence fasta file []", true, "", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_output_index_file("o", "o", "output index file [<in.gtf>.gci]", false, "", "str", cmd);
+            TCLAP::UnlabeledValueArg<std::string> arg_gencode_gtf_file("<in.gtf>", "input GENCODE GTF file", true, "","file", cmd);
+
+            cmd.parse(argc, argv);
+
+            gencode_gtf_file = arg_gencode_gtf_file.getValue();
+            ref_fasta_file = arg_ref_fasta_file.getValue();
+            output_index_file = arg_output_index_file.getValue();
+            if (output_index_file=="")
+            {
+                output_index_file = gencode_gtf_file + ".gci";
+            }
+        }
+        catch (TCLAP::ArgException &e)
+        {
+            std::cerr << "error: " << e.error() << " for arg " << e.argId() << "\n";
+            abort();
+        }
+    };
+
+    void initialize()
+    {
+        no_transcripts = 0;
+    }
+
+    void index_gencode()
+    {
+        no_transcripts = GENCODEIndex::build(gencode_gtf_file, ref_fasta_file, output_index_file);
+    };
+
+    void print_options()
+    {
+        std::clog << "index_gencode v" << version << "\n\n";
+
+        std::clog << "options:     input GTF file        " << gencode_gtf_file << "\n";
+        std::clog << "         [o] output index file     " << output_index_file << "\n";
+        print_ref_op("         [r] ref FASTA file        ", ref_fasta_file);
+        std::clog << "\n";
+    }
+
+    void print_stats()
+    {
+        std::clog << "\n";
+        std::clog << "stats: no. of transcripts indexed  " << no_transcripts << "\n";
+        std::clog << "\n";
+    };
+
+    ~Igor() {};
+
+    private:
+};
+}
+
+void index_gencode(int argc, char ** argv)
+{
+    Igor igor(argc, argv);
+    igor.print_options();
+    igor.initialize();
+    igor.index_gencode();
+    igor.print_stats();
+};
@@ -26,6 +26,57 @@
 namespace
 {
 
+#define COLUMN_CHROM    0
+#define COLUMN_POS      1
+#define COLUMN_REF      2
+#define COLUMN_ALT      3
+#define COLUMN_N_ALLELE 4
+#define COLUMN_FILTER   5
+#define COLUMN_INFO     6
+
+/**
+ * A column of the columnar export.
+ *
+ * A column of fixed width is a .npy array of a row per record, a column of
+ * variable length values is a .npy array of the values and a .offsets.npy
+ * array of no. of records + 1 offsets into it, and a string column is a
+ * .bytes file of the concatenated strings and a .offsets.npy array.
+ */
+typedef struct
+{
+    std::string name;
+    int32_t source;
+    int32_t id;
+    int32_t type;
+    int32_t width;
+    bool fixed;
+
+    NPYWriter* values;
+    NPYWriter* offsets;
+    FILE* bytes;
+    int64_t offset;
+} column_t;
+
+/**
+ * Values of the columns for a run of records.
+ */
+typedef struct
+{
+    std::vector<std::vector<char> > values;
+    std::vector<std::vector<int64_t> > lengths;
+    int64_t no_rows;
+} chunk_t;
+
+/**
+ * Appends n values to a column buffer.
+ */
+template<class T>
+void append(std::vector<char>& data, const T* values, size_t n)
+{
+    const char* p = reinterpret_cast<const char*>(values);
+    data.insert(data.end(), p, p+n*sizeof(T));
+}
+
 class Igor : Program
 {
     public:
@@ -38,6 +89,8 @@ class Igor : Program
     std::vector<GenomeInterval> intervals;
     std::vector<std::string> filter_tags;
     std::vector<std::string> info_tags;
+    std::string output_column_dir;
+    int32_t no_threads;
     bool debug;
 
     ///////
@@ -45,22 +98,48 @@ class Igor : Program
     ///////
     BCFOrderedReader *odr;
 
+    ////////////////////
+    //columnar export//
+    ////////////////////
+    std::vector<column_t> columns;
+
+    //regions extracted in parallel, empty if extracted sequentially
+    std::vector<GenomeInterval> regions;
+    std::vector<bool> exclusive;
+    std::vector<chunk_t*> chunks;
+    int32_t no_workers;
+    int32_t next_region;
+    int32_t next_chunk;
+    int32_t window;
+    std::mutex chunk_lock;
+    std::condition_variable chunk_written;
+
+    //contigs in the order of the CHROM column, contigs missing from the header follow
+    //in the order of the regions, or in the order of the records when read sequentially
+    std::vector<std::string> chroms;
+    std::map<std::string, int32_t> chrom2idx;
+    std::vector<std::vector<int32_t> > rid2idx;
+    std::mutex chrom_lock;
+
     //////////
     //filter//
     //////////
     std::string fexp;
     Filter filter;
     bool filter_exists;
+    std::vector<Filter*> filters;
 
     /////////
     //stats//
     /////////
     uint32_t no_variants;
+    std::vector<uint32_t> worker_no_variants;
 
     /////////
     //tools//
     /////////
     VariantManip *vm;
+    std::vector<VariantManip*> vms;
 
     Igor(int argc, char **argv)
     {
@@ -81,6 +160,8 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_info_tags("t", "t", "list of info tags to be extracted []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_filter_tags("u", "u", "list of filter tags to be extracted []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter expression []", false, "", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_output_column_dir("c", "c", "output directory for a columnar export of NumPy .npy files instead of a tab delimited file []", false, "", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("n", "n", "no. of threads for the columnar export, used when the input is indexed [1]", false, 1, "int", cmd);
             TCLAP::SwitchArg arg_debug("d", "d", "debug [false]", cmd, false);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
 
@@ -97,6 +178,8 @@ class Igor : Program
                 notice("no filter or info tags specified\n");
                 exit(1);
             }
+            output_column_dir = arg_output_column_dir.getValue();
+            no_threads = arg_no_threads.getValue();
             debug = arg_debug.getValue();
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
         }
@@ -112,6 +195,24 @@ class Igor : Program
         //////////////////////
         //i/o initialization//
         //////////////////////
+        //the columnar export of an indexed file is extracted region by region in parallel,
+        //the regions are planned as for the synced tools but are read with ordered readers
+        //so that the records keep the order of the file
+        no_workers = 1;
+        if (output_column_dir!="" && no_threads>1)
+        {
+            std::vector<std::string> input_vcf_files(1, input_vcf_file);
+            ParallelSyncedDriver driver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+
+            if (driver.parallel())
+            {
+                no_workers = driver.no_workers;
+                regions = driver.regions;
+                exclusive = driver.exclusive;
+            }
+            driver.sr->close();
+        }
+
         odr = new BCFOrderedReader(input_vcf_file, intervals);
 
         /////////////////////////
@@ -119,16 +220,27 @@ class Igor : Program
         /////////////////////////
         filter.parse(fexp.c_str(), false);
         filter_exists = fexp=="" ? false : true;
+        for (int32_t i=0; i<no_workers; ++i)
+        {
+            filters.push_back(new Filter());
+            filters[i]->parse(fexp.c_str(), false);
+        }
 
         ////////////////////////
         //stats initialization//
         ////////////////////////
         no_variants = 0;
+        worker_no_variants.resize(no_workers, 0);
+        rid2idx.resize(no_workers);
 
         ////////////////////////
         //tools initialization//
         ////////////////////////
         vm = new VariantManip();
+        for (int32_t i=0; i<no_workers; ++i)
+        {
+            vms.push_back(new VariantManip());
+        }
     }
 
     void info2tab()
@@ -513,6 +625,472 @@ class Igor : Program
         odr->close();
     };
 
+    /**
+     * Exports the sites, FILTER and INFO fields as a column file each.
+     */
+    void info2col()
+    {
+        bcf_hdr_t* h = odr->hdr;
+
+        append_cwd(output_column_dir);
+        mkdir(output_column_dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+        //CHROM is the index of the contig in CHROM.txt, the contigs of the header come first
+        for (int32_t i=0; i<h->n[BCF_DT_CTG]; ++i)
+        {
+            chrom2idx[bcf_hdr_id2name(h, i)] = i;
+            chroms.push_back(bcf_hdr_id2name(h, i));
+        }
+
+        //the contigs only found in the index are numbered before the workers start
+        //so that the numbering does not depend on which worker reaches them first
+        for (size_t i=0; i<regions.size(); ++i)
+        {
+            if (chrom2idx.find(regions[i].seq)==chrom2idx.end())
+            {
+                chrom2idx[regions[i].seq] = chroms.size();
+                chroms.push_back(regions[i].seq);
+            }
+        }
+
+        add_column("CHROM", COLUMN_CHROM, -1, BCF_HT_INT, 0, true);
+        add_column("POS", COLUMN_POS, -1, BCF_HT_INT, 0, true);
+        add_column("REF", COLUMN_REF, -1, BCF_HT_STR, 0, false);
+        add_column("ALT", COLUMN_ALT, -1, BCF_HT_STR, 0, false);
+        add_column("N_ALLELE", COLUMN_N_ALLELE, -1, BCF_HT_INT, 0, true);
+
+        for (size_t i=0; i<filter_tags.size(); ++i)
+        {
+            int32_t id = bcf_hdr_id2int(h, BCF_DT_ID, filter_tags[i].c_str());
+            if (!bcf_hdr_idinfo_exists(h, BCF_HL_FLT, id))
+            {
+                notice("%s filter tag does not exist", filter_tags[i].c_str());
+                continue;
+            }
+
+            add_column("FILTER_" + filter_tags[i], COLUMN_FILTER, id, BCF_HT_FLAG, 0, true);
+        }
+
+        for (size_t i=0; i<info_tags.size(); ++i)
+        {
+            int32_t id = bcf_hdr_id2int(h, BCF_DT_ID, info_tags[i].c_str());
+            if (!bcf_hdr_idinfo_exists(h, BCF_HL_INFO, id))
+            {
+                notice("%s info tag does not exist", info_tags[i].c_str());
+                continue;
+            }
+
+            int32_t vlen = bcf_hdr_id2length(h, BCF_HL_INFO, id);
+            int32_t type = bcf_hdr_id2type(h, BCF_HL_INFO, id);
+            int32_t num = bcf_hdr_id2number(h, BCF_HL_INFO, id);
+
+            if (type==BCF_HT_FLAG)
+            {
+                add_column("INFO_" + info_tags[i], COLUMN_INFO, id, type, 0, true);
+            }
+            else if (type==BCF_HT_STR)
+            {
+                add_column("INFO_" + info_tags[i], COLUMN_INFO, id, type, 0, false);
+            }
+            else if (vlen==BCF_VL_FIXED)
+            {
+                add_column("INFO_" + info_tags[i], COLUMN_INFO, id, type, num==1 ? 0 : num, true);
+            }
+            else
+            {
+                add_column("INFO_" + info_tags[i], COLUMN_INFO, id, type, 0, false);
+            }
+        }
+
+        if (regions.size())
+        {
+            chunks.resize(regions.size(), NULL);
+            next_region = 0;
+            next_chunk = 0;
+            window = 4*no_workers;
+
+            std::vector<std::thread> workers;
+            for (int32_t i=0; i<no_workers; ++i)
+            {
+                workers.push_back(std::thread(&Igor::extract_regions, this, i));
+            }
+            for (int32_t i=0; i<no_workers; ++i)
+            {
+                workers[i].join();
+            }
+        }
+        else
+        {
+            bcf1_t* v = bcf_init();
+            chunk_t* chunk = new_chunk();
+
+            while (odr->read(v))
+            {
+                extract(0, h, v, chunk);
+
+                if (chunk->no_rows==(1<<16))
+                {
+                    write_chunk(chunk);
+                }
+            }
+            write_chunk(chunk);
+
+            delete chunk;
+            bcf_destroy(v);
+        }
+        odr->close();
+
+        for (size_t i=0; i<columns.size(); ++i)
+        {
+            column_t& col = columns[i];
+            if (col.values) delete col.values;
+            if (col.offsets) delete col.offsets;
+            if (col.bytes) fclose(col.bytes);
+        }
+
+        for (size_t i=0; i<worker_no_variants.size(); ++i)
+        {
+            no_variants += worker_no_variants[i];
+        }
+
+        //written last as contigs missing from the header are only known once the records are read
+        std::string file_name = output_column_dir + "/CHROM.txt";
+        FILE* out = fopen(file_name.c_str(), "w");
+        if (!out)
+        {
+            fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+            exit(1);
+        }
+        for (size_t i=0; i<chroms.size(); ++i)
+        {
+            fprintf(out, "%s\n", chroms[i].c_str());
+        }
+        fclose(out);
+    };
+
+    /**
+     * Gets the index in CHROM.txt of contig rid of the header of a worker.
+     * Each worker reads with a single header so the index is looked up by name once per contig.
+     */
+    int32_t get_chrom_index(int32_t worker, bcf_hdr_t* h, int32_t rid)
+    {
+        std::vector<int32_t>& idx = rid2idx[worker];
+        if (rid>=(int32_t)idx.size())
+        {
+            idx.resize(h->n[BCF_DT_CTG], -1);
+        }
+
+        if (idx[rid]<0)
+        {
+            std::string chrom(bcf_hdr_id2name(h, rid));
+
+            std::lock_guard<std::mutex> l(chrom_lock);
+            std::map<std::string, int32_t>::iterator i = chrom2idx.find(chrom);
+            if (i==chrom2idx.end())
+            {
+                i = chrom2idx.insert(std::make_pair(chrom, (int32_t)chroms.size())).first;
+                chroms.push_back(chrom);
+            }
+            idx[rid] = i->second;
+        }
+
+        return idx[rid];
+    }
+
+    /**
+     * Worker thread loop, extracts one region after another.  The regions
+     * are written out in order as they complete.
+     */
+    void extract_regions(int32_t worker)
+    {
+        BCFOrderedReader* wodr = NULL;
+        bcf1_t* v = bcf_init();
+
+        while (true)
+        {
+            int32_t region;
+            {
+                std::unique_lock<std::mutex> l(chunk_lock);
+
+                //bounds the chunks held for regions not yet written
+                while (next_region<(int32_t)regions.size() && next_region>=next_chunk+window)
+                {
+                    chunk_written.wait(l);
+                }
+
+                if (next_region==(int32_t)regions.size())
+                {
+                    break;
+                }
+                region = next_region++;
+            }
+
+            GenomeInterval& interval = regions[region];
+            if (!wodr)
+            {
+                std::vector<GenomeInterval> region_intervals(1, interval);
+                wodr = new BCFOrderedReader(input_vcf_file, region_intervals);
+            }
+            else
+            {
+                wodr->jump_to_interval(interval);
+            }
+
+            chunk_t* chunk = new_chunk();
+            while (wodr->read(v))
+            {
+                //only the first region of an interval takes the records overlapping its start
+                if (exclusive[region] && bcf_get_pos1(v)<interval.start1)
+                {
+                    continue;
+                }
+
+                extract(worker, wodr->hdr, v, chunk);
+            }
+
+            //the worker completing the next region in order writes it and the completed regions after it
+            std::unique_lock<std::mutex> l(chunk_lock);
+            chunks[region] = chunk;
+            while (next_chunk<(int32_t)chunks.size() && chunks[next_chunk])
+            {
+                write_chunk(chunks[next_chunk]);
+                delete chunks[next_chunk];
+                chunks[next_chunk++] = NULL;
+                chunk_written.notify_all();
+            }
+        }
+
+        if (wodr)
+        {
+            wodr->close();
+            delete wodr;
+        }
+        bcf_destroy(v);
+    }
+
+    /**
+     * Adds a column and creates its files.
+     */
+    void add_column(std::string name, int32_t source, int32_t id, int32_t type, int32_t width, bool fixed)
+    {
+        column_t col;
+        col.name = name;
+        col.source = source;
+        col.id = id;
+        col.type = type;
+        col.width = width;
+        col.fixed = fixed;
+        col.values = NULL;
+        col.offsets = NULL;
+        col.bytes = NULL;
+        col.offset = 0;
+
+        std::string prefix = output_column_dir + "/" + name;
+        if (type==BCF_HT_STR)
+        {
+            std::string file_name = prefix + ".bytes";
+            col.bytes = fopen(file_name.c_str(), "w");
+            if (!col.bytes)
+            {
+                fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+                exit(1);
+            }
+        }
+        else
+        {
+            std::string descr = type==BCF_HT_FLAG ? "|u1" : (type==BCF_HT_REAL ? "<f4" : "<i4");
+            col.values = new NPYWriter(prefix + ".npy", descr, width);
+        }
+
+        if (!fixed)
+        {
+            col.offsets = new NPYWriter(prefix + ".offsets.npy", "<i8");
+            col.offsets->write(&col.offset, 1);
+        }
+
+        columns.push_back(col);
+    }
+
+    /**
+     * Creates an empty chunk.
+     */
+    chunk_t* new_chunk()
+    {
+        chunk_t* chunk = new chunk_t();
+        chunk->values.resize(columns.size());
+        chunk->lengths.resize(columns.size());
+        chunk->no_rows = 0;
+        return chunk;
+    }
+
+    /**
+     * Appends the values of a record to a chunk.
+     *
+     * Missing integers are bcf_int32_missing, missing floats are NaN
+     * and absent strings are empty.
+     */
+    void extract(int32_t worker, bcf_hdr_t* h, bcf1_t* v, chunk_t* chunk)
+    {
+        bcf_unpack(v, BCF_UN_INFO);
+
+        if (filter_exists)
+        {
+            Variant variant;
+            vms[worker]->classify_variant(h, v, variant);
+            if (!filters[worker]->apply(h, v, &variant, false))
+            {
+                return;
+            }
+        }
+
+        float missing;
+        bcf_float_set_missing(missing);
+
+        for (size_t i=0; i<columns.size(); ++i)
+        {
+            column_t& col = columns[i];
+            std::vector<char>& data = chunk->values[i];
+            std::vector<int64_t>& lengths = chunk->lengths[i];
+
+            if (col.source==COLUMN_CHROM)
+            {
+                int32_t rid = get_chrom_index(worker, h, bcf_get_rid(v));
+                append(data, &rid, 1);
+            }
+            else if (col.source==COLUMN_POS)
+            {
+                int32_t pos1 = bcf_get_pos1(v);
+                append(data, &pos1, 1);
+            }
+            else if (col.source==COLUMN_REF)
+            {
+                char* ref = bcf_get_ref(v);
+                size_t len = strlen(ref);
+                append(data, ref, len);
+                lengths.push_back(len);
+            }
+            else if (col.source==COLUMN_ALT)
+            {
+                size_t len = 0;
+                for (int32_t j=1; j<bcf_get_n_allele(v); ++j)
+                {
+                    if (j>1)
+                    {
+                        data.push_back(',');
+                        ++len;
+                    }
+                    char* alt = bcf_get_alt(v, j);
+                    size_t l = strlen(alt);
+                    append(data, alt, l);
+                    len += l;
+                }
+                lengths.push_back(len);
+            }
+            else if (col.source==COLUMN_N_ALLELE)
+            {
+                int32_t no_alleles = bcf_get_n_allele(v);
+                append(data, &no_alleles, 1);
+            }
+            else if (col.source==COLUMN_FILTER)
+            {
+                //PASS and . are taken to be the same as in bcf_has_filter
+                uint8_t present = v->d.n_flt==0 && col.id==0;
+                for (int32_t j=0; j<v->d.n_flt; ++j)
+                {
+                    if (v->d.flt[j]==col.id) present = 1;
+                }
+                append(data, &present, 1);
+            }
+            else if (col.type==BCF_HT_FLAG)
+            {
+                uint8_t present = bcf_get_info_id(v, col.id)!=NULL;
+                append(data, &present, 1);
+            }
+            else if (col.type==BCF_HT_STR)
+            {
+                const char* s = NULL;
+                int32_t len = bcf_get_info_str(v, col.id, &s);
+                if (len>0) append(data, s, len);
+                lengths.push_back(std::max(len, 0));
+            }
+            else if (col.fixed)
+            {
+                int32_t n = std::max(col.width, 1);
+                size_t size = data.size();
+                data.resize(size+n*4);
+                if (col.type==BCF_HT_INT)
+                {
+                    bcf_get_info_int_vec(v, col.id, (int32_t*) &data[size], n, bcf_int32_missing);
+                }
+                else
+                {
+                    bcf_get_info_flt_vec(v, col.id, (float*) &data[size], n, missing);
+                }
+            }
+            else
+            {
+                size_t size = data.size();
+                bcf_info_t* info = bcf_get_info_id(v, col.id);
+                int32_t n = info ? info->len : 0;
+                data.resize(size+n*4);
+                if (col.type==BCF_HT_INT)
+                {
+                    n = bcf_get_info_int_vec(v, col.id, (int32_t*) &data[size], n, bcf_int32_missing);
+                }
+                else
+                {
+                    n = bcf_get_info_flt_vec(v, col.id, (float*) &data[size], n, missing);
+                }
+                data.resize(size+n*4);
+                lengths.push_back(n);
+            }
+        }
+
+        ++chunk->no_rows;
+        ++worker_no_variants[worker];
+    }
+
+    /**
+     * Appends a chunk to the column files and empties it.
+     */
+    void write_chunk(chunk_t* chunk)
+    {
+        for (size_t i=0; i<columns.size(); ++i)
+        {
+            column_t& col = columns[i];
+            std::vector<char>& data = chunk->values[i];
+            std::vector<int64_t>& lengths = chunk->lengths[i];
+
+            if (col.bytes)
+            {
+                if (data.size() && fwrite(data.data(), 1, data.size(), col.bytes)!=data.size())
+                {
+                    fprintf(stderr, "[%s:%d %s] Cannot write column %s\n", __FILE__, __LINE__, __FUNCTION__, col.name.c_str());
+                    exit(1);
+                }
+            }
+            else
+            {
+                col.values->write(data.data(), col.fixed ? chunk->no_rows : data.size()/col.values->size);
+            }
+
+            if (col.offsets)
+            {
+                for (size_t j=0; j<lengths.size(); ++j)
+                {
+                    col.offset += lengths[j];
+                    lengths[j] = col.offset;
+                }
+                col.offsets->write(lengths.data(), lengths.size());
+            }
+
+            data.clear();
+            lengths.clear();
+        }
+
+        chunk->no_rows = 0;
+    }
+
     void print_options()
     {
         std::clog << "info2tab v" << version << "\n";
@@ -521,6 +1099,8 @@ class Igor : Program
         std::clog << "         [o] output text file      " << output_text_file << "\n";
         print_strvec("         [u] filter tags           ", filter_tags);
         print_strvec("         [t] info tags             ", info_tags);
+        print_str_op("         [c] output column dir     ", output_column_dir);
+        print_num_op("         [n] no. of threads        ", no_threads);
         print_int_op("         [i] intervals             ", intervals);
         std::clog << "\n";
     }
@@ -544,6 +1124,13 @@ void info2tab(int argc, char ** argv)
     Igor igor(argc, argv);
     igor.print_options();
     igor.initialize();
-    igor.info2tab();
+    if (igor.output_column_dir!="")
+    {
+        igor.info2col();
+    }
+    else
+    {
+        igor.info2tab();
+    }
     igor.print_stats();
 };
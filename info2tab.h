@@ -24,7 +24,13 @@
 #ifndef INFO2TAB_H
 #define INFO2TAB_H
 
+#include <sys/stat.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "program.h"
+#include "npy_writer.h"
+#include "parallel_synced_driver.h"
 
 void info2tab(int argc, char ** argv);
 
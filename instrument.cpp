@@ -0,0 +1,230 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "instrument.h"
+
+bool Instrument::enabled = false;
+std::string Instrument::json_file;
+double Instrument::progress_interval = 0;
+std::string Instrument::command;
+uint64_t Instrument::start_ns = 0;
+clock_t Instrument::start_clock = 0;
+std::thread* Instrument::progress_thread = NULL;
+std::mutex Instrument::lock;
+std::condition_variable Instrument::stopped;
+bool Instrument::done = false;
+
+/**
+ * Constructor, registers the stat.
+ */
+InstrumentStat::InstrumentStat(const char* name, bool timed)
+{
+    this->name = name;
+    this->timed = timed;
+    count = 0;
+    ns = 0;
+    Instrument::stats().push_back(this);
+}
+
+/**
+ * Returns the registered stats.
+ */
+std::vector<InstrumentStat*>& Instrument::stats()
+{
+    //constructed on first use as the stats are statics of other translation units
+    static std::vector<InstrumentStat*> stats;
+    return stats;
+}
+
+/**
+ * Removes the instrumentation options from argv and returns the new argc.
+ */
+int32_t Instrument::parse(int32_t argc, char** argv)
+{
+    int32_t j = 1;
+    for (int32_t i=1; i<argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if ((arg=="--stats-json" || arg=="--progress") && i+1<argc)
+        {
+            if (arg=="--stats-json")
+            {
+                json_file = argv[++i];
+            }
+            else
+            {
+                progress_interval = atof(argv[++i]);
+            }
+        }
+        else
+        {
+            argv[j++] = argv[i];
+        }
+    }
+    argv[j] = NULL;
+
+    enabled = json_file!="" || progress_interval>0;
+    return j;
+}
+
+/**
+ * Starts the clocks and the progress reports.
+ */
+void Instrument::start(int32_t argc, char** argv)
+{
+    if (!enabled) return;
+
+    for (int32_t i=1; i<argc; ++i)
+    {
+        if (i>1) command.append(1, ' ');
+        command.append(argv[i]);
+    }
+
+    start_ns = now();
+    start_clock = clock();
+
+    if (progress_interval>0)
+    {
+        progress_thread = new std::thread(&Instrument::report_progress);
+    }
+}
+
+/**
+ * Stops the progress reports and writes the JSON report.
+ */
+void Instrument::stop()
+{
+    if (!enabled) return;
+
+    if (progress_thread)
+    {
+        {
+            std::unique_lock<std::mutex> l(lock);
+            done = true;
+            stopped.notify_all();
+        }
+        progress_thread->join();
+        delete progress_thread;
+        progress_thread = NULL;
+    }
+
+    if (json_file!="")
+    {
+        write_json();
+    }
+}
+
+/**
+ * Returns the number of records read so far by the ordered and synced readers.
+ */
+uint64_t Instrument::records_read()
+{
+    uint64_t records = 0;
+    std::vector<InstrumentStat*>& s = stats();
+    for (size_t i=0; i<s.size(); ++i)
+    {
+        if (!strcmp(s[i]->name, "bcf_ordered_reader.records") ||
+            !strcmp(s[i]->name, "bcf_synced_reader.records"))
+        {
+            records += s[i]->count.load(std::memory_order_relaxed);
+        }
+    }
+
+    return records;
+}
+
+/**
+ * Prints the progress every progress_interval seconds until stopped.
+ */
+void Instrument::report_progress()
+{
+    uint64_t last_ns = start_ns;
+    uint64_t last_records = 0;
+
+    std::unique_lock<std::mutex> l(lock);
+    while (!stopped.wait_for(l, std::chrono::duration<double>(progress_interval), []{ return done; }))
+    {
+        uint64_t t = now();
+        uint64_t records = records_read();
+        fprintf(stderr, "[progress] %.1fs %llu records %.0f records/s\n", (t-start_ns)*1e-9,
+                                                                        (unsigned long long) records,
+                                                                        (records-last_records)/((t-last_ns)*1e-9));
+        last_ns = t;
+        last_records = records;
+    }
+}
+
+/**
+ * Writes the JSON report.
+ */
+void Instrument::write_json()
+{
+    FILE* file = json_file=="-" ? stderr : fopen(json_file.c_str(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, json_file.c_str());
+        return;
+    }
+
+    std::string escaped;
+    for (size_t i=0; i<command.size(); ++i)
+    {
+        if (command[i]=='"' || command[i]=='\\') escaped.append(1, '\\');
+        escaped.append(1, command[i]);
+    }
+
+    double elapsed = (now()-start_ns)*1e-9;
+    uint64_t records = records_read();
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"command\": \"%s\",\n", escaped.c_str());
+    fprintf(file, "  \"elapsed_seconds\": %.6f,\n", elapsed);
+    fprintf(file, "  \"cpu_seconds\": %.6f,\n", (double)(clock()-start_clock)/CLOCKS_PER_SEC);
+    fprintf(file, "  \"records_read\": %llu,\n", (unsigned long long) records);
+    fprintf(file, "  \"records_per_second\": %.1f,\n", elapsed>0 ? records/elapsed : 0);
+
+    std::vector<InstrumentStat*>& s = stats();
+    for (int32_t timed=1; timed>=0; --timed)
+    {
+        fprintf(file, "  \"%s\": {", timed ? "timers" : "counters");
+        bool first = true;
+        for (size_t i=0; i<s.size(); ++i)
+        {
+            if (s[i]->timed!=(bool)timed || !s[i]->count) continue;
+
+            fprintf(file, "%s\n    \"%s\": ", first ? "" : ",", s[i]->name);
+            if (timed)
+            {
+                fprintf(file, "{\"calls\": %llu, \"seconds\": %.6f}", (unsigned long long) s[i]->count.load(), s[i]->ns.load()*1e-9);
+            }
+            else
+            {
+                fprintf(file, "%llu", (unsigned long long) s[i]->count.load());
+            }
+            first = false;
+        }
+        fprintf(file, "%s}%s\n", first ? "" : "\n  ", timed ? "," : "");
+    }
+    fprintf(file, "}\n");
+
+    if (file!=stderr) fclose(file);
+}
@@ -0,0 +1,173 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+/**
+ * A named timer or counter.
+ *
+ * Timers accumulate the number of calls and the wall time spent in the
+ * scopes timed by InstrumentTimer, time spent in nested timed scopes is
+ * included.  Counters accumulate the values added with VT_COUNT.  The
+ * stats are defined as statics where they are used and are registered
+ * on construction.  They are updated atomically so that they may be
+ * shared by threads.
+ */
+class InstrumentStat
+{
+    public:
+
+    const char* name;
+    bool timed;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> ns;
+
+    /**
+     * Constructor, registers the stat.
+     */
+    InstrumentStat(const char* name, bool timed=true);
+};
+
+/**
+ * Runtime instrumentation of the tools.
+ *
+ * The instrumentation is turned on by the global options
+ *
+ *  --stats-json <file>  writes the timers and counters as JSON to file, - for stderr
+ *  --progress <sec>     prints the number of records read and the rate every sec seconds
+ *
+ * which are removed from the arguments in main before the tool parses
+ * them.  When neither is given, the timers only test a flag.  Building
+ * with -DVT_NO_INSTRUMENT compiles the timers and counters out.
+ */
+class Instrument
+{
+    public:
+
+    static bool enabled;
+
+    /**
+     * Returns the registered stats.
+     */
+    static std::vector<InstrumentStat*>& stats();
+
+    /**
+     * Monotonic time in nanoseconds.
+     */
+    static inline uint64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * Removes the instrumentation options from argv and returns the new argc.
+     */
+    static int32_t parse(int32_t argc, char** argv);
+
+    /**
+     * Starts the clocks and the progress reports.
+     */
+    static void start(int32_t argc, char** argv);
+
+    /**
+     * Stops the progress reports and writes the JSON report.
+     */
+    static void stop();
+
+    private:
+
+    static std::string json_file;
+    static double progress_interval;
+    static std::string command;
+    static uint64_t start_ns;
+    static clock_t start_clock;
+    //not destroyed at exit as tools exit with the progress thread running
+    static std::thread* progress_thread;
+    static std::mutex lock;
+    static std::condition_variable stopped;
+    static bool done;
+
+    /**
+     * Returns the number of records read so far.
+     */
+    static uint64_t records_read();
+
+    /**
+     * Prints the progress every progress_interval seconds until stopped.
+     */
+    static void report_progress();
+
+    /**
+     * Writes the JSON report.
+     */
+    static void write_json();
+};
+
+/**
+ * Times a scope.
+ */
+class InstrumentTimer
+{
+    public:
+
+    InstrumentStat& stat;
+    uint64_t t0;
+
+    InstrumentTimer(InstrumentStat& stat) : stat(stat), t0(Instrument::enabled ? Instrument::now() : 0) {};
+
+    ~InstrumentTimer()
+    {
+        if (t0)
+        {
+            stat.ns.fetch_add(Instrument::now()-t0, std::memory_order_relaxed);
+            stat.count.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+};
+
+#ifndef VT_NO_INSTRUMENT
+#define VT_TIMER_STAT(stat, name) static InstrumentStat stat(name)
+#define VT_COUNTER_STAT(stat, name) static InstrumentStat stat(name, false)
+#define VT_TIME(stat) InstrumentTimer stat##_timer(stat)
+#define VT_COUNT(stat, n) if (Instrument::enabled) stat.count.fetch_add((n), std::memory_order_relaxed)
+#else
+#define VT_TIMER_STAT(stat, name)
+#define VT_COUNTER_STAT(stat, name)
+#define VT_TIME(stat)
+#define VT_COUNT(stat, n)
+#endif
+
+#endif
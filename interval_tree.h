@@ -24,53 +24,24 @@
 #ifndef INTERVAL_TREE_H
 #define INTERVAL_TREE_H
 
+#include <algorithm>
 #include "utils.h"
 #include "interval.h"
 
-#define RED 1
-#define BLACK 2
-
-class IntervalTreeNode
-{
-    public:
-    IntervalTreeNode* parent;
-    IntervalTreeNode* left;
-    IntervalTreeNode* right;
-    int32_t start;
-    int32_t max;
-    int32_t min;
-    std::vector<Interval*> intervals;
-    uint32_t color;
-
-    /**
-     * Constructs an IntervalTreeNode and initialize it with an interval.
-     */
-    IntervalTreeNode(Interval* interval);
-
-    /**
-     * Constructs an IntervalTreeNode.
-     */
-    ~IntervalTreeNode();
-
-    /**
-     * Insert an interval.
-     */
-    void insert(Interval* interval);
-
-    /**
-     * Prints the node.
-     */
-    void print();
-
-    private:
-};
-
+/**
+ * A static interval index.
+ *
+ * The intervals are inserted in bulk and then sorted by start position
+ * into a single array by index.  The array is searched as an implicit
+ * balanced binary tree: the element at the middle of each range is the
+ * root of that range.  Each element records the maximum end position in
+ * its subtree.  Searches do not modify the index, so once index has
+ * been called the tree can be searched from several threads.  Searching
+ * a tree with intervals inserted since the last call to index is an error.
+ */
 class IntervalTree
 {
     public:
-    IntervalTreeNode* root;
-    uint32_t no_elements;
-    uint32_t height;
 
     /**
      * Constructor.
@@ -78,7 +49,7 @@ class IntervalTree
     IntervalTree();
 
     /**
-     * Destructor.
+     * Destructor, the intervals are owned by the caller.
      */
     ~IntervalTree();
 
@@ -88,17 +59,74 @@ class IntervalTree
     uint32_t size();
 
     /**
-     * Insert an interval, returns a node if the insertion causes violation of the red black tree.
+     * Inserts an interval, index must be called before the next search.
      */
     void insert(Interval* interval);
 
     /**
-     * Gets overlapping intervals with [start,end]. Returns true on success and false otherwise.
+     * Sorts the intervals and computes the subtree maximum end positions.
+     * Intervals with the same start position are kept in insertion order.
+     */
+    void index();
+
+    /**
+     * Gets overlapping intervals with [start,end].
      */
     void search(int32_t start, int32_t end, std::vector<Interval*>& intervals);
 
     /**
-     * Brute force recursive search for overlap for sanity checks.
+     * Calls f(Interval*) on each interval overlapping [start,end] without allocating.
+     */
+    template<class F>
+    void search(int32_t start, int32_t end, F f)
+    {
+        if (!indexed)
+        {
+            fprintf(stderr, "[%s:%d %s] interval tree searched before it was indexed\n", __FILE__, __LINE__, __FUNCTION__);
+            exit(1);
+        }
+        if (nodes.empty()) return;
+
+        int32_t n = nodes.size();
+        frame_t stack[64];
+        int32_t t = 0;
+        stack[t].k = max_level; stack[t].x = (1<<max_level)-1; stack[t].w = 0; ++t;
+
+        while (t)
+        {
+            frame_t z = stack[--t];
+
+            //small subtrees are scanned
+            if (z.k<=3)
+            {
+                int32_t i0 = z.x >> z.k << z.k;
+                int32_t i1 = std::min(i0 + (1<<(z.k+1)) - 1, n);
+                for (int32_t i=i0; i<i1 && nodes[i].beg1<=end; ++i)
+                {
+                    if (start<=nodes[i].end1) f(nodes[i].interval);
+                }
+            }
+            //left subtree first
+            else if (z.w==0)
+            {
+                int32_t y = z.x - (1<<(z.k-1));
+                stack[t].k = z.k; stack[t].x = z.x; stack[t].w = 1; ++t;
+                if (y>=n || nodes[y].max>=start)
+                {
+                    stack[t].k = z.k-1; stack[t].x = y; stack[t].w = 0; ++t;
+                }
+            }
+            //then the node and the right subtree
+            else if (z.x<n && nodes[z.x].beg1<=end)
+            {
+                if (start<=nodes[z.x].end1) f(nodes[z.x].interval);
+                stack[t].k = z.k-1; stack[t].x = z.x + (1<<(z.k-1)); stack[t].w = 0; ++t;
+            }
+        }
+    }
+
+    /**
+     * Brute force search for overlap for sanity checks.
      */
     void search_brute(int32_t start, int32_t end, std::vector<Interval*>& intervals);
 
@@ -107,47 +135,26 @@ class IntervalTree
      */
     void print();
 
-    /**
-     * Validates red black tree property.
-     */
-    void validate();
-
     private:
 
-    /**
-     * Insert an interval, returns a node if the insertion causes violation of the red black tree.
-     */
-    IntervalTreeNode* simple_insert(Interval* interval);
-
-    /**
-     * Iterative method for search_brute.
-     */
-    void search_iter_brute(int32_t start, int32_t end, std::vector<Interval*>& intervals, IntervalTreeNode* x);
-
-    /**
-     * Iterative method for search.
-     */
-    void search_iter(int32_t start, int32_t end, std::vector<Interval*>& intervals, IntervalTreeNode* x);
-
-    /**
-     * Iterative method for print.
-     */
-    void print_iter(IntervalTreeNode* x);
-
-    /**
-     * Iterative method for validate.
-     */
-    void validate_iter(IntervalTreeNode* x, uint32_t depth);
-
-    /**
-     * Left rotates a node.
-     */
-    void left_rotate(IntervalTreeNode* x);
-
-    /**
-     * Righ rotates a node.
-     */
-    void right_rotate(IntervalTreeNode* y);
+    typedef struct
+    {
+        int32_t beg1;
+        int32_t end1;
+        int32_t max;
+        Interval* interval;
+    } node_t;
+
+    typedef struct
+    {
+        int32_t k;
+        int32_t x;
+        int32_t w;
+    } frame_t;
+
+    std::vector<node_t> nodes;
+    int32_t max_level;
+    bool indexed;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -23,8 +23,10 @@
 
 #include "lfhmm.h"
 
-#define MAXLEN 1024
-#define MAXLEN_NBITS 10
+VT_TIMER_STAT(align_stat, "lfhmm.align");
+
+//positions and motif counts are held in the 12 bit fields of a track
+#define MAXLEN 4095
 
 #define S       0
 #define ML      1
@@ -49,7 +51,7 @@
 #define MATCH 2
 
 /*for indexing single array*/
-#define index(i,j) (((i)<<MAXLEN_NBITS)+(j))
+#define index(i,j) (((i)*stride)+(j))
 
 /*functions for getting trace back information*/
 #define track_get_u(t)      (((t)&0xF8000000)>>27)
@@ -83,16 +85,20 @@ LFHMM::LFHMM(bool debug)
  */
 LFHMM::~LFHMM()
 {
-    delete optimal_path;
+    delete[] optimal_path;
+    delete[] motif_discordance;
 
+    //matrices go back to the alignment workspace of this thread
     for (size_t state=S; state<=E; ++state)
     {
-        delete V[state];
-        delete U[state];
+        AlignmentWorkspace::release(V[state], no_rows*stride);
+        AlignmentWorkspace::release(U[state], no_rows*stride);
+        delete[] moves[state];
     }
 
-    delete V;
-    delete U;
+    delete[] V;
+    delete[] U;
+    delete[] moves;
 };
 
 /**
@@ -102,7 +108,6 @@ void LFHMM::initialize()
 {
     initialize_structures();
     initialize_T();
-    initialize_UV();
 };
 
 /**
@@ -118,23 +123,22 @@ void LFHMM::initialize_structures()
     lflen = 0;
     mlen = 0;
 
-    motif_discordance = new int32_t[MAXLEN];
-    optimal_path = new int32_t[MAXLEN<<2];
+    motif_discordance = NULL;
+    optimal_path = NULL;
+    max_path_len = 0;
     optimal_path_traced = false;
 
     typedef int32_t (LFHMM::*move) (int32_t t, int32_t j);
+    //the matrices are sized by resize for the first alignment
+    no_rows = 0;
+    stride = 0;
     V = new float*[NSTATES];
     U = new int32_t*[NSTATES];
     moves = new move*[NSTATES];
     for (size_t state=S; state<=E; ++state)
     {
-        V[state] = new float[MAXLEN*MAXLEN];
-        U[state] = new int32_t[MAXLEN*MAXLEN];
-        moves[state] = new move[NSTATES];
-    }
-
-    for (size_t state=S; state<=E; ++state)
-    {
+        V[state] = NULL;
+        U[state] = NULL;
         moves[state] = new move[NSTATES];
     }
 
@@ -204,9 +208,9 @@ void LFHMM::initialize_T()
  */
 void LFHMM::initialize_UV()
 {
-    for (size_t i=0; i<MAXLEN; ++i)
+    for (size_t i=0; i<no_rows; ++i)
     {
-        for (size_t j=0; j<MAXLEN; ++j)
+        for (size_t j=0; j<stride; ++j)
         {
             size_t c = index(i,j);
 
@@ -275,6 +279,38 @@ void LFHMM::initialize_UV()
     V[Z][index(0,0)] = -INFINITY;
 };
 
+/**
+ * Grows the matrices to at least rows x cols cells.
+ */
+void LFHMM::resize(size_t rows, size_t cols)
+{
+    if (rows<=no_rows && cols<=stride) return;
+
+    for (size_t state=S; state<=E; ++state)
+    {
+        AlignmentWorkspace::release(V[state], no_rows*stride);
+        AlignmentWorkspace::release(U[state], no_rows*stride);
+    }
+
+    no_rows = std::max(rows, no_rows);
+    stride = std::max(cols, stride);
+
+    for (size_t state=S; state<=E; ++state)
+    {
+        V[state] = AlignmentWorkspace::acquire<float>(no_rows*stride);
+        U[state] = AlignmentWorkspace::acquire<int32_t>(no_rows*stride);
+    }
+
+    //a path has at most a move per row and per column, motifs are counted from 1
+    delete[] optimal_path;
+    delete[] motif_discordance;
+    max_path_len = no_rows+stride;
+    optimal_path = new int32_t[max_path_len];
+    motif_discordance = new int32_t[no_rows+1];
+
+    initialize_UV();
+}
+
 /**
  * Sets a model.
  */
@@ -472,7 +508,7 @@ void LFHMM::proc_comp(int32_t A, int32_t B, int32_t index1, int32_t j, int32_t m
     if (debug)
     {
         std::cerr << "\t" << state2string(A) << "=>" << state2string(B);
-        std::cerr << " (" << ((index1-j)>>MAXLEN_NBITS) << "," << j << ") ";
+        std::cerr << " (" << ((index1-j)/stride) << "," << j << ") ";
         std::cerr << track2string(U[A][index1]) << "=>";
         std::cerr << track2string(t) << " ";
         std::cerr << emission << " (e: " << (track_get_d(t)<=MOTIF?track_get_base(t):'N') << " vs " << (j!=rlen?read[j]:'N')  << ") + ";
@@ -488,6 +524,8 @@ void LFHMM::proc_comp(int32_t A, int32_t B, int32_t index1, int32_t j, int32_t m
  */
 void LFHMM::align(const char* read, const char* qual)
 {
+    VT_TIME(align_stat);
+
     clear_statistics();
     optimal_path_traced = false;
     this->read = read;
@@ -495,11 +533,12 @@ void LFHMM::align(const char* read, const char* qual)
     rlen = strlen(read);
     plen = lflen + rlen;
 
-    if (rlen>=MAXLEN)
+    if (plen>MAXLEN)
     {
-        fprintf(stderr, "[%s:%d %s] Sequence to be aligned is greater than %d currently supported: %d\n", __FILE__, __LINE__, __FUNCTION__, MAXLEN, rlen);
+        fprintf(stderr, "[%s:%d %s] Sequence to be aligned with its flanks is greater than %d currently supported: %d\n", __FILE__, __LINE__, __FUNCTION__, MAXLEN, plen);
         exit(1);
     }
+    resize(plen+1, rlen+1);
 
     float max = 0;
     char maxPath = 'X';
@@ -702,7 +741,7 @@ void LFHMM::trace_path()
     }
 
     //trace path
-    optimal_path_ptr = optimal_path+(MAXLEN<<2)-1;
+    optimal_path_ptr = optimal_path+max_path_len-1;
     int32_t i = optimal_probe_len, j = rlen;
     int32_t last_t = make_track(optimal_state, UNMODELED, 0, 0); //dummy end track for E
     optimal_path_len = 0;
@@ -1223,7 +1262,7 @@ void LFHMM::print_alignment(std::string& pad)
     std::cerr << "Model:  ";
     int32_t t = NULL_TRACK;
     int32_t j = 0;
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         int32_t u = track_get_u(*path);
         if (u==ML || u==M || u==D)
@@ -1241,7 +1280,7 @@ void LFHMM::print_alignment(std::string& pad)
     std::cerr << "       S";
     path = optimal_path_ptr;
     j=1;
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         std::cerr << track2cigarstring1(*path,j);
         int32_t u = track_get_u(*path);
@@ -1255,7 +1294,7 @@ void LFHMM::print_alignment(std::string& pad)
 
     path = optimal_path_ptr;
     std::cerr << "        ";
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         std::cerr << track2cigarstring2(*path);
         ++path;
@@ -1265,7 +1304,7 @@ void LFHMM::print_alignment(std::string& pad)
     path = optimal_path_ptr;
     j=1;
     std::cerr << "Read:   ";
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         int32_t u = track_get_u(*path);
         if (u==ML || u==M || u==I || u==Z)
@@ -1428,7 +1467,6 @@ void LFHMM::print_track(int32_t t)
 }
 
 #undef MAXLEN
-#undef MAXLEN_NBITS
 #undef S
 #undef ML
 #undef M
@@ -23,7 +23,8 @@
 
 #include "lhmm.h"
 
-#define MAXLEN 250
+VT_TIMER_STAT(align_stat, "lhmm.align");
+
 #define S 0
 #define X 1
 #define Y 2
@@ -47,21 +48,7 @@ LHMM::LHMM()
  */
 LHMM::~LHMM()
 {
-    delete scoreX;
-    delete scoreY;
-    delete scoreM;
-    delete scoreI;
-    delete scoreD;
-    delete scoreW;
-    delete scoreZ;
-
-    delete pathX;
-    delete pathY;
-    delete pathM;
-    delete pathI;
-    delete pathD;
-    delete pathW;
-    delete pathZ;
+    release();
 };
 
 /**
@@ -100,89 +87,136 @@ void LHMM::initialize()
     transition[W][Z] = 0; //log10((eta*(1-eta))/(eta*(1-eta)));
     transition[Z][Z] = 0; //log10((1-eta)/(1-eta));
 
-    scoreX = new double[MAXLEN*MAXLEN];
-    scoreY = new double[MAXLEN*MAXLEN];
-    scoreM = new double[MAXLEN*MAXLEN];
-    scoreI = new double[MAXLEN*MAXLEN];
-    scoreD = new double[MAXLEN*MAXLEN];
-    scoreW = new double[MAXLEN*MAXLEN];
-    scoreZ = new double[MAXLEN*MAXLEN];
-
-    pathX = new char[MAXLEN*MAXLEN];
-    pathY = new char[MAXLEN*MAXLEN];
-    pathM = new char[MAXLEN*MAXLEN];
-    pathI = new char[MAXLEN*MAXLEN];
-    pathD = new char[MAXLEN*MAXLEN];
-    pathW = new char[MAXLEN*MAXLEN];
-    pathZ = new char[MAXLEN*MAXLEN];
-
-    //assume alignments can't possibly be maxLength bases or more
-    for (int32_t i=0; i<MAXLEN; ++i)
+    logEta = log10(eta);
+    logTau = log10(tau);
+
+    no_rows = 0;
+    stride = 0;
+    scoreX = scoreY = scoreM = scoreI = scoreD = scoreW = scoreZ = NULL;
+    pathX = pathY = pathM = pathI = pathD = pathW = pathZ = NULL;
+};
+
+/**
+ * Grows the matrices to at least rows x cols cells.
+ */
+void LHMM::resize(size_t rows, size_t cols)
+{
+    if (rows<=no_rows && cols<=stride)
+    {
+        return;
+    }
+
+    release();
+
+    //the initial values reach into the second row and column
+    no_rows = std::max(std::max(rows, no_rows), (size_t)2);
+    stride = std::max(std::max(cols, stride), (size_t)2);
+
+    scoreX = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    scoreY = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    scoreM = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    scoreI = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    scoreD = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    scoreW = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    scoreZ = AlignmentWorkspace::acquire<double>(no_rows*stride);
+
+    pathX = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathY = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathM = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathI = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathD = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathW = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathZ = AlignmentWorkspace::acquire<char>(no_rows*stride);
+
+    for (size_t i=0; i<no_rows; ++i)
     {
-        for (int32_t j=0; j<MAXLEN; ++j)
+        for (size_t j=0; j<stride; ++j)
         {
-            scoreX[i*MAXLEN+j] = -DBL_MAX;
-            scoreY[i*MAXLEN+j] = -DBL_MAX;
-            scoreM[i*MAXLEN+j] = -DBL_MAX;
-            scoreI[i*MAXLEN+j] = -DBL_MAX;
-            scoreD[i*MAXLEN+j] = -DBL_MAX;
-            scoreW[i*MAXLEN+j] = -DBL_MAX;
-            scoreZ[i*MAXLEN+j] = -DBL_MAX;
+            scoreX[i*stride+j] = -DBL_MAX;
+            scoreY[i*stride+j] = -DBL_MAX;
+            scoreM[i*stride+j] = -DBL_MAX;
+            scoreI[i*stride+j] = -DBL_MAX;
+            scoreD[i*stride+j] = -DBL_MAX;
+            scoreW[i*stride+j] = -DBL_MAX;
+            scoreZ[i*stride+j] = -DBL_MAX;
 
             if (j)
             {
-                pathX[i*MAXLEN+j] = 'Y';
-                pathY[i*MAXLEN+j] = 'Y';
-                pathM[i*MAXLEN+j] = 'Y';
-                pathI[i*MAXLEN+j] = 'Y';
-                pathD[i*MAXLEN+j] = 'Y';
-                pathW[i*MAXLEN+j] = 'Y';
-                pathZ[i*MAXLEN+j] = 'Y';
+                pathX[i*stride+j] = 'Y';
+                pathY[i*stride+j] = 'Y';
+                pathM[i*stride+j] = 'Y';
+                pathI[i*stride+j] = 'Y';
+                pathD[i*stride+j] = 'Y';
+                pathW[i*stride+j] = 'Y';
+                pathZ[i*stride+j] = 'Y';
             }
             else
             {
-                pathX[i*MAXLEN+j] = 'X';
-                pathY[i*MAXLEN+j] = 'X';
-                pathM[i*MAXLEN+j] = 'X';
-                pathI[i*MAXLEN+j] = 'X';
-                pathD[i*MAXLEN+j] = 'X';
-                pathW[i*MAXLEN+j] = 'X';
-                pathZ[i*MAXLEN+j] = 'X';
+                pathX[i*stride+j] = 'X';
+                pathY[i*stride+j] = 'X';
+                pathM[i*stride+j] = 'X';
+                pathI[i*stride+j] = 'X';
+                pathD[i*stride+j] = 'X';
+                pathW[i*stride+j] = 'X';
+                pathZ[i*stride+j] = 'X';
             }
         }
     }
 
-    logEta = log10(eta);
-    logTau = log10(tau);
+    scoreX[0*stride] = 0;
+    scoreY[0*stride] = 0;
+    scoreM[0*stride] = 0;
+    scoreW[0*stride] = 0;
+    scoreZ[0*stride] = 0;
+    pathX[0*stride] = 'N';
+    pathX[1*stride] = 'S';
+    pathY[0*stride] = 'N';
+    pathY[0*stride+1] = 'S';
+    pathM[0*stride] = 'N';
+    pathM[1*stride+1] = 'S';
+
+    for (size_t k=1; k<no_rows; ++k)
+    {
+        scoreX[k*stride] = scoreX[(k-1)*stride] + transition[X][X];
+        scoreY[k*stride] = -DBL_MAX;
+        scoreW[k*stride] = scoreW[(k-1)*stride] + transition[W][W];
+        scoreZ[k*stride] = -DBL_MAX;
+    }
 
-    scoreX[0*MAXLEN+0] = 0;
-    scoreY[0*MAXLEN+0] = 0;
-    scoreM[0*MAXLEN+0] = 0;
-    scoreW[0*MAXLEN+0] = 0;
-    scoreZ[0*MAXLEN+0] = 0;
-    pathX[0*MAXLEN+0] = 'N';
-    pathX[1*MAXLEN+0] = 'S';
-    pathY[0*MAXLEN+0] = 'N';
-    pathY[0*MAXLEN+1] = 'S';
-    pathM[0*MAXLEN+0] = 'N';
-    pathM[1*MAXLEN+1] = 'S';
-
-    for (uint32_t k=1; k<MAXLEN; ++k)
+    for (size_t k=1; k<stride; ++k)
     {
-        scoreX[k*MAXLEN+0] = scoreX[(k-1)*MAXLEN+0] + transition[X][X];
-        scoreX[0*MAXLEN+k] = -DBL_MAX;
-        scoreY[k*MAXLEN+0] = -DBL_MAX;
-        scoreY[0*MAXLEN+k] = scoreY[0*MAXLEN+(k-1)] + transition[Y][Y];
-        scoreW[k*MAXLEN+0] = scoreW[(k-1)*MAXLEN+0] + transition[W][W];
-        scoreW[0*MAXLEN+k] = -DBL_MAX;
-        scoreZ[k*MAXLEN+0] = -DBL_MAX;
-        scoreZ[0*MAXLEN+k] = scoreZ[0*MAXLEN+(k-1)] + transition[Z][Z];
+        scoreX[0*stride+k] = -DBL_MAX;
+        scoreY[0*stride+k] = scoreY[0*stride+(k-1)] + transition[Y][Y];
+        scoreW[0*stride+k] = -DBL_MAX;
+        scoreZ[0*stride+k] = scoreZ[0*stride+(k-1)] + transition[Z][Z];
     }
 
-    scoreX[0*MAXLEN+0] = -DBL_MAX;
-    scoreY[0*MAXLEN+0] = -DBL_MAX;
-    scoreW[0*MAXLEN+0] = -DBL_MAX;
-    scoreZ[0*MAXLEN+0] = -DBL_MAX;
+    scoreX[0*stride] = -DBL_MAX;
+    scoreY[0*stride] = -DBL_MAX;
+    scoreW[0*stride] = -DBL_MAX;
+    scoreZ[0*stride] = -DBL_MAX;
+};
+
+/**
+ * Returns the matrices to the alignment workspace.
+ */
+void LHMM::release()
+{
+    AlignmentWorkspace::release(scoreX, no_rows*stride);
+    AlignmentWorkspace::release(scoreY, no_rows*stride);
+    AlignmentWorkspace::release(scoreM, no_rows*stride);
+    AlignmentWorkspace::release(scoreI, no_rows*stride);
+    AlignmentWorkspace::release(scoreD, no_rows*stride);
+    AlignmentWorkspace::release(scoreW, no_rows*stride);
+    AlignmentWorkspace::release(scoreZ, no_rows*stride);
+
+    AlignmentWorkspace::release(pathX, no_rows*stride);
+    AlignmentWorkspace::release(pathY, no_rows*stride);
+    AlignmentWorkspace::release(pathM, no_rows*stride);
+    AlignmentWorkspace::release(pathI, no_rows*stride);
+    AlignmentWorkspace::release(pathD, no_rows*stride);
+    AlignmentWorkspace::release(pathW, no_rows*stride);
+    AlignmentWorkspace::release(pathZ, no_rows*stride);
 };
 
 /**
@@ -190,6 +224,8 @@ void LHMM::initialize()
  */
 void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bool debug)
 {
+    VT_TIME(align_stat);
+
     //std::cerr << "Running this\n" ;
     this->x = x;
     this->y = y;
@@ -198,6 +234,7 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
     //adds a starting character at the fron of each string that must be matched
     xlen = strlen(x);
     ylen = strlen(y);
+    resize(xlen+1, ylen+1);
     double max = 0;
     char maxPath = 'X';
 
@@ -207,17 +244,17 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
         for (uint32_t j=1; j<=ylen; ++j)
         {
             //X
-            double xx = scoreX[(i-1)*MAXLEN+j] + transition[X][X];
+            double xx = scoreX[(i-1)*stride+j] + transition[X][X];
 
             max = xx;
             maxPath = 'X';
 
-            scoreX[i*MAXLEN+j] = max;
-            pathX[i*MAXLEN+j] = maxPath;
+            scoreX[i*stride+j] = max;
+            pathX[i*stride+j] = maxPath;
 
             //Y
-            double xy = scoreX[i*MAXLEN+(j-1)] + transition[X][Y];
-            double yy = scoreY[i*MAXLEN+(j-1)] + transition[Y][Y];
+            double xy = scoreX[i*stride+(j-1)] + transition[X][Y];
+            double yy = scoreY[i*stride+(j-1)] + transition[Y][Y];
 
             max = xy;
             maxPath = 'X';
@@ -228,15 +265,15 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
                 maxPath = 'Y';
             }
 
-            scoreY[i*MAXLEN+j] = max;
-            pathY[i*MAXLEN+j] = maxPath;
+            scoreY[i*stride+j] = max;
+            pathY[i*stride+j] = maxPath;
 
             //M
-            double xm = scoreX[(i-1)*MAXLEN+(j-1)] + transition[X][M];
-            double ym = scoreY[(i-1)*MAXLEN+(j-1)] + transition[Y][M];
-            double mm = scoreM[(i-1)*MAXLEN+(j-1)] + ((i==1&&j==1) ? transition[S][M] : transition[M][M]);
-            double im = scoreI[(i-1)*MAXLEN+(j-1)] + transition[I][M];
-            double dm = scoreD[(i-1)*MAXLEN+(j-1)] + transition[D][M];
+            double xm = scoreX[(i-1)*stride+(j-1)] + transition[X][M];
+            double ym = scoreY[(i-1)*stride+(j-1)] + transition[Y][M];
+            double mm = scoreM[(i-1)*stride+(j-1)] + ((i==1&&j==1) ? transition[S][M] : transition[M][M]);
+            double im = scoreI[(i-1)*stride+(j-1)] + transition[I][M];
+            double dm = scoreD[(i-1)*stride+(j-1)] + transition[D][M];
 
             max = xm;
             maxPath = 'X';
@@ -262,12 +299,12 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
                 maxPath = 'D';
             }
 
-            scoreM[i*MAXLEN+j] = max + log10_emission_odds(x[i-1], y[j-1], LogTool::pl2prob((uint32_t) qual[j-1]-33));
-            pathM[i*MAXLEN+j] = maxPath;
+            scoreM[i*stride+j] = max + log10_emission_odds(x[i-1], y[j-1], LogTool::pl2prob((uint32_t) qual[j-1]-33));
+            pathM[i*stride+j] = maxPath;
 
             //D
-            double md = scoreM[(i-1)*MAXLEN+j] + transition[M][D];
-            double dd = scoreD[(i-1)*MAXLEN+j] + transition[D][D];
+            double md = scoreM[(i-1)*stride+j] + transition[M][D];
+            double dd = scoreD[(i-1)*stride+j] + transition[D][D];
 
             max = md;
             maxPath = 'M';
@@ -278,12 +315,12 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
                 maxPath = 'D';
             }
 
-            scoreD[i*MAXLEN+j] = max;
-            pathD[i*MAXLEN+j] = maxPath;
+            scoreD[i*stride+j] = max;
+            pathD[i*stride+j] = maxPath;
 
             //I
-            double mi = scoreM[i*MAXLEN+(j-1)] + transition[M][I];
-            double ii = scoreI[i*MAXLEN+(j-1)] + transition[I][I];
+            double mi = scoreM[i*stride+(j-1)] + transition[M][I];
+            double ii = scoreI[i*stride+(j-1)] + transition[I][I];
 
             max = mi;
             maxPath = 'M';
@@ -294,12 +331,12 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
                 maxPath = 'I';
             }
 
-            scoreI[i*MAXLEN+j] = max;
-            pathI[i*MAXLEN+j] = maxPath;
+            scoreI[i*stride+j] = max;
+            pathI[i*stride+j] = maxPath;
 
             //W
-            double mw = scoreM[(i-1)*MAXLEN+j] + transition[M][W];
-            double ww = scoreW[(i-1)*MAXLEN+j] + transition[W][W];
+            double mw = scoreM[(i-1)*stride+j] + transition[M][W];
+            double ww = scoreW[(i-1)*stride+j] + transition[W][W];
 
             max = mw;
             maxPath = 'M';
@@ -310,13 +347,13 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
                 maxPath = 'W';
             }
 
-            scoreW[i*MAXLEN+j] = max;
-            pathW[i*MAXLEN+j] = maxPath;
+            scoreW[i*stride+j] = max;
+            pathW[i*stride+j] = maxPath;
 
             //Z
-            double mz = scoreM[i*MAXLEN+(j-1)] + transition[M][Z];
-            double wz = scoreW[i*MAXLEN+(j-1)] + transition[W][Z];
-            double zz = scoreZ[i*MAXLEN+(j-1)] + transition[Z][Z];
+            double mz = scoreM[i*stride+(j-1)] + transition[M][Z];
+            double wz = scoreW[i*stride+(j-1)] + transition[W][Z];
+            double zz = scoreZ[i*stride+(j-1)] + transition[Z][Z];
 
             max = mz;
             maxPath = 'M';
@@ -332,11 +369,11 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
                 maxPath = 'Z';
             }
 
-            scoreZ[i*MAXLEN+j] = max;
-            pathZ[i*MAXLEN+j] = maxPath;
+            scoreZ[i*stride+j] = max;
+            pathZ[i*stride+j] = maxPath;
         }
 
-        scoreM[xlen*MAXLEN+ylen] += logTau-logEta;
+        scoreM[xlen*stride+ylen] += logTau-logEta;
     }
 
     if (debug)
@@ -379,16 +416,16 @@ void LHMM::align(double& llk, const char* x, const char* y, const char* qual, bo
  */
 void LHMM::trace_path()
 {
-    double globalMax = scoreM[xlen*MAXLEN+ylen];
+    double globalMax = scoreM[xlen*stride+ylen];
     char globalMaxPath = 'M';
-    if (scoreW[xlen*MAXLEN+ylen]>globalMax)
+    if (scoreW[xlen*stride+ylen]>globalMax)
     {
-        globalMax = scoreW[xlen*MAXLEN+ylen];
+        globalMax = scoreW[xlen*stride+ylen];
         globalMaxPath = 'W';
     }
-    if (scoreZ[xlen*MAXLEN+ylen]>globalMax)
+    if (scoreZ[xlen*stride+ylen]>globalMax)
     {
-        globalMax = scoreZ[xlen*MAXLEN+ylen];
+        globalMax = scoreZ[xlen*stride+ylen];
         globalMaxPath = 'Z';
     }
 
@@ -504,58 +541,58 @@ void LHMM::trace_path(char state, uint32_t i, uint32_t j)
     {
         if (state=='X')
         {
-            ss << pathX[i*MAXLEN+j];
-            trace_path(pathX[i*MAXLEN+j], i-1, j);
+            ss << pathX[i*stride+j];
+            trace_path(pathX[i*stride+j], i-1, j);
         }
         else if (state=='Y')
         {
-            ss << pathY[i*MAXLEN+j];
-            trace_path(pathY[i*MAXLEN+j], i, j-1);
+            ss << pathY[i*stride+j];
+            trace_path(pathY[i*stride+j], i, j-1);
         }
         else if (state=='M')
         {
-            if (matchStartX==-1 && (pathM[i*MAXLEN+j] =='X' || pathM[i*MAXLEN+j]=='Y'))
+            if (matchStartX==-1 && (pathM[i*stride+j] =='X' || pathM[i*stride+j]=='Y'))
             {
                matchStartX = i;
                matchStartY = j;
             }
 
-            ss << pathM[i*MAXLEN+j];
-            trace_path(pathM[i*MAXLEN+j], i-1, j-1);
+            ss << pathM[i*stride+j];
+            trace_path(pathM[i*stride+j], i-1, j-1);
             ++noBasesAligned;
         }
         else if (state=='I')
         {
-            ss << pathI[i*MAXLEN+j];
-            trace_path(pathI[i*MAXLEN+j], i, j-1);
+            ss << pathI[i*stride+j];
+            trace_path(pathI[i*stride+j], i, j-1);
         }
         else if (state=='D')
         {
-            ss << pathD[i*MAXLEN+j];
-            trace_path(pathD[i*MAXLEN+j], i-1, j);
+            ss << pathD[i*stride+j];
+            trace_path(pathD[i*stride+j], i-1, j);
             ++noBasesAligned;
         }
         else if (state=='W')
         {
-            if (matchEndX==-1 && pathW[i*MAXLEN+j] =='M')
+            if (matchEndX==-1 && pathW[i*stride+j] =='M')
             {
                 matchEndX = i-1;
                 matchEndY = j;
             }
 
-            ss << pathW[i*MAXLEN+j];
-            trace_path(pathW[i*MAXLEN+j], i-1, j);
+            ss << pathW[i*stride+j];
+            trace_path(pathW[i*stride+j], i-1, j);
         }
         else if (state=='Z')
         {
-            if (matchEndX==-1 && pathZ[i*MAXLEN+j] =='M')
+            if (matchEndX==-1 && pathZ[i*stride+j] =='M')
             {
                 matchEndX = i;
                 matchEndY = j-1;
             }
 
-            ss << pathZ[i*MAXLEN+j];
-            trace_path(pathZ[i*MAXLEN+j], i, j-1);
+            ss << pathZ[i*stride+j];
+            trace_path(pathZ[i*stride+j], i, j-1);
         }
         else if (state=='S')
         {
@@ -577,8 +614,8 @@ void LHMM::trace_path(char state, uint32_t i, uint32_t j)
            matchStartY = j+1;
         }
 
-        ss << pathY[i*MAXLEN+j];
-        trace_path(pathY[i*MAXLEN+j], i, j-1);
+        ss << pathY[i*stride+j];
+        trace_path(pathY[i*stride+j], i, j-1);
     }
     else if (i>0 && j==0)
     {
@@ -587,8 +624,8 @@ void LHMM::trace_path(char state, uint32_t i, uint32_t j)
            matchStartY = j+1;
         }
 
-        ss << pathX[i*MAXLEN+j];
-        trace_path(pathX[i*MAXLEN+j], i-1, j);
+        ss << pathX[i*stride+j];
+        trace_path(pathX[i*stride+j], i-1, j);
     }
     else
     {
@@ -851,7 +888,7 @@ void LHMM::print(double *v, uint32_t xlen, uint32_t ylen)
     {
         for (uint32_t j=0; j<ylen; ++j)
         {
-            std::cerr << (v[i*MAXLEN+j]==-DBL_MAX?-1000:v[i*MAXLEN+j]) << "\t";
+            std::cerr << (v[i*stride+j]==-DBL_MAX?-1000:v[i*stride+j]) << "\t";
         }
 
         std::cerr << "\n";
@@ -867,14 +904,13 @@ void LHMM::print(char *v, uint32_t xlen, uint32_t ylen)
     {
         for (uint32_t j=0; j<ylen; ++j)
         {
-          std::cerr << v[i*MAXLEN+j] << "\t";
+          std::cerr << v[i*stride+j] << "\t";
         }
 
         std::cerr << "\n";
     }
 };
 
-#undef MAXLEN
 #undef S
 #undef X
 #undef Y
@@ -25,7 +25,9 @@
 #define LHMM_H
 
 #include "log_tool.h"
+#include "align_workspace.h"
 #include "utils.h"
+#include "instrument.h"
 
 #define NSTATES 9
 
@@ -52,6 +54,11 @@ class LHMM
 
     double transition[NSTATES][NSTATES];
 
+    //scoring and path matrices of no_rows rows of stride cells from the
+    //alignment workspace, grown to the lengths of the aligned sequences
+    size_t no_rows;
+    size_t stride;
+
     //scoring matrix
     double *scoreX;
     double *scoreY;
@@ -111,6 +118,16 @@ class LHMM
      */
     void initialize();
 
+    /**
+     * Grows the matrices to at least rows x cols cells.
+     */
+    void resize(size_t rows, size_t cols);
+
+    /**
+     * Returns the matrices to the alignment workspace.
+     */
+    void release();
+
     /**
      * Align and compute genotype likelihood.
      */
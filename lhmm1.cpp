@@ -25,14 +25,15 @@
 
 #include "lhmm1.h"
 
+VT_TIMER_STAT(align_stat, "lhmm1.align");
+
 LHMM1::LHMM1()
 {
-    initialize(500);
+    initialize();
 };
 
-void LHMM1::initialize(int32_t maxLength)
+void LHMM1::initialize()
 {
-    this->maxLength = maxLength;
 //  delta = 0.01;
 //  epsilon = 0.1;
 //  tau = 0.1;
@@ -94,79 +95,115 @@ void LHMM1::initialize(int32_t maxLength)
     twz = log10((eta*(1-eta))/(eta*(1-eta)));
     tzz = log10((1-eta)/(1-eta));
 
-    //assume alignments can't possibly be maxLength bases or more
-    //todo:: allow for resizing if you do encounter fragments which are really long
-    std::vector<double> temp(maxLength+1, -DBL_MAX);
-    std::vector<char> tempX(maxLength+1, 'Y');
-    tempX[0] = 'X';
-    std::vector<char> tempY(maxLength+1, 'Y');
-    tempY[0] = 'X';
-
-    X.clear();
-    Y.clear();
-    M.clear();
-    I.clear();
-    D.clear();
-    W.clear();
-    Z.clear();
-    pathX.clear();
-    pathY.clear();
-    pathM.clear();
-    pathD.clear();
-    pathI.clear();
-    pathW.clear();
-    pathZ.clear();
-
-    for (uint32_t i=0; i<maxLength+1; ++i)
+    logEta = log10(eta);
+    logTau = log10(tau);
+
+    no_rows = 0;
+    stride = 0;
+    X = Y = M = I = D = W = Z = NULL;
+    pathX = pathY = pathM = pathD = pathI = pathW = pathZ = NULL;
+};
+
+LHMM1::~LHMM1()
+{
+    release();
+};
+
+/**
+ * Grows the matrices to at least rows x cols cells.
+ */
+void LHMM1::resize(uint32_t rows, uint32_t cols)
+{
+    if (rows<=no_rows && cols<=stride)
     {
-        X.push_back(temp);
-        Y.push_back(temp);
-        M.push_back(temp);
-        I.push_back(temp);
-        D.push_back(temp);
-        W.push_back(temp);
-        Z.push_back(temp);
-        pathX.push_back(tempX);
-        pathY.push_back(tempY);
-        pathM.push_back(tempX);
-        pathD.push_back(tempX);
-        pathI.push_back(tempX);
-        pathW.push_back(tempX);
-        pathZ.push_back(tempX);
+        return;
     }
 
-    logEta = log10(eta);
-    logTau = log10(tau);
+    release();
+
+    //the initial values reach into the second row and column
+    no_rows = std::max(std::max(rows, no_rows), (uint32_t)2);
+    stride = std::max(std::max(cols, stride), (uint32_t)2);
+
+    X = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    Y = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    M = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    I = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    D = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    W = AlignmentWorkspace::acquire<double>(no_rows*stride);
+    Z = AlignmentWorkspace::acquire<double>(no_rows*stride);
+
+    pathX = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathY = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathM = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathD = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathI = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathW = AlignmentWorkspace::acquire<char>(no_rows*stride);
+    pathZ = AlignmentWorkspace::acquire<char>(no_rows*stride);
+
+    for (uint32_t i=0; i<no_rows; ++i)
+    {
+        for (uint32_t j=0; j<stride; ++j)
+        {
+            X[i*stride+j] = Y[i*stride+j] = M[i*stride+j] = I[i*stride+j] = D[i*stride+j] = W[i*stride+j] = Z[i*stride+j] = -DBL_MAX;
+            pathX[i*stride+j] = pathY[i*stride+j] = pathM[i*stride+j] = pathD[i*stride+j] = pathI[i*stride+j] = pathW[i*stride+j] = pathZ[i*stride+j] = j ? 'Y' : 'X';
+        }
+    }
 
-    X[0][0] = 0;
-    Y[0][0] = 0;
-    M[0][0] = 0;
-    W[0][0] = 0;
-    Z[0][0] = 0;
-    pathX[0][0] = 'N';
-    pathX[1][0] = 'S';
-    pathY[0][0] = 'N';
-    pathY[0][1] = 'S';
-    pathM[0][0] = 'N';
-    pathM[1][1] = 'S';
-
-    for (uint32_t k=1; k<maxLength+1; ++k)
+    X[0] = 0;
+    Y[0] = 0;
+    M[0] = 0;
+    W[0] = 0;
+    Z[0] = 0;
+    pathX[0] = 'N';
+    pathX[1*stride] = 'S';
+    pathY[0] = 'N';
+    pathY[1] = 'S';
+    pathM[0] = 'N';
+    pathM[1*stride+1] = 'S';
+
+    for (uint32_t k=1; k<no_rows; ++k)
     {
-        X[k][0] = X[k-1][0] + txx;
-        X[0][k] = -DBL_MAX;
-        Y[k][0] = -DBL_MAX;
-        Y[0][k] = Y[0][k-1] + tyy;
-        W[k][0] = W[k-1][0] + tww;
-        W[0][k] = -DBL_MAX;
-        Z[k][0] = -DBL_MAX;
-        Z[0][k] = Z[0][k-1] + tzz;
+        X[k*stride] = X[(k-1)*stride] + txx;
+        Y[k*stride] = -DBL_MAX;
+        W[k*stride] = W[(k-1)*stride] + tww;
+        Z[k*stride] = -DBL_MAX;
     }
 
-    X[0][0] = -DBL_MAX;
-    Y[0][0] = -DBL_MAX;
-    W[0][0] = -DBL_MAX;
-    Z[0][0] = -DBL_MAX;
+    for (uint32_t k=1; k<stride; ++k)
+    {
+        X[k] = -DBL_MAX;
+        Y[k] = Y[k-1] + tyy;
+        W[k] = -DBL_MAX;
+        Z[k] = Z[k-1] + tzz;
+    }
 
+    X[0] = -DBL_MAX;
+    Y[0] = -DBL_MAX;
+    W[0] = -DBL_MAX;
+    Z[0] = -DBL_MAX;
+};
+
+/**
+ * Returns the matrices to the alignment workspace.
+ */
+void LHMM1::release()
+{
+    AlignmentWorkspace::release(X, no_rows*stride);
+    AlignmentWorkspace::release(Y, no_rows*stride);
+    AlignmentWorkspace::release(M, no_rows*stride);
+    AlignmentWorkspace::release(I, no_rows*stride);
+    AlignmentWorkspace::release(D, no_rows*stride);
+    AlignmentWorkspace::release(W, no_rows*stride);
+    AlignmentWorkspace::release(Z, no_rows*stride);
+
+    AlignmentWorkspace::release(pathX, no_rows*stride);
+    AlignmentWorkspace::release(pathY, no_rows*stride);
+    AlignmentWorkspace::release(pathM, no_rows*stride);
+    AlignmentWorkspace::release(pathD, no_rows*stride);
+    AlignmentWorkspace::release(pathI, no_rows*stride);
+    AlignmentWorkspace::release(pathW, no_rows*stride);
+    AlignmentWorkspace::release(pathZ, no_rows*stride);
 };
 
 bool LHMM1::containsIndel()
@@ -198,16 +235,16 @@ double LHMM1::pl2prob(uint32_t PL)
  */
 void LHMM1::tracePath()
 {
-    double globalMax = M[xlen][ylen];
+    double globalMax = M[xlen*stride+ylen];
     char globalMaxPath = 'M';
-    if (W[xlen][ylen]>globalMax)
+    if (W[xlen*stride+ylen]>globalMax)
     {
-        globalMax = W[xlen][ylen];
+        globalMax = W[xlen*stride+ylen];
         globalMaxPath = 'W';
     }
-    if (Z[xlen][ylen]>globalMax)
+    if (Z[xlen*stride+ylen]>globalMax)
     {
-        globalMax = Z[xlen][ylen];
+        globalMax = Z[xlen*stride+ylen];
         globalMaxPath = 'Z';
     }
 
@@ -337,15 +374,15 @@ void LHMM1::tracePath(std::stringstream& ss, char state, uint32_t i, uint32_t j)
     {
         if (state=='X')
         {
-            //std::cerr << pathX[i][j] << " " << i << " " << j << " " << matchStartY << "\n";
-            ss << pathX[i][j];
-            tracePath(ss, pathX[i][j], i-1, j);
+            //std::cerr << pathX[i*stride+j] << " " << i << " " << j << " " << matchStartY << "\n";
+            ss << pathX[i*stride+j];
+            tracePath(ss, pathX[i*stride+j], i-1, j);
         }
         else if (state=='Y')
         {
-            //std::cerr << pathY[i][j] << " " << i << " " << j << " " << matchStartY << "\n";
-            ss << pathY[i][j];
-            tracePath(ss, pathY[i][j], i, j-1);
+            //std::cerr << pathY[i*stride+j] << " " << i << " " << j << " " << matchStartY << "\n";
+            ss << pathY[i*stride+j];
+            tracePath(ss, pathY[i*stride+j], i, j-1);
         }
         else if (state=='M')
         {
@@ -357,7 +394,7 @@ void LHMM1::tracePath(std::stringstream& ss, char state, uint32_t i, uint32_t j)
 //                //std::cerr << "set matchEndX "  << matchEndX  << " " << matchEndY  <<  "\n";
 //            }
 //
-            if (matchStartX==-1 && (pathM[i][j] =='X' || pathM[i][j]=='Y'))
+            if (matchStartX==-1 && (pathM[i*stride+j] =='X' || pathM[i*stride+j]=='Y'))
             {
                matchStartX = i;
                matchStartY = j;
@@ -366,48 +403,48 @@ void LHMM1::tracePath(std::stringstream& ss, char state, uint32_t i, uint32_t j)
             }
 
 
-            //std::cout << pathM[i][j] << " " << i << " " << j << " " << matchEndY << "\n";
-            ss << pathM[i][j];
-            tracePath(ss, pathM[i][j], i-1, j-1);
+            //std::cout << pathM[i*stride+j] << " " << i << " " << j << " " << matchEndY << "\n";
+            ss << pathM[i*stride+j];
+            tracePath(ss, pathM[i*stride+j], i-1, j-1);
             ++noBasesAligned;
         }
         else if (state=='I')
         {
-            //std::cout << pathI[i][j] << " " << i << " " << j << "\n";
-            ss << pathI[i][j];
-            tracePath(ss, pathI[i][j], i, j-1);
+            //std::cout << pathI[i*stride+j] << " " << i << " " << j << "\n";
+            ss << pathI[i*stride+j];
+            tracePath(ss, pathI[i*stride+j], i, j-1);
         }
         else if (state=='D')
         {
-            //std::cout << pathD[i][j] << " " << i << " " << j << "\n";
-            ss << pathD[i][j];
-            tracePath(ss, pathD[i][j], i-1, j);
+            //std::cout << pathD[i*stride+j] << " " << i << " " << j << "\n";
+            ss << pathD[i*stride+j];
+            tracePath(ss, pathD[i*stride+j], i-1, j);
             ++noBasesAligned;
         }
         else if (state=='W')
         {
-            if (matchEndX==-1 && pathW[i][j] =='M')
+            if (matchEndX==-1 && pathW[i*stride+j] =='M')
             {
                 matchEndX = i-1;
                 matchEndY = j;
             }
 
 
-            //std::cout << pathW[i][j] << " " << i << " " << j << "\n";
-            ss << pathW[i][j];
-            tracePath(ss, pathW[i][j], i-1, j);
+            //std::cout << pathW[i*stride+j] << " " << i << " " << j << "\n";
+            ss << pathW[i*stride+j];
+            tracePath(ss, pathW[i*stride+j], i-1, j);
         }
         else if (state=='Z')
         {
-            if (matchEndX==-1 && pathZ[i][j] =='M')
+            if (matchEndX==-1 && pathZ[i*stride+j] =='M')
             {
                 matchEndX = i;
                 matchEndY = j-1;
             }
 
-            //std::cout << pathZ[i][j] << " " << i << " " << j << "\n";
-            ss << pathZ[i][j];
-            tracePath(ss, pathZ[i][j], i, j-1);
+            //std::cout << pathZ[i*stride+j] << " " << i << " " << j << "\n";
+            ss << pathZ[i*stride+j];
+            tracePath(ss, pathZ[i*stride+j], i, j-1);
         }
         else if (state=='S')
         {
@@ -431,9 +468,9 @@ void LHMM1::tracePath(std::stringstream& ss, char state, uint32_t i, uint32_t j)
            matchStartY = j+1;
         }
 
-        // std::cout << pathY[i][j] << " " << i << " " << j << "\n";
-        ss << pathY[i][j];
-        tracePath(ss, pathY[i][j], i, j-1);
+        // std::cout << pathY[i*stride+j] << " " << i << " " << j << "\n";
+        ss << pathY[i*stride+j];
+        tracePath(ss, pathY[i*stride+j], i, j-1);
     }
     else if (i>0 && j==0)
     {
@@ -441,14 +478,14 @@ void LHMM1::tracePath(std::stringstream& ss, char state, uint32_t i, uint32_t j)
         {
            matchStartY = j+1;
         }
-        // std::cout << pathX[i][j] << " " << i << " " << j << "\n";
-        ss << pathX[i][j];
-        tracePath(ss, pathX[i][j], i-1, j);
+        // std::cout << pathX[i*stride+j] << " " << i << " " << j << "\n";
+        ss << pathX[i*stride+j];
+        tracePath(ss, pathX[i*stride+j], i-1, j);
     }
     else
     {
         //std::cout << "\n";
-        //ss << pathX[i][j];
+        //ss << pathX[i*stride+j];
     }
 }
 
@@ -568,6 +605,8 @@ Align and compute genotype likelihood.
 */
 void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual, bool debug)
 {
+    VT_TIME(align_stat);
+
     x = _x;
     y = _y;
     qual = _qual;
@@ -576,11 +615,7 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
     xlen = strlen(x);
     ylen = strlen(y);
     
-    int32_t mlen = xlen>ylen?xlen:ylen;
-    if (mlen>this->maxLength)
-    {    
-        initialize(mlen+10);
-    }
+    resize(xlen+1, ylen+1);
     
     double max = 0;
     char maxPath = 'X';
@@ -596,17 +631,17 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
             //std::cerr << i << " " << j  << "\n" ;
 
             //X
-            double xx = X[i-1][j] + txx;
+            double xx = X[(i-1)*stride+j] + txx;
 
             max = xx;
             maxPath = 'X';
 
-            X[i][j] = max;
-            pathX[i][j] = maxPath;
+            X[i*stride+j] = max;
+            pathX[i*stride+j] = maxPath;
 
             //Y
-            double xy = X[i][j-1] + txy;
-            double yy = Y[i][j-1] + tyy;
+            double xy = X[i*stride+j-1] + txy;
+            double yy = Y[i*stride+j-1] + tyy;
 
             max = xy;
             maxPath = 'X';
@@ -617,15 +652,15 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
                 maxPath = 'Y';
             }
 
-            Y[i][j] = max;
-            pathY[i][j] = maxPath;
+            Y[i*stride+j] = max;
+            pathY[i*stride+j] = maxPath;
 
             //M
-            double xm = X[i-1][j-1] + txm;
-            double ym = Y[i-1][j-1] + tym;
-            double mm = M[i-1][j-1] + ((i==1&&j==1) ? tsm : tmm);
-            double im = I[i-1][j-1] + tim;
-            double dm = D[i-1][j-1] + tdm;
+            double xm = X[(i-1)*stride+j-1] + txm;
+            double ym = Y[(i-1)*stride+j-1] + tym;
+            double mm = M[(i-1)*stride+j-1] + ((i==1&&j==1) ? tsm : tmm);
+            double im = I[(i-1)*stride+j-1] + tim;
+            double dm = D[(i-1)*stride+j-1] + tdm;
 
             max = xm;
             maxPath = 'X';
@@ -651,12 +686,12 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
                 maxPath = 'D';
             }
 
-            M[i][j] = max + logEmissionOdds(x[i-1], y[j-1], pl2prob((uint32_t) qual[j-1]-33));
-            pathM[i][j] = maxPath;
+            M[i*stride+j] = max + logEmissionOdds(x[i-1], y[j-1], pl2prob((uint32_t) qual[j-1]-33));
+            pathM[i*stride+j] = maxPath;
 
             //D
-            double md = M[i-1][j] + tmd;
-            double dd = D[i-1][j] + tdd;
+            double md = M[(i-1)*stride+j] + tmd;
+            double dd = D[(i-1)*stride+j] + tdd;
 
             max = md;
             maxPath = 'M';
@@ -667,12 +702,12 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
                 maxPath = 'D';
             }
 
-            D[i][j] = max;
-            pathD[i][j] = maxPath;
+            D[i*stride+j] = max;
+            pathD[i*stride+j] = maxPath;
 
             //I
-            double mi = M[i][j-1] + tmi;
-            double ii = I[i][j-1] + tii;
+            double mi = M[i*stride+j-1] + tmi;
+            double ii = I[i*stride+j-1] + tii;
 
             max = mi;
             maxPath = 'M';
@@ -683,12 +718,12 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
                 maxPath = 'I';
             }
 
-            I[i][j] = max;
-            pathI[i][j] = maxPath;
+            I[i*stride+j] = max;
+            pathI[i*stride+j] = maxPath;
 
             //W
-            double mw = M[i-1][j] + tmw;
-            double ww = W[i-1][j] + tww;
+            double mw = M[(i-1)*stride+j] + tmw;
+            double ww = W[(i-1)*stride+j] + tww;
 
             max = mw;
             maxPath = 'M';
@@ -699,13 +734,13 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
                 maxPath = 'W';
             }
 
-            W[i][j] = max;
-            pathW[i][j] = maxPath;
+            W[i*stride+j] = max;
+            pathW[i*stride+j] = maxPath;
 
             //Z
-            double mz = M[i][j-1] + tmz;
-            double wz = W[i][j-1] + twz;
-            double zz = Z[i][j-1] + tzz;
+            double mz = M[i*stride+j-1] + tmz;
+            double wz = W[i*stride+j-1] + twz;
+            double zz = Z[i*stride+j-1] + tzz;
 
             max = mz;
             maxPath = 'M';
@@ -721,11 +756,11 @@ void LHMM1::align(double& llk, const char* _x, const char* _y, const char* _qual
                 maxPath = 'Z';
             }
 
-            Z[i][j] = max;
-            pathZ[i][j] = maxPath;
+            Z[i*stride+j] = max;
+            pathZ[i*stride+j] = maxPath;
         }
 
-        M[xlen][ylen] += logTau-logEta;
+        M[xlen*stride+ylen] += logTau-logEta;
     }
 
     if (debug)
@@ -1131,39 +1166,39 @@ std::string LHMM1::reverse(std::string s)
     return rs;
 };
 
-void LHMM1::printVector(std::vector<std::vector<double> >& v, uint32_t xLen, uint32_t yLen)
+void LHMM1::printVector(double* v, uint32_t xLen, uint32_t yLen)
 {
     for (uint32_t i=0; i<xLen; ++i)
     {
         for (uint32_t j=0; j<yLen; ++j)
         {
-          std::cerr << (v[i][j]==-DBL_MAX?-1000:v[i][j]) << "\t";
+          std::cerr << (v[i*stride+j]==-DBL_MAX?-1000:v[i*stride+j]) << "\t";
         }
 
         std::cerr << "\n";
     }
 };
 
-void LHMM1::printVector(std::vector<std::vector<char> >& v, uint32_t xLen, uint32_t yLen)
+void LHMM1::printVector(char* v, uint32_t xLen, uint32_t yLen)
 {
     for (uint32_t i=0; i<xLen; ++i)
     {
         for (uint32_t j=0; j<yLen; ++j)
         {
-          std::cerr << v[i][j] << "\t";
+          std::cerr << v[i*stride+j] << "\t";
         }
 
         std::cerr << "\n";
     }
 };
 
-void LHMM1::printVector(std::vector<std::vector<double> >& v)
+void LHMM1::printVector(double* v)
 {
-    for (uint32_t i=0; i<v.size(); ++i)
+    for (uint32_t i=0; i<no_rows; ++i)
     {
-        for (uint32_t j=0; j<v[i].size(); ++j)
+        for (uint32_t j=0; j<stride; ++j)
         {
-          std::cerr << v[i][j] << "\t";
+          std::cerr << v[i*stride+j] << "\t";
         }
 
         std::cerr << "\n";
@@ -25,8 +25,10 @@
 #define LHMM1_H
 
 #include "log_tool.h"
+#include "align_workspace.h"
 #include <regex.h>
 #include "utils.h"
+#include "instrument.h"
 
 class LHMM1
 {
@@ -35,23 +37,26 @@ class LHMM1
     const char* y;
     const char* qual;
 
-    std::vector<std::vector<double> > X;
-    std::vector<std::vector<double> > Y;
-    std::vector<std::vector<double> > M;
-    std::vector<std::vector<double> > I;
-    std::vector<std::vector<double> > D;
-    std::vector<std::vector<double> > W;
-    std::vector<std::vector<double> > Z;
-    std::vector<std::vector<char> > pathX;
-    std::vector<std::vector<char> > pathY;
-    std::vector<std::vector<char> > pathM;
-    std::vector<std::vector<char> > pathD;
-    std::vector<std::vector<char> > pathI;
-    std::vector<std::vector<char> > pathW;
-    std::vector<std::vector<char> > pathZ;
+    //scoring and path matrices of no_rows rows of stride cells from the
+    //alignment workspace, grown to the lengths of the aligned sequences
+    double* X;
+    double* Y;
+    double* M;
+    double* I;
+    double* D;
+    double* W;
+    double* Z;
+    char* pathX;
+    char* pathY;
+    char* pathM;
+    char* pathD;
+    char* pathI;
+    char* pathW;
+    char* pathZ;
+    uint32_t no_rows;
+    uint32_t stride;
     std::vector<double> PLs;
 
-    uint32_t maxLength;
     uint32_t xlen;
     uint32_t ylen;
     std::string path;
@@ -127,8 +132,17 @@ class LHMM1
     /*Constructor*/
     LHMM1();
 
+    /*Destructor*/
+    ~LHMM1();
+
     /*Helper method for constructor*/
-    void initialize(int32_t l);
+    void initialize();
+
+    /*Grows the matrices to at least rows x cols cells*/
+    void resize(uint32_t rows, uint32_t cols);
+
+    /*Returns the matrices to the alignment workspace*/
+    void release();
 
     bool containsIndel();
 
@@ -175,11 +189,11 @@ class LHMM1
 
     std::string reverse(std::string s);
 
-    void printVector(std::vector<std::vector<double> >& v, uint32_t xLen, uint32_t yLen);
+    void printVector(double* v, uint32_t xLen, uint32_t yLen);
 
-    void printVector(std::vector<std::vector<char> >& v, uint32_t xLen, uint32_t yLen);
+    void printVector(char* v, uint32_t xLen, uint32_t yLen);
 
-    void printVector(std::vector<std::vector<double> >& v);
+    void printVector(double* v);
 
     void printAlignment();
 
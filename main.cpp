@@ -48,6 +48,7 @@
 #include "genotype.h"
 #include "hfilter.h"
 #include "index.h"
+#include "index_gencode.h"
 #include "info2tab.h"
 #include "liftover.h"
 #include "milk_filter.h"
@@ -61,6 +62,7 @@
 #include "paste_genotypes.h"
 #include "paste_and_compute_features_sequential.h"
 #include "peek.h"
+#include "pipeline.h"
 #include "profile_afs.h"
 #include "profile_chm1.h"
 #include "profile_chrom.h"
@@ -73,7 +75,9 @@
 #include "profile_snps.h"
 #include "profile_vntrs.h"
 #include "rminfo.h"
+#include "scatter.h"
 #include "seq.h"
+#include "serve.h"
 #include "set_ref.h"
 #include "sort.h"
 #include "subset.h"
@@ -83,6 +87,7 @@
 #include "union_variants.h"
 #include "uniq.h"
 #include "validate.h"
+#include "vcf_text_pool.h"
 #include "version.h"
 #include "view.h"
 #include "vntrize.h"
@@ -117,13 +122,17 @@ void help()
     std::clog << "Useful tools:\n";
     std::clog << "view                      view vcf/vcf.gz/bcf files\n";
     std::clog << "index                     index vcf.gz/bcf files\n";
+    std::clog << "index_gencode             index GENCODE GTF file for annotate_variants\n";
     std::clog << "normalize                 normalize variants\n";
     std::clog << "decompose                 decompose variants\n";
     std::clog << "uniq                      drop duplicate variants\n";
+    std::clog << "pipe                      chain normalize, decompose, uniq etc. in a single process\n";
     std::clog << "cat                       concatenate VCF files\n";
     std::clog << "paste                     paste VCF files\n";
     std::clog << "sort                      sort VCF files\n";
     std::clog << "subset                    subset VCF file to variants polymorphic in a sample\n";
+    std::clog << "scatter                   split the genome into balanced interval lists for parallel runs\n";
+    std::clog << "serve                     run commands from a resident server on a local socket\n";
     std::clog << "\n";
     std::clog << "peek                      summary of variants in the vcf file\n";
     std::clog << "partition                 partition variants\n";
@@ -138,14 +147,27 @@ void help()
     std::clog << "discover                  discover variants\n";
     std::clog << "genotype                  genotype variants\n";
     std::clog << "\n";
+    std::clog << "Global options:\n";
+    std::clog << "--stats-json <file>       write per stage timers and counters as JSON to file, - for stderr\n";
+    std::clog << "--progress <sec>          print the no. of records read and records/sec every sec seconds\n";
+    std::clog << "--vcf-threads <n>         parse and format VCF text and (de)compress BGZF files with n threads\n";
+    std::clog << "\n";
 }
 
-int main(int argc, char ** argv)
+/**
+ * Runs the vt command in argv[1], also used by serve to run submitted jobs.
+ */
+int run(int argc, char ** argv)
 {
     clock_t t0;
     t0 = clock();
     bool print = true;
 
+    //global instrumentation and threading options are removed before the tool parses its options
+    argc = Instrument::parse(argc, argv);
+    argc = VCFTextPool::parse_args(argc, argv);
+    Instrument::start(argc, argv);
+
     if (argc==1)
     {
         help();
@@ -170,6 +192,10 @@ int main(int argc, char ** argv)
     {
         print = index(argc-1, ++argv);
     }
+    else if (argc>1 && cmd=="index_gencode")
+    {
+        index_gencode(argc-1, ++argv);
+    }
     else if (argc>1 && cmd=="merge")
     {
         print = merge(argc-1, ++argv);
@@ -234,6 +260,10 @@ int main(int argc, char ** argv)
     {
         print = rminfo(argc-1, ++argv);
     }
+    else if (argc>1 && cmd=="scatter")
+    {
+        scatter(argc-1, ++argv);
+    }
     else if (argc>1 && cmd=="sort")
     {
         print = sort(argc-1, ++argv);
@@ -246,6 +276,10 @@ int main(int argc, char ** argv)
     {
         uniq(argc-1, ++argv);
     }
+    else if (argc>1 && cmd=="pipe")
+    {
+        pipeline(argc-1, ++argv);
+    }
     else if (argc>1 && cmd=="set_ref")
     {
         set_ref(argc-1, ++argv);
@@ -334,6 +368,10 @@ int main(int argc, char ** argv)
     {
         profile_snps(argc-1, ++argv);
     }
+    else if (argc>1 && cmd=="serve")
+    {
+        serve(argc-1, ++argv, run);
+    }
     else if (argc>1 && cmd=="seq")
     {
         print = seq(argc-1, ++argv);
@@ -432,5 +470,12 @@ int main(int argc, char ** argv)
         print_time((float)(t1-t0)/CLOCKS_PER_SEC);
     }
 
+    Instrument::stop();
+
     return 0;
 }
+
+int main(int argc, char ** argv)
+{
+    return run(argc, argv);
+}
@@ -187,7 +187,7 @@ Each VCF file is required to have the FORMAT flags E and N and should have exact
         std::string samples;
  
         bcf1_t* nv = bcf_init();
-        Variant var;
+        VariantClass var;
         std::vector<bcfptr*> current_recs;
         while(sr->read_next_position(current_recs))
         {
@@ -44,12 +44,15 @@ class Igor : Program
     std::string candidate_sites_vcf_file;
     std::vector<GenomeInterval> intervals;
     std::string interval_list;
+    int32_t no_threads;
 
     ///////
     //i/o//
     ///////
+    ParallelSyncedDriver *driver;
     BCFSyncedReader *sr;
     BCFOrderedWriter *odw;
+    int32_t out;
     bcf1_t *v;
 
     ///////////////
@@ -62,7 +65,7 @@ class Igor : Program
     //filter//
     //////////
     std::string fexp;
-    Filter filter;
+    std::vector<Filter*> worker_filters;
     bool filter_exists;
 
     /////////
@@ -72,11 +75,14 @@ class Igor : Program
     uint32_t no_snps;
     uint32_t no_indels;
     uint32_t no_vntrs;
+    std::vector<uint32_t> worker_no_snps;
+    std::vector<uint32_t> worker_no_indels;
+    std::vector<uint32_t> worker_no_vntrs;
 
     /////////
     //tools//
     /////////
-    VariantManip * vm;
+    std::vector<VariantManip*> vms;
 
     Igor(int argc, char ** argv)
     {
@@ -98,6 +104,7 @@ Extracts only the naive genotypes based on best guess genotypes.";
             TCLAP::ValueArg<std::string> arg_candidate_sites_vcf_file("c", "c", "candidate sites VCF file with annotation []", true, "-", "", cmd);
             TCLAP::ValueArg<std::string> arg_input_vcf_file_list("L", "L", "file containing list of input VCF files", true, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter expression (applied to candidate sites file)[]", false, "", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the inputs are indexed [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledMultiArg<std::string> arg_input_vcf_files("<in1.vcf>...", "Multiple VCF files",false, "files", cmd);
 
             cmd.parse(argc, argv);
@@ -107,6 +114,7 @@ Extracts only the naive genotypes based on best guess genotypes.";
             candidate_sites_vcf_file = arg_candidate_sites_vcf_file.getValue();
             output_vcf_file = arg_output_vcf_file.getValue();
             fexp = arg_fexp.getValue();
+            no_threads = arg_no_threads.getValue();
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
         }
         catch (TCLAP::ArgException &e)
@@ -118,20 +126,25 @@ Extracts only the naive genotypes based on best guess genotypes.";
 
     void initialize()
     {
-        /////////////////////////
-        //filter initialization//
-        /////////////////////////
-        filter.parse(fexp.c_str(), false);
-        filter_exists = fexp=="" ? false : true;
-
         //////////////////////
         //i/o initialization//
         //////////////////////
         fprintf(stderr, "[I:%s:%d %s] Initializing %zd VCF files ...", __FILE__, __LINE__, __FUNCTION__, input_vcf_files.size());
         input_vcf_files.insert(input_vcf_files.begin(), candidate_sites_vcf_file);
-        sr = new BCFSyncedReader(input_vcf_files, intervals, false);
+        driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+        sr = driver->sr;
         fprintf(stderr, " done.\n");
 
+        /////////////////////////
+        //filter initialization//
+        /////////////////////////
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            worker_filters.push_back(new Filter());
+            worker_filters[i]->parse(fexp.c_str(), false);
+        }
+        filter_exists = fexp=="" ? false : true;
+
         odw = new BCFOrderedWriter(output_vcf_file, 0);
         bcf_hdr_append(odw->hdr, "##fileformat=VCFv4.2");
         bcf_hdr_transfer_contigs(sr->hdrs[0], odw->hdr);
@@ -219,6 +232,7 @@ Extracts only the naive genotypes based on best guess genotypes.";
         }
     
         odw->write_hdr();
+        out = driver->add_writer(odw);
 
         ///////////////
         //general use//
@@ -232,15 +246,46 @@ Extracts only the naive genotypes based on best guess genotypes.";
         no_snps = 0;
         no_indels = 0;
         no_vntrs = 0;
+        worker_no_snps.resize(driver->no_workers, 0);
+        worker_no_indels.resize(driver->no_workers, 0);
+        worker_no_vntrs.resize(driver->no_workers, 0);
 
         /////////
         //tools//
         /////////
-        vm = new VariantManip();
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            vms.push_back(new VariantManip());
+        }
     }
 
     void merge_genotypes()
     {
+        driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { merge_genotypes(worker, region, sr); });
+
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            no_snps += worker_no_snps[i];
+            no_indels += worker_no_indels[i];
+            no_vntrs += worker_no_vntrs[i];
+        }
+
+        odw->close();
+        fprintf(stderr, "[I:%s:%d %s] Synced reader closing ...", __FILE__, __LINE__, __FUNCTION__);    
+        sr->close();
+        fprintf(stderr, " closed\n");    
+    };
+
+    /**
+     * Merges the genotypes of a region.
+     */
+    void merge_genotypes(int32_t worker, int32_t region, BCFSyncedReader* sr)
+    {
+        uint32_t& no_snps = worker_no_snps[worker];
+        uint32_t& no_indels = worker_no_indels[worker];
+        uint32_t& no_vntrs = worker_no_vntrs[worker];
+        VariantManip* vm = vms[worker];
+
         int32_t *NSAMPLES = NULL;
         int32_t no_NSAMPLES = 0;
         int32_t *GT = NULL;
@@ -310,7 +355,7 @@ Extracts only the naive genotypes based on best guess genotypes.";
             if (filter_exists)
             {
                 vm->classify_variant(current_recs[0]->h, current_recs[0]->v, var);
-                if (!filter.apply(current_recs[0]->h, current_recs[0]->v, &var, false))
+                if (!worker_filters[worker]->apply(current_recs[0]->h, current_recs[0]->v, &var, false))
                 {
                     continue;
                 }
@@ -626,7 +671,7 @@ Extracts only the naive genotypes based on best guess genotypes.";
                 exit(1);
             }
 
-            odw->write(nv);
+            driver->write(region, out, nv);
 //            bcf_print(odw->hdr, nv);
 
             //this acts as a flag to initialize a newly merged record
@@ -641,11 +686,16 @@ Extracts only the naive genotypes based on best guess genotypes.";
 
         }
 
-        odw->close();
-        fprintf(stderr, "[I:%s:%d %s] Synced reader closing ...", __FILE__, __LINE__, __FUNCTION__);    
-        sr->close();
-        fprintf(stderr, " closed\n");    
-        
+        bcf_destroy(nv);
+        if (NSAMPLES) free(NSAMPLES);
+        if (GT) free(GT);
+        if (PL) free(PL);
+        if (AD) free(AD);
+        if (ADF) free(ADF);
+        if (ADR) free(ADR);
+        if (BQSUM) free(BQSUM);
+        if (DP) free(DP);
+        if (CG) free(CG);
     };
 
     void print_options()
@@ -655,6 +705,7 @@ Extracts only the naive genotypes based on best guess genotypes.";
         std::clog << "         [c] candidate sites VCF file                 " << candidate_sites_vcf_file << "\n";
         std::clog << "         [o] output VCF file                          " << output_vcf_file << "\n";
         print_str_op("         [f] filter (applied to candidate sites file) ", fexp);
+        print_num_op("         [t] no. of threads                           ", no_threads);
         print_int_op("         [i] intervals                                ", intervals);
         std::clog << "\n";
     }
@@ -25,6 +25,7 @@
 #define MERGE_GENOTYPES_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
 #include "log_tool.h"
 
 void merge_genotypes(int argc, char ** argv);
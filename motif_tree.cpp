@@ -29,167 +29,186 @@
 #define T 3
 #define N 4
 
+
+std::map<uint32_t, MotifTables*> MotifTables::tables;
+std::mutex MotifTables::tables_mutex;
+
 /**
- * Constructor.
+ * Tabulates the canonical forms and aperiodicity of all motifs up to max_len.
  */
-MotifTree::MotifTree(uint32_t max_len, bool debug)
+MotifTables::MotifTables(uint32_t max_len)
 {
     this->max_len = max_len;
-    mm = new MotifMap(max_len);
+    no_users = 0;
 
-    this->debug = debug;
-
-    lc.resize(max_len+1,0);
+    MotifMap mm(max_len);
+    cindex.resize(mm.max_index+1, 0);
+    aperiodic.resize(mm.max_index+1, 0);
 
-    tree = (node *) malloc(sizeof(node)*mm->max_index+1);
-
-    //perform mapping.
+    //tabulate the canonical forms and the aperiodicity of all motifs,
+    //a motif is encoded here with its first base in the most significant
+    //bits so that rotating and comparing motifs preserves the index order.
     for (uint32_t len=1; len<=max_len; ++len)
     {
-        for (uint32_t index=mm->len_count[len-1]; index<mm->len_count[len]; ++index)
+        uint32_t offset = mm.len_count[len-1];
+        uint32_t mask = (uint32_t)((1ULL<<(len<<1))-1);
+        uint32_t hi = (len-1)<<1;
+
+        for (uint32_t code=0; code<=mask; ++code)
         {
-            uint32_t seq = mm->index2seq(index);
-            tree[index] = {index, mm->seq2index(mm->canonical(seq, len), len), 0, len, seq};
+            uint32_t c = code;
+            uint32_t r = code;
+            for (uint32_t i=1; i<len; ++i)
+            {
+                r = ((r<<2) | (r>>hi)) & mask;
+                c = r<c ? r : c;
+            }
+            cindex[offset+code] = offset+c;
 
-            uint32_t c = mm->canonical(seq, len);
-            //bool a = mm->is_aperiodic(c, len);
-            //std::cerr << " " << mm->seq2str(c, len) << " " << mm->is_aperiodic(c, len) << "\n";
+            if (c==code)
+            {
+                //a motif is periodic if it is invariant to a rotation by a proper divisor of its length
+                bool is_aperiodic = true;
+                for (uint32_t i=1; i<=(len>>1) && is_aperiodic; ++i)
+                {
+                    if (len%i==0)
+                    {
+                        uint32_t s = i<<1;
+                        r = ((code<<s) | (code>>((len<<1)-s))) & mask;
+                        is_aperiodic = r!=code;
+                    }
+                }
+                aperiodic[offset+code] = is_aperiodic;
+            }
+            else
+            {
+                aperiodic[offset+code] = aperiodic[offset+c];
+            }
         }
     }
 };
 
 /**
- * Destructor.
+ * Returns the shared tables for motifs up to max_len, tabulating them on first use.
  */
-MotifTree::~MotifTree()
+MotifTables* MotifTables::acquire(uint32_t max_len)
 {
-    if (tree) delete tree;
-    if (mm) delete mm;
-};
+    std::lock_guard<std::mutex> lock(tables_mutex);
 
-/**
- * Gets subsequence from a string at the spos0 position of length cmax_len.
- */
-uint32_t MotifTree::get_sub_seq(char* seq, uint32_t len, uint32_t spos0, uint32_t& s)
-{
-    if (spos0==0)
+    MotifTables* mt;
+    std::map<uint32_t, MotifTables*>::iterator i = tables.find(max_len);
+    if (i==tables.end())
     {
-        s = 0;
-        for (uint32_t i=0; i<cmax_len; ++i)
-        {
-            uint32_t j = base2index(seq[i]);
-            s = set_seqi(s, i, j);
-        }
-
-        return cmax_len;
+        mt = new MotifTables(max_len);
+        tables[max_len] = mt;
     }
     else
     {
-        uint32_t slen = 0;
-
-        //shorter than max_len
-        if (len-spos0<cmax_len)
-        {
-            slen = len-spos0;
-            s = shift(s, slen+1);
-            s = set_seqi(s, len-spos0, 0);
-        }
-        else
-        {
-            slen = cmax_len;
-            s = shift(s, cmax_len);
-            //std::cerr << seq[spos0+max_len-1] << " " << spos0+max_len-1 <<" " << base2index(seq[spos0+max_len-1]) << "\n";
-            s = set_seqi(s, cmax_len-1, base2index(seq[spos0+cmax_len-1]));
-        }
-
-        return slen;
+        mt = i->second;
     }
+
+    ++mt->no_users;
+    return mt;
 }
 
 /**
- * Construct suffix tree based on sequence of length len.
+ * Releases tables obtained with acquire, they are freed when no longer used.
  */
-void MotifTree::set_sequence(char* seq, uint32_t len)
+void MotifTables::release(MotifTables* mt)
 {
-    //computes the relevant maximum possible length of motif to check
-    cmax_len = (len >> 1) < max_len ? (len >> 1) : max_len;
+    std::lock_guard<std::mutex> lock(tables_mutex);
 
-    if (debug)
+    if (--mt->no_users==0)
     {
-        std::cerr << "len : " << len << "\n";
-        std::cerr << "cmax_len : " << cmax_len << "\n";
+        tables.erase(mt->max_len);
+        delete mt;
     }
+}
 
-    uint32_t s = 0;
-    for (uint32_t i=0; i<len; ++i)
-    {
-        //update as uint32_t representation
-        uint32_t l = get_sub_seq(seq, len, i, s);
+/**
+ * Constructor.
+ */
+MotifTree::MotifTree(uint32_t max_len, bool debug)
+{
+    this->max_len = max_len;
+    mm = new MotifMap(max_len);
 
-        //mm->print_seq(s,l);
+    this->debug = debug;
 
-        //insert prefix
-        insert_prefix(s, l);
-    }
+    lc.resize(max_len+1,0);
+
+    tables = MotifTables::acquire(max_len);
+    cindex = &tables->cindex[0];
+    aperiodic = &tables->aperiodic[0];
+    count.resize(mm->max_index+1, 0);
 };
 
 /**
- * Inserts prefix s into tree.
+ * Destructor.
  */
-void MotifTree::insert_prefix(uint32_t s, uint32_t len)
+MotifTree::~MotifTree()
 {
-    for (uint32_t i=1; i<=len; ++i)
-    {
-        uint32_t index = mm->seq2index(s, i);
-        ++tree[index].count;
-    }
-}
+    if (mm) delete mm;
+    MotifTables::release(tables);
+};
 
 /**
- * Consolidate motif counts.
+ * Clears the motif counts.
  */
-void MotifTree::consolidate_motif_counts()
+void MotifTree::clear()
 {
-    cm.clear();
+    for (uint32_t i=0; i<cmotifs.size(); ++i)
+    {
+        count[cmotifs[i]] = 0;
+    }
+    cmotifs.clear();
     std::fill(lc.begin(), lc.end(), 0);
     while (!pcm.empty()) pcm.pop();
-    consolidate_motif_counts(&tree[0]);
-    consolidate_motif_counts(&tree[1]);
-    consolidate_motif_counts(&tree[2]);
-    consolidate_motif_counts(&tree[3]);
 }
 
 /**
- * Consolidate motif counts.
+ * Counts the canonical motifs of seq of length len up to cmax_len.
+ *
+ * The last cmax_len bases are kept in s with the most recent base in
+ * the least significant bits so that the k-mer ending at each position
+ * is obtained by masking s.
  */
-void MotifTree::consolidate_motif_counts(node* n)
+void MotifTree::set_sequence(char* seq, uint32_t len)
 {
-    if (n->count)
-    {
-        if (cm.find(n->cindex)==cm.end())
-        {
-            cm[n->cindex] = n->count;
-        }
-        else
-        {
-            cm[n->cindex] += n->count;
-        }
+    //computes the relevant maximum possible length of motif to check
+    cmax_len = (len >> 1) < max_len ? (len >> 1) : max_len;
+    //a single base is its own motif
+    if (len==1) cmax_len = 1;
 
-        lc[n->len] += n->count;
+    if (debug)
+    {
+        std::cerr << "len : " << len << "\n";
+        std::cerr << "cmax_len : " << cmax_len << "\n";
+    }
 
-        n->count = 0;
+    uint32_t s = 0;
+    for (uint32_t i=0; i<len; ++i)
+    {
+        s = (s<<2) | base2index(seq[i]);
 
-        if (n->len != cmax_len)
+        uint32_t l = i<cmax_len ? i+1 : cmax_len;
+        for (uint32_t j=1; j<=l; ++j)
         {
-            uint32_t index = get_first_child(n->seq, n->len);
-
-            consolidate_motif_counts(&tree[index]);
-            consolidate_motif_counts(&tree[index+1]);
-            consolidate_motif_counts(&tree[index+2]);
-            consolidate_motif_counts(&tree[index+3]);
+            uint32_t c = cindex[mm->len_count[j-1] + (s & (uint32_t)((1ULL<<(j<<1))-1))];
+            if (!count[c]++)
+            {
+                cmotifs.push_back(c);
+            }
         }
     }
-}
+
+    for (uint32_t j=1; j<=cmax_len; ++j)
+    {
+        lc[j] = len-j+1;
+    }
+
+    std::sort(cmotifs.begin(), cmotifs.end());
+};
 
 /**
  * Shifts a string.
@@ -210,57 +229,55 @@ std::string MotifTree::shift_str(std::string& seq, uint32_t i)
  */
 bool MotifTree::exist_two_copies(std::string& seq, std::string& motif)
 {
+    uint32_t n = seq.size();
+    uint32_t m = motif.size();
+
     //all phases of motif
-    for (uint32_t i=0; i<motif.size(); ++i)
+    for (uint32_t i=0; i<m; ++i)
     {
-        std::string ru = shift_str(motif, i);
-        const char* s = seq.c_str();
-
-        if ((s = strstr(s, ru.c_str())))
+        uint32_t copies = 0;
+        for (uint32_t j=0; j+m<=n;)
         {
-            s += ru.size();
-            
-            if ((s = strstr(s, ru.c_str())))
+            uint32_t k = 0;
+            while (k<m && seq[j+k]==motif[(i+k)%m]) ++k;
+
+            if (k==m)
+            {
+                if (++copies==2) return true;
+                j += m;
+            }
+            else
             {
-                return true;
+                ++j;
             }
         }
     }
-    
+
     return false;
 }
 
 /**
  * Compute fit of expected content of nucleotides.
  */
-float MotifTree::compute_fit(uint32_t index, scontent* sc)
+float MotifTree::compute_fit(uint32_t seq, uint32_t len, scontent* sc)
 {
     uint32_t e[] = {0,0,0,0};
-    node* n = &tree[index];
-    
-//    std::cerr << "compute fit: " << mm->seq2str(n->seq, n->len) << "\n";
-    
+
     //compute expected fit
-    for (uint32_t i=0; i<n->len; ++i)
+    for (uint32_t i=0; i<len; ++i)
     {
-        ++e[get_seqi(n->seq, i)];
+        ++e[get_seqi(seq, i)];
     }
-    
-//    std::cerr << e[0] << " " << e[1] << " " << e[2] << " " << e[3] << "\n";
-    
+
     float fit = 0;
     float t = 0;
-    
-//    std::cerr << "n " << sc->n << " (" << sc->base[A] << "," << sc->base[C] << "," << sc->base[G] << "," << sc->base[T] << ")\n";
-    
+
     for (uint32_t i=0; i<4; ++i)
     {
-        t = (float)sc->base[i]/sc->n - (float)e[i]/n->len;
+        t = (float)sc->base[i]/sc->n - (float)e[i]/len;
         fit += t*t;
     }
-    
-//    std::cerr << "compute fit " << fit << "\n";
-    
+
     return fit;
 }
 
@@ -298,84 +315,70 @@ void MotifTree::detect_candidate_motifs(char* seq, uint32_t len)
         }
     }
 
-    //construct tree
+    //count motifs
+    clear();
     set_sequence(const_cast<char*>(s.c_str()), s.size());
 
-//    print_tree();
-
     //gather distribution
     scontent sc;
-    sc.base[A] = tree[A].count;
-    sc.base[C] = tree[C].count;
-    sc.base[G] = tree[G].count;
-    sc.base[T] = tree[T].count;
+    for (uint32_t i=0; i<4; ++i)
+    {
+        sc.base[i] = cmax_len ? count[i] : 0;
+    }
     sc.n = sc.base[A] + sc.base[C] + sc.base[G] + sc.base[T];
-    
-    //count occurrences
-    consolidate_motif_counts();
 
     if (debug)
-        std::cerr << "candidate motifs: " << cm.size() << "\n";
-
-    float sthreshold = std::min(0.80, (s.size()-1.0)/s.size());
+        std::cerr << "candidate motifs: " << cmotifs.size() << "\n";
 
-    for (std::map<uint32_t, uint32_t>::iterator i = cm.begin(); i!=cm.end(); ++i)
+    uint32_t mlen = 1;
+    for (uint32_t i=0; i<cmotifs.size(); ++i)
     {
-        if (mm->is_aperiodic(mm->index2seq(i->first), tree[i->first].len))
+        uint32_t index = cmotifs[i];
+        while (index>=mm->len_count[mlen]) ++mlen;
+
+        if (aperiodic[index])
         {
+            uint32_t mseq = mm->index2seq(index);
             //p - purity proportion
-            float p = (float)i->second/(lc[tree[i->first].len]);
+            float p = (float)count[index]/(lc[mlen]);
             //f - fit based on content
-            float f = compute_fit(i->first, &sc);
-            //p -= f;
-             
-            //if ((tree[i->first].len==1 && p+f>sthreshold) || (tree[i->first].len>1 && p>0.2))
-            if (len<10 || (tree[i->first].len==1 && p>0.6) || (tree[i->first].len>1))
+            float f = compute_fit(mseq, mlen, &sc);
+
+            if (len<10 || (mlen==1 && p>0.6) || (mlen>1))
             {
-                std::string motif = mm->seq2str(mm->index2seq(i->first), tree[i->first].len);
-                if (exist_two_copies(s, motif))
+                std::string motif = mm->seq2str(mseq, mlen);
+                if (debug)
                 {
-                    if (debug) std::cerr << motif << " : " << p << " " << tree[i->first].len << " " << f << "\n";
-                    pcm.push(CandidateMotif(motif, p, tree[i->first].len, f));
-                }
-                else
-                {
-                    if (debug) std::cerr << motif << " : " << p << " " << tree[i->first].len << " " << f << " (< 2 copies)\n";
-                    pcm.push(CandidateMotif(motif, p, tree[i->first].len, f));
+                    if (exist_two_copies(s, motif))
+                        std::cerr << motif << " : " << p << " " << mlen << " " << f << "\n";
+                    else
+                        std::cerr << motif << " : " << p << " " << mlen << " " << f << " (< 2 copies)\n";
                 }
+                pcm.push(CandidateMotif(motif, p, mlen, f));
             }
         }
     }
 
     //if no pickups
-    if (pcm.size()==0)
+    if (pcm.size()==0 && cmotifs.size())
     {
-        std::map<uint32_t, uint32_t>::iterator i = cm.begin();
-        
-        float p = (float)i->second/(lc[tree[i->first].len]);
-        float f = compute_fit(i->first, &sc);
-        p -= f;
-        if (debug) std::cerr << mm->seq2str(mm->index2seq(i->first), tree[i->first].len) << " : " << p << " " << tree[i->first].len << " " << f << "\n";
-        pcm.push(CandidateMotif(mm->seq2str(mm->index2seq(i->first), tree[i->first].len), p, tree[i->first].len, f));
-            
-    }    
+        uint32_t index = cmotifs[0];
+        mlen = 1;
+        while (index>=mm->len_count[mlen]) ++mlen;
 
-//    print_tree();
+        uint32_t mseq = mm->index2seq(index);
+        float p = (float)count[index]/(lc[mlen]);
+        float f = compute_fit(mseq, mlen, &sc);
+        p -= f;
+        if (debug) std::cerr << mm->seq2str(mseq, mlen) << " : " << p << " " << mlen << " " << f << "\n";
+        pcm.push(CandidateMotif(mm->seq2str(mseq, mlen), p, mlen, f));
+    }
 };
 
-/**
- * Gets index of first child.
- */
-uint32_t MotifTree::get_first_child(uint32_t seq, uint32_t len)
-{
-    //not necessary sequence should be zeroed out after valid length.
-    //uint32_t cseq = set_seq(s, len, 0);
-    uint32_t index = mm->seq2index(seq, len+1);
-    return index;
-}
-
 /**
  * Converts base to index.
+ *
+ * Bases other than ACGT are counted as A.
  */
 int32_t MotifTree::base2index(char base)
 {
@@ -394,53 +397,10 @@ int32_t MotifTree::base2index(char base)
             return T;
             break;
         default:
-            return N;
+            return A;
     }
 };
 
-/**
- * Print node.
- */
-void MotifTree::print_node(node* n)
-{
-    std::cerr << std::string(n->len, '\t') << "seq: " << mm->seq2str(n->seq, n->len) << "\n";
-    std::cerr << std::string(n->len, '\t') << "cnt: " << n->count << "\n";
-    std::cerr << std::string(n->len, '\t') << "len: " << n->len << "\n";
-    std::cerr << std::string(n->len, '\t') << "can: " << mm->seq2str(mm->canonical(n->seq, n->len), n->len) << "\n";
-    std::cerr << "\n";
-}
-
-/**
- * Print tree.
- */
-void MotifTree::print_tree()
-{
-    print_tree(&tree[0]);
-    print_tree(&tree[1]);
-    print_tree(&tree[2]);
-    print_tree(&tree[3]);
-}
-
-/**
- * Print tree.
- */
-void MotifTree::print_tree(node* n)
-{
-    if (n->count)
-    {
-        print_node(n);
-
-        if (n->len != max_len)
-        {
-            uint32_t index = get_first_child(n->seq, n->len);
-
-            print_tree(&tree[index]);
-            print_tree(&tree[index+1]);
-            print_tree(&tree[index+2]);
-            print_tree(&tree[index+3]);
-        }
-    }
-}
 
 #undef A
 #undef C
@@ -24,6 +24,8 @@
 #ifndef MOTIF_TREE_H
 #define MOTIF_TREE_H
 
+#include <algorithm>
+#include <mutex>
 #include "utils.h"
 #include "motif_map.h"
 
@@ -45,19 +47,6 @@ typedef struct
     uint32_t n; //total number of bases
 } scontent;
 
-/**
- * struct for encoding a node.
- */
-typedef struct
-{
-    uint32_t index; //index
-    uint32_t cindex; //index of the cannonical form
-    uint32_t count;  //count of occurence of this motif
-    uint32_t len;    //length of the motif
-    uint32_t seq;    //sequence encoded in 2 bits per base, this allows for a maximum length of 16 bases
-
-} node;
-
 #define index2base(i) ("ACGT"[(i)])
 
 /**
@@ -100,21 +89,59 @@ class CompareCandidateMotif
 };
 
 /**
- * Motif Suffix Tree for selecting candidate motifs.
+ * Canonical forms and aperiodicity of all motifs up to a maximum length.
  *
- * Each node is represented by int64_t
+ * The tables are read only and are shared by all motif trees of the same
+ * maximum length through acquire and release.
+ */
+class MotifTables
+{
+    public:
+    uint32_t max_len;
+    std::vector<uint32_t> cindex;   // index of the canonical form of each motif
+    std::vector<uint8_t> aperiodic; // aperiodicity of each motif
+
+    /**
+     * Returns the shared tables for motifs up to max_len, tabulating them on first use.
+     */
+    static MotifTables* acquire(uint32_t max_len);
+
+    /**
+     * Releases tables obtained with acquire, they are freed when no longer used.
+     */
+    static void release(MotifTables* mt);
+
+    private:
+    int32_t no_users;
+
+    static std::map<uint32_t, MotifTables*> tables;
+    static std::mutex tables_mutex;
+
+    /**
+     * Tabulates the canonical forms and aperiodicity of all motifs up to max_len.
+     */
+    MotifTables(uint32_t max_len);
+};
+
+/**
+ * Motif counter for selecting candidate motifs.
  *
- * the first 20 bits indexes to the cannonical form
- * the next 12 bits gives the count
- * the last 32 bits provides the sequence represented by 2 bits per base
+ * All k-mers up to the candidate maximum length are counted in a single
+ * rolling pass over the sequence with 2 bits per base and accumulated
+ * directly into flat counts indexed by the MotifMap index of their
+ * canonical form.  The canonical forms and the aperiodicity of every
+ * motif are looked up in the shared MotifTables.
  */
 class MotifTree
 {
     public:
-    node* tree;
     MotifMap *mm;
     uint32_t max_len;
-    std::map<uint32_t, uint32_t> cm;
+    MotifTables* tables;
+    const uint32_t* cindex;         // index of the canonical form of each motif
+    const uint8_t* aperiodic;       // aperiodicity of each motif
+    std::vector<uint32_t> count;    // counts of each canonical motif
+    std::vector<uint32_t> cmotifs;  // canonical motifs with non zero counts
     std::vector<uint32_t> lc;   // for counting the number of motifs of length x.
     std::priority_queue<CandidateMotif, std::vector<CandidateMotif>, CompareCandidateMotif > pcm;
     uint32_t cmax_len; //candidate maximum length
@@ -131,34 +158,14 @@ class MotifTree
     ~MotifTree();
 
     /**
-     * Clear the suffix tree.
+     * Counts the canonical motifs of seq of length len up to cmax_len.
      */
-    void clear();
-
-    /**
-     * Gets subsequence from a C string.
-     */
-    uint32_t get_sub_seq(char* seq, uint32_t len, uint32_t spos0, uint32_t& s);
-
-    /**
-     * Inserts prefix s into tree.
-     */
-    void insert_prefix(uint32_t s, uint32_t len);
-
-    /**
-     * Consolidate motif counts.
-     */
-    void consolidate_motif_counts();
-
-    /**
-     * Consolidate motif counts.
-     */
-    void consolidate_motif_counts(node* n);
+    void set_sequence(char* seq, uint32_t len);
 
     /**
-     * Construct suffix tree based on sequence up to max_motif_len.
+     * Clears the motif counts.
      */
-    void set_sequence(char* seq, uint32_t len);
+    void clear();
 
     /**
      * Shifts a string.
@@ -173,7 +180,7 @@ class MotifTree
     /**
      * Compute fit of expected content of nucleotides.
      */
-    float compute_fit(uint32_t index, scontent* sc);
+    float compute_fit(uint32_t seq, uint32_t len, scontent* sc);
 
     /**
      * Detects candidate motifs from seq of length len.
@@ -185,34 +192,12 @@ class MotifTree
      */
     void detect_candidate_motifs(char* seq, uint32_t len);
 
-    /**
-     * Gets index of first child.
-     */
-    uint32_t get_first_child(uint32_t seq, uint32_t len);
-
-
     private:
 
     /**
      * Converts base to index.
      */
     int32_t base2index(char base);
-
-    /**
-     * Print node.
-     */
-    void print_node(node* n);
-
-    /**
-     * Print tree.
-     */
-    void print_tree();
-
-    /**
-     * Print tree.
-     */
-    void print_tree(node* n);
-
 };
 
 #undef A
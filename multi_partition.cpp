@@ -67,6 +67,21 @@ class OverlapStats
         ins.resize((1 << no_datasets), 0);
         del.resize((1 << no_datasets), 0);
     };
+
+    /**
+     * Adds the counts of another set of stats.
+     */
+    void add(OverlapStats& stats)
+    {
+        for (uint32_t i=0; i<no.size(); ++i)
+        {
+            no[i] += stats.no[i];
+            ts[i] += stats.ts[i];
+            tv[i] += stats.tv[i];
+            ins[i] += stats.ins[i];
+            del[i] += stats.del[i];
+        }
+    };
 };
 
 class Igor : Program
@@ -82,28 +97,31 @@ class Igor : Program
     std::vector<std::string> input_vcf_files;
     std::vector<GenomeInterval> intervals;
     std::string interval_list;
+    int32_t no_threads;
 
     ///////
     //i/o//
     ///////
+    ParallelSyncedDriver *driver;
     BCFSyncedReader *sr;
 
     //////////
     //filter//
     //////////
     std::string fexp;
-    Filter filter;
+    std::vector<Filter*> worker_filters;
     bool filter_exists;
 
     /////////
     //stats//
     /////////
     OverlapStats stats;
+    std::vector<OverlapStats> worker_stats;
 
     ////////////////
     //common tools//
     ////////////////
-    VariantManip *vm;
+    std::vector<VariantManip*> vms;
 
     Igor(int argc, char ** argv)
     {
@@ -120,6 +138,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_intervals("i", "i", "intervals []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_interval_list("I", "I", "file containing list of intervals []", false, "", "file", cmd);
             TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter", false, "", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the inputs are indexed [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledMultiArg<std::string> arg_input_vcf_files("<in1.vcf><in2.vcf>...", "multiple input VCF files for comparison", true, "files", cmd);
 
             cmd.parse(argc, argv);
@@ -127,6 +146,7 @@ class Igor : Program
             fexp = arg_fexp.getValue();
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
             input_vcf_files = arg_input_vcf_files.getValue();
+            no_threads = arg_no_threads.getValue();
 
             if (input_vcf_files.size()<2)
             {
@@ -146,27 +166,51 @@ class Igor : Program
         //////////////////////
         //i/o initialization//
         //////////////////////
-        sr = new BCFSyncedReader(input_vcf_files, intervals, SYNC_BY_VAR);
+        driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+        sr = driver->sr;
 
         ///////////////////////
         //tool initialization//
         ///////////////////////
-        vm = new VariantManip("");
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            vms.push_back(new VariantManip(""));
+        }
 
         /////////////////////////
         //filter initialization//
         /////////////////////////
-        filter.parse(fexp.c_str());
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            worker_filters.push_back(new Filter());
+            worker_filters[i]->parse(fexp.c_str());
+        }
         filter_exists = fexp=="" ? false : true;
 
         ////////////////////////
         //stats initialization//
         ////////////////////////
         stats.resize(input_vcf_files.size());
+        worker_stats.resize(driver->no_workers, OverlapStats(input_vcf_files.size()));
     }
 
     void partition()
     {
+        driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { partition(worker, region, sr); });
+
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            stats.add(worker_stats[i]);
+        }
+    };
+
+    /**
+     * Partitions the variants of a region.
+     */
+    void partition(int32_t worker, int32_t region, BCFSyncedReader* sr)
+    {
+        OverlapStats& stats = worker_stats[worker];
+
         //for combining the alleles
         std::vector<bcfptr*> crecs;
         Variant variant;
@@ -175,12 +219,12 @@ class Igor : Program
 
         while(sr->read_next_position(crecs))
         {
-            int32_t vtype = vm->classify_variant(crecs[0]->h, crecs[0]->v, variant);
+            int32_t vtype = vms[worker]->classify_variant(crecs[0]->h, crecs[0]->v, variant);
 
             uint32_t presence = 0;
             for (uint32_t i=0; i<crecs.size(); ++i)
             {
-                if (filter_exists && !filter.apply(crecs[i]->h,crecs[i]->v,&variant))
+                if (filter_exists && !worker_filters[worker]->apply(crecs[i]->h,crecs[i]->v,&variant))
                 {
                     continue;
                 }
@@ -222,6 +266,7 @@ class Igor : Program
             ++c;
         }
         print_str_op("         [f] filter             ", fexp);
+        print_num_op("         [t] no. of threads     ", no_threads);
         print_int_op("         [i] intervals          ", intervals);
         std::clog << "\n";
    }
@@ -25,6 +25,7 @@
 #define MULTI_PARTITION_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
 
 void multi_partition(int argc, char ** argv);
 
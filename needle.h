@@ -24,6 +24,7 @@
 #define NEEDLE_H
 
 #include "utils.h"
+#include "align_workspace.h"
 
 class NWParameters
 {
@@ -52,7 +53,12 @@ class NeedlemanWunsch
     int len_read;
 
     std::vector<int> scores;
-    std::vector<Traceback> matrix;
+
+    //traceback matrix of len_ref+1 rows of stride cells from the alignment workspace
+    Traceback* matrix;
+    size_t matrix_size;
+    size_t stride;
+
     std::vector<Traceback> trace;
 
     NWParameters params;
@@ -62,6 +68,11 @@ class NeedlemanWunsch
      */
     NeedlemanWunsch(bool debug=false);
 
+    /**
+     * Destructor.
+     */
+    ~NeedlemanWunsch();
+
     void set_read(const char * read) 
     {
         this->read = read;
@@ -136,6 +136,7 @@ class Igor : Program
         //i/o initialization//
         //////////////////////
         odr = new BCFOrderedReader(input_vcf_file, intervals);
+        odr->set_required_fields(BCF_UN_INFO);
         odw = new BCFOrderedWriter(output_vcf_file, window_size);
         odw->link_hdr(odr->hdr);
         bcf_hdr_append(odw->hdr, "##INFO=<ID=OLD_VARIANT,Number=.,Type=String,Description=\"Original chr:pos:ref:alt encoding\">\n");
@@ -187,8 +188,6 @@ class Igor : Program
 
         while (odr->read(v))
         {
-            bcf_unpack(v, BCF_UN_INFO);
-
             if (debug) bcf_print_liten(odr->hdr, v);
 
             int32_t type = vm->classify_variant(odw->hdr, v, variant);
@@ -0,0 +1,114 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "npy_writer.h"
+
+#define NPY_HEADER_SIZE 128
+
+/**
+ * Creates the file, width is the no. of values in a row or 0 for a
+ * 1 dimensional array.
+ */
+NPYWriter::NPYWriter(std::string file_name, std::string descr, int32_t width)
+{
+    this->file_name = file_name;
+    this->descr = descr;
+    this->width = width;
+    size = atoi(descr.c_str()+2);
+    no_rows = 0;
+
+    file = fopen(file_name.c_str(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+        exit(1);
+    }
+
+    write_header();
+}
+
+/**
+ * Closes the file if it is still open.
+ */
+NPYWriter::~NPYWriter()
+{
+    close();
+}
+
+/**
+ * Appends no_rows rows.
+ */
+void NPYWriter::write(const void* values, size_t no_rows)
+{
+    size_t n = no_rows*std::max(width, 1);
+    if (n && fwrite(values, size, n, file)!=n)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot write to %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+        exit(1);
+    }
+    this->no_rows += no_rows;
+}
+
+/**
+ * Writes the final header and closes the file.
+ */
+void NPYWriter::close()
+{
+    if (!file) return;
+
+    rewind(file);
+    write_header();
+    fclose(file);
+    file = NULL;
+}
+
+/**
+ * Writes the header for the current no. of rows at the start of the file.
+ */
+void NPYWriter::write_header()
+{
+    //magic string, version 1.0 and the length of the dictionary that pads the header to NPY_HEADER_SIZE bytes
+    char header[NPY_HEADER_SIZE];
+    memcpy(header, "\x93NUMPY\x01\x00", 8);
+    header[8] = (NPY_HEADER_SIZE-10)&0xFF;
+    header[9] = (NPY_HEADER_SIZE-10)>>8;
+
+    char shape[64];
+    if (width)
+    {
+        snprintf(shape, 64, "(%zu, %d)", no_rows, width);
+    }
+    else
+    {
+        snprintf(shape, 64, "(%zu,)", no_rows);
+    }
+
+    int32_t n = snprintf(header+10, NPY_HEADER_SIZE-10, "{'descr': '%s', 'fortran_order': False, 'shape': %s, }", descr.c_str(), shape);
+    memset(header+10+n, ' ', NPY_HEADER_SIZE-10-n);
+    header[NPY_HEADER_SIZE-1] = '\n';
+
+    if (fwrite(header, 1, NPY_HEADER_SIZE, file)!=NPY_HEADER_SIZE)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot write to %s\n", __FILE__, __LINE__, __FUNCTION__, file_name.c_str());
+        exit(1);
+    }
+}
@@ -0,0 +1,87 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#ifndef NPY_WRITER_H
+#define NPY_WRITER_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "hts_utils.h"
+
+/**
+ * Writes a NumPy .npy array file row by row.
+ *
+ * The file has a fixed size header that is rewritten with the number of
+ * rows on close, so the rows can be streamed and the file is loaded with
+ * numpy.load(file, mmap_mode='r') without parsing.  Values are written in
+ * the byte order of the host, which is expected to be little endian.
+ *
+ *  NPYWriter w(file, "<i4", 1);
+ *  w.write(values, no_rows);
+ *  w.close();
+ */
+class NPYWriter
+{
+    public:
+
+    std::string file_name;
+    //NumPy type string, eg. <i4, <f4, |u1
+    std::string descr;
+    //no. of values per row, 0 for a 1 dimensional array
+    int32_t width;
+    //size of a value in bytes
+    int32_t size;
+    size_t no_rows;
+
+    /**
+     * Creates the file, width is the no. of values in a row or 0 for a
+     * 1 dimensional array.
+     */
+    NPYWriter(std::string file_name, std::string descr, int32_t width=0);
+
+    /**
+     * Closes the file if it is still open.
+     */
+    ~NPYWriter();
+
+    /**
+     * Appends no_rows rows.
+     */
+    void write(const void* values, size_t no_rows);
+
+    /**
+     * Writes the final header and closes the file.
+     */
+    void close();
+
+    private:
+
+    FILE* file;
+
+    /**
+     * Writes the header for the current no. of rows at the start of the file.
+     */
+    void write_header();
+};
+
+#endif
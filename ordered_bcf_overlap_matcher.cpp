@@ -39,6 +39,7 @@ OrderedBCFOverlapMatcher::OrderedBCFOverlapMatcher(std::string& file, std::vecto
     
     no_regions = 0;
     current_interval.seq = "";
+    current_rid = -1;
     no_exact_overlaps = 0;
     no_fuzzy_overlaps = 0;
     no_nonoverlaps = 0;
@@ -64,6 +65,7 @@ OrderedBCFOverlapMatcher::OrderedBCFOverlapMatcher(std::string& file, std::vecto
 
     no_regions = 0;
     current_interval.seq = "";
+    current_rid = -1;
     no_exact_overlaps = 0;
     no_fuzzy_overlaps = 0;
     no_nonoverlaps = 0;
@@ -83,10 +85,25 @@ OrderedBCFOverlapMatcher::~OrderedBCFOverlapMatcher()
  * Returns true if chrom:start1-end1 overlaps with a region in the file.
  */
 bool OrderedBCFOverlapMatcher::overlaps_with(std::string& chrom, int32_t start1, int32_t end1)
+{
+    return overlaps_with(odr->hdr, bcf_hdr_name2id(odr->hdr, chrom.c_str()), start1, end1);
+}
+
+/**
+ * Returns true if contig rid of h:start1-end1 overlaps with a region in the file.
+ */
+bool OrderedBCFOverlapMatcher::overlaps_with(bcf_hdr_t* h, int32_t rid, int32_t start1, int32_t end1)
 {
     bool overlaps = false;
 
-    if (current_interval.seq!=chrom)
+    std::vector<int32_t>& crids = get_crids(h);
+    int32_t crid = (rid>=0 && rid<(int32_t)crids.size()) ? crids[rid] : -1;
+    if (crid<0)
+    {
+        return false;
+    }
+
+    if (current_rid!=crid)
     {
         std::list<bcf1_t*>::iterator i = buffer.begin();
         while (i!=buffer.end())
@@ -95,7 +112,8 @@ bool OrderedBCFOverlapMatcher::overlaps_with(std::string& chrom, int32_t start1,
             i = buffer.erase(i);
         }
 
-        current_interval.set(chrom);
+        current_rid = crid;
+        current_interval.set(bcf_hdr_id2name(odr->hdr, crid));
         if (!odr->jump_to_interval(current_interval))
         {
             fprintf(stderr, "[%s:%d %s] cannot jump to %s\n", __FILE__, __LINE__, __FUNCTION__, current_interval.to_string().c_str());
@@ -171,6 +189,39 @@ bool OrderedBCFOverlapMatcher::overlaps_with(std::string& chrom, int32_t start1,
     return overlaps;
 };
 
+/**
+ * Gets the contigs of the file of the contigs of h.
+ */
+std::vector<int32_t>& OrderedBCFOverlapMatcher::get_crids(bcf_hdr_t* h)
+{
+    for (size_t i=0; i<hdrs.size(); ++i)
+    {
+        if (hdrs[i]==h && (int32_t)rid2crid[i].size()==h->n[BCF_DT_CTG])
+        {
+            return rid2crid[i];
+        }
+    }
+
+    std::vector<int32_t> crids(h->n[BCF_DT_CTG], -1);
+    for (int32_t i=0; i<h->n[BCF_DT_CTG]; ++i)
+    {
+        crids[i] = bcf_hdr_name2id(odr->hdr, bcf_hdr_id2name(h, i));
+    }
+
+    for (size_t i=0; i<hdrs.size(); ++i)
+    {
+        if (hdrs[i]==h)
+        {
+            rid2crid[i].swap(crids);
+            return rid2crid[i];
+        }
+    }
+
+    hdrs.push_back(h);
+    rid2crid.push_back(crids);
+    return rid2crid.back();
+};
+
 /**
  * Returns true if chrom:start1-end1 overlaps with a region in the file and populates the overlapping variants.
  * This ensures that all records in the reference VCF is processed to compute accurate overlap statistics.
@@ -46,6 +46,7 @@ class OrderedBCFOverlapMatcher
     bcf1_t *v;
     
     GenomeInterval current_interval;
+    int32_t current_rid;
     std::list<bcf1_t*> buffer;
     bool end_of_file;
     int32_t no_regions;
@@ -58,6 +59,10 @@ class OrderedBCFOverlapMatcher
     bool filter_exists;
 
     Variant variant;
+
+    //contig of the file of each contig of a query header
+    std::vector<bcf_hdr_t*> hdrs;
+    std::vector<std::vector<int32_t> > rid2crid;
     
 	///////
     //stats
@@ -86,6 +91,11 @@ class OrderedBCFOverlapMatcher
      * Returns true if chrom:start1-end1 overlaps with a region in the file.
      */
     bool overlaps_with(std::string& chrom, int32_t start1, int32_t end1);
+
+    /**
+     * Returns true if contig rid of h:start1-end1 overlaps with a region in the file.
+     */
+    bool overlaps_with(bcf_hdr_t* h, int32_t rid, int32_t start1, int32_t end1);
         
     /**
      * Returns true if chrom:start1-end1 overlaps with a region in the file and populates the overlapping variants.
@@ -158,6 +168,11 @@ class OrderedBCFOverlapMatcher
     bool is_exact_match(int32_t rid, int32_t beg1, int32_t end1, bcf1_t* v);
     
     private:
+
+    /**
+     * Gets the contigs of the file of the contigs of h.
+     */
+    std::vector<int32_t>& get_crids(bcf_hdr_t* h);
 };
     
 #endif
@@ -28,81 +28,185 @@
  */
 OrderedRegionOverlapMatcher::OrderedRegionOverlapMatcher(std::string& file)
 {
-    todr = new TBXOrderedReader(file, true);
+    track = BEDTrack::lookup(file);
+    todr = track ? NULL : new TBXOrderedReader(file, true);
     s = {0,0,0};
     no_regions = 0;
-    current_interval.seq = "";
+    tid = -1;
+    lo = 0;
+    next_tid = -1;
+    chrom_tid = -1;
 };
 
 /**
  * Destructor.
  */
-OrderedRegionOverlapMatcher::~OrderedRegionOverlapMatcher() {};
+OrderedRegionOverlapMatcher::~OrderedRegionOverlapMatcher()
+{
+    if (prefetch.valid()) prefetch.wait();
+    if (track) BEDTrack::release(track);
+};
+
+/**
+ * Returns true if contig rid of h:beg1-end1 overlaps with a region in the file.
+ */
+bool OrderedRegionOverlapMatcher::overlaps_with(bcf_hdr_t* h, int32_t rid, int32_t beg1, int32_t end1)
+{
+    std::vector<int32_t>& tids = get_tids(h);
+    if (rid<0 || rid>=(int32_t)tids.size())
+    {
+        return overlaps_with(-1, -1, beg1, end1);
+    }
+
+    //the next contig of the header that is in the track
+    int32_t next = -1;
+    if (tids[rid]!=tid)
+    {
+        for (int32_t i=rid+1; i<(int32_t)tids.size() && next<0; ++i)
+        {
+            next = tids[i];
+        }
+    }
+
+    return overlaps_with(tids[rid], next, beg1, end1);
+};
 
 /**
  * Returns true if chrom:beg1-end1 overlaps with a region in the file.
  */
 bool OrderedRegionOverlapMatcher::overlaps_with(std::string& chrom, int32_t beg1, int32_t end1)
 {
-    bool overlaps = false;
+    if (this->chrom!=chrom)
+    {
+        this->chrom = chrom;
+        chrom_tid = get_tid(chrom.c_str());
+    }
+
+    return overlaps_with(chrom_tid, chrom_tid<0 ? -1 : chrom_tid+1, beg1, end1);
+};
+
+/**
+ * Returns true if contig tid of the track:beg1-end1 overlaps with a region in the file.
+ * The regions of contig next_tid are read ahead.
+ */
+bool OrderedRegionOverlapMatcher::overlaps_with(int32_t tid, int32_t next_tid, int32_t beg1, int32_t end1)
+{
     overlapping_regions.clear();
 
     //moves to new chromosome
-    if (current_interval.seq!=chrom)
+    if (this->tid!=tid)
     {
-        buffer.clear();
-        current_interval.set(chrom);
-        todr->jump_to_interval(current_interval);
-        while (todr->read(&s))
+        if (prefetch.valid()) prefetch.get();
+        if (tid>=0 && tid==this->next_tid)
+        {
+            regions.swap(next_regions);
+        }
+        else
+        {
+            read_regions(tid, &regions);
+        }
+
+        max_end1.resize(regions.size());
+        for (size_t i=0; i<regions.size(); ++i)
+        {
+            max_end1[i] = i ? std::max(max_end1[i-1], regions[i].end1) : regions[i].end1;
+        }
+        no_regions += regions.size();
+        this->tid = tid;
+        lo = 0;
+
+        //the reader is only used by one read at a time
+        this->next_tid = next_tid;
+        if (next_tid>=0 && next_tid!=tid)
         {
-            BEDRecord br(&s);
-            if (br.end1<beg1) continue;
-            overlaps = overlaps || (br.beg1<=end1);
-            if (br.beg1<=end1)
-            {
-                Interval region(br.beg1, br.end1);
-                overlapping_regions.push_back(region);
-            }
-            buffer.push_back(br);
-            if (br.beg1>end1) break;
+            prefetch = std::async(std::launch::async, &OrderedRegionOverlapMatcher::read_regions, this, next_tid, &next_regions);
         }
     }
-    else
+
+    //queries are ordered so regions ending before beg1 are passed for good
+    while (lo<regions.size() && max_end1[lo]<beg1) ++lo;
+
+    bool overlaps = false;
+    for (size_t i=lo; i<regions.size() && regions[i].beg1<=end1; ++i)
     {
-        //scythe preceding bed records
-        std::list<BEDRecord>::iterator i = buffer.begin();
-        while (i!=buffer.end())
+        if (regions[i].end1>=beg1)
         {
-            if ((*i).end1<beg1)
-            {
-                i = buffer.erase(i);
-                continue;
-            }
-
-            overlaps = ((*i).beg1<=end1);
-            break;
+            overlaps = true;
+            overlapping_regions.push_back(regions[i]);
         }
+    }
 
-        if (!overlaps)
+    return overlaps;
+};
+
+/**
+ * Gets the contig of the track named chrom, -1 if absent.
+ */
+int32_t OrderedRegionOverlapMatcher::get_tid(const char* chrom)
+{
+    if (track) return track->get_tid(chrom);
+    return todr->tbx ? tbx_name2id(todr->tbx, chrom) : -1;
+};
+
+/**
+ * Gets the contigs of the track of the contigs of h.
+ */
+std::vector<int32_t>& OrderedRegionOverlapMatcher::get_tids(bcf_hdr_t* h)
+{
+    for (size_t i=0; i<hdrs.size(); ++i)
+    {
+        if (hdrs[i]==h && (int32_t)rid2tid[i].size()==h->n[BCF_DT_CTG])
         {
-            if (buffer.empty())
-            {
-                while (todr->read(&s))
-                {
-                    BEDRecord br(&s);
-                    if (br.end1<beg1) continue;
-                    overlaps = overlaps || (br.beg1<=end1);
-                    if (br.beg1<=end1)
-                    {
-                        Interval region(br.beg1, br.end1);
-                        overlapping_regions.push_back(region);
-                    }
-                    buffer.push_back(br);
-                    if (br.beg1>end1) break;
-                }
-            }
+            return rid2tid[i];
         }
     }
 
-    return overlaps;
+    std::vector<int32_t> tids(h->n[BCF_DT_CTG], -1);
+    for (int32_t i=0; i<h->n[BCF_DT_CTG]; ++i)
+    {
+        tids[i] = get_tid(bcf_hdr_id2name(h, i));
+    }
+
+    for (size_t i=0; i<hdrs.size(); ++i)
+    {
+        if (hdrs[i]==h)
+        {
+            rid2tid[i].swap(tids);
+            return rid2tid[i];
+        }
+    }
+
+    hdrs.push_back(h);
+    rid2tid.push_back(tids);
+    return rid2tid.back();
+};
+
+/**
+ * Reads the regions of contig tid of the track.
+ */
+void OrderedRegionOverlapMatcher::read_regions(int32_t tid, std::vector<Interval>* regions)
+{
+    regions->clear();
+    if (tid<0) return;
+
+    if (track)
+    {
+        if (tid<(int32_t)track->regions.size()) *regions = track->regions[tid];
+        return;
+    }
+
+    if (!todr->tbx) return;
+
+    hts_itr_t* itr = tbx_itr_queryi(todr->tbx, tid, 0, HTS_POS_MAX);
+    if (!itr) return;
+
+    kstring_t line = {0,0,0};
+    while (tbx_itr_next(todr->hts, todr->tbx, itr, &line)>=0)
+    {
+        BEDRecord br(&line);
+        regions->push_back(Interval(br.beg1, br.end1));
+    }
+
+    if (line.m) free(line.s);
+    tbx_itr_destroy(itr);
 };
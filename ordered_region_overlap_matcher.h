@@ -24,6 +24,7 @@
 #ifndef OVERLAP_REGION_MATCHER_H
 #define OVERLAP_REGION_MATCHER_H
 
+#include <future>
 #include "hts_utils.h"
 #include "bcf_ordered_reader.h"
 #include "tbx_ordered_reader.h"
@@ -32,6 +33,12 @@
 /**
  *  This class allows for overlap matching via streaming which
  *  requires that files are ordered.
+ *
+ *  The regions of a contig are read into an array sorted by start
+ *  that is swept once as the queries advance, the regions of the
+ *  next contig are read in the background.  Contigs of the queries
+ *  are translated to contigs of the track once per header.  A track
+ *  kept resident by vt serve is used in place of the file.
  */
 class OrderedRegionOverlapMatcher
 {
@@ -47,11 +54,30 @@ class OrderedRegionOverlapMatcher
     ///////
     BCFOrderedReader *odr;
     TBXOrderedReader *todr;
+    BEDTrack *track;
 
     kstring_t s;
 
-    GenomeInterval current_interval;
-    std::list<BEDRecord> buffer;
+    //regions of the current contig of the track, sorted by start,
+    //and the running maximum of their ends
+    int32_t tid;
+    std::vector<Interval> regions;
+    std::vector<int32_t> max_end1;
+    size_t lo;
+
+    //regions of the next contig of the track
+    int32_t next_tid;
+    std::vector<Interval> next_regions;
+    std::future<void> prefetch;
+
+    //contig of the track of each contig of a query header
+    std::vector<bcf_hdr_t*> hdrs;
+    std::vector<std::vector<int32_t> > rid2tid;
+
+    //contig of the last query by name
+    std::string chrom;
+    int32_t chrom_tid;
+
     std::vector<Interval> overlapping_regions;
     bool end_of_file;
     int32_t no_regions;
@@ -66,12 +92,38 @@ class OrderedRegionOverlapMatcher
      */
     ~OrderedRegionOverlapMatcher();
 
+    /**
+     * Returns true if contig rid of h:beg1-end1 overlaps with a region in the file.
+     */
+    bool overlaps_with(bcf_hdr_t* h, int32_t rid, int32_t beg1, int32_t end1);
+
     /**
      * Returns true if chrom:beg1-end1 overlaps with a region in the file.
      */
     bool overlaps_with(std::string& chrom, int32_t beg1, int32_t end1);
 
     private:
+
+    /**
+     * Returns true if contig tid of the track:beg1-end1 overlaps with a region in the file.
+     * The regions of contig next_tid are read ahead.
+     */
+    bool overlaps_with(int32_t tid, int32_t next_tid, int32_t beg1, int32_t end1);
+
+    /**
+     * Gets the contig of the track named chrom, -1 if absent.
+     */
+    int32_t get_tid(const char* chrom);
+
+    /**
+     * Gets the contigs of the track of the contigs of h.
+     */
+    std::vector<int32_t>& get_tids(bcf_hdr_t* h);
+
+    /**
+     * Reads the regions of contig tid of the track.
+     */
+    void read_regions(int32_t tid, std::vector<Interval>* regions);
 };
 
 #endif
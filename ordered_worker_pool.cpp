@@ -0,0 +1,138 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "ordered_worker_pool.h"
+#include "align_workspace.h"
+
+/**
+ * Starts no_workers threads, at most capacity records are buffered.
+ */
+OrderedWorkerPool::OrderedWorkerPool(int32_t no_workers, Work work, int32_t capacity)
+{
+    this->work = work;
+    this->capacity = capacity>0 ? capacity : 64*no_workers;
+    closed = false;
+
+    for (int32_t i=0; i<no_workers; ++i)
+    {
+        workers.push_back(std::thread(&OrderedWorkerPool::run, this, i));
+    }
+}
+
+/**
+ * Joins the workers.
+ */
+OrderedWorkerPool::~OrderedWorkerPool()
+{
+    close();
+    for (size_t i=0; i<workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+}
+
+/**
+ * Queues a record, blocks while the reorder buffer is full and its oldest record is not processed.
+ */
+void OrderedWorkerPool::push(bcf1_t* v)
+{
+    std::unique_lock<std::mutex> l(lock);
+
+    while ((int32_t)slots.size()>=capacity && !slots.front().done)
+    {
+        slot_done.wait(l);
+    }
+
+    slot_t s = {v, false, false};
+    slots.push_back(s);
+    jobs.push_back(&slots.back());
+    job_ready.notify_one();
+}
+
+/**
+ * Returns the oldest record if it has been processed.  If wait is true, blocks until it is.
+ * Returns false if there are no records in the buffer.
+ */
+bool OrderedWorkerPool::pop(bcf1_t*& v, bool& keep, bool wait)
+{
+    std::unique_lock<std::mutex> l(lock);
+
+    if (slots.empty()) return false;
+
+    while (!slots.front().done)
+    {
+        if (!wait) return false;
+        slot_done.wait(l);
+    }
+
+    v = slots.front().v;
+    keep = slots.front().keep;
+    slots.pop_front();
+
+    return true;
+}
+
+/**
+ * Signals the end of input, the remaining records are still returned by pop.
+ */
+void OrderedWorkerPool::close()
+{
+    std::unique_lock<std::mutex> l(lock);
+    closed = true;
+    job_ready.notify_all();
+}
+
+/**
+ * Worker thread loop.
+ */
+void OrderedWorkerPool::run(int32_t worker)
+{
+    while (true)
+    {
+        slot_t* s;
+        {
+            std::unique_lock<std::mutex> l(lock);
+            while (jobs.empty() && !closed)
+            {
+                job_ready.wait(l);
+            }
+
+            if (jobs.empty())
+            {
+                //blocks left behind by matrices that grew during the run
+                AlignmentWorkspace::trim();
+                return;
+            }
+
+            s = jobs.front();
+            jobs.pop_front();
+        }
+
+        bool keep = work(worker, s->v);
+
+        std::unique_lock<std::mutex> l(lock);
+        s->keep = keep;
+        s->done = true;
+        slot_done.notify_all();
+    }
+}
@@ -0,0 +1,113 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#ifndef ORDERED_WORKER_POOL_H
+#define ORDERED_WORKER_POOL_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "hts_utils.h"
+
+/**
+ * A pool of worker threads that processes records out of order and
+ * returns them in the order they were pushed.
+ *
+ * Each worker is identified by an index so that the caller can give
+ * every worker its own copy of the non thread safe tools (faidx handles,
+ * HMMs, filters).  The work function returns false if the record is to
+ * be dropped from the output.
+ *
+ *  while (odr->read(v))
+ *  {
+ *      pool.push(v);
+ *      while (pool.pop(v, keep, false)) { ... }
+ *      v = odw->get_bcf1_from_pool();
+ *  }
+ *  pool.close();
+ *  while (pool.pop(v, keep, true)) { ... }
+ */
+class OrderedWorkerPool
+{
+    public:
+
+    typedef std::function<bool (int32_t worker, bcf1_t* v)> Work;
+
+    /**
+     * Starts no_workers threads, at most capacity records are buffered.
+     */
+    OrderedWorkerPool(int32_t no_workers, Work work, int32_t capacity=0);
+
+    /**
+     * Joins the workers.
+     */
+    ~OrderedWorkerPool();
+
+    /**
+     * Queues a record, blocks while the reorder buffer is full and its oldest record is not processed.
+     */
+    void push(bcf1_t* v);
+
+    /**
+     * Returns the oldest record if it has been processed.  If wait is true, blocks until it is.
+     * Returns false if there are no records in the buffer.
+     */
+    bool pop(bcf1_t*& v, bool& keep, bool wait);
+
+    /**
+     * Signals the end of input, the remaining records are still returned by pop.
+     */
+    void close();
+
+    private:
+
+    typedef struct
+    {
+        bcf1_t* v;
+        bool done;
+        bool keep;
+    } slot_t;
+
+    Work work;
+    int32_t capacity;
+    bool closed;
+
+    //references to elements of a deque stay valid across push_back and pop_front
+    std::deque<slot_t> slots;
+    std::deque<slot_t*> jobs;
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable job_ready;
+    std::condition_variable slot_done;
+
+    /**
+     * Worker thread loop.
+     */
+    void run(int32_t worker);
+};
+
+#endif
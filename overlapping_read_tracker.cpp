@@ -0,0 +1,225 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "overlapping_read_tracker.h"
+
+/**
+ * Constructor.
+ */
+OverlappingReadTracker::OverlappingReadTracker()
+{
+    tid = -1;
+    keys = kh_init(mkey);
+    ring.resize(256);
+    head = 0;
+    no_buckets = 0;
+    base1 = 0;
+
+    no_tracked = 0;
+    no_matched = 0;
+    no_expired = 0;
+    max_pending = 0;
+    max_bytes = memory();
+}
+
+/**
+ * Destructor.
+ */
+OverlappingReadTracker::~OverlappingReadTracker()
+{
+    kh_destroy(mkey, keys);
+}
+
+/**
+ * Processes a read, reads must be presented in coordinate order.
+ *
+ * Returns true if the read is the second mate of a tracked
+ * overlapping pair.
+ */
+bool OverlappingReadTracker::is_overlapping_mate(bam1_t *s)
+{
+    //some bams may not be properly formed and contain orphaned reads
+    if (bam_get_tid(s)!=tid)
+    {
+        clear();
+        tid = bam_get_tid(s);
+    }
+
+    int32_t pos1 = bam_get_pos1(s);
+    expire(pos1);
+
+    //this read is part of a mate pair on the same contig
+    if (bam_get_mpos1(s) && (bam_get_tid(s)==bam_get_mtid(s)))
+    {
+        int32_t mpos1 = bam_get_mpos1(s);
+
+        //first mate
+        if (mpos1>pos1)
+        {
+            //overlapping
+            if (mpos1<=(pos1 + bam_get_l_qseq(s) - 1))
+            {
+                //bam_get_mpos1 is 0 based, key on where the mate will be read
+                add(hash(bam_get_qname(s), mpos1+1), mpos1+1);
+            }
+        }
+        else
+        {
+            //second mate, its position is the one its first mate was keyed on
+            khiter_t k = kh_get(mkey, keys, hash(bam_get_qname(s), pos1));
+            if (k!=kh_end(keys))
+            {
+                kh_del(mkey, keys, k);
+                ++no_matched;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Discards all pending first mates.
+ */
+void OverlappingReadTracker::clear()
+{
+    no_expired += kh_size(keys);
+    kh_clear(mkey, keys);
+    for (uint32_t i=0; i<no_buckets; ++i)
+    {
+        ring[(head+i)&(ring.size()-1)].clear();
+    }
+    no_buckets = 0;
+}
+
+/**
+ * Returns the memory held in bytes.
+ */
+size_t OverlappingReadTracker::memory()
+{
+    size_t bytes = kh_n_buckets(keys)*sizeof(uint64_t) + ((kh_n_buckets(keys)>>4)+1)*sizeof(uint32_t);
+    bytes += ring.capacity()*sizeof(std::vector<uint64_t>);
+    for (size_t i=0; i<ring.size(); ++i)
+    {
+        bytes += ring[i].capacity()*sizeof(uint64_t);
+    }
+
+    return bytes;
+}
+
+/**
+ * Hashes a QNAME together with a position, 64 bit FNV-1a.
+ */
+uint64_t OverlappingReadTracker::hash(const char* qname, int32_t pos1)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char* p = qname; *p; ++p)
+    {
+        h ^= (uint8_t) *p;
+        h *= 0x100000001b3ULL;
+    }
+    uint32_t pos = pos1;
+    for (int32_t i=0; i<4; ++i)
+    {
+        h ^= (pos & 0xFF);
+        h *= 0x100000001b3ULL;
+        pos >>= 8;
+    }
+
+    return h;
+}
+
+/**
+ * Expires buckets for mate positions before pos1.
+ */
+void OverlappingReadTracker::expire(int32_t pos1)
+{
+    if (no_buckets && pos1<base1)
+    {
+        //not coordinate sorted, nothing pending can be relied on
+        clear();
+    }
+
+    uint32_t mask = ring.size()-1;
+    while (no_buckets && base1<pos1)
+    {
+        std::vector<uint64_t>& bucket = ring[head];
+        for (size_t i=0; i<bucket.size(); ++i)
+        {
+            khiter_t k = kh_get(mkey, keys, bucket[i]);
+            if (k!=kh_end(keys))
+            {
+                kh_del(mkey, keys, k);
+                ++no_expired;
+            }
+        }
+        bucket.clear();
+        head = (head+1)&mask;
+        --no_buckets;
+        ++base1;
+    }
+
+    if (!no_buckets)
+    {
+        base1 = pos1;
+    }
+}
+
+/**
+ * Adds a key to the bucket of mate position mpos1.
+ */
+void OverlappingReadTracker::add(uint64_t key, int32_t mpos1)
+{
+    int32_t ret;
+    kh_put(mkey, keys, key, &ret);
+    ++no_tracked;
+
+    uint32_t offset = mpos1-base1;
+    if (offset>=ring.size())
+    {
+        //grow to a power of two, keeping buckets in position order
+        size_t size = ring.size();
+        while (offset>=size) size <<= 1;
+        std::vector<std::vector<uint64_t> > grown(size);
+        for (uint32_t i=0; i<no_buckets; ++i)
+        {
+            grown[i].swap(ring[(head+i)&(ring.size()-1)]);
+        }
+        ring.swap(grown);
+        head = 0;
+    }
+
+    ring[(head+offset)&(ring.size()-1)].push_back(key);
+    if (offset>=no_buckets)
+    {
+        no_buckets = offset+1;
+    }
+
+    if (kh_size(keys)>max_pending)
+    {
+        max_pending = kh_size(keys);
+        size_t bytes = memory();
+        if (bytes>max_bytes) max_bytes = bytes;
+    }
+}
@@ -0,0 +1,116 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#ifndef OVERLAPPING_READ_TRACKER_H
+#define OVERLAPPING_READ_TRACKER_H
+
+#include <cstdint>
+#include <vector>
+#include "htslib/khash.h"
+#include "htslib/sam.h"
+#include "hts_utils.h"
+
+KHASH_SET_INIT_INT64(mkey)
+
+/**
+ * Tracks the first mates of overlapping read pairs in a coordinate sorted
+ * BAM so that the second mate can be recognised and dropped.
+ *
+ * A pending first mate is identified by a 64 bit hash of its QNAME and the
+ * position of its mate.  As the mate of an overlapping read lies within a
+ * read length downstream, the keys are bucketed in a ring indexed by mate
+ * position and a bucket is expired as soon as the reads move past it, so
+ * orphaned mates do not accumulate for the whole run.
+ */
+class OverlappingReadTracker
+{
+    public:
+
+    int32_t tid;                                 //current sequence id
+    khash_t(mkey) *keys;                         //pending first mates
+    std::vector<std::vector<uint64_t> > ring;    //keys bucketed by mate position
+    uint32_t head;                               //ring index of the bucket at base1
+    uint32_t no_buckets;                         //number of buckets in use
+    int32_t base1;                               //mate position of the bucket at head
+
+    /////////
+    //stats//
+    /////////
+    uint64_t no_tracked;
+    uint64_t no_matched;
+    uint64_t no_expired;
+    uint32_t max_pending;
+    size_t max_bytes;
+
+    /**
+     * Constructor.
+     */
+    OverlappingReadTracker();
+
+    /**
+     * Destructor.
+     */
+    ~OverlappingReadTracker();
+
+    /**
+     * Processes a read, reads must be presented in coordinate order.
+     *
+     * Returns true if the read is the second mate of a tracked
+     * overlapping pair.
+     */
+    bool is_overlapping_mate(bam1_t *s);
+
+    /**
+     * Discards all pending first mates.
+     */
+    void clear();
+
+    /**
+     * Returns the number of pending first mates.
+     */
+    uint32_t size() { return kh_size(keys); };
+
+    /**
+     * Returns the memory held in bytes.
+     */
+    size_t memory();
+
+    private:
+
+    /**
+     * Hashes a QNAME together with a position.
+     */
+    uint64_t hash(const char* qname, int32_t pos1);
+
+    /**
+     * Expires buckets for mate positions before pos1.
+     */
+    void expire(int32_t pos1);
+
+    /**
+     * Adds a key to the bucket of mate position mpos1.
+     */
+    void add(uint64_t key, int32_t mpos1);
+};
+
+#endif
@@ -0,0 +1,514 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "packed_reference.h"
+
+std::map<std::string, PackedReference*> PackedReference::images;
+std::mutex PackedReference::images_mutex;
+
+namespace
+{
+
+/**
+ * Decoding table for a byte of 4 packed bases.
+ */
+class PackedBaseTable
+{
+    public:
+
+    char bases[256][4];
+
+    PackedBaseTable()
+    {
+        for (int32_t i=0; i<256; ++i)
+        {
+            for (int32_t j=0; j<4; ++j)
+            {
+                bases[i][j] = "ACGT"[(i>>(j<<1))&3];
+            }
+        }
+    }
+};
+
+PackedBaseTable pbt;
+
+bool run_end_le(const pk_ref_run_t& run, int64_t pos0)
+{
+    return run.end0<=pos0;
+}
+
+bool iupac_pos_lt(const pk_ref_iupac_t& iupac, int64_t pos0)
+{
+    return iupac.pos0<pos0;
+}
+
+/**
+ * Writes a section padded to 8 bytes, returns the offset it was written at.
+ */
+uint64_t write_section(FILE* fp, const void* data, size_t len)
+{
+    uint64_t off = ftell(fp);
+    if (len) fwrite(data, 1, len, fp);
+    static const char pad[8] = {0,0,0,0,0,0,0,0};
+    if (len&7) fwrite(pad, 1, 8-(len&7), fp);
+    return off;
+}
+
+}
+
+/**
+ * Maps a packed reference.
+ */
+PackedReference::PackedReference(std::string& file)
+{
+    this->file = file;
+    no_users = 0;
+
+    fd = open(file.c_str(), O_RDONLY);
+    if (fd<0)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot open packed reference: %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str());
+        exit(1);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size<sizeof(pk_ref_hdr_t))
+    {
+        fprintf(stderr, "[%s:%d %s] Not a packed reference: %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str());
+        exit(1);
+    }
+
+    map_len = st.st_size;
+    map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd, 0);
+    if (map==MAP_FAILED)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot map packed reference: %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str());
+        exit(1);
+    }
+
+    base = (const uint8_t*) map;
+    hdr = (const pk_ref_hdr_t*) base;
+    if (strncmp(hdr->magic, PK_REF_MAGIC, 8) || hdr->version!=PK_REF_VERSION || hdr->str_off+hdr->str_len>map_len)
+    {
+        fprintf(stderr, "[%s:%d %s] Not a packed reference or incompatible version: %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str());
+        exit(1);
+    }
+
+    seqs = (const pk_ref_seq_t*) (base + hdr->seq_off);
+    n_runs = (const pk_ref_run_t*) (base + hdr->n_run_off);
+    mask_runs = (const pk_ref_run_t*) (base + hdr->mask_run_off);
+    iupacs = (const pk_ref_iupac_t*) (base + hdr->iupac_off);
+    str = (const char*) (base + hdr->str_off);
+
+    for (uint32_t i=0; i<hdr->n_seq; ++i)
+    {
+        seq2idx[std::string(&str[seqs[i].name])] = i;
+    }
+}
+
+/**
+ * Unmaps the packed reference.
+ */
+PackedReference::~PackedReference()
+{
+    munmap(map, map_len);
+    close(fd);
+}
+
+/**
+ * Returns a shared handle to the packed reference in file, mapping it on first use.
+ */
+PackedReference* PackedReference::acquire(std::string& file)
+{
+    std::lock_guard<std::mutex> lock(images_mutex);
+
+    //the same file may be named by different paths
+    std::string path = canonical_path(file);
+
+    PackedReference* pr;
+    std::map<std::string, PackedReference*>::iterator i = images.find(path);
+    if (i==images.end())
+    {
+        pr = new PackedReference(path);
+        images[path] = pr;
+    }
+    else
+    {
+        pr = i->second;
+    }
+
+    ++pr->no_users;
+    return pr;
+}
+
+/**
+ * Releases a handle obtained with acquire, the image is unmapped when it is no longer used.
+ */
+void PackedReference::release(PackedReference* pr)
+{
+    std::lock_guard<std::mutex> lock(images_mutex);
+
+    if (--pr->no_users==0)
+    {
+        images.erase(pr->file);
+        delete pr;
+    }
+}
+
+/**
+ * Checks if file is a packed reference.
+ */
+bool PackedReference::is_packed(std::string& file)
+{
+    FILE* fp = fopen(file.c_str(), "rb");
+    if (fp==NULL) return false;
+
+    char magic[8];
+    bool packed = fread(magic, 1, 8, fp)==8 && !strncmp(magic, PK_REF_MAGIC, 8);
+    fclose(fp);
+
+    return packed;
+}
+
+/**
+ * Checks if packed_file is a packed reference of the current version
+ * made from ref_fasta_file as it is now, by its size and modification time.
+ */
+bool PackedReference::is_current(std::string& packed_file, std::string& ref_fasta_file)
+{
+    struct stat st;
+    if (stat(ref_fasta_file.c_str(), &st)) return false;
+
+    FILE* fp = fopen(packed_file.c_str(), "rb");
+    if (fp==NULL) return false;
+
+    pk_ref_hdr_t h;
+    bool current = fread(&h, sizeof(pk_ref_hdr_t), 1, fp)==1 &&
+                   !strncmp(h.magic, PK_REF_MAGIC, 8) &&
+                   h.version==PK_REF_VERSION &&
+                   h.fasta_size==(int64_t)st.st_size &&
+                   h.fasta_mtime==(int64_t)st.st_mtime;
+    fclose(fp);
+
+    return current;
+}
+
+/**
+ * Packs a FASTA file.
+ * Returns the number of sequences packed.
+ */
+int32_t PackedReference::pack(std::string& ref_fasta_file, std::string& packed_file)
+{
+    htsFile* hts = hts_open(ref_fasta_file.c_str(), "r");
+    if (hts==NULL)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot open FASTA file: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
+        exit(1);
+    }
+
+    FILE* fp = fopen(packed_file.c_str(), "wb");
+    if (fp==NULL)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot write packed reference: %s\n", __FILE__, __LINE__, __FUNCTION__, packed_file.c_str());
+        exit(1);
+    }
+
+    pk_ref_hdr_t h;
+    memset(&h, 0, sizeof(pk_ref_hdr_t));
+    fwrite(&h, sizeof(pk_ref_hdr_t), 1, fp);
+
+    struct stat st;
+    if (stat(ref_fasta_file.c_str(), &st)==0)
+    {
+        h.fasta_size = st.st_size;
+        h.fasta_mtime = st.st_mtime;
+    }
+
+    std::vector<pk_ref_seq_t> seqs;
+    std::vector<pk_ref_run_t> n_runs;
+    std::vector<pk_ref_run_t> mask_runs;
+    std::vector<pk_ref_iupac_t> iupacs;
+    std::string str;
+
+    pk_ref_seq_t* s = NULL;
+    int64_t n_beg0 = -1, mask_beg0 = -1;
+    uint8_t byte = 0;
+
+    kstring_t line = {0,0,0};
+    while (true)
+    {
+        bool eof = hts_getline(hts, '\n', &line)<0;
+
+        //close the current sequence
+        if (s && (eof || (line.l && line.s[0]=='>')))
+        {
+            if (n_beg0!=-1) n_runs.push_back({n_beg0, s->len});
+            if (mask_beg0!=-1) mask_runs.push_back({mask_beg0, s->len});
+            if (s->len&3) fputc(byte, fp);
+            s->n_run_end = n_runs.size();
+            s->mask_run_end = mask_runs.size();
+            s->iupac_end = iupacs.size();
+            n_beg0 = mask_beg0 = -1;
+            byte = 0;
+        }
+
+        if (eof) break;
+
+        if (line.l && line.s[0]=='>')
+        {
+            seqs.push_back(pk_ref_seq_t());
+            s = &seqs.back();
+            memset(s, 0, sizeof(pk_ref_seq_t));
+
+            size_t l = 1;
+            while (l<line.l && !isspace(line.s[l])) ++l;
+            s->name = str.size();
+            str.append(line.s+1, l-1);
+            str.append(1, '\0');
+
+            s->bases = ftell(fp);
+            s->n_run_beg = n_runs.size();
+            s->mask_run_beg = mask_runs.size();
+            s->iupac_beg = iupacs.size();
+            continue;
+        }
+
+        if (s==NULL) continue;
+
+        for (size_t i=0; i<line.l; ++i)
+        {
+            char c = line.s[i];
+            if (isspace(c)) continue;
+
+            int64_t pos0 = s->len;
+
+            bool lower = islower(c);
+            if (lower && mask_beg0==-1)
+            {
+                mask_beg0 = pos0;
+            }
+            else if (!lower && mask_beg0!=-1)
+            {
+                mask_runs.push_back({mask_beg0, pos0});
+                mask_beg0 = -1;
+            }
+
+            c = toupper(c);
+            uint8_t code = 0;
+            switch (c)
+            {
+                case 'A': code = 0; break;
+                case 'C': code = 1; break;
+                case 'G': code = 2; break;
+                case 'T': code = 3; break;
+                case 'N': break;
+                default:
+                {
+                    pk_ref_iupac_t iupac;
+                    memset(&iupac, 0, sizeof(pk_ref_iupac_t));
+                    iupac.pos0 = pos0;
+                    iupac.base = c;
+                    iupacs.push_back(iupac);
+                }
+            }
+
+            if (c=='N' && n_beg0==-1)
+            {
+                n_beg0 = pos0;
+            }
+            else if (c!='N' && n_beg0!=-1)
+            {
+                n_runs.push_back({n_beg0, pos0});
+                n_beg0 = -1;
+            }
+
+            byte |= code << ((pos0&3)<<1);
+            if ((pos0&3)==3)
+            {
+                fputc(byte, fp);
+                byte = 0;
+            }
+
+            ++s->len;
+        }
+    }
+
+    if (line.m) free(line.s);
+    hts_close(hts);
+
+    //pad the bases to the section alignment
+    static const char pad[8] = {0,0,0,0,0,0,0,0};
+    fwrite(pad, 1, (8-(ftell(fp)&7))&7, fp);
+
+    memcpy(h.magic, PK_REF_MAGIC, 8);
+    h.version = PK_REF_VERSION;
+    h.n_seq = seqs.size();
+    h.seq_off = write_section(fp, seqs.data(), seqs.size()*sizeof(pk_ref_seq_t));
+    h.n_n_run = n_runs.size();
+    h.n_run_off = write_section(fp, n_runs.data(), n_runs.size()*sizeof(pk_ref_run_t));
+    h.n_mask_run = mask_runs.size();
+    h.mask_run_off = write_section(fp, mask_runs.data(), mask_runs.size()*sizeof(pk_ref_run_t));
+    h.n_iupac = iupacs.size();
+    h.iupac_off = write_section(fp, iupacs.data(), iupacs.size()*sizeof(pk_ref_iupac_t));
+    h.str_len = str.size();
+    h.str_off = write_section(fp, str.data(), str.size());
+
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&h, sizeof(pk_ref_hdr_t), 1, fp);
+    fclose(fp);
+
+    return seqs.size();
+}
+
+/**
+ * Returns the index of sequence chrom, -1 if it is absent.
+ */
+int32_t PackedReference::seq_index(const char* chrom)
+{
+    std::map<std::string, int32_t>::iterator i = seq2idx.find(chrom);
+    return i==seq2idx.end() ? -1 : i->second;
+}
+
+/**
+ * Returns the length of sequence chrom, -1 if it is absent.
+ */
+int64_t PackedReference::seq_len(const char* chrom)
+{
+    int32_t i = seq_index(chrom);
+    return i==-1 ? -1 : seqs[i].len;
+}
+
+/**
+ * Decodes bases [beg0,end0) of sequence i into seq.
+ */
+void PackedReference::decode(int32_t i, int64_t beg0, int64_t end0, char* seq, bool uc)
+{
+    const pk_ref_seq_t& s = seqs[i];
+    const uint8_t* b = base + s.bases;
+
+    //2 bit bases, a byte at a time where aligned
+    char* o = seq;
+    int64_t p = beg0;
+    while (p<end0 && (p&3))
+    {
+        *o++ = pbt.bases[b[p>>2]][p&3];
+        ++p;
+    }
+    while (p+4<=end0)
+    {
+        memcpy(o, pbt.bases[b[p>>2]], 4);
+        o += 4;
+        p += 4;
+    }
+    while (p<end0)
+    {
+        *o++ = pbt.bases[b[p>>2]][p&3];
+        ++p;
+    }
+    *o = '\0';
+
+    //N runs
+    const pk_ref_run_t* run = std::lower_bound(n_runs+s.n_run_beg, n_runs+s.n_run_end, beg0, run_end_le);
+    for (; run<n_runs+s.n_run_end && run->beg0<end0; ++run)
+    {
+        int64_t rbeg0 = std::max(run->beg0, beg0);
+        int64_t rend0 = std::min(run->end0, end0);
+        memset(seq+rbeg0-beg0, 'N', rend0-rbeg0);
+    }
+
+    //other IUPAC codes
+    const pk_ref_iupac_t* iupac = std::lower_bound(iupacs+s.iupac_beg, iupacs+s.iupac_end, beg0, iupac_pos_lt);
+    for (; iupac<iupacs+s.iupac_end && iupac->pos0<end0; ++iupac)
+    {
+        seq[iupac->pos0-beg0] = iupac->base;
+    }
+
+    //soft masking
+    if (!uc)
+    {
+        run = std::lower_bound(mask_runs+s.mask_run_beg, mask_runs+s.mask_run_end, beg0, run_end_le);
+        for (; run<mask_runs+s.mask_run_end && run->beg0<end0; ++run)
+        {
+            int64_t rend0 = std::min(run->end0, end0);
+            for (int64_t j=std::max(run->beg0, beg0); j<rend0; ++j)
+            {
+                seq[j-beg0] = tolower(seq[j-beg0]);
+            }
+        }
+    }
+}
+
+/**
+ * Decodes chrom:beg0-end0 (inclusive) into seq, which must hold end0-beg0+2 characters.
+ * Coordinates are clamped to the sequence as in faidx.
+ * Returns the number of bases written, -2 if chrom is absent.
+ */
+int64_t PackedReference::fetch(const char* chrom, int64_t beg0, int64_t end0, char* seq, bool uc)
+{
+    int32_t i = seq_index(chrom);
+    if (i==-1)
+    {
+        return -2;
+    }
+
+    int64_t len = seqs[i].len;
+    if (len==0)
+    {
+        seq[0] = '\0';
+        return 0;
+    }
+
+    if (end0<beg0) beg0 = end0;
+    beg0 = beg0<0 ? 0 : (beg0>=len ? len-1 : beg0);
+    end0 = end0<0 ? 0 : (end0>=len ? len-1 : end0);
+
+    decode(i, beg0, end0+1, seq, uc);
+
+    return end0-beg0+1;
+}
+
+/**
+ * Decodes chrom:beg0-end0 (inclusive) into seq.
+ * Returns the number of bases written, -2 if chrom is absent.
+ */
+int64_t PackedReference::fetch(const char* chrom, int64_t beg0, int64_t end0, std::string& seq, bool uc)
+{
+    //size the buffer for the clamped interval
+    int64_t len = seq_len(chrom);
+    if (end0>=len) end0 = len-1;
+    if (beg0<0) beg0 = 0;
+
+    seq.resize(end0<beg0 ? 2 : end0-beg0+2);
+    int64_t n = fetch(chrom, beg0, end0, &seq[0], uc);
+    seq.resize(n<0 ? 0 : n);
+
+    return n;
+}
+
+/**
+ * Returns the uppercase base at chrom:pos0, 0 if chrom is absent.
+ */
+char PackedReference::fetch_base(const char* chrom, int64_t pos0)
+{
+    char b[2];
+    return fetch(chrom, pos0, pos0, b)<0 ? 0 : b[0];
+}
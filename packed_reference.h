@@ -0,0 +1,218 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#ifndef PACKED_REFERENCE_H
+#define PACKED_REFERENCE_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "htslib/kstring.h"
+#include "hts_utils.h"
+#include "utils.h"
+
+#define PK_REF_MAGIC "VTPKREF"
+#define PK_REF_VERSION 2
+
+/**
+ * On disk layout of a packed reference.
+ *
+ * header | 2 bit bases | sequences | N runs | soft mask runs | IUPAC bases | string pool
+ *
+ * Bases are packed 4 to a byte, A,C,G,T as 0,1,2,3 from the low bits up,
+ * and each sequence starts on a byte boundary.  Runs of N and of lower
+ * case bases are recorded as sorted half open intervals, the remaining
+ * non ACGTN characters are kept individually so that the image is
+ * lossless with respect to the uppercased FASTA.
+ *
+ * All sections are 8 byte aligned and the file is mapped read only.  The
+ * size and modification time of the FASTA file it was packed from are
+ * kept so that a stale <ref>.pack is not used in place of the FASTA.
+ */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t n_seq;
+    uint64_t seq_off;
+    uint64_t n_run_off;
+    uint64_t n_n_run;
+    uint64_t mask_run_off;
+    uint64_t n_mask_run;
+    uint64_t iupac_off;
+    uint64_t n_iupac;
+    uint64_t str_off;
+    uint64_t str_len;
+    int64_t fasta_size;
+    int64_t fasta_mtime;
+} pk_ref_hdr_t;
+
+typedef struct
+{
+    uint64_t name;        //offset into string pool
+    int64_t len;
+    uint64_t bases;       //byte offset of the first base in the file
+    uint64_t n_run_beg;   //first N run of this sequence
+    uint64_t n_run_end;
+    uint64_t mask_run_beg;//first soft mask run of this sequence
+    uint64_t mask_run_end;
+    uint64_t iupac_beg;   //first IUPAC base of this sequence
+    uint64_t iupac_end;
+} pk_ref_seq_t;
+
+typedef struct
+{
+    int64_t beg0;
+    int64_t end0;         //one past the last base
+} pk_ref_run_t;
+
+typedef struct
+{
+    int64_t pos0;
+    char base;
+    char pad[7];
+} pk_ref_iupac_t;
+
+/**
+ * Memory mapped 2 bit packed reference genome.
+ *
+ * Bases are decoded directly from the mapped image into the caller's
+ * buffer, fetches do not allocate and the object is safe to share
+ * between threads.  Images are shared by all users in a process
+ * through acquire and release.
+ */
+class PackedReference
+{
+    public:
+
+    std::string file;
+
+    /**
+     * Returns a shared handle to the packed reference in file, mapping it on first use.
+     */
+    static PackedReference* acquire(std::string& file);
+
+    /**
+     * Releases a handle obtained with acquire, the image is unmapped when it is no longer used.
+     */
+    static void release(PackedReference* pr);
+
+    /**
+     * Checks if file is a packed reference.
+     */
+    static bool is_packed(std::string& file);
+
+    /**
+     * Checks if packed_file is a packed reference of the current version
+     * made from ref_fasta_file as it is now, by its size and modification time.
+     */
+    static bool is_current(std::string& packed_file, std::string& ref_fasta_file);
+
+    /**
+     * Packs a FASTA file.
+     * Returns the number of sequences packed.
+     */
+    static int32_t pack(std::string& ref_fasta_file, std::string& packed_file);
+
+    /**
+     * Returns the number of sequences.
+     */
+    int32_t nseq() { return hdr->n_seq; };
+
+    /**
+     * Returns the name of the ith sequence.
+     */
+    const char* iseq_name(int32_t i) { return &str[seqs[i].name]; };
+
+    /**
+     * Returns the index of sequence chrom, -1 if it is absent.
+     */
+    int32_t seq_index(const char* chrom);
+
+    /**
+     * Returns the length of sequence chrom, -1 if it is absent.
+     */
+    int64_t seq_len(const char* chrom);
+
+    /**
+     * Decodes chrom:beg0-end0 (inclusive) into seq, which must hold end0-beg0+2 characters.
+     * Coordinates are clamped to the sequence as in faidx.
+     * Returns the number of bases written, -2 if chrom is absent.
+     */
+    int64_t fetch(const char* chrom, int64_t beg0, int64_t end0, char* seq, bool uc=true);
+
+    /**
+     * Decodes chrom:beg0-end0 (inclusive) into seq.
+     * Returns the number of bases written, -2 if chrom is absent.
+     */
+    int64_t fetch(const char* chrom, int64_t beg0, int64_t end0, std::string& seq, bool uc=true);
+
+    /**
+     * Returns the uppercase base at chrom:pos0, 0 if chrom is absent.
+     */
+    char fetch_base(const char* chrom, int64_t pos0);
+
+    private:
+
+    int fd;
+    void* map;
+    size_t map_len;
+    const pk_ref_hdr_t* hdr;
+    const pk_ref_seq_t* seqs;
+    const pk_ref_run_t* n_runs;
+    const pk_ref_run_t* mask_runs;
+    const pk_ref_iupac_t* iupacs;
+    const char* str;
+    const uint8_t* base;
+    std::map<std::string, int32_t> seq2idx;
+    int32_t no_users;
+
+    static std::map<std::string, PackedReference*> images;
+    static std::mutex images_mutex;
+
+    /**
+     * Maps a packed reference.
+     */
+    PackedReference(std::string& file);
+
+    /**
+     * Unmaps the packed reference.
+     */
+    ~PackedReference();
+
+    /**
+     * Decodes bases [beg0,end0) of sequence i into seq.
+     */
+    void decode(int32_t i, int64_t beg0, int64_t end0, char* seq, bool uc);
+};
+
+#endif
@@ -0,0 +1,301 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "pair_hmm.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#define PHMM_FLOAT_SCALE 1e36f
+#define PHMM_FLOAT_MIN 1e-28f
+
+namespace
+{
+
+/**
+ * A cell of the batch matrices, one float per lane.
+ */
+typedef float lanes_t __attribute__((vector_size(PHMM_LANES*sizeof(float))));
+
+/**
+ * Maps a base to an index into the emission table, anything other
+ * than ACGT is treated as N and matches every base.
+ */
+inline int32_t base2index(char b)
+{
+    switch (b)
+    {
+        case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': return 3;
+        default: return 4;
+    }
+}
+
+}
+
+/**
+ * Constructor.
+ */
+PairHMM::PairHMM(uint32_t gap_open, uint32_t gap_extend)
+{
+    this->gap_open = pow(10, -((float)gap_open)/10);
+    this->gap_extend = pow(10, -((float)gap_extend)/10);
+
+    for (int32_t q=0; q<64; ++q)
+    {
+        float e = pow(10, -((float)(q<2 ? 2 : q))/10);
+        match_prob[q] = 1-e;
+        mismatch_prob[q] = e/3;
+    }
+
+    m = i = d = pm = pi = pd = NULL;
+    capacity = 0;
+}
+
+/**
+ * Destructor.
+ */
+PairHMM::~PairHMM()
+{
+    free(m); free(i); free(d);
+    free(pm); free(pi); free(pd);
+}
+
+/**
+ * Computes log10 likelihoods of a batch of reads against a haplotype.
+ */
+void PairHMM::forward(const char* hap, int32_t hlen,
+                      const std::vector<std::string>& reads,
+                      const std::vector<std::string>& quals,
+                      float* lls)
+{
+    const std::string* batch_reads[PHMM_LANES];
+    const std::string* batch_quals[PHMM_LANES];
+
+    for (size_t k=0; k<reads.size(); k+=PHMM_LANES)
+    {
+        int32_t no = std::min((size_t)PHMM_LANES, reads.size()-k);
+        for (int32_t l=0; l<no; ++l)
+        {
+            batch_reads[l] = &reads[k+l];
+            batch_quals[l] = &quals[k+l];
+        }
+        forward_batch(hap, hlen, batch_reads, batch_quals, no, &lls[k]);
+    }
+}
+
+/**
+ * Computes one batch of up to PHMM_LANES reads.
+ */
+void PairHMM::forward_batch(const char* hap, int32_t hlen,
+                            const std::string** reads,
+                            const std::string** quals,
+                            int32_t no, float* lls)
+{
+    if (capacity<(size_t)hlen+1)
+    {
+        capacity = hlen+1;
+        float** buffers[6] = {&m, &i, &d, &pm, &pi, &pd};
+        for (int32_t k=0; k<6; ++k)
+        {
+            free(*buffers[k]);
+            if (posix_memalign((void**)buffers[k], sizeof(lanes_t), capacity*sizeof(lanes_t)))
+            {
+                fprintf(stderr, "[%s:%d %s] cannot allocate pair HMM matrices\n", __FILE__, __LINE__, __FUNCTION__);
+                exit(1);
+            }
+        }
+    }
+
+#ifdef __SSE__
+    //cells far from the alignment decay into denormals which are very slow
+    uint32_t mxcsr = _mm_getcsr();
+    _mm_setcsr(mxcsr | 0x8040);
+#endif
+
+    int32_t rlen[PHMM_LANES];
+    int32_t max_rlen = 0;
+    for (int32_t l=0; l<PHMM_LANES; ++l)
+    {
+        rlen[l] = l<no ? reads[l]->size() : 0;
+        if (rlen[l]>max_rlen) max_rlen = rlen[l];
+    }
+
+    hidx.resize(hlen);
+    for (int32_t j=0; j<hlen; ++j)
+    {
+        hidx[j] = base2index(hap[j]);
+    }
+
+    lanes_t* cm = (lanes_t*) m;
+    lanes_t* ci = (lanes_t*) i;
+    lanes_t* cd = (lanes_t*) d;
+    lanes_t* um = (lanes_t*) pm;
+    lanes_t* ui = (lanes_t*) pi;
+    lanes_t* ud = (lanes_t*) pd;
+
+    const lanes_t zero = {0};
+    const lanes_t mm = zero + (1-2*gap_open);
+    const lanes_t gm = zero + (1-gap_extend);
+    const lanes_t go = zero + gap_open;
+    const lanes_t ge = zero + gap_extend;
+
+    //row 0, the read may start anywhere on the haplotype
+    const lanes_t init = zero + PHMM_FLOAT_SCALE/hlen;
+    for (int32_t j=0; j<=hlen; ++j)
+    {
+        um[j] = zero;
+        ui[j] = zero;
+        ud[j] = init;
+    }
+
+    float sum[PHMM_LANES];
+    lanes_t prior[5];
+    for (int32_t r=1; r<=max_rlen; ++r)
+    {
+        //emissions of this row for each haplotype base
+        for (int32_t l=0; l<PHMM_LANES; ++l)
+        {
+            int32_t b = 4;
+            int32_t q = 0;
+            if (r<=rlen[l])
+            {
+                b = base2index((*reads[l])[r-1]);
+                q = (uint8_t) (*quals[l])[r-1];
+                if (q>63) q = 63;
+            }
+
+            for (int32_t h=0; h<4; ++h)
+            {
+                prior[h][l] = (b==4 || b==h) ? match_prob[q] : mismatch_prob[q];
+            }
+            prior[4][l] = match_prob[q];
+        }
+
+        cm[0] = ci[0] = cd[0] = zero;
+        for (int32_t j=1; j<=hlen; ++j)
+        {
+            cm[j] = prior[hidx[j-1]]*(mm*um[j-1] + gm*(ui[j-1]+ud[j-1]));
+            ci[j] = go*um[j] + ge*ui[j];
+            cd[j] = go*cm[j-1] + ge*cd[j-1];
+        }
+
+        //lanes whose read ends on this row
+        for (int32_t l=0; l<no; ++l)
+        {
+            if (rlen[l]==r)
+            {
+                float s = 0;
+                for (int32_t j=1; j<=hlen; ++j)
+                {
+                    s += cm[j][l] + ci[j][l];
+                }
+                sum[l] = s;
+            }
+        }
+
+        std::swap(cm, um);
+        std::swap(ci, ui);
+        std::swap(cd, ud);
+    }
+
+#ifdef __SSE__
+    _mm_setcsr(mxcsr);
+#endif
+
+    for (int32_t l=0; l<no; ++l)
+    {
+        if (rlen[l]==0)
+        {
+            lls[l] = 0;
+        }
+        else if (sum[l]<PHMM_FLOAT_MIN)
+        {
+            lls[l] = forward(hap, hlen, reads[l]->c_str(), quals[l]->c_str(), rlen[l]);
+        }
+        else
+        {
+            lls[l] = log10(sum[l]) - log10(PHMM_FLOAT_SCALE);
+        }
+    }
+}
+
+/**
+ * Computes log10 likelihood of a single read against a haplotype in
+ * double precision.
+ */
+double PairHMM::forward(const char* hap, int32_t hlen,
+                        const char* read, const char* qual, int32_t rlen)
+{
+    if (dm.size()<(size_t)hlen+1)
+    {
+        dm.resize(hlen+1); di.resize(hlen+1); dd.resize(hlen+1);
+        dpm.resize(hlen+1); dpi.resize(hlen+1); dpd.resize(hlen+1);
+    }
+
+    const double go = gap_open;
+    const double ge = gap_extend;
+    const double mm = 1-2*go;
+    const double gm = 1-ge;
+
+    double scale = ldexp(1.0, 1020);
+    for (int32_t j=0; j<=hlen; ++j)
+    {
+        dpm[j] = 0;
+        dpi[j] = 0;
+        dpd[j] = scale/hlen;
+    }
+
+    for (int32_t r=1; r<=rlen; ++r)
+    {
+        int32_t b = base2index(read[r-1]);
+        int32_t q = (uint8_t) qual[r-1];
+        if (q>63) q = 63;
+        double e = pow(10, -((double)(q<2 ? 2 : q))/10);
+
+        dm[0] = di[0] = dd[0] = 0;
+        for (int32_t j=1; j<=hlen; ++j)
+        {
+            int32_t h = base2index(hap[j-1]);
+            double p = (b==4 || h==4 || b==h) ? 1-e : e/3;
+            dm[j] = p*(mm*dpm[j-1] + gm*(dpi[j-1]+dpd[j-1]));
+            di[j] = go*dpm[j] + ge*dpi[j];
+            dd[j] = go*dm[j-1] + ge*dd[j-1];
+        }
+
+        dm.swap(dpm);
+        di.swap(dpi);
+        dd.swap(dpd);
+    }
+
+    double s = 0;
+    for (int32_t j=1; j<=hlen; ++j)
+    {
+        s += dpm[j] + dpi[j];
+    }
+
+    return log10(s) - log10(scale);
+}
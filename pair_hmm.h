@@ -0,0 +1,118 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#ifndef PAIR_HMM_H
+#define PAIR_HMM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define PHMM_LANES 8
+
+/**
+ * Pair HMM forward kernel for scoring reads against candidate haplotypes.
+ *
+ * Computes log10 P(read | haplotype) summed over all alignments of the
+ * read to any part of the haplotype, with per base error rates from the
+ * base qualities and constant gap open and extension probabilities.
+ *
+ * Reads are scored against a haplotype in batches of PHMM_LANES.  Each
+ * cell of the dynamic programming matrices holds one vector of lanes so
+ * that a cell update is a single SIMD operation over all the reads in the
+ * batch.  The batch is computed in single precision with a scaling
+ * constant and denormals flushed to zero, lanes that underflow are
+ * recomputed in double precision.
+ *
+ * Scratch space is kept in the object and reused, one object should be
+ * used per thread.
+ */
+class PairHMM
+{
+    public:
+
+    float gap_open;
+    float gap_extend;
+
+    /**
+     * Constructor.
+     *
+     * @gap_open   - PHRED scaled gap open probability.
+     * @gap_extend - PHRED scaled gap extension probability.
+     */
+    PairHMM(uint32_t gap_open=45, uint32_t gap_extend=10);
+
+    /**
+     * Destructor.
+     */
+    ~PairHMM();
+
+    /**
+     * Computes log10 likelihoods of a batch of reads against a haplotype.
+     *
+     * @reads - read bases.
+     * @quals - PHRED base qualities, one byte per base without offset.
+     * @lls   - output, must hold reads.size() entries.
+     */
+    void forward(const char* hap, int32_t hlen,
+                 const std::vector<std::string>& reads,
+                 const std::vector<std::string>& quals,
+                 float* lls);
+
+    /**
+     * Computes log10 likelihood of a single read against a haplotype in
+     * double precision.
+     */
+    double forward(const char* hap, int32_t hlen,
+                   const char* read, const char* qual, int32_t rlen);
+
+    private:
+
+    //single precision batch scratch, (hlen+1)*PHMM_LANES each
+    float *m, *i, *d, *pm, *pi, *pd;
+    size_t capacity;
+
+    //double precision scratch, hlen+1 each
+    std::vector<double> dm, di, dd, dpm, dpi, dpd;
+
+    //haplotype bases as emission table indices
+    std::vector<int32_t> hidx;
+
+    //emission lookup by PHRED quality
+    float match_prob[64];
+    float mismatch_prob[64];
+
+    /**
+     * Computes one batch of up to PHMM_LANES reads.
+     */
+    void forward_batch(const char* hap, int32_t hlen,
+                       const std::string** reads,
+                       const std::string** quals,
+                       int32_t no, float* lls);
+};
+
+#endif
@@ -0,0 +1,428 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "parallel_synced_driver.h"
+
+/**
+ * Opens the files and plans the regions.
+ */
+ParallelSyncedDriver::ParallelSyncedDriver(std::vector<std::string>& file_names, std::vector<GenomeInterval>& intervals, bool sync_by_pos, int32_t no_threads)
+{
+    sr = new BCFSyncedReader(file_names, intervals, sync_by_pos);
+    this->file_names = sr->file_names;
+    this->sync_by_pos = sync_by_pos;
+
+    no_workers = 1;
+    next_region = 0;
+    next_flush = 0;
+    window = 0;
+
+    if (no_threads>1 && indexed())
+    {
+        no_workers = no_threads;
+        plan(intervals);
+
+        if (regions.size()>1)
+        {
+            no_workers = std::min(no_threads, (int32_t) regions.size());
+            window = 4*no_workers;
+        }
+        else
+        {
+            no_workers = 1;
+            regions.clear();
+        }
+    }
+}
+
+/**
+ * Closes the readers.
+ */
+ParallelSyncedDriver::~ParallelSyncedDriver()
+{
+    delete sr;
+}
+
+/**
+ * Returns true if the regions are processed in parallel.
+ */
+bool ParallelSyncedDriver::parallel()
+{
+    return regions.size()!=0;
+}
+
+/**
+ * Returns true if all the files have an index, the indices are kept for plan.
+ */
+bool ParallelSyncedDriver::indexed()
+{
+    for (int32_t i=0; i<sr->nfiles; ++i)
+    {
+        if (file_names[i]=="-")
+        {
+            return false;
+        }
+
+        if (!sr->idxs[i] && !sr->tbxs[i] && !sr->load_index(i))
+        {
+            return false;
+        }
+
+        if (!sr->idxs[i] && !sr->tbxs[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Splits the contigs or the given intervals into regions.
+ */
+void ParallelSyncedDriver::plan(std::vector<GenomeInterval>& intervals)
+{
+    //no. of records per contig from the index statistics, -1 if not recorded
+    std::map<std::string, int64_t> counts;
+    std::vector<std::string> seqs;
+    for (int32_t i=0; i<sr->nfiles; ++i)
+    {
+        int32_t nseqs = 0;
+        const char** names = NULL;
+        hts_idx_t* idx = NULL;
+
+        if (sr->idxs[i])
+        {
+            idx = sr->idxs[i];
+            names = bcf_index_seqnames(idx, sr->hdrs[i], &nseqs);
+        }
+        else
+        {
+            idx = sr->tbxs[i]->idx;
+            names = tbx_seqnames(sr->tbxs[i], &nseqs);
+        }
+
+        for (int32_t j=0; j<nseqs; ++j)
+        {
+            int32_t tid = sr->idxs[i] ? bcf_hdr_name2id(sr->hdrs[i], names[j]) : tbx_name2id(sr->tbxs[i], names[j]);
+            uint64_t mapped = 0, unmapped = 0;
+            int64_t n = (tid>=0 && hts_idx_get_stat(idx, tid, &mapped, &unmapped)==0) ? mapped : -1;
+
+            std::string seq(names[j]);
+            if (counts.find(seq)==counts.end())
+            {
+                counts[seq] = n;
+                seqs.push_back(seq);
+            }
+            else if (counts[seq]>=0)
+            {
+                counts[seq] = n<0 ? -1 : counts[seq]+n;
+            }
+        }
+
+        if (names) free(names);
+    }
+
+    //contigs in header order, followed by those only found in the indices
+    std::vector<GenomeInterval> chunks = intervals;
+    if (chunks.size()==0)
+    {
+        int32_t nseqs = 0;
+        const char** names = bcf_hdr_seqnames(sr->hdrs[0], &nseqs);
+        std::map<std::string, int64_t> listed;
+        for (int32_t j=0; j<nseqs; ++j)
+        {
+            std::string seq(names[j]);
+            listed[seq] = 1;
+            if (counts.find(seq)!=counts.end() && counts[seq]!=0)
+            {
+                chunks.push_back(GenomeInterval(seq));
+            }
+        }
+        if (names) free(names);
+
+        for (size_t j=0; j<seqs.size(); ++j)
+        {
+            if (listed.find(seqs[j])==listed.end() && counts[seqs[j]]!=0)
+            {
+                chunks.push_back(GenomeInterval(seqs[j]));
+            }
+        }
+    }
+
+    //regions of about an eighth of the records a worker would process
+    int64_t total = 0;
+    for (std::map<std::string, int64_t>::iterator i=counts.begin(); i!=counts.end(); ++i)
+    {
+        if (i->second>0) total += i->second;
+    }
+    int64_t records_per_region = std::max((int64_t)10000, total/(8*no_workers));
+
+    for (size_t i=0; i<chunks.size(); ++i)
+    {
+        GenomeInterval& interval = chunks[i];
+        std::map<std::string, int64_t>::iterator c = counts.find(interval.seq);
+        int32_t rid = bcf_hdr_name2id(sr->hdrs[0], interval.seq.c_str());
+        int64_t len = rid>=0 ? sr->hdrs[0]->id[BCF_DT_CTG][rid].val->info[0] : 0;
+
+        int64_t n = 1;
+        int64_t start1 = interval.start1;
+        int64_t end1 = len && interval.end1>len ? len : interval.end1;
+        if (c!=counts.end() && c->second>0 && len && end1>start1)
+        {
+            int64_t records = c->second*(end1-start1+1)/len;
+            n = std::min((records+records_per_region-1)/records_per_region, end1-start1+1);
+            n = std::max(n, (int64_t)1);
+        }
+
+        //the first region of an interval keeps the records overlapping its start
+        //as the sequential reader does, the others only take records starting in them
+        for (int64_t j=0; j<n; ++j)
+        {
+            int64_t beg = start1 + (end1-start1+1)*j/n;
+            int64_t end = j==n-1 ? interval.end1 : start1 + (end1-start1+1)*(j+1)/n - 1;
+            regions.push_back(GenomeInterval(interval.seq, beg, end));
+            exclusive.push_back(j!=0);
+        }
+    }
+}
+
+/**
+ * Registers a writer and returns its index for write.
+ */
+int32_t ParallelSyncedDriver::add_writer(BCFOrderedWriter* odw)
+{
+    writers.push_back(odw);
+    return writers.size()-1;
+}
+
+/**
+ * Writes a record for a region.  The record remains owned by the caller.
+ */
+void ParallelSyncedDriver::write(int32_t region, int32_t writer, bcf1_t* v)
+{
+    if (!parallel())
+    {
+        writers[writer]->write(v);
+    }
+    else
+    {
+        //only the worker processing a region writes to its buffer
+        buffers[region][writer].push_back(copy(owners[region], writer, v));
+    }
+}
+
+/**
+ * Returns a copy of a record of a worker expressed in the header of a writer.
+ *
+ * The headers of a worker share the identifiers of the primary reader up to
+ * the definitions the worker added while reading.  A record that uses one of
+ * these is formatted with the header of the worker and parsed with the header
+ * of the writer, which then defines the field or contig as the primary reader
+ * would have.
+ */
+bcf1_t* ParallelSyncedDriver::copy(int32_t worker, int32_t writer, bcf1_t* v)
+{
+    BCFSyncedReader* wsr = readers[worker];
+    int32_t i = wsr->get_file_index(v);
+    if (i==-1)
+    {
+        return bcf_dup(v);
+    }
+
+    bcf_hdr_t* h = wsr->hdrs[i];
+    int32_t nids = no_ids[worker][i];
+    int32_t ncontigs = no_contigs[worker][i];
+    if (h->n[BCF_DT_ID]==nids && h->n[BCF_DT_CTG]==ncontigs)
+    {
+        return bcf_dup(v);
+    }
+
+    bcf_unpack(v, BCF_UN_ALL);
+    bool added = v->rid>=ncontigs;
+    for (int32_t j=0; !added && j<v->d.n_flt; ++j) added = v->d.flt[j]>=nids;
+    for (int32_t j=0; !added && j<v->n_info; ++j) added = v->d.info[j].key>=nids;
+    for (int32_t j=0; !added && j<v->n_fmt; ++j) added = v->d.fmt[j].id>=nids;
+    if (!added)
+    {
+        return bcf_dup(v);
+    }
+
+    kstring_t s = {0,0,0};
+    if (vcf_format(h, v, &s)<0)
+    {
+        fprintf(stderr, "[E:%s:%d %s] cannot format record of %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+        exit(1);
+    }
+    if (s.l && s.s[s.l-1]=='\n') s.s[--s.l] = 0;
+
+    bcf1_t* w = bcf_init1();
+    {
+        std::unique_lock<std::mutex> l(hdr_lock);
+        if (vcf_parse(&s, writers[writer]->hdr, w)<0)
+        {
+            fprintf(stderr, "[E:%s:%d %s] cannot parse record of %s with the output header\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+            exit(1);
+        }
+    }
+    free(s.s);
+
+    return w;
+}
+
+/**
+ * Runs the work over all regions and returns when all records are written.
+ */
+void ParallelSyncedDriver::run(Work work)
+{
+    if (!parallel())
+    {
+        work(0, 0, sr);
+        return;
+    }
+
+    buffers.resize(regions.size(), std::vector<std::vector<bcf1_t*> >(writers.size()));
+    done.resize(regions.size(), false);
+    readers.resize(no_workers, NULL);
+    owners.resize(regions.size(), -1);
+    no_ids.resize(no_workers);
+    no_contigs.resize(no_workers);
+
+    std::vector<std::thread> workers;
+    for (int32_t i=0; i<no_workers; ++i)
+    {
+        workers.push_back(std::thread(&ParallelSyncedDriver::process, this, i, std::ref(work)));
+    }
+
+    //regions are written out in order as they complete
+    for (next_flush=0; next_flush<(int32_t)regions.size(); )
+    {
+        std::vector<std::vector<bcf1_t*> > records;
+        {
+            std::unique_lock<std::mutex> l(lock);
+            while (!done[next_flush])
+            {
+                region_done.wait(l);
+            }
+            records.swap(buffers[next_flush]);
+        }
+
+        for (size_t i=0; i<records.size(); ++i)
+        {
+            for (size_t j=0; j<records[i].size(); ++j)
+            {
+                {
+                    std::unique_lock<std::mutex> l(hdr_lock);
+                    writers[i]->write(records[i][j]);
+                }
+                bcf_destroy(records[i][j]);
+            }
+        }
+
+        std::unique_lock<std::mutex> l(lock);
+        ++next_flush;
+        region_flushed.notify_all();
+    }
+
+    for (size_t i=0; i<workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+}
+
+/**
+ * Opens the reader of a worker.
+ */
+BCFSyncedReader* ParallelSyncedDriver::open(int32_t worker, std::vector<GenomeInterval>& interval)
+{
+    std::vector<std::string> files = file_names;
+    BCFSyncedReader* wsr = new BCFSyncedReader(files, interval, sync_by_pos);
+
+    //the header lines added by the tool keep the identifiers they have in the primary reader
+    {
+        std::unique_lock<std::mutex> l(hdr_lock);
+        for (int32_t i=0; i<wsr->nfiles; ++i)
+        {
+            if (!bcf_hdr_merge(wsr->hdrs[i], sr->hdrs[i]))
+            {
+                fprintf(stderr, "[E:%s:%d %s] cannot copy the header of %s\n", __FILE__, __LINE__, __FUNCTION__, file_names[i].c_str());
+                exit(1);
+            }
+            no_ids[worker].push_back(wsr->hdrs[i]->n[BCF_DT_ID]);
+            no_contigs[worker].push_back(wsr->hdrs[i]->n[BCF_DT_CTG]);
+        }
+    }
+
+    wsr->set_required_fields(sr->unpack, sr->samples);
+    readers[worker] = wsr;
+
+    return wsr;
+}
+
+/**
+ * Worker thread loop.
+ */
+void ParallelSyncedDriver::process(int32_t worker, Work& work)
+{
+    BCFSyncedReader* wsr = NULL;
+
+    while (true)
+    {
+        int32_t region;
+        {
+            std::unique_lock<std::mutex> l(lock);
+
+            //bounds the records held for regions not yet written
+            while (next_region<(int32_t)regions.size() && next_region>=next_flush+window)
+            {
+                region_flushed.wait(l);
+            }
+
+            if (next_region==(int32_t)regions.size())
+            {
+                break;
+            }
+            region = next_region++;
+        }
+
+        std::vector<GenomeInterval> interval(1, regions[region]);
+        if (!wsr)
+        {
+            wsr = open(worker, interval);
+        }
+        wsr->set_intervals(interval, exclusive[region]);
+        owners[region] = worker;
+
+        work(worker, region, wsr);
+
+        std::unique_lock<std::mutex> l(lock);
+        done[region] = true;
+        region_done.notify_all();
+    }
+
+    if (wsr)
+    {
+        wsr->close();
+        delete wsr;
+    }
+}
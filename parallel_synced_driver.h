@@ -0,0 +1,168 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#ifndef PARALLEL_SYNCED_DRIVER_H
+#define PARALLEL_SYNCED_DRIVER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "hts_utils.h"
+#include "genome_interval.h"
+#include "bcf_synced_reader.h"
+#include "bcf_ordered_writer.h"
+
+/**
+ * Runs a tool over a set of synced files, one region at a time on a pool of threads.
+ *
+ * When all the files are indexed and more than one thread is requested, the
+ * contigs (or the intervals given) are split into regions of about the same
+ * number of records.  Each worker owns a BCFSyncedReader that is pointed at one
+ * region after another; a region only returns the records that start in it so
+ * the regions partition the records.  Records written by a region are buffered
+ * and handed to the writers in region order, that is, in the order of the
+ * contigs in the header.
+ *
+ * The reader of a worker opens the files itself and starts with the header lines
+ * of the primary reader, those added by the tool included, and its required fields.
+ * Fields and contigs missing from the headers are defined by each reader as it
+ * meets them, a record that uses such a definition is carried over by name to
+ * the header of the writer it is written to.  The work function should only
+ * use the headers of the reader it is given.
+ *
+ * Otherwise the work is invoked once on the calling thread with the primary
+ * reader and records go straight to the writers.
+ *
+ * The work function is given the index of the worker so that per worker tools
+ * and statistics can be kept and reduced after run returns.
+ *
+ *  ParallelSyncedDriver driver(files, intervals, SYNC_BY_VAR, no_threads);
+ *  int32_t out = driver.add_writer(odw);
+ *  driver.run([&](int32_t worker, int32_t region, BCFSyncedReader* sr)
+ *  {
+ *      while (sr->read_next_position(crecs)) { ... driver.write(region, out, v); }
+ *  });
+ */
+class ParallelSyncedDriver
+{
+    public:
+
+    typedef std::function<void (int32_t worker, int32_t region, BCFSyncedReader* sr)> Work;
+
+    //primary reader, the tool reads its headers and declares its required fields on it
+    BCFSyncedReader* sr;
+
+    //number of workers, per worker state should be prepared for this many workers
+    int32_t no_workers;
+
+    //regions processed in parallel, empty if run sequentially
+    std::vector<GenomeInterval> regions;
+    std::vector<bool> exclusive;
+
+    /**
+     * Opens the files and plans the regions.
+     */
+    ParallelSyncedDriver(std::vector<std::string>& file_names, std::vector<GenomeInterval>& intervals, bool sync_by_pos, int32_t no_threads);
+
+    /**
+     * Closes the readers.
+     */
+    ~ParallelSyncedDriver();
+
+    /**
+     * Returns true if the regions are processed in parallel.
+     */
+    bool parallel();
+
+    /**
+     * Registers a writer and returns its index for write.
+     */
+    int32_t add_writer(BCFOrderedWriter* odw);
+
+    /**
+     * Writes a record for a region.  The record remains owned by the caller.
+     */
+    void write(int32_t region, int32_t writer, bcf1_t* v);
+
+    /**
+     * Runs the work over all regions and returns when all records are written.
+     */
+    void run(Work work);
+
+    private:
+
+    std::vector<std::string> file_names;
+    bool sync_by_pos;
+    std::vector<BCFOrderedWriter*> writers;
+
+    //records buffered per region and writer
+    std::vector<std::vector<std::vector<bcf1_t*> > > buffers;
+    std::vector<bool> done;
+
+    //reader of each worker, the worker of each region and the number of
+    //identifiers and contigs in the headers of a worker when it was opened
+    std::vector<BCFSyncedReader*> readers;
+    std::vector<int32_t> owners;
+    std::vector<std::vector<int32_t> > no_ids;
+    std::vector<std::vector<int32_t> > no_contigs;
+
+    int32_t next_region;
+    int32_t next_flush;
+    int32_t window;
+
+    std::mutex lock;
+    std::condition_variable region_done;
+    std::condition_variable region_flushed;
+
+    //guards the headers of the primary reader and of the writers
+    std::mutex hdr_lock;
+
+    /**
+     * Returns true if all the files have an index, the indices are kept for plan.
+     */
+    bool indexed();
+
+    /**
+     * Splits the contigs or the given intervals into regions.
+     */
+    void plan(std::vector<GenomeInterval>& intervals);
+
+    /**
+     * Opens the reader of a worker.
+     */
+    BCFSyncedReader* open(int32_t worker, std::vector<GenomeInterval>& interval);
+
+    /**
+     * Returns a copy of a record of a worker expressed in the header of a writer.
+     */
+    bcf1_t* copy(int32_t worker, int32_t writer, bcf1_t* v);
+
+    /**
+     * Worker thread loop.
+     */
+    void process(int32_t worker, Work& work);
+};
+
+#endif
@@ -68,29 +68,36 @@ class Igor : Program
     std::vector<GenomeInterval> intervals;
     std::string interval_list;
     bool write_partition;
+    int32_t no_threads;
 
     ///////
     //i/o//
     ///////
+    ParallelSyncedDriver *driver;
     BCFSyncedReader *sr;
+    BCFOrderedWriter *a;
+    BCFOrderedWriter *ab[2];
+    BCFOrderedWriter *b;
+    int32_t out_a, out_ab[2], out_b;
 
     //////////
     //filter//
     //////////
     std::vector<std::string> fexps;
     std::string fexp;
-    Filter filters[2];
+    std::vector<Filter*> filters[2];
     bool filter_exists[2];
         
     /////////
     //stats//
     /////////
     OverlapStats stats;
+    std::vector<OverlapStats> worker_stats;
 
     ////////////////
     //common tools//
     ////////////////
-    VariantManip *vm;
+    std::vector<VariantManip*> vms;
 
     Igor(int argc, char ** argv)
     {
@@ -108,6 +115,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_interval_list("I", "I", "file containing list of intervals []", false, "", "file", cmd);
             TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter", false, "", "str", cmd);
             TCLAP::SwitchArg arg_write_partition("w", "w", "write partitioned variants to file", cmd, false);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the inputs are indexed [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledMultiArg<std::string> arg_input_vcf_files("<in1.vcf><in2.vcf>", "2 input VCF files for comparison", true, "files", cmd);
 
             cmd.parse(argc, argv);
@@ -121,6 +129,7 @@ class Igor : Program
             }
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
             write_partition = arg_write_partition.getValue();
+            no_threads = arg_no_threads.getValue();
             input_vcf_files = arg_input_vcf_files.getValue();
 
             if (input_vcf_files.size()!=2)
@@ -141,65 +150,106 @@ class Igor : Program
         //////////////////////
         //i/o initialization//
         //////////////////////
-        sr = new BCFSyncedReader(input_vcf_files, intervals, SYNC_BY_VAR);
+        driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+        sr = driver->sr;
+
+        if (write_partition)
+        {
+            a = new BCFOrderedWriter("a-b.bcf");
+            a->link_hdr(sr->hdrs[0]);
+            a->write_hdr();
+            ab[0] = new BCFOrderedWriter("a&b1.bcf");
+            ab[0]->link_hdr(sr->hdrs[0]);
+            ab[0]->write_hdr();
+            ab[1] = new BCFOrderedWriter("a&b2.bcf");
+            ab[1]->link_hdr(sr->hdrs[1]);
+            ab[1]->write_hdr();
+            b = new BCFOrderedWriter("b-a.bcf");
+            b->link_hdr(sr->hdrs[1]);
+            b->write_hdr();
+
+            out_a = driver->add_writer(a);
+            out_ab[0] = driver->add_writer(ab[0]);
+            out_ab[1] = driver->add_writer(ab[1]);
+            out_b = driver->add_writer(b);
+        }
 
         ///////////////////////
         //tool initialization//
         ///////////////////////
-        vm = new VariantManip("");
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            vms.push_back(new VariantManip(""));
+        }
 
         /////////////////////////
         //filter initialization//
         /////////////////////////
-        if (fexps.size()==1)
-        {
-            filters[0].parse(fexps[0].c_str());
-            filter_exists[0] = true;
-            filters[1].parse(fexps[0].c_str());
-            filter_exists[1] = true;
-        }
-        else if (fexps.size()==2)
+        filter_exists[0] = false;
+        filter_exists[1] = false;
+        for (int32_t i=0; i<driver->no_workers; ++i)
         {
-            filters[0].parse(fexps[0].c_str());
-            filter_exists[0] = true;
-            filters[1].parse(fexps[1].c_str());
-            filter_exists[1] = true;
+            filters[0].push_back(new Filter());
+            filters[1].push_back(new Filter());
+
+            if (fexps.size()==1)
+            {
+                filters[0][i]->parse(fexps[0].c_str());
+                filter_exists[0] = true;
+                filters[1][i]->parse(fexps[0].c_str());
+                filter_exists[1] = true;
+            }
+            else if (fexps.size()==2)
+            {
+                filters[0][i]->parse(fexps[0].c_str());
+                filter_exists[0] = true;
+                filters[1][i]->parse(fexps[1].c_str());
+                filter_exists[1] = true;
+            }
         }
         
         ////////////////////////
         //stats initialization//
         ////////////////////////
+        worker_stats.resize(driver->no_workers);
     }
 
     void partition()
     {
-        //for combining the alleles
-        std::vector<bcfptr*> crecs;
-        Variant variant;
-        std::vector<int32_t> presence(2, 0);
+        driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { partition(worker, region, sr); });
+
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            OverlapStats& w = worker_stats[i];
+            stats.a += w.a; stats.ab += w.ab; stats.b += w.b;
+            stats.a_ts += w.a_ts; stats.ab_ts += w.ab_ts; stats.b_ts += w.b_ts;
+            stats.a_tv += w.a_tv; stats.ab_tv += w.ab_tv; stats.b_tv += w.b_tv;
+            stats.a_ins += w.a_ins; stats.ab_ins += w.ab_ins; stats.b_ins += w.b_ins;
+            stats.a_del += w.a_del; stats.ab_del += w.ab_del; stats.b_del += w.b_del;
+        }
 
-        BCFOrderedWriter *a;
-        BCFOrderedWriter *ab[2];
-        BCFOrderedWriter *b;
         if (write_partition)
         {
-            a = new BCFOrderedWriter("a-b.bcf");
-            a->link_hdr(sr->hdrs[0]);
-            a->write_hdr();
-            ab[0] = new BCFOrderedWriter("a&b1.bcf");
-            ab[0]->link_hdr(sr->hdrs[0]);
-            ab[0]->write_hdr();
-            ab[1] = new BCFOrderedWriter("a&b2.bcf");
-            ab[1]->link_hdr(sr->hdrs[1]);
-            ab[1]->write_hdr();
-            b = new BCFOrderedWriter("b-a.bcf");
-            b->link_hdr(sr->hdrs[1]);
-            b->write_hdr();
+            a->close();
+            ab[0]->close();
+            ab[1]->close();
+            b->close();
         }
+    };
+
+    /**
+     * Partitions the variants of a region.
+     */
+    void partition(int32_t worker, int32_t region, BCFSyncedReader* sr)
+    {
+        //for combining the alleles
+        std::vector<bcfptr*> crecs;
+        Variant variant;
+        std::vector<int32_t> presence(2, 0);
 
         while(sr->read_next_position(crecs))
         {
-            int32_t vtype = vm->classify_variant(crecs[0]->h, crecs[0]->v, variant);
+            int32_t vtype = vms[worker]->classify_variant(crecs[0]->h, crecs[0]->v, variant);
 
             //check existence
             for (int32_t i=0; i<crecs.size(); ++i)
@@ -208,7 +258,7 @@ class Igor : Program
 
                 if (filter_exists[index])
                 {
-                    if (!filters[index].apply(crecs[i]->h,crecs[i]->v, &variant))
+                    if (!filters[index][worker]->apply(crecs[i]->h,crecs[i]->v, &variant))
                     {
                         continue;
                     }
@@ -230,7 +280,7 @@ class Igor : Program
                 del += alleles[i].dlen ? 1-variant.alleles[i].ins : 0;
             }
 
-            update_overlap_stats(presence, ts, tv, ins, del);
+            update_overlap_stats(worker_stats[worker], presence, ts, tv, ins, del);
 
             if (write_partition)
             {
@@ -238,34 +288,26 @@ class Igor : Program
                 {
                     if (presence[1])
                     {
-                        ab[crecs[0]->file_index]->write(crecs[0]->v);
-                        ab[crecs[1]->file_index]->write(crecs[1]->v);
+                        driver->write(region, out_ab[crecs[0]->file_index], crecs[0]->v);
+                        driver->write(region, out_ab[crecs[1]->file_index], crecs[1]->v);
                     }
                     else
                     {
-                        a->write(crecs[0]->v);
+                        driver->write(region, out_a, crecs[0]->v);
                     }
                 }
                 else if (presence[1])
                 {
-                    b->write(crecs[0]->v);
+                    driver->write(region, out_b, crecs[0]->v);
                 }
             }
 
             presence[0] = 0;
             presence[1] = 0;
         }
-
-        if (write_partition)
-        {
-            a->close();
-            ab[0]->close();
-            ab[1]->close();
-            b->close();
-        }
     };
 
-    void update_overlap_stats(std::vector<int32_t>& presence, int32_t ts,  int32_t tv, int32_t ins, int32_t del)
+    void update_overlap_stats(OverlapStats& stats, std::vector<int32_t>& presence, int32_t ts,  int32_t tv, int32_t ins, int32_t del)
     {
         //update overlap stats
         if (presence[0] && !presence[1])
@@ -322,6 +364,7 @@ class Igor : Program
             std::clog << "         [w] write_partition    false\n";
 
         }
+        print_num_op("         [t] no. of threads     ", no_threads);
         print_int_op("         [i] intervals          ", intervals);
         std::clog << "\n";
    }
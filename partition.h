@@ -25,6 +25,7 @@
 #define PARTITION_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
 
 void partition(int argc, char ** argv);
 
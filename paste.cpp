@@ -26,6 +26,131 @@
 namespace
 {
 
+/**
+ * Reads the next record of every input file, the files are split between
+ * threads that read and unpack the FORMAT fields of their records concurrently.
+ */
+class ParallelRecordReader
+{
+    public:
+
+    std::vector<BCFOrderedReader*>& odrs;
+    std::vector<bcf1_t*> vs;
+
+    ParallelRecordReader(std::vector<BCFOrderedReader*>& odrs, int32_t no_threads)
+        : odrs(odrs)
+    {
+        for (size_t i=0; i<odrs.size(); ++i)
+        {
+            vs.push_back(bcf_init());
+        }
+
+        this->no_threads = std::max(1, std::min(no_threads, (int32_t) odrs.size()));
+        round = 0;
+        pending = 0;
+        no_read = 0;
+        stop = false;
+
+        //the calling thread reads the first share of the files
+        for (int32_t t=1; t<this->no_threads; ++t)
+        {
+            threads.push_back(std::thread(&ParallelRecordReader::run, this, t));
+        }
+    }
+
+    ~ParallelRecordReader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        work.notify_all();
+
+        for (size_t t=0; t<threads.size(); ++t)
+        {
+            threads[t].join();
+        }
+
+        for (size_t i=0; i<vs.size(); ++i)
+        {
+            bcf_destroy(vs[i]);
+        }
+    }
+
+    /**
+     * Reads a record from every file.
+     * Returns false if any of the files is exhausted.
+     */
+    bool read()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++round;
+            pending = threads.size();
+            no_read = 0;
+        }
+        work.notify_all();
+
+        int32_t n = read_share(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]{ return pending==0; });
+        no_read += n;
+
+        return no_read==(int32_t) vs.size();
+    }
+
+    private:
+
+    int32_t no_threads;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable done;
+    uint64_t round;
+    int32_t pending;
+    int32_t no_read;
+    bool stop;
+
+    int32_t read_share(int32_t t)
+    {
+        int32_t n = 0;
+        for (size_t i=t; i<vs.size(); i+=no_threads)
+        {
+            if (odrs[i]->read(vs[i]))
+            {
+                bcf_unpack(vs[i], BCF_UN_FMT);
+                ++n;
+            }
+        }
+
+        return n;
+    }
+
+    void run(int32_t t)
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work.wait(lock, [this, seen]{ return stop || round!=seen; });
+                if (stop) return;
+                seen = round;
+            }
+
+            int32_t n = read_share(t);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                no_read += n;
+                --pending;
+            }
+            done.notify_one();
+        }
+    }
+};
+
 class Igor : Program
 {
     public:
@@ -38,6 +163,7 @@ class Igor : Program
     std::vector<std::string> input_vcf_files;
     std::string input_vcf_file_list;
     std::string output_vcf_file;
+    int32_t no_threads;
     bool print;
 
     ///////
@@ -70,11 +196,12 @@ class Igor : Program
                  "              Input requirements and assumptions:\n"
                  "              1. Same variants are represented in the same order for each file (required)\n"
                  "              2. Genotype fields are the same for corresponding records (required)\n"
-                 "              3. Sample names are different in all the files (warning will be given if not)\n"
+                 "              3. Sample names are different in all the files (required, duplicates are reported and are an error)\n"
                  "              4. Headers (not including the samples) are the same for all the files (unchecked assumption, will fail if output is BCF)\n"
                  "              Outputs:\n"
                  "              1. INFO fields output will be that of the first file\n"
-                 "              2. Genotype fields are the same for corresponding records\n";
+                 "              2. Genotype fields are the same for corresponding records\n"
+                 "              3. Genotype fields are copied without re-encoding unless their width differs between files\n";
 
 
             version = "0.5";
@@ -83,6 +210,7 @@ class Igor : Program
             TCLAP::SwitchArg arg_print("p", "p", "print options and summary []", cmd, false);
             TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "", cmd);
             TCLAP::ValueArg<std::string> arg_input_vcf_file_list("L", "L", "file containing list of input VCF files", false, "", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads decoding the input files [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledMultiArg<std::string> arg_input_vcf_files("<in1.vcf>...", "Multiple VCF files",false, "files", cmd);
 
             cmd.parse(argc, argv);
@@ -92,6 +220,7 @@ class Igor : Program
             parse_files(input_vcf_files, arg_input_vcf_files.getValue(), arg_input_vcf_file_list.getValue());
             const std::vector<std::string>& v = arg_input_vcf_files.getValue();
             print = arg_print.getValue();
+            no_threads = arg_no_threads.getValue();
 
             if (input_vcf_files.size()==0)
             {
@@ -138,8 +267,10 @@ class Igor : Program
 
         //add all sample names to output vcf header and warn if there are more than one occurence of a sample
         int32_t no_samples = bcf_hdr_nsamples(odw->hdr);
+        int32_t no_input_samples = no_samples;
         for (size_t i=1; i<nfiles; ++i)
         {
+            no_input_samples += bcf_hdr_nsamples(odrs[i]->hdr);
             for (size_t j=0; j<bcf_hdr_nsamples(odrs[i]->hdr); ++j)
             {
                 if (bcf_hdr_id2int(odw->hdr, BCF_DT_SAMPLE, bcf_hdr_get_sample_name(odrs[i]->hdr, j))==-1)
@@ -155,184 +286,90 @@ class Igor : Program
         }
         bcf_hdr_add_sample(odw->hdr, NULL);
 
-        odw->write_hdr();
-
-        std::vector<bcfptr*> current_recs;
-        int ncount =0;
+        if (no_samples!=no_input_samples)
+        {
+            fprintf(stderr, "[E:%s:%d %s] samples have to be unique across the input files.\n", __FILE__, __LINE__, __FUNCTION__);
+            exit(1);
+        }
 
-        std::vector<bcfptr*> sample2record(no_samples, NULL);
-        std::vector<int32_t> sample2index(no_samples, -1);
+        odw->write_hdr();
 
-        bcf1_t* vs[nfiles];
         bcf1_t *nv = bcf_init();
+        ParallelRecordReader prr(odrs, no_threads);
+        kstring_t indiv = {0,0,0};
 
-        for (size_t i =0; i<nfiles; ++i)
+        while (prr.read())
         {
-            vs[i]= bcf_init();
-        }
-
-        std::vector<std::string> genotype_fields;
+            std::vector<bcf1_t*>& vs = prr.vs;
 
-        while(true)
-        {
-            size_t read_no = 0;
-            for (size_t i =0; i<nfiles; ++i)
+            //check consistency of FORMAT
+            for (size_t i=1; i<nfiles; ++i)
             {
-                if (odrs[i]->read(vs[i]))
+                if (vs[0]->n_fmt!=vs[i]->n_fmt)
                 {
-                    bcf_unpack(vs[i], BCF_UN_FMT);
-                    ++read_no;
+                    fprintf(stderr, "[E:%s:%d %s] FORMAT not consistent between files %s %s.\n", __FILE__, __LINE__, __FUNCTION__, input_vcf_files[0].c_str(),  input_vcf_files[i].c_str());
+                    exit(1);
                 }
-            }
-
-            if (read_no!=nfiles)
-            {
-                break;
-            }
 
-            bcf_copy(nv, vs[0]);
-            int32_t nval_per_sample[vs[0]->n_fmt];
-            int32_t size[vs[0]->n_fmt];
-            //check consistency of FORMAT
-            for (size_t i=1; i<nfiles; ++i)
-            {
-                if (vs[0]->n_fmt==vs[i]->n_fmt)
+                for (size_t j=0; j<vs[0]->n_fmt; ++j)
                 {
-                    for (size_t j=0; j<vs[0]->n_fmt; ++j)
+                    const char* a = bcf_get_format(odrs[0]->hdr, vs[0], j);
+                    const char* b = bcf_get_format(odrs[i]->hdr, vs[i], j);
+                    if (strcmp(a,b))
                     {
-                        const char* a = bcf_get_format(odrs[0]->hdr, vs[0], j);
-                        const char* b = bcf_get_format(odrs[i]->hdr, vs[i], j);
-                        if (i==1)
-                        {
-                            nval_per_sample[j] = vs[0]->d.fmt[j].n > vs[1]->d.fmt[j].n ? vs[0]->d.fmt[j].n : vs[1]->d.fmt[j].n;
-                        }
-                        else
-                        {
-                            nval_per_sample[j] = nval_per_sample[j] > vs[i]->d.fmt[j].n ? nval_per_sample[j] : vs[i]->d.fmt[j].n;
-                        }
-                        if (i==1)
-                        {
-                            size[j] = vs[0]->d.fmt[j].size > vs[1]->d.fmt[j].size ? vs[0]->d.fmt[j].size : vs[1]->d.fmt[j].size;
-                        }
-                        else
-                        {
-                            size[j] = size[j] > vs[i]->d.fmt[j].size ? size[j] : vs[i]->d.fmt[j].size;
-                        }
-                        if (strcmp(a,b))
-                        {
-                            fprintf(stderr, "[E:%s:%d %s] FORMAT not consistent between files %s %s.\n", __FILE__, __LINE__, __FUNCTION__, input_vcf_files[0].c_str(),  input_vcf_files[i].c_str());
-                            exit(1);
-                        }
+                        fprintf(stderr, "[E:%s:%d %s] FORMAT not consistent between files %s %s.\n", __FILE__, __LINE__, __FUNCTION__, input_vcf_files[0].c_str(),  input_vcf_files[i].c_str());
+                        exit(1);
                     }
                 }
-                else
-                {
-                    fprintf(stderr, "[E:%s:%d %s] FORMAT not consistent between files %s %s.\n", __FILE__, __LINE__, __FUNCTION__, input_vcf_files[0].c_str(),  input_vcf_files[i].c_str());
-                    exit(1);
-                }
             }
 
-            //for each format, construct array
-            for (size_t i=0; i<vs[0]->n_fmt; ++i)
+            //splice the encoded per sample blocks of each FORMAT field
+            indiv.l = 0;
+            for (size_t j=0; j<vs[0]->n_fmt; ++j)
             {
-                const char* genotype_field = bcf_get_format(odrs[0]->hdr, vs[0], i);
-
-                if (vs[0]->d.fmt[i].type == BCF_BT_INT8 ||
-                    vs[0]->d.fmt[i].type == BCF_BT_INT16 ||
-                    vs[0]->d.fmt[i].type == BCF_BT_INT32)
+                int32_t type = vs[0]->d.fmt[j].type;
+                int32_t n = vs[0]->d.fmt[j].n;
+                bool identical = true;
+                for (size_t i=1; i<nfiles; ++i)
                 {
-                    int32_t ndst = no_samples * nval_per_sample[i] * sizeof(int32_t);
-
-                    int32_t *data = (int32_t *) malloc(ndst);
-                    int32_t *p = data;
-                    int32_t np = no_samples * nval_per_sample[i];
-
-                    for (size_t j=0; j<nfiles; ++j)
+                    bcf_fmt_t& fmt = vs[i]->d.fmt[j];
+                    if (fmt.type!=type || fmt.n!=n)
                     {
-                        int32_t b = bcf_get_format_int32(odrs[j]->hdr, vs[j], genotype_field, &p, &np);
-                        p = p+bcf_hdr_nsamples(odrs[j]->hdr)*vs[j]->d.fmt[i].n;
-                        np = np-bcf_hdr_nsamples(odrs[j]->hdr)*nval_per_sample[i];
-
-                        if (vs[j]->d.fmt[i].n<nval_per_sample[i])
-                        {
-                            int32_t steps = bcf_hdr_nsamples(odrs[j]->hdr)*(nval_per_sample[i] - vs[j]->d.fmt[i].n);
-                            while (steps)
-                            {
-                                p[0] = *(p-1);
-                                ++p;
-                                --steps;
-                            }
-                        }
+                        identical = false;
+                        type = widen_type(type, fmt.type, input_vcf_files[i]);
+                        n = std::max(n, fmt.n);
                     }
-
-                    bcf_update_format_int32(odw->hdr, nv, genotype_field, data, no_samples * vs[0]->d.fmt[i].n);
-                    free(data);
                 }
-                else if (vs[0]->d.fmt[i].type == BCF_BT_FLOAT)
-                {
-                    int32_t ndst = no_samples * nval_per_sample[i] * sizeof(float);
 
-                    float *data = (float *) malloc(ndst);
-                    float *p = data;
-                    int32_t np = no_samples * nval_per_sample[i];
+                bcf_enc_int1(&indiv, vs[0]->d.fmt[j].id);
+                bcf_enc_size(&indiv, n, type);
 
-                    for (size_t j=0; j<nfiles; ++j)
+                if (identical)
+                {
+                    for (size_t i=0; i<nfiles; ++i)
                     {
-                        int32_t b = bcf_get_format_float(odrs[j]->hdr, vs[j], genotype_field, &p, &np);
-                        p = p+bcf_hdr_nsamples(odrs[j]->hdr)*vs[j]->d.fmt[i].n;
-                        np = np-bcf_hdr_nsamples(odrs[j]->hdr)*nval_per_sample[i];
-
-                        if (vs[j]->d.fmt[i].n<nval_per_sample[i])
-                        {
-                            int32_t steps = bcf_hdr_nsamples(odrs[j]->hdr)*(nval_per_sample[i] - vs[j]->d.fmt[i].n);
-                            while (steps)
-                            {
-                                p[0] = *(p-1);
-                                ++p;
-                                --steps;
-                            }
-                        }
+                        kputsn((char*) vs[i]->d.fmt[j].p, vs[i]->n_sample*vs[i]->d.fmt[j].size, &indiv);
                     }
-
-                    bcf_update_format_float(odw->hdr, nv, genotype_field, data, no_samples * vs[0]->d.fmt[i].n);
-                    free(data);
                 }
-                else if (vs[0]->d.fmt[i].type == BCF_BT_CHAR)
+                else
                 {
-                    int32_t ndst = no_samples * sizeof(char *);
-
-                    char **data = (char **) malloc(ndst);
-                    int32_t cp = 0;
-
-                    for (size_t j=0; j<nfiles; ++j)
+                    for (size_t i=0; i<nfiles; ++i)
                     {
-                        char** p = NULL;
-                        int32_t np = 0;
-                        int32_t b = bcf_get_format_char(odrs[j]->hdr, vs[j], genotype_field, &p, &np);
-                        
-                        for (size_t k=0; k<bcf_hdr_nsamples(odrs[j]->hdr); ++k)
-                        {
-                            data[cp+k] = p[k];
-                            ++cp;    
-                        }
-                        free(p);
+                        append_widened(&indiv, vs[i]->d.fmt[j], vs[i]->n_sample, type, n);
                     }
-
-                    bcf_update_format_string(odw->hdr, nv, genotype_field, const_cast<const char**>(data), no_samples * vs[0]->d.fmt[i].n);
-                    
-                    cp = 0;
-                    for (size_t j=0; j<nfiles; ++j)
-                    {
-                        free(data[cp]);
-                        cp += bcf_hdr_nsamples(odrs[j]->hdr);
-                    }                    
-                    free(data);
                 }
             }
 
+            bcf_copy(nv, vs[0]);
+            nv->n_sample = no_samples;
+            nv->indiv.l = 0;
+            kputsn(indiv.s, indiv.l, &nv->indiv);
+
             odw->write(nv);
         }
 
+        if (indiv.m) free(indiv.s);
+
         for (size_t i=0; i<nfiles; ++i)
         {
             odrs[i]->close();
@@ -341,6 +378,95 @@ class Igor : Program
         odw->close();
     };
 
+    /**
+     * Returns the wider of two BCF types, FORMAT fields may only be widened within integers.
+     */
+    int32_t widen_type(int32_t a, int32_t b, std::string& file)
+    {
+        if (a==b)
+        {
+            return a;
+        }
+        else if (a<=BCF_BT_INT32 && b<=BCF_BT_INT32)
+        {
+            return std::max(a, b);
+        }
+
+        fprintf(stderr, "[E:%s:%d %s] FORMAT types not consistent between files %s %s.\n", __FILE__, __LINE__, __FUNCTION__, input_vcf_files[0].c_str(), file.c_str());
+        exit(1);
+    }
+
+    /**
+     * Appends the per sample values of fmt to s, converted to type and padded to n values.
+     * Integers keep their missing and vector end markers, padding uses the vector end marker,
+     * strings are padded with NULs.
+     */
+    void append_widened(kstring_t* s, bcf_fmt_t& fmt, int32_t no_samples, int32_t type, int32_t n)
+    {
+        if (type==BCF_BT_CHAR)
+        {
+            for (int32_t k=0; k<no_samples; ++k)
+            {
+                kputsn((char*) fmt.p + k*fmt.size, fmt.n, s);
+                for (int32_t l=fmt.n; l<n; ++l) kputc('\0', s);
+            }
+        }
+        else if (type==BCF_BT_FLOAT)
+        {
+            uint32_t vector_end = bcf_float_vector_end;
+            for (int32_t k=0; k<no_samples; ++k)
+            {
+                kputsn((char*) fmt.p + k*fmt.size, fmt.size, s);
+                for (int32_t l=fmt.n; l<n; ++l) kputsn((char*) &vector_end, 4, s);
+            }
+        }
+        else
+        {
+            for (int32_t k=0; k<no_samples; ++k)
+            {
+                uint8_t* p = fmt.p + k*fmt.size;
+                for (int32_t l=0; l<n; ++l)
+                {
+                    int32_t x = bcf_int32_vector_end;
+                    if (l<fmt.n)
+                    {
+                        switch (fmt.type)
+                        {
+                            case BCF_BT_INT8:
+                                x = le_to_i8(p+l);
+                                x = x==bcf_int8_missing ? bcf_int32_missing : (x==bcf_int8_vector_end ? bcf_int32_vector_end : x);
+                                break;
+                            case BCF_BT_INT16:
+                                x = le_to_i16(p+2*l);
+                                x = x==bcf_int16_missing ? bcf_int32_missing : (x==bcf_int16_vector_end ? bcf_int32_vector_end : x);
+                                break;
+                            default:
+                                x = le_to_i32(p+4*l);
+                        }
+                    }
+
+                    if (type==BCF_BT_INT8)
+                    {
+                        int8_t y = x==bcf_int32_missing ? bcf_int8_missing : (x==bcf_int32_vector_end ? bcf_int8_vector_end : x);
+                        kputc_(y, s);
+                    }
+                    else if (type==BCF_BT_INT16)
+                    {
+                        uint8_t b[2];
+                        i16_to_le(x==bcf_int32_missing ? bcf_int16_missing : (x==bcf_int32_vector_end ? bcf_int16_vector_end : x), b);
+                        kputsn((char*) b, 2, s);
+                    }
+                    else
+                    {
+                        uint8_t b[4];
+                        i32_to_le(x, b);
+                        kputsn((char*) b, 4, s);
+                    }
+                }
+            }
+        }
+    }
+
     void print_options()
     {
         if (!print) return;
@@ -348,6 +474,7 @@ class Igor : Program
         std::clog << "paste v" << version << "\n\n";
         print_ifiles("options:     input VCF file        ", input_vcf_files);
         std::clog << "         [o] output VCF file       " << output_vcf_file << "\n";
+        print_num_op("         [t] no. of threads        ", no_threads);
         std::clog << "\n";
     }
 
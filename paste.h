@@ -24,7 +24,11 @@
 #ifndef PASTE_H
 #define PASTE_H
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "program.h"
+#include "htslib/hts_endian.h"
 
 bool paste(int argc, char ** argv);
 
@@ -41,20 +41,87 @@ class Igor : Program
     bool print;
     std::vector<GenomeInterval> intervals;
     int32_t maxBQ;
+    int32_t window;
+    int32_t no_threads;
 
     ///////
     //i/o//
     ///////
     BCFOrderedReader *odr;
+    std::vector<BCFOrderedReader*> odrs;
     BCFOrderedWriter *odw;
+    bcf1_t *v;
+    bcf1_t *nv;
 
     ///////////////
     //general use//
     ///////////////
 
+    //statistics of a site, for a file and summed over the files
+    typedef struct
+    {
+        float bqr_num, bqr_den;
+        float mqr_num, mqr_den;
+        float cyr_num, cyr_den;
+        float str_num, str_den;
+        float nmr_num, nmr_den;
+        float ior_num, ior_den;
+        float nm0_num, nm0_den;
+        float nm1_num, nm1_den;
+        float ab_num, ab_den;
+        float abz_num, abz_den;
+        int32_t ns_nref;
+        int32_t dp_sum;
+    } site_stats_t;
+
+    //a site of the current window and the genotype fields of every file
+    typedef struct
+    {
+        bool is_snp;
+        int32_t rid;
+        int32_t pos;
+        int32_t rlen;
+        int32_t n_allele;
+        int32_t n_geno;
+        std::vector<std::string> alleles;
+        std::vector<int32_t> filts;
+        std::vector<int32_t> pls;
+        std::vector<int32_t> ads;
+        std::vector<int32_t> gts;
+        std::vector<int32_t> gqs;
+        std::vector<int32_t> ods;
+        std::vector<site_stats_t> file_stats;
+        int32_t max_gq;
+    } site_t;
+
+    //reads the files [beg,end) into the sites of the window
+    typedef struct
+    {
+        int32_t beg;
+        int32_t end;
+        bcf1_t *v;
+        int32_t *p_bqsum, np_bqsum;
+        int32_t *p_dp, np_dp;
+        int32_t *p_gt, np_gt;
+        int32_t *p_pl, np_pl;
+        int32_t *p_bq, np_bq;
+        int32_t *p_mq, np_mq;
+        int32_t *p_cy, np_cy;
+        char **p_st; int32_t np_st;
+        int32_t *p_al, np_al;
+        int32_t *p_nm, np_nm;
+    } worker_t;
+
+    int32_t nfiles;
+    std::vector<worker_t*> workers;
+    std::vector<bool> skips;
+    std::vector<site_t> sites;
+    int32_t no_sites;
+
     /////////
     //stats//
     /////////
+    int32_t no_sites_written;
 
     /////////
     //tools//
@@ -92,6 +159,8 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_intervals("i","i","Intervals[]", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_interval_list("I", "I", "file containing list of intervals []", false, "", "file", cmd);
             TCLAP::ValueArg<int32_t> arg_max_bq("q", "q", "Maximum base quality to cap []", false, 30, "int", cmd);
+            TCLAP::ValueArg<int32_t> arg_window("w", "w", "no. of sites held in memory [1000]", false, 1000, "int", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, the files are split between them [1]", false, 1, "int", cmd);
 
             cmd.parse(argc, argv);
 
@@ -101,6 +170,8 @@ class Igor : Program
             const std::vector<std::string>& v = arg_input_vcf_files.getValue();
             print = arg_print.getValue();
             maxBQ = arg_max_bq.getValue();
+            window = std::max(arg_window.getValue(), 1);
+            no_threads = std::max(arg_no_threads.getValue(), 1);
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
 
             if (input_vcf_files.size()==0)
@@ -130,10 +201,6 @@ class Igor : Program
             exit(1);
         }
 
-        //for (size_t i=0; i<input_vcf_files.size(); ++i)
-        //{
-        //    odrs.push_back(new BCFOrderedReader(input_vcf_files[i], intervals));
-        //}
         odw = new BCFOrderedWriter(output_vcf_file, 0);
 
         odw->set_hdr(odr->hdr);
@@ -166,13 +233,45 @@ class Igor : Program
         bcf_hdr_append(odw->hdr, "##FORMAT=<ID=OD,Number=1,Type=Integer,Description=\"Other Allele Depth\">\n");
         bcf_hdr_append(odw->hdr, "##FORMAT=<ID=PL,Number=G,Type=Integer,Description=\"Phred-scale Genotype Likelihoods\">\n");
 
+        // the genotype files are read in lockstep
+        nfiles = input_vcf_files.size();
+        for (int32_t i=0; i<nfiles; ++i)
+        {
+            odrs.push_back(new BCFOrderedReader(input_vcf_files[i], intervals));
+
+            if ( bcf_hdr_nsamples(odrs[i]->hdr) != 1 ) {
+                fprintf(stderr, "[E:%s:%d %s] The genotype file must contain exactly one sample", __FILE__, __LINE__, __FUNCTION__);
+                exit(1);
+            }
+            if ( i > 0 )
+              bcf_hdr_add_sample(odw->hdr, bcf_hdr_get_sample_name(odrs[i]->hdr, 0));
+        }
+        bcf_hdr_add_sample(odw->hdr, NULL);
+
+        odw->write_hdr();
+
         ///////////////
         //general use//
         ///////////////
+        v = bcf_init();
+        nv = bcf_init();
+        sites.resize(window);
+        no_sites = 0;
+
+        no_threads = std::min(no_threads, nfiles);
+        for (int32_t j=0; j<no_threads; ++j)
+        {
+            worker_t* w = new worker_t();
+            w->beg = (int64_t)nfiles*j/no_threads;
+            w->end = (int64_t)nfiles*(j+1)/no_threads;
+            w->v = bcf_init();
+            workers.push_back(w);
+        }
 
         ////////////////////////
         //stats initialization//
         ////////////////////////
+        no_sites_written = 0;
 
         /////////
         //tools//
@@ -224,226 +323,237 @@ class Igor : Program
     // Assume that either
     // BQSUM : DPF : DPR or
     // GT, PL, DP, CY, ST, NM exists
+    //
+    // The files are read in lockstep, window sites at a time, the files
+    // being split between the workers.  A site is written out once every
+    // file has passed it so only the sites of a window are kept in memory.
+    // The statistics of each file are kept apart and summed in the order of
+    // the files, so the output does not depend on the window or the threads.
 
-    // store everything into memory
-    std::vector<int32_t> vn_alleles;
-    std::vector<int32_t> vn_genos;
-    std::vector<int32_t*> v_pls;
-    std::vector<int32_t*> v_gts;
-    std::vector<int32_t*> v_gqs;
-    std::vector<int32_t*> v_ads;
-    std::vector<int32_t*> v_ods;
-
-    // check the type from FORMAT, first field must be either BQSUM or GT
-    int32_t* p_bqsum = NULL;
-    int32_t np_bqsum = 0;
-    int32_t* p_dp = NULL;
-    int32_t np_dp = 0;
-    int32_t* p_gt = NULL;
-    int32_t np_gt = 0;
-    int32_t* p_pl = NULL;
-    int32_t np_pl = 0;
-    int32_t* p_bq = NULL;
-    int32_t np_bq = 0;
-    int32_t* p_mq = NULL;
-    int32_t np_mq = 0;
-    int32_t* p_cy = NULL;
-    int32_t np_cy = 0;
-    char**   p_st = NULL;
-    int32_t np_st = 0;
-    int32_t*  p_al = NULL;
-    int32_t np_al = 0;
-    int32_t* p_nm = NULL;
-    int32_t np_nm = 0;
-
-    // read the first genotype file to populate
-    int32_t nfiles = input_vcf_files.size();
-    std::vector<bool> v_skips;
-    std::vector<bool> v_is_snps;
-    std::vector<int32_t> v_rids;
-    std::vector<int32_t> v_poss;
-    std::vector<int32_t> v_rlens;
-    std::vector< std::vector<std::string> > v_d_alleles;
-    std::vector< std::vector<int32_t> > v_filts;
-
-        bcf1_t* v = bcf_init();
-    while( odr->read(v) ) {
-      // skip multi-allelics
-      bool skip = false;
-      bcf_unpack(v, BCF_UN_ALL);
-
-      if ( v->n_allele > 2 ) skip = true;
-      else if ( ( !intervals.empty() ) && ( ( v->pos < intervals[0].start1 ) || ( v->pos > intervals[0].end1 ) ) ) skip = true;
-      else {
-        bool is_vntr = false;
-        for(size_t i=0; i < v->n_allele; ++i) {
-          if ( strcmp(v->d.allele[i],"<VNTR>") == 0 )
-        is_vntr = true;
+        while (read_block())
+        {
+            if (workers.size()==1)
+            {
+                process_block(workers[0]);
+            }
+            else
+            {
+                std::vector<std::thread> threads;
+                for (size_t j=0; j<workers.size(); ++j)
+                {
+                    threads.push_back(std::thread(&Igor::process_block, this, workers[j]));
+                }
+                for (size_t j=0; j<threads.size(); ++j)
+                {
+                    threads[j].join();
+                }
+            }
+
+            //every file has passed the sites of the block
+            for (int32_t k=0; k<no_sites; ++k)
+            {
+                site_stats_t stats;
+                reduce(sites[k], stats);
+                write_site(sites[k], stats);
+            }
         }
-        if ( is_vntr ) skip = true;
-      }
 
-      // determine whether to skip the marker or not
-      v_skips.push_back(skip);
-      if ( skip ) continue;
-
-      // populate marker information
-      v_is_snps.push_back(bcf_is_snp(v));
-      v_rids.push_back(v->rid);
-      v_poss.push_back(v->pos);
-      v_rlens.push_back(v->rlen);
-      v_d_alleles.push_back(std::vector<std::string>());
-      for(size_t i=0; i < v->n_allele; ++i) {
-        v_d_alleles.back().push_back(v->d.allele[i]);
-      }
-      vn_alleles.push_back(v->n_allele);
-      vn_genos.push_back(v->n_allele * (v->n_allele+1)/2);
+        odr->close();
+        for (int32_t i=0; i<nfiles; ++i)
+        {
+            odrs[i]->close();
+        }
+        odw->close();
+    };
 
-      v_filts.push_back(std::vector<int32_t>());
-      for(size_t i=0; i < v->d.n_flt; ++i) {
-        v_filts.back().push_back(v->d.flt[i]);
-      }
+    /**
+     * Reads the next block of at most window sites from the anchor file.
+     * Returns false when there are no more records.
+     */
+    bool read_block()
+    {
+        skips.clear();
+        no_sites = 0;
 
-      // initialize genotype fields
-      v_pls.push_back( (int32_t*)calloc( nfiles * vn_genos.back(), sizeof(int32_t) ) );
-      v_ads.push_back( (int32_t*)calloc( nfiles * vn_alleles.back(), sizeof(int32_t) ) );
-      v_gts.push_back( (int32_t*)calloc( nfiles * 2, sizeof(int32_t) ) );
-      v_gqs.push_back( (int32_t*)calloc( nfiles, sizeof(int32_t) ) );
-      v_ods.push_back( (int32_t*)calloc( nfiles, sizeof(int32_t) ) );
+        while (no_sites<window && odr->read(v))
+        {
+            // skip multi-allelics
+            bool skip = false;
+            bcf_unpack(v, BCF_UN_ALL);
+
+            if ( v->n_allele > 2 ) skip = true;
+            else if ( ( !intervals.empty() ) && ( ( v->pos < intervals[0].start1 ) || ( v->pos > intervals[0].end1 ) ) ) skip = true;
+            else {
+              bool is_vntr = false;
+              for(size_t i=0; i < v->n_allele; ++i) {
+                if ( strcmp(v->d.allele[i],"<VNTR>") == 0 )
+              is_vntr = true;
+              }
+              if ( is_vntr ) skip = true;
+            }
+
+            // determine whether to skip the marker or not
+            skips.push_back(skip);
+            if ( skip ) continue;
+
+            // populate marker information
+            site_t& site = sites[no_sites++];
+            site.is_snp = bcf_is_snp(v);
+            site.rid = v->rid;
+            site.pos = v->pos;
+            site.rlen = v->rlen;
+            site.n_allele = v->n_allele;
+            site.n_geno = v->n_allele * (v->n_allele+1)/2;
+            site.alleles.resize(v->n_allele);
+            for(size_t i=0; i < v->n_allele; ++i) {
+              site.alleles[i].assign(v->d.allele[i]);
+            }
+            site.filts.assign(v->d.flt, v->d.flt + v->d.n_flt);
+
+            // initialize genotype fields
+            site.pls.assign(nfiles * site.n_geno, 0);
+            site.ads.assign(nfiles * site.n_allele, 0);
+            site.gts.assign(nfiles * 2, 0);
+            site.gqs.assign(nfiles, 0);
+            site.ods.assign(nfiles, 0);
+            site.file_stats.resize(nfiles);
+            site.max_gq = 0;
+        }
+
+        return !skips.empty();
     }
-    odr->close();
-    delete odr;
-
-    std::vector<float> v_bqr_nums(v_rids.size(), 0);
-    std::vector<float> v_bqr_dens(v_rids.size(), 0);
-    std::vector<float> v_mqr_nums(v_rids.size(), 0);
-    std::vector<float> v_mqr_dens(v_rids.size(), 0);
-    std::vector<float> v_cyr_nums(v_rids.size(), 0);
-    std::vector<float> v_cyr_dens(v_rids.size(), 0);
-    std::vector<float> v_str_nums(v_rids.size(), 0);
-    std::vector<float> v_str_dens(v_rids.size(), 0);
-    std::vector<float> v_nmr_nums(v_rids.size(), 0);
-    std::vector<float> v_nmr_dens(v_rids.size(), 0);
-    std::vector<float> v_ior_nums(v_rids.size(), 0);
-    std::vector<float> v_ior_dens(v_rids.size(), 0);
-    std::vector<float> v_nm0_nums(v_rids.size(), 0);
-    std::vector<float> v_nm0_dens(v_rids.size(), 0);
-    std::vector<float> v_nm1_nums(v_rids.size(), 0);
-    std::vector<float> v_nm1_dens(v_rids.size(), 0);
-    std::vector<float> v_ab_nums(v_rids.size(), 0);
-    std::vector<float> v_ab_dens(v_rids.size(), 0);
-    std::vector<float> v_abz_nums(v_rids.size(), 0);
-    std::vector<float> v_abz_dens(v_rids.size(), 0);
-    std::vector<int32_t> v_ns_nrefs(v_rids.size(), 0);
-    std::vector<int32_t> v_dp_sums(v_rids.size(), 0);
-    std::vector<int32_t> v_max_gqs(v_rids.size(), 0);
-
-    bcf_clear(v);
-
-    for(size_t i=0; i < nfiles; ++i) {
-      fprintf(stderr,"Reading input file %s..\n", input_vcf_files[i].c_str());
-      // set odr and v
-      odr = new BCFOrderedReader(input_vcf_files[i], intervals);
-      v = bcf_init();
-
-      if ( bcf_hdr_nsamples(odr->hdr) != 1 ) {
-          fprintf(stderr, "[E:%s:%d %s] The genotype file must contain exactly one sample", __FILE__, __LINE__, __FUNCTION__);
-          exit(1);
-      }
-      if ( i > 0 )
-        bcf_hdr_add_sample(odw->hdr, bcf_hdr_get_sample_name(odr->hdr, 0));
 
-      for( size_t j=0, k=0; j < v_skips.size(); ++j) {
-        if ( ! odr->read(v) ) {
-          fprintf(stderr, "[E:%s:%d %s] Cannot read variant from genotype files. j=%zu, k=%zu, pos[k]=%d", __FILE__, __LINE__, __FUNCTION__, j, k, v_poss[k]);
-          exit(1);
+    /**
+     * Reads the current block from the files of a worker and computes the site statistics of each file.
+     */
+    void process_block(worker_t* w)
+    {
+        for (int32_t i=w->beg; i<w->end; ++i)
+        {
+            BCFOrderedReader* odr = odrs[i];
+            bcf1_t* v = w->v;
+
+            for (size_t j=0, k=0; j<skips.size(); ++j)
+            {
+                if ( ! odr->read(v) ) {
+                  fprintf(stderr, "[E:%s:%d %s] Cannot read variant from genotype files. j=%zu, k=%zu, pos[k]=%d", __FILE__, __LINE__, __FUNCTION__, j, k, sites[k].pos);
+                  exit(1);
+                }
+                if ( skips[j] ) continue;
+                bcf_unpack(v, BCF_UN_ALL);
+
+                site_stats_t& stats = sites[k].file_stats[i];
+                memset(&stats, 0, sizeof(site_stats_t));
+                process_site(w, i, odr->hdr, v, sites[k], stats);
+                ++k;
+            }
         }
-        if ( v_skips[j] ) continue;
-        bcf_unpack(v, BCF_UN_ALL);
+    }
 
+    /**
+     * Adds the genotype fields of the ith file at a site.
+     */
+    void process_site(worker_t* w, int32_t i, bcf_hdr_t* hdr, bcf1_t* v, site_t& site, site_stats_t& stats)
+    {
         // check marker infor with anchor files
-        if ( ( v->rid != v_rids[k] ) || ( v->pos != v_poss[k] ) || ( v->rlen != v_rlens[k] ) || ( v->n_allele != vn_alleles[k] ) ) {
+        if ( ( v->rid != site.rid ) || ( v->pos != site.pos ) || ( v->rlen != site.rlen ) || ( v->n_allele != site.n_allele ) ) {
           fprintf(stderr, "[E:%s:%d %s] Variant position or ref alleles does not match\n", __FILE__, __LINE__, __FUNCTION__);
           exit(1);
         }
 
-        for(size_t l=0; l < vn_alleles[k]; ++l) {
-          if ( v_d_alleles[k][l].compare(v->d.allele[l]) ) {
+        for(size_t l=0; l < site.n_allele; ++l) {
+          if ( site.alleles[l].compare(v->d.allele[l]) ) {
           fprintf(stderr, "[E:%s:%d %s] Variant alleles does not match\n", __FILE__, __LINE__, __FUNCTION__);
           exit(1);
           }
         }
 
+        int32_t n_allele = site.n_allele;
+        int32_t n_geno = site.n_geno;
+
         // extract genotype fields and calculate summary statistics
-        if ( bcf_get_format_int32(odr->hdr, v, "BQSUM", &p_bqsum, &np_bqsum) >= 0 ) { // BQSUM observed - REF-ONLY
-          if ( bcf_get_format_int32(odr->hdr, v, "DP", &p_dp, &np_dp) < 0 ) {
+        if ( bcf_get_format_int32(hdr, v, "BQSUM", &w->p_bqsum, &w->np_bqsum) >= 0 ) { // BQSUM observed - REF-ONLY
+          if ( bcf_get_format_int32(hdr, v, "DP", &w->p_dp, &w->np_dp) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- BQSUM, DP\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( ( np_bqsum != np_dp ) || ( np_dp != 1 ) ) {
+          if ( ( w->np_bqsum != w->np_dp ) || ( w->np_dp != 1 ) ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not have the samme number of fields -- BQSUM, DP\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
 
-          for(size_t l=0; l < vn_alleles[k]; ++l){
-        v_ads[k][ i*vn_alleles[k] + l] = (l == 0 ? p_dp[0] : 0);
-        v_ods[k][ i ] = 0;
+          int32_t* p_bqsum = w->p_bqsum;
+          int32_t* p_dp = w->p_dp;
+
+          for(size_t l=0; l < n_allele; ++l){
+        site.ads[ i*n_allele + l] = (l == 0 ? p_dp[0] : 0);
+        site.ods[ i ] = 0;
         for(size_t m=0; m <= l; ++m)  {
           if ( m == 0 ) {
             if ( l == 0 )
-              v_pls[k][vn_genos[k] * i + l * (l+1) / 2 + m] = 0;
+              site.pls[n_geno * i + l * (l+1) / 2 + m] = 0;
             else
-              v_pls[k][vn_genos[k] * i + l * (l+1) / 2 + m] = (int32_t)floor(6.931472 * p_dp[0] + 0.5);
+              site.pls[n_geno * i + l * (l+1) / 2 + m] = (int32_t)floor(6.931472 * p_dp[0] + 0.5);
           }
           else
-            v_pls[k][vn_genos[k] * i + l * (l+1) / 2 + m] = (int32_t)floor(p_bqsum[0] + 10.98612 * p_dp[0] + 0.5);
+            site.pls[n_geno * i + l * (l+1) / 2 + m] = (int32_t)floor(p_bqsum[0] + 10.98612 * p_dp[0] + 0.5);
           }
           }
-          v_dp_sums[k] += p_dp[0];
+          stats.dp_sum += p_dp[0];
         }
-        else if ( bcf_get_genotypes(odr->hdr, v, &p_gt, &np_gt) >= 0 ) {  // GT unobserved -- non-REF
+        else if ( bcf_get_genotypes(hdr, v, &w->p_gt, &w->np_gt) >= 0 ) {  // GT unobserved -- non-REF
           // extract PL, DP, BQ, MQ, CY, ST, AL, NM
-          if ( bcf_get_format_int32(odr->hdr, v, "PL", &p_pl, &np_pl) < 0 ) {
+          if ( bcf_get_format_int32(hdr, v, "PL", &w->p_pl, &w->np_pl) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- PL\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( bcf_get_format_int32(odr->hdr, v, "DP", &p_dp, &np_dp) < 0 ) {
+          if ( bcf_get_format_int32(hdr, v, "DP", &w->p_dp, &w->np_dp) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- DP\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( bcf_get_format_int32(odr->hdr, v, "BQ", &p_bq, &np_bq) < 0 ) {
+          if ( bcf_get_format_int32(hdr, v, "BQ", &w->p_bq, &w->np_bq) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- BQ\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( bcf_get_format_int32(odr->hdr, v, "MQ", &p_mq, &np_mq) < 0 ) {
+          if ( bcf_get_format_int32(hdr, v, "MQ", &w->p_mq, &w->np_mq) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- MQ\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( bcf_get_format_int32(odr->hdr, v, "CY", &p_cy, &np_cy) < 0 ) {
+          if ( bcf_get_format_int32(hdr, v, "CY", &w->p_cy, &w->np_cy) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- GT, CY\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( bcf_get_format_string(odr->hdr, v, "ST", &p_st, &np_st) < 0 ) {
+          if ( bcf_get_format_string(hdr, v, "ST", &w->p_st, &w->np_st) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- GT, ST\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( bcf_get_format_int32(odr->hdr, v, "AL", &p_al, &np_al) < 0 ) {
+          if ( bcf_get_format_int32(hdr, v, "AL", &w->p_al, &w->np_al) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- GT, AL\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
-          if ( bcf_get_format_int32(odr->hdr, v, "NM", &p_nm, &np_nm) < 0 ) {
+          if ( bcf_get_format_int32(hdr, v, "NM", &w->p_nm, &w->np_nm) < 0 ) {
         fprintf(stderr, "[E:%s:%d %s] FORMAT field does not contain expected fields -- GT, NM\n", __FILE__, __LINE__, __FUNCTION__);
         exit(1);
           }
 
+          int32_t* p_gt = w->p_gt;
+          int32_t* p_pl = w->p_pl;
+          int32_t* p_dp = w->p_dp;
+          int32_t* p_bq = w->p_bq;
+          int32_t* p_mq = w->p_mq;
+          int32_t* p_cy = w->p_cy;
+          char** p_st = w->p_st;
+          int32_t* p_al = w->p_al;
+          int32_t* p_nm = w->p_nm;
+
           // sanity checking
-          if ( np_pl != vn_genos[k] ) {
-        fprintf(stderr, "[E:%s:%d %s] np_pl (%d) != n_genos (%d)\n", __FILE__, __LINE__, __FUNCTION__, np_pl, vn_genos[k]);
+          if ( w->np_pl != n_geno ) {
+        fprintf(stderr, "[E:%s:%d %s] np_pl (%d) != n_genos (%d)\n", __FILE__, __LINE__, __FUNCTION__, w->np_pl, n_geno);
         exit(1);
           }
 
-          if ( ( np_dp != 1 ) || ( np_gt != 2 ) ) {
-        fprintf(stderr, "[E:%s:%d %s] Assertion failed in np_dp (%d) == np_gt (%d),  np_st (%d) == np_al (%d)\n", __FILE__, __LINE__, __FUNCTION__, np_dp, np_gt, np_st, np_al);
+          if ( ( w->np_dp != 1 ) || ( w->np_gt != 2 ) ) {
+        fprintf(stderr, "[E:%s:%d %s] Assertion failed in np_dp (%d) == np_gt (%d),  np_st (%d) == np_al (%d)\n", __FILE__, __LINE__, __FUNCTION__, w->np_dp, w->np_gt, w->np_st, w->np_al);
         exit(1);
           }
           if ( p_dp[0] != strlen(p_st[0]) ) {
@@ -455,11 +565,11 @@ class Igor : Program
           int32_t a1 = bcf_gt_allele(p_gt[0]);
           int32_t a2 = bcf_gt_allele(p_gt[1]);
           int32_t gt = bcf_alleles2gt(a1, a2);
-          for(size_t l=0; l < vn_genos[k]; ++l) {
-        v_pls[k][vn_genos[k] * i + l] = p_pl[l];
+          for(size_t l=0; l < n_geno; ++l) {
+        site.pls[n_geno * i + l] = p_pl[l];
           }
 
-          v_dp_sums[k] += p_dp[0];
+          stats.dp_sum += p_dp[0];
 
           int32_t bq_s1 = 0;
           int32_t bq_s2 = 0;
@@ -481,9 +591,9 @@ class Igor : Program
           double  oth_exp_q20 = 0;
           double  oth_obs_q20 = 0;
 
-          int32_t* ads_z = &v_ads[k][ i*vn_alleles[k] ];
+          int32_t* ads_z = &site.ads[ i*n_allele ];
 
-          ++v_ns_nrefs[k];
+          ++stats.ns_nref;
 
           for(size_t l=0; l < p_dp[0]; ++l) {
         if ( p_bq[l] > maxBQ ) p_bq[l] = maxBQ;
@@ -495,7 +605,7 @@ class Igor : Program
           }
 
           // calculate cycle-based tail distance
-          float log_td = 0-logf((float)abs(v_is_snps[k] ? p_cy[l] : (int)(rand() % 100))+1.); // temporarily ignore cycles
+          float log_td = 0-logf((float)abs(site.is_snp ? p_cy[l] : noise(i, site.pos, l))+1.); // temporarily ignore cycles
 
           ++dp_ra;
           bq_s1 += p_bq[l];
@@ -528,7 +638,7 @@ class Igor : Program
             ++oth_obs_q20;
             ++dp_q20;
           }
-          ++v_ods[k][i];
+          ++site.ods[i];
         }
           }
 
@@ -542,12 +652,12 @@ class Igor : Program
           float w_ref_s1 = log(dp_ra-al_s1+1.);
 
           if ( gt == 1 ) { // het genotypes
-        v_ab_nums[k] += (w_dp_ra * (dp_ra - al_s1 + 0.05) / (double)(dp_ra + 0.1));
-        v_ab_dens[k] += w_dp_ra;
+        stats.ab_num += (w_dp_ra * (dp_ra - al_s1 + 0.05) / (double)(dp_ra + 0.1));
+        stats.ab_den += w_dp_ra;
 
         // E(r) = 0.5(r+a) V(r) = 0.25(r+a)
-        v_abz_nums[k] += w_dp_ra * (dp_ra - al_s1 - dp_ra*0.5)/sqrt(0.25 * dp_ra + 1e-3);
-        v_abz_dens[k] += (w_dp_ra * w_dp_ra);
+        stats.abz_num += w_dp_ra * (dp_ra - al_s1 - dp_ra*0.5)/sqrt(0.25 * dp_ra + 1e-3);
+        stats.abz_den += (w_dp_ra * w_dp_ra);
 
         float bqr = sqrt_dp_ra * compute_correlation( dp_ra, bq_al, bq_s1, bq_s2, al_s1, al_s1, .1 );
         float mqr = sqrt_dp_ra * compute_correlation( dp_ra, mq_al, mq_s1, mq_s2, al_s1, al_s1, .1 );
@@ -556,57 +666,75 @@ class Igor : Program
         float nmr = sqrt_dp_ra * compute_correlation( dp_ra, nm_al, nm_s1, nm_s2, al_s1, al_s1, .1 );
 
         // Use Stouffer's method to combine the z-scores, but weighted by log of sample size
-        v_bqr_nums[k] += (bqr * w_dp_ra); v_bqr_dens[k] += (w_dp_ra * w_dp_ra);
-        v_mqr_nums[k] += (mqr * w_dp_ra); v_mqr_dens[k] += (w_dp_ra * w_dp_ra);
-        v_cyr_nums[k] += (cyr * w_dp_ra); v_cyr_dens[k] += (w_dp_ra * w_dp_ra);
-        v_str_nums[k] += (str * w_dp_ra); v_str_dens[k] += (w_dp_ra * w_dp_ra);
-        v_nmr_nums[k] += (nmr * w_dp_ra); v_nmr_dens[k] += (w_dp_ra * w_dp_ra);
+        stats.bqr_num += (bqr * w_dp_ra); stats.bqr_den += (w_dp_ra * w_dp_ra);
+        stats.mqr_num += (mqr * w_dp_ra); stats.mqr_den += (w_dp_ra * w_dp_ra);
+        stats.cyr_num += (cyr * w_dp_ra); stats.cyr_den += (w_dp_ra * w_dp_ra);
+        stats.str_num += (str * w_dp_ra); stats.str_den += (w_dp_ra * w_dp_ra);
+        stats.nmr_num += (nmr * w_dp_ra); stats.nmr_den += (w_dp_ra * w_dp_ra);
           }
 
-          v_ior_nums[k] += (ior * w_dp_q20); v_ior_dens[k] += w_dp_q20;
-          v_nm1_nums[k] += (nm1 * w_al_s1);  v_nm1_dens[k] += w_al_s1;
-          v_nm0_nums[k] += (nm0 * w_ref_s1); v_nm0_dens[k] += w_ref_s1;
+          stats.ior_num += (ior * w_dp_q20); stats.ior_den += w_dp_q20;
+          stats.nm1_num += (nm1 * w_al_s1);  stats.nm1_den += w_al_s1;
+          stats.nm0_num += (nm0 * w_ref_s1); stats.nm0_den += w_ref_s1;
         }
-
-        ++k;
-      }
-      odr->close();
-      delete odr;
     }
-        bcf_hdr_add_sample(odw->hdr, NULL);
 
-        odw->write_hdr();
-
-    bcf1_t* nv = bcf_init();
+    /**
+     * Sums the statistics of the files for a site, in the order of the files.
+     */
+    void reduce(site_t& site, site_stats_t& s)
+    {
+        memset(&s, 0, sizeof(site_stats_t));
+        for (int32_t i=0; i<nfiles; ++i)
+        {
+            site_stats_t& w = site.file_stats[i];
+            s.bqr_num += w.bqr_num; s.bqr_den += w.bqr_den;
+            s.mqr_num += w.mqr_num; s.mqr_den += w.mqr_den;
+            s.cyr_num += w.cyr_num; s.cyr_den += w.cyr_den;
+            s.str_num += w.str_num; s.str_den += w.str_den;
+            s.nmr_num += w.nmr_num; s.nmr_den += w.nmr_den;
+            s.ior_num += w.ior_num; s.ior_den += w.ior_den;
+            s.nm0_num += w.nm0_num; s.nm0_den += w.nm0_den;
+            s.nm1_num += w.nm1_num; s.nm1_den += w.nm1_den;
+            s.ab_num += w.ab_num; s.ab_den += w.ab_den;
+            s.abz_num += w.abz_num; s.abz_den += w.abz_den;
+            s.ns_nref += w.ns_nref;
+            s.dp_sum += w.dp_sum;
+        }
+    }
 
-    for(size_t k=0; k < v_rids.size(); ++k) {
+    /**
+     * Computes the features of a site and writes it out.
+     */
+    void write_site(site_t& site, site_stats_t& stats)
+    {
       bcf_clear(nv);
-      nv->rid = v_rids[k];
-      nv->pos = v_poss[k];
-      nv->rlen = v_rlens[k];
+      nv->rid = site.rid;
+      nv->pos = site.pos;
+      nv->rlen = site.rlen;
       nv->n_sample = nfiles;
 
-      const char* tmp_d_alleles[vn_alleles[k]];
-      for(int l=0; l < vn_alleles[k]; ++l)
-        tmp_d_alleles[l] = v_d_alleles[k][l].c_str();
-      bcf_update_alleles(odw->hdr, nv, tmp_d_alleles, vn_alleles[k]);
+      int32_t n_allele = site.n_allele;
+      int32_t n_geno = site.n_geno;
+      int32_t* pls = &site.pls[0];
 
-      if ( !v_filts[k].empty() ) {
-        int tmp_filts[v_filts[k].size()];
-        for(size_t l=0; l < v_filts[k].size(); ++l) {
-          tmp_filts[l] = v_filts[k][l];
-        }
-        bcf_update_filter(odw->hdr, nv, tmp_filts, (int32_t)v_filts[k].size());
+      const char* tmp_d_alleles[n_allele];
+      for(int l=0; l < n_allele; ++l)
+        tmp_d_alleles[l] = site.alleles[l].c_str();
+      bcf_update_alleles(odw->hdr, nv, tmp_d_alleles, n_allele);
+
+      if ( !site.filts.empty() ) {
+        bcf_update_filter(odw->hdr, nv, &site.filts[0], (int32_t)site.filts.size());
       }
 
       bcf_unpack(nv, BCF_UN_ALL);
 
       // calculate the allele frequencies under HWE
-      float MLE_HWE_AF[vn_alleles[k]];
-      float MLE_HWE_GF[vn_genos[k]];
+      float MLE_HWE_AF[n_allele];
+      float MLE_HWE_GF[n_geno];
       int32_t ploidy = 2; // temporarily constant
       int32_t n = 0;
-      Estimator::compute_gl_af_hwe(v_pls[k], nfiles, ploidy, vn_alleles[k], MLE_HWE_AF, MLE_HWE_GF,  n, 1e-20);
+      Estimator::compute_gl_af_hwe(pls, nfiles, ploidy, n_allele, MLE_HWE_AF, MLE_HWE_GF,  n, 1e-20);
 
       // calculate the genotypes (diploid only)
       double gp, gp_sum, max_gp;
@@ -614,18 +742,18 @@ class Igor : Program
       int32_t best_a1, best_a2;
       int32_t* pls_i;
       int32_t an = 0;
-      int32_t acs[vn_alleles[k]];
-      int32_t gcs[vn_genos[k]];
-      float afs[vn_alleles[k]];
+      int32_t acs[n_allele];
+      int32_t gcs[n_geno];
+      float afs[n_allele];
 
-      memset(acs, 0, sizeof(int32_t)*vn_alleles[k]);
-      memset(gcs, 0, sizeof(int32_t)*vn_genos[k]);
+      memset(acs, 0, sizeof(int32_t)*n_allele);
+      memset(gcs, 0, sizeof(int32_t)*n_geno);
 
       for(size_t i=0; i < nfiles; ++i) {
-        pls_i = &v_pls[k][ i * vn_genos[k] ];
+        pls_i = &pls[ i * n_geno ];
         max_gp = gp_sum = gp = ( LogTool::pl2prob(pls_i[0]) * MLE_HWE_AF[0] * MLE_HWE_AF[0] );
         best_gt = 0; best_a1 = 0; best_a2 = 0;
-        for(size_t l=1; l < vn_alleles[k]; ++l) {
+        for(size_t l=1; l < n_allele; ++l) {
           for(size_t m=0; m <= l; ++m) {
         gp = ( LogTool::pl2prob(pls_i[ l*(l+1)/2 + m]) * MLE_HWE_AF[l] * MLE_HWE_AF[m] * (l == m ? 1 : 2) );
         gp_sum += gp;
@@ -642,59 +770,58 @@ class Igor : Program
         if ( prob > 1 )
           prob = 1;
 
-        v_gqs[k][i] = (int32_t)LogTool::prob2pl(prob);
+        site.gqs[i] = (int32_t)LogTool::prob2pl(prob);
 
-        if ( ( best_gt > 0 ) && ( v_max_gqs[k] < v_gqs[k][i] ) )
-          v_max_gqs[k] = v_gqs[k][i];
+        if ( ( best_gt > 0 ) && ( site.max_gq < site.gqs[i] ) )
+          site.max_gq = site.gqs[i];
 
-        v_gts[k][2*i]   = ((best_a1 + 1) << 1);
-        v_gts[k][2*i+1] = ((best_a2 + 1) << 1);
+        site.gts[2*i]   = ((best_a1 + 1) << 1);
+        site.gts[2*i+1] = ((best_a2 + 1) << 1);
         an += 2;
         ++acs[best_a1];
         ++acs[best_a2];
         ++gcs[best_gt];
       }
 
-      for(size_t i=0; i < vn_alleles[k]; ++i) {
+      for(size_t i=0; i < n_allele; ++i) {
         afs[i] = acs[i]/(float)an;
       }
 
-      bcf_update_format_int32(odw->hdr, nv, "GT", v_gts[k], nfiles * 2);
-      bcf_update_format_int32(odw->hdr, nv, "GQ", v_gqs[k], nfiles );
-      bcf_update_format_int32(odw->hdr, nv, "AD", v_ads[k], nfiles * vn_alleles[k]);
-      bcf_update_format_int32(odw->hdr, nv, "OD", v_ods[k], nfiles );
-      bcf_update_format_int32(odw->hdr, nv, "PL", v_pls[k], nfiles * vn_genos[k]);
+      bcf_update_format_int32(odw->hdr, nv, "GT", &site.gts[0], nfiles * 2);
+      bcf_update_format_int32(odw->hdr, nv, "GQ", &site.gqs[0], nfiles );
+      bcf_update_format_int32(odw->hdr, nv, "AD", &site.ads[0], nfiles * n_allele);
+      bcf_update_format_int32(odw->hdr, nv, "OD", &site.ods[0], nfiles );
+      bcf_update_format_int32(odw->hdr, nv, "PL", pls, nfiles * n_geno);
 
-      float avgdp = (float)v_dp_sums[k]/(float)nfiles;
+      float avgdp = (float)stats.dp_sum/(float)nfiles;
 
-      nv->qual = (float) v_max_gqs[k];
+      nv->qual = (float) site.max_gq;
       bcf_update_info_float(odw->hdr, nv, "AVGDP", &avgdp, 1);
-      bcf_update_info_int32(odw->hdr, nv, "AC", &acs[1], vn_alleles[k]-1);
+      bcf_update_info_int32(odw->hdr, nv, "AC", &acs[1], n_allele-1);
       bcf_update_info_int32(odw->hdr, nv, "AN", &an, 1);
-      bcf_update_info_float(odw->hdr, nv, "AF", &afs[1], vn_alleles[k]-1);
-      bcf_update_info_int32(odw->hdr, nv, "GC", gcs, vn_genos[k]);
+      bcf_update_info_float(odw->hdr, nv, "AF", &afs[1], n_allele-1);
+      bcf_update_info_int32(odw->hdr, nv, "GC", gcs, n_geno);
       bcf_update_info_int32(odw->hdr, nv, "GN", &nfiles, 1);
 
       if (n) {
         float* MLE_HWE_AF_PTR = &MLE_HWE_AF[1];
-        bcf_update_info_float(odw->hdr, nv, "HWEAF", MLE_HWE_AF_PTR, vn_alleles[k]-1);
+        bcf_update_info_float(odw->hdr, nv, "HWEAF", MLE_HWE_AF_PTR, n_allele-1);
         //bcf_update_info_float(odw->hdr, nv, "HWEGF", &MLE_HWE_GF, n_genos);
       }
 
       // calculate the allele frequencies under HWD
-      float MLE_AF[vn_alleles[k]];
-      float MLE_GF[vn_genos[k]];
+      float MLE_AF[n_allele];
+      float MLE_GF[n_geno];
       n = 0;
-      Estimator::compute_gl_af(v_pls[k], nfiles, ploidy, vn_alleles[k], MLE_AF, MLE_GF,  n, 1e-20);
+      Estimator::compute_gl_af(pls, nfiles, ploidy, n_allele, MLE_AF, MLE_GF,  n, 1e-20);
       if (n) {
-        float* MLE_AF_PTR = &MLE_AF[1];
-        //bcf_update_info_float(odw->hdr, nv, "HWDAF", MLE_AF_PTR, n_alleles-1);
-        bcf_update_info_float(odw->hdr, nv, "HWDGF", &MLE_GF, vn_genos[k]);
+        //bcf_update_info_float(odw->hdr, nv, "HWDAF", &MLE_AF[1], n_alleles-1);
+        bcf_update_info_float(odw->hdr, nv, "HWDGF", &MLE_GF, n_geno);
       }
 
       float fic = 0;
       n = 0;
-      Estimator::compute_gl_fic(v_pls[k], nfiles, ploidy, MLE_HWE_AF, vn_alleles[k], MLE_GF, fic, n);
+      Estimator::compute_gl_fic(pls, nfiles, ploidy, MLE_HWE_AF, n_allele, MLE_GF, fic, n);
       if ( std::isnan((double)fic) ) fic = 0;
       if (n) {
         bcf_update_info_float(odw->hdr, nv, "IBC", &fic, 1);
@@ -705,33 +832,44 @@ class Igor : Program
       float logp;
       int32_t df;
       n = 0;
-      Estimator::compute_hwe_lrt(v_pls[k], nfiles, ploidy, vn_alleles[k], MLE_HWE_GF, MLE_GF, n, lrts, logp, df);
+      Estimator::compute_hwe_lrt(pls, nfiles, ploidy, n_allele, MLE_HWE_GF, MLE_GF, n, lrts, logp, df);
       if (n) {
         if ( fic > 0 ) logp = 0-logp;
         bcf_update_info_float(odw->hdr, nv, "HWE_SLP", &logp, 1);
       }
 
       // add additional annotations
-      v_ns_nrefs[k] -= (nfiles - gcs[0]);
-      bcf_update_info_int32(odw->hdr, nv, "NS_NREF", &v_ns_nrefs[k], 1);
-      v_ab_nums[k] /= (v_ab_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "ABE",  &v_ab_nums[k], 1);
-      v_abz_nums[k] /= sqrt(v_abz_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "ABZ",  &v_abz_nums[k], 1);
-      v_bqr_nums[k] /= sqrt(v_bqr_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "BQZ", &v_bqr_nums[k], 1);
-      v_mqr_nums[k] /= sqrt(v_mqr_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "MQZ", &v_mqr_nums[k], 1);
-      v_cyr_nums[k] /= sqrt(v_cyr_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "CYZ", &v_cyr_nums[k], 1);
-      v_str_nums[k] /= sqrt(v_str_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "STZ", &v_str_nums[k], 1);
-      v_nmr_nums[k] /= sqrt(v_nmr_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "NMZ", &v_nmr_nums[k], 1);
-      v_ior_nums[k] = log(v_ior_nums[k]/v_ior_dens[k]+1e-6)/log(10.); bcf_update_info_float(odw->hdr, nv, "IOR", &v_ior_nums[k], 1);
-      v_nm1_nums[k] /= (v_nm1_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "NM1", &v_nm1_nums[k], 1);
-      v_nm0_nums[k] /= (v_nm0_dens[k]+1e-6); bcf_update_info_float(odw->hdr, nv, "NM0", &v_nm0_nums[k], 1);
-
-      //fprintf(stderr,"AC = %f, AN = %f, NS_NREF = %f, AB = %f, BQR = %f, MQR = %f, CYR = %f, STR = %f, NMR = %f, IOR = %f, NMA = %f\n", acs[1], an, ns_nref, ab_num, bqr_num, mqr_num, cyr_num, str_num, nmr_num, ior_num, nma_num);
+      stats.ns_nref -= (nfiles - gcs[0]);
+      bcf_update_info_int32(odw->hdr, nv, "NS_NREF", &stats.ns_nref, 1);
+      stats.ab_num /= (stats.ab_den+1e-6); bcf_update_info_float(odw->hdr, nv, "ABE",  &stats.ab_num, 1);
+      stats.abz_num /= sqrt(stats.abz_den+1e-6); bcf_update_info_float(odw->hdr, nv, "ABZ",  &stats.abz_num, 1);
+      stats.bqr_num /= sqrt(stats.bqr_den+1e-6); bcf_update_info_float(odw->hdr, nv, "BQZ", &stats.bqr_num, 1);
+      stats.mqr_num /= sqrt(stats.mqr_den+1e-6); bcf_update_info_float(odw->hdr, nv, "MQZ", &stats.mqr_num, 1);
+      stats.cyr_num /= sqrt(stats.cyr_den+1e-6); bcf_update_info_float(odw->hdr, nv, "CYZ", &stats.cyr_num, 1);
+      stats.str_num /= sqrt(stats.str_den+1e-6); bcf_update_info_float(odw->hdr, nv, "STZ", &stats.str_num, 1);
+      stats.nmr_num /= sqrt(stats.nmr_den+1e-6); bcf_update_info_float(odw->hdr, nv, "NMZ", &stats.nmr_num, 1);
+      stats.ior_num = log(stats.ior_num/stats.ior_den+1e-6)/log(10.); bcf_update_info_float(odw->hdr, nv, "IOR", &stats.ior_num, 1);
+      stats.nm1_num /= (stats.nm1_den+1e-6); bcf_update_info_float(odw->hdr, nv, "NM1", &stats.nm1_num, 1);
+      stats.nm0_num /= (stats.nm0_den+1e-6); bcf_update_info_float(odw->hdr, nv, "NM0", &stats.nm0_num, 1);
 
       odw->write(nv);
+      ++no_sites_written;
     }
 
-        odw->close();
-    };
+    /**
+     * Stand in for the cycles of indels, a hash of file, position and read
+     * index in [0,100).  This replaced draws from rand(), whose order would
+     * depend on the threads, so CYZ of indels differs once from the output
+     * of the versions that drew from rand().
+     */
+    int32_t noise(int32_t i, int32_t pos, int32_t l)
+    {
+        uint32_t h = (uint32_t)i*2654435761U ^ (uint32_t)pos*40503U ^ (uint32_t)l*2246822519U;
+        h ^= h >> 15;
+        h *= 2246822519U;
+        h ^= h >> 13;
+        return h % 100;
+    }
 
     void print_options()
     {
@@ -740,6 +878,8 @@ class Igor : Program
         std::clog << "paste_and_comput_features v" << version << "\n\n";
         print_ifiles("options:     input VCF file        ", input_vcf_files);
         std::clog << "         [o] output VCF file       " << output_vcf_file << "\n";
+        print_num_op("         [w] window                ", window);
+        print_num_op("         [t] no. of threads        ", no_threads);
         std::clog << "\n";
     }
 
@@ -749,6 +889,7 @@ class Igor : Program
 
         std::clog << "\n";
         std::cerr << "stats: Total number of files pasted  " << input_vcf_files.size() << "\n";
+        std::cerr << "       Total number of sites written " << no_sites_written << "\n";
         std::clog << "\n";
     };
 
@@ -27,6 +27,7 @@
 #include "program.h"
 #include "log_tool.h"
 #include "estimator.h"
+#include <thread>
 
 bool paste_and_compute_features_sequential(int argc, char ** argv);
 
@@ -102,6 +102,7 @@ class Igor : Program
     VariantManip *vm;
     SVTree* sv_tree;
     VNTRTree* vntr_tree;
+    VNTRInfoIDs* vntr_info_ids;
 
     Igor(int argc, char **argv)
     {
@@ -146,6 +147,8 @@ class Igor : Program
         //i/o initialization//
         //////////////////////
         odr = new BCFOrderedReader(input_vcf_file, intervals);
+        no_samples = bcf_hdr_get_n_sample(odr->hdr);
+        odr->set_required_fields(BCF_UN_INFO, false);
         v = bcf_init1();
 
         /////////////////////////
@@ -157,7 +160,6 @@ class Igor : Program
         ////////////////////////
         //stats initialization//
         ////////////////////////
-        no_samples = 0;
         no_chromosomes = 0;
         no_records = 0;
         no_reference = 0;
@@ -187,14 +189,13 @@ class Igor : Program
         vm = new VariantManip(ref_fasta_file);
         sv_tree = new SVTree();
         vntr_tree = new VNTRTree();
+        vntr_info_ids = new VNTRInfoIDs(odr->hdr);
     }
 
     KHASH_MAP_INIT_INT(32, char)
 
     void peek()
     {
-        no_samples = bcf_hdr_get_n_sample(odr->hdr);
-
         int ret, is_missing;
         
         khiter_t k;
@@ -254,6 +255,7 @@ class Igor : Program
 //                
 
 //                bcf_print(odr->hdr,v);
+                variant.update_vntr_from_info_fields(*vntr_info_ids);
                 vntr_tree->count(variant);
             }
 
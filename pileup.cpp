@@ -23,6 +23,10 @@
 
 #include "pileup.h"
 
+VT_TIMER_STAT(add_M_stat, "pileup.add_M");
+VT_TIMER_STAT(add_D_stat, "pileup.add_D");
+VT_TIMER_STAT(add_I_stat, "pileup.add_I");
+
 /**
  * Clears the soft clipped information.
  */
@@ -190,6 +194,7 @@ Pileup::Pileup(uint32_t k, uint32_t window_size)
     beg0 = end0 = 0;
     gbeg1 = 0;
 
+    rs = NULL;
     debug = 0;
 };
 
@@ -232,12 +237,8 @@ void Pileup::set_reference(std::string& ref_fasta_file)
 {
     if (ref_fasta_file!="")
     {
-        fai = fai_load(ref_fasta_file.c_str());
-        if (fai==NULL)
-        {
-            fprintf(stderr, "[%s:%d %s] cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-            exit(1);
-        }
+        if (rs) delete rs;
+        rs = new ReferenceSequence(ref_fasta_file);
     }
 };
 
@@ -440,6 +441,8 @@ void Pileup::update_read_end(uint32_t gpos1)
  */
 void Pileup::add_M(uint32_t mgpos1, uint32_t spos0, uint32_t len, uint8_t* seq, uint8_t* qual, uint32_t snp_baseq_cutoff)
 {
+    VT_TIME(add_M_stat);
+
     add_3prime_padding(mgpos1);
 
     uint32_t gend1 = get_gend1();
@@ -530,6 +533,8 @@ void Pileup::add_M(uint32_t mgpos1, uint32_t spos0, uint32_t len, uint8_t* seq,
  */
 void Pileup::add_D(uint32_t gpos1, uint32_t len)
 {
+    VT_TIME(add_D_stat);
+
     //there should never be a need to perform 3' padding for deletions
     //add_3prime_padding(gpos1);
 
@@ -583,6 +588,8 @@ void Pileup::add_D(uint32_t gpos1, uint32_t len)
  */
 void Pileup::add_I(uint32_t gpos1, std::string& ins, uint32_t rpos1)
 {
+    VT_TIME(add_I_stat);
+
     //there should never be a need to perform 3' padding for insertions
     //add_3prime_padding(gpos1);
 
@@ -939,17 +946,7 @@ uint32_t Pileup::base2index(char base)
  */
 char Pileup::get_base(std::string& chrom, uint32_t& pos1)
 {
-    int ref_len = 0;
-    char *refseq = faidx_fetch_uc_seq(fai, chrom.c_str(), pos1-1, pos1-1, &ref_len);
-    if (!refseq)
-    {
-        fprintf(stderr, "[%s:%d %s] failure to extrac base from fasta file: %s:%d: >\n", __FILE__, __LINE__, __FUNCTION__, chrom.c_str(), pos1-1);
-        exit(1);
-    }
-    char base = refseq[0];
-    free(refseq);
-
-    return base;
+    return rs->fetch_base(chrom.c_str(), pos1);
 };
 
 /**
@@ -957,9 +954,8 @@ char Pileup::get_base(std::string& chrom, uint32_t& pos1)
  */
 char* Pileup::get_sequence(std::string& chrom, uint32_t pos1, uint32_t len)
 {
-    int ref_len = 0;
-    char* seq = faidx_fetch_uc_seq(fai, chrom.c_str(), pos1-1, pos1+len-2, &ref_len);
-    if (!seq || ref_len!=len)
+    char* seq = rs->fetch_seq(chrom.c_str(), pos1, pos1+len-1);
+    if (!seq || strlen(seq)!=len)
     {
         fprintf(stderr, "[%s:%d %s] failure to extract sequence from fasta file: %s:%d: >\n", __FILE__, __LINE__, __FUNCTION__, chrom.c_str(), pos1-1);
         exit(1);
@@ -27,6 +27,8 @@
 #include "utils.h"
 #include "hts_utils.h"
 #include "variant.h"
+#include "instrument.h"
+#include "reference_sequence.h"
 
 /**
  * Contains sufficient statistic for a position in the pileup.
@@ -166,7 +168,7 @@ class Pileup
 
     int32_t debug;
 
-    faidx_t *fai;
+    ReferenceSequence *rs;
 
     public:
 
@@ -0,0 +1,251 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "pipeline.h"
+
+namespace
+{
+
+typedef void (*Tool)(int argc, char ** argv);
+
+void run_normalize(int argc, char ** argv)
+{
+    normalize(argc, argv);
+}
+
+/**
+ * Tools that read and write through BCFOrderedReader, BCFSyncedReader
+ * and BCFOrderedWriter and can thus be chained in process.
+ */
+Tool get_tool(const std::string& name)
+{
+    if (name=="annotate_indels") return &annotate_indels;
+    if (name=="annotate_vntrs") return &annotate_vntrs;
+    if (name=="decompose") return &decompose;
+    if (name=="decompose_blocksub") return &decompose_blocksub;
+    if (name=="normalize") return &run_normalize;
+    if (name=="uniq") return &uniq;
+    return NULL;
+}
+
+class Igor : Program
+{
+    public:
+
+    ///////////
+    //options//
+    ///////////
+    std::string input_vcf_file;
+    std::string output_vcf_file;
+    std::string stages_list;
+    int32_t capacity;
+
+    ///////
+    //i/o//
+    ///////
+    std::vector<std::vector<std::string> > stages;
+    std::vector<Tool> tools;
+    std::vector<BCFPipe*> pipes;
+
+    /////////
+    //stats//
+    /////////
+    std::vector<uint64_t> no_records;
+
+    Igor(int argc, char **argv)
+    {
+        version = "0.5";
+
+        //////////////////////////
+        //options initialization//
+        //////////////////////////
+        try
+        {
+            std::string desc = "Runs tools as stages of a single process, each stage on its own thread.\n"
+                 "              Records are passed between the stages decoded, without being written out and parsed again.\n"
+                 "              Stages are separated by commas and may carry their options, the input and output\n"
+                 "              of each stage are set by this command.\n"
+                 "              Supported tools : annotate_indels, annotate_vntrs, decompose, decompose_blocksub, normalize, uniq\n"
+                 "\n"
+                 "              e.g. vt pipe \"decompose -s,normalize -r hs37d5.fa,uniq\" in.vcf -o out.bcf\n";
+
+            TCLAP::CmdLine cmd(desc, ' ', version);
+            VTOutput my; cmd.setOutput(&my);
+            TCLAP::ValueArg<int32_t> arg_capacity("b", "b", "no. of records buffered between stages [1000]", false, 1000, "int", cmd);
+            TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "str", cmd);
+            TCLAP::UnlabeledValueArg<std::string> arg_stages_list("<stages>", "comma separated list of tools with their options", true, "","str", cmd);
+            TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
+
+            cmd.parse(argc, argv);
+
+            input_vcf_file = arg_input_vcf_file.getValue();
+            output_vcf_file = arg_output_vcf_file.getValue();
+            stages_list = arg_stages_list.getValue();
+            capacity = arg_capacity.getValue();
+        }
+        catch (TCLAP::ArgException &e)
+        {
+            std::cerr << "error: " << e.error() << " for arg " << e.argId() << "\n";
+            abort();
+        }
+    };
+
+    void initialize()
+    {
+        /////////////////////////
+        //stages initialization//
+        /////////////////////////
+        std::vector<std::string> specs;
+        split(specs, ",", stages_list);
+
+        for (size_t i=0; i<specs.size(); ++i)
+        {
+            std::vector<std::string> args;
+            split(args, " ", specs[i]);
+            if (args.empty())
+            {
+                continue;
+            }
+
+            Tool tool = get_tool(args[0]);
+            if (!tool)
+            {
+                fprintf(stderr, "[%s:%d %s] %s cannot be run in a pipe\n", __FILE__, __LINE__, __FUNCTION__, args[0].c_str());
+                exit(1);
+            }
+
+            for (size_t j=1; j<args.size(); ++j)
+            {
+                if (args[j]=="-o")
+                {
+                    fprintf(stderr, "[%s:%d %s] the output of %s is set by vt pipe, use -o of vt pipe for the final output\n", __FILE__, __LINE__, __FUNCTION__, args[0].c_str());
+                    exit(1);
+                }
+            }
+
+            stages.push_back(args);
+            tools.push_back(tool);
+        }
+
+        if (stages.empty())
+        {
+            fprintf(stderr, "[%s:%d %s] no stages specified\n", __FILE__, __LINE__, __FUNCTION__);
+            exit(1);
+        }
+
+        //the input and output of each stage
+        for (size_t i=0; i<stages.size(); ++i)
+        {
+            if (i+1<stages.size())
+            {
+                pipes.push_back(new BCFPipe(capacity));
+            }
+
+            stages[i].push_back("-o");
+            stages[i].push_back(i+1<stages.size() ? pipes[i]->name : output_vcf_file);
+            stages[i].push_back(i ? pipes[i-1]->name : input_vcf_file);
+        }
+    }
+
+    void pipeline()
+    {
+        std::vector<std::thread> threads;
+
+        //a stage is started when its input header is available so that
+        //the options of the tools are printed in order
+        for (size_t i=0; i<stages.size(); ++i)
+        {
+            threads.push_back(std::thread(&Igor::run, this, i));
+            if (i<pipes.size())
+            {
+                pipes[i]->wait_hdr();
+            }
+        }
+
+        for (size_t i=0; i<threads.size(); ++i)
+        {
+            threads[i].join();
+        }
+
+        for (size_t i=0; i<pipes.size(); ++i)
+        {
+            no_records.push_back(pipes[i]->no_records);
+            delete pipes[i];
+        }
+    };
+
+    /**
+     * Runs a stage and signals the end of its records to the next stage.
+     */
+    void run(size_t i)
+    {
+        std::vector<char*> argv;
+        for (size_t j=0; j<stages[i].size(); ++j)
+        {
+            argv.push_back(const_cast<char*>(stages[i][j].c_str()));
+        }
+        argv.push_back(NULL);
+
+        tools[i](argv.size()-1, &argv[0]);
+
+        if (i<pipes.size())
+        {
+            pipes[i]->close();
+        }
+    }
+
+    void print_options()
+    {
+        std::clog << "pipe v" << version << "\n\n";
+
+        std::clog << "options:     input VCF file        " << input_vcf_file << "\n";
+        std::clog << "         [o] output VCF file       " << output_vcf_file << "\n";
+        std::clog << "             stages                " << stages_list << "\n";
+        print_num_op("         [b] buffered records      ", capacity);
+        std::clog << "\n";
+    }
+
+    void print_stats()
+    {
+        std::clog << "\nstats: no. of stages                             " << stages.size() << "\n";
+        for (size_t i=0; i<no_records.size(); ++i)
+        {
+            std::clog << "       no. of records passed to " << std::setw(20) << std::left << stages[i+1][0] << no_records[i] << "\n";
+        }
+        std::clog << "\n";
+    };
+
+    ~Igor() {};
+
+    private:
+};
+
+}
+
+void pipeline(int argc, char ** argv)
+{
+    Igor igor(argc, argv);
+    igor.print_options();
+    igor.initialize();
+    igor.pipeline();
+    igor.print_stats();
+};
@@ -219,6 +219,7 @@ class Igor : Program
         //i/o initialization//
         //////////////////////
         sr = new BCFSyncedReader(input_vcf_files, intervals, false);
+        sr->set_required_fields(BCF_UN_INFO, false);
 
         ///////////////////////
         //tool initialization//
@@ -253,7 +254,6 @@ class Igor : Program
             bcf_hdr_t *h = current_recs[0]->h;
             int32_t vtype = vm->classify_variant(h, v, variant);
 
-            std::string chrom = bcf_get_chrom(h,v);
             int32_t start1 = bcf_get_pos1(v);
             int32_t end1 = bcf_get_end1(v);
 
@@ -279,12 +279,12 @@ class Igor : Program
             //annotate
             if (presence[0])
             {
-                if (orom_lcplx->overlaps_with(chrom, start1-1, end1+1))
+                if (orom_lcplx->overlaps_with(h, bcf_get_rid(v), start1-1, end1+1))
                 {
                     ++lcplx;
                 }
 
-                if (orom_gencode_cds->overlaps_with(chrom, start1-1, end1+1))
+                if (orom_gencode_cds->overlaps_with(h, bcf_get_rid(v), start1-1, end1+1))
                 {
                     if (abs(variant.alleles[0].dlen)%3!=0)
                     {
@@ -125,6 +125,7 @@ class Igor : Program
         //i/o initialization//
         //////////////////////
         odr = new BCFOrderedReader(input_vcf_file, intervals);
+        odr->set_required_fields(BCF_UN_INFO, false);
 
         /////////////////////////
         //filter initialization//
@@ -154,8 +155,6 @@ class Igor : Program
 
         while(odr->read(v))
         {
-            bcf_unpack(v, BCF_UN_ALL);
-
             //bcf_print_liten(odr->hdr, v);
 
             if (bcf_get_n_allele(v)!=2)
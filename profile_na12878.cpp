@@ -428,7 +428,6 @@ class Igor : Program
                 presence_bcfptr[index] = current_recs[i];
             }
 
-            std::string chrom = bcf_get_chrom(h,v);
             int32_t start1 = bcf_get_pos1(v);
             int32_t end1 = bcf_get_end1(v);
 
@@ -437,7 +436,7 @@ class Igor : Program
             ///////////////////////
             if (presence[0])
             {
-                if (orom_gencode_cds->overlaps_with(chrom, start1, end1))
+                if (orom_gencode_cds->overlaps_with(h, bcf_get_rid(v), start1, end1))
                 {
                     if (abs(variant.alleles[0].dlen)%3!=0)
                     {
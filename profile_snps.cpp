@@ -217,6 +217,7 @@ class Igor : Program
         //i/o initialization//
         //////////////////////
         sr = new BCFSyncedReader(input_vcf_files, intervals, false);
+        sr->set_required_fields(BCF_UN_INFO, false);
 
         ///////////////////////
         //tool initialization//
@@ -272,16 +273,15 @@ class Igor : Program
             //annotate
             if (presence[0])
             {
-                std::string chrom = bcf_get_chrom(h,v);
                 int32_t start1 = bcf_get_pos1(v);
                 int32_t end1 = bcf_get_end1(v);
                 
-                if (orom_lcplx->overlaps_with(chrom, start1, end1))
+                if (orom_lcplx->overlaps_with(h, bcf_get_rid(v), start1, end1))
                 {
                     ++lcplx;
                 }
 
-                if (orom_gencode_cds->overlaps_with(chrom, start1, end1))
+                if (orom_gencode_cds->overlaps_with(h, bcf_get_rid(v), start1, end1))
                 {
                     ++nonsyn;
                 }
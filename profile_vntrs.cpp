@@ -100,6 +100,7 @@ class Igor : Program
     ////////////////
     VariantManip *vm;
     VNTRTree* vntr_tree;
+    VNTRInfoIDs* vntr_info_ids;
 
     Igor(int argc, char ** argv)
     {
@@ -213,6 +214,7 @@ class Igor : Program
         ///////////////////////
         vm = new VariantManip("");
         vntr_tree = new VNTRTree();
+        vntr_info_ids = new VNTRInfoIDs(odr->hdr);
         orom_gencode_cds = new OrderedRegionOverlapMatcher(cds_bed_file);
         orom_lcplx = new OrderedRegionOverlapMatcher(cplx_bed_file);
 
@@ -264,7 +266,6 @@ class Igor : Program
 
             ++no_vntrs;
 
-            std::string chrom = bcf_get_chrom(odr->hdr,v);
             int32_t rid = bcf_get_rid(v);
             int32_t start1 = bcf_get_pos1(v);
             int32_t end1 = bcf_get_end1(v);
@@ -289,12 +290,12 @@ class Igor : Program
                 last_end1 = end1;
             }
 
-            if (orom_lcplx->overlaps_with(chrom, start1, end1))
+            if (orom_lcplx->overlaps_with(odr->hdr, bcf_get_rid(v), start1, end1))
             {
                 ++no_lcplx;
             }
 
-            if (orom_gencode_cds->overlaps_with(chrom, start1, end1))
+            if (orom_gencode_cds->overlaps_with(odr->hdr, bcf_get_rid(v), start1, end1))
             {
                 ++no_cds;
             }
@@ -329,6 +330,7 @@ class Igor : Program
                 }
             }
 
+            variant.update_vntr_from_info_fields(*vntr_info_ids);
             vntr_tree->count(variant);
         }
 
@@ -40,6 +40,7 @@
 #include "filter.h"
 #include "genome_interval.h"
 #include "reference_sequence.h"
+#include "instrument.h"
 
 class VTOutput : public TCLAP::StdOutput
 {
@@ -31,9 +31,6 @@ ReadFilter::ReadFilter(uint32_t read_mapq_cutoff, uint16_t read_exclude_flag, bo
     this->read_mapq_cutoff = read_mapq_cutoff;
     this->read_exclude_flag = read_exclude_flag;
     this->ignore_overlapping_read = ignore_overlapping_read;    
-    
-    //for tracking overlapping reads
-    reads = kh_init(rdict);
 
     chrom = "";
     tid = -1;
@@ -60,57 +57,11 @@ ReadFilter::ReadFilter(uint32_t read_mapq_cutoff, uint16_t read_exclude_flag, bo
  */
 bool ReadFilter::filter_read(bam_hdr_t* h, bam1_t *s)
 {
-    if (ignore_overlapping_read)
+    if (ignore_overlapping_read && mates.is_overlapping_mate(s))
     {
-        //check to see that hash should be cleared when encountering new contig.
-        //some bams may not be properly formed and contain orphaned reads that
-        //is retained in the hash
-        if (bam_get_tid(s)!=tid)
-        {
-            clear_reads();
-            tid = bam_get_tid(s);
-        }
-        
-        //this read is part of a mate pair on the same contig
-        if (bam_get_mpos1(s) && (bam_get_tid(s)==bam_get_mtid(s)))
-        {
-            khiter_t k;
-            int32_t ret;
-    
-            //first mate
-            if (bam_get_mpos1(s)>bam_get_pos1(s))
-            {
-                //overlapping
-                if (bam_get_mpos1(s)<=(bam_get_pos1(s) + bam_get_l_qseq(s) - 1))
-                {
-                    //add read that has overlapping
-                    //duplicate the record and perform the stitching later
-                    char* qname = strdup(bam_get_qname(s));
-                    k = kh_put(rdict, reads, qname, &ret);
-                    if (!ret)
-                    {
-                        //already present
-                        free(qname);
-                    }
-                    kh_val(reads, k) = {bam_get_pos1(s), bam_get_pos1(s)+bam_get_l_qseq(s)-1};
-                }
-            }
-            else
-            {
-                //check overlap
-                if((k = kh_get(rdict, reads, bam_get_qname(s)))!=kh_end(reads))
-                {
-                    if (kh_exist(reads, k))
-                    {
-                        free((char*)kh_key(reads, k));
-                        kh_del(rdict, reads, k);
-                        ++no_overlapping_reads;
-                    }
-                    //set this on to remove overlapping reads.
-                    return false;
-                }
-            }
-        }
+        //set this on to remove overlapping reads.
+        ++no_overlapping_reads;
+        return false;
     }
 
     if(bam_get_flag(s) & read_exclude_flag)
@@ -218,18 +169,11 @@ bool ReadFilter::filter_read(bam_hdr_t* h, bam1_t *s)
 }
 
 /**
- * Clear reads from hash.
+ * Clear reads from the overlapping mate tracker.
  */
 void ReadFilter::clear_reads()
 {
-    for (khiter_t k = kh_begin(reads); k != kh_end(reads); ++k)
-    {
-        if (kh_exist(reads, k))
-        {
-            free((char*)kh_key(reads, k));
-            kh_del(rdict, reads, k);
-        }
-    }
+    mates.clear();
 }
 
 /**
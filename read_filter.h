@@ -30,16 +30,7 @@
 #include "hts_utils.h"
 #include "utils.h"
 #include "augmented_bam_record.h"
-
-/**
- * For detecting overlapping reads.
- */
-typedef struct
-{
-  int32_t start1, end1;
-} interval_t;
-
-KHASH_MAP_INIT_STR(rdict, interval_t)
+#include "overlapping_read_tracker.h"
 
 /**
  * Filter for reads.
@@ -56,7 +47,7 @@ class ReadFilter
     uint32_t read_mapq_cutoff;
     uint16_t read_exclude_flag;
     bool ignore_overlapping_read;
-    khash_t(rdict) *reads;
+    OverlappingReadTracker mates;
 
     /////////
     //stats//
@@ -97,7 +88,6 @@ class ReadFilter
      */
     ~ReadFilter()
     {
-        kh_destroy(rdict, reads);
     }
     
     /**
@@ -108,7 +98,7 @@ class ReadFilter
     bool filter_read(bam_hdr_t* h, bam1_t *s);
 
     /**
-     * Clear reads from hash.
+     * Clear reads from the overlapping mate tracker.
      */
     void clear_reads();
 
@@ -30,16 +30,9 @@
  */
 ReferenceSequence::ReferenceSequence(std::string& ref_fasta_file, uint32_t k, uint32_t window_size)
 {
-    this->ref_fasta_file = ref_fasta_file;
-    if (ref_fasta_file!="")
-    {
-        fai = fai_load(ref_fasta_file.c_str());
-        if (fai==NULL)
-        {
-            fprintf(stderr, "[%s:%d %s] cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-            exit(1);
-        }
-    }
+    fai = NULL;
+    pr = NULL;
+    set_reference(ref_fasta_file);
 
     //Buffer size is a power of 2^k.
     buffer_size = 1 << k;
@@ -55,11 +48,21 @@ ReferenceSequence::ReferenceSequence(std::string& ref_fasta_file, uint32_t k, ui
     debug = 0;
 };
 
+/**
+ * Destructor.
+ */
+ReferenceSequence::~ReferenceSequence()
+{
+    if (fai) fai_destroy(fai);
+    if (pr) PackedReference::release(pr);
+};
+
 /**
  * Fetches the number of sequences.
  */
 int32_t ReferenceSequence::fetch_nseq()
 {
+    if (pr) return pr->nseq();
     return faidx_nseq(fai);
 }
 
@@ -69,7 +72,7 @@ int32_t ReferenceSequence::fetch_nseq()
 std::string ReferenceSequence::fetch_iseq_name(int32_t i)
 {
     std::string s;
-    s.assign(faidx_iseq(fai, i));
+    s.assign(pr ? pr->iseq_name(i) : faidx_iseq(fai, i));
 
     return s;
 }
@@ -79,6 +82,7 @@ std::string ReferenceSequence::fetch_iseq_name(int32_t i)
  */
 int32_t ReferenceSequence::fetch_seq_len(std::string& seq)
 {
+    if (pr) return pr->seq_len(seq.c_str());
     return faidx_seq_len(fai, seq.c_str());
 }
 
@@ -87,6 +91,17 @@ int32_t ReferenceSequence::fetch_seq_len(std::string& seq)
  */
 char ReferenceSequence::fetch_base(const char* chrom, int32_t pos1)
 {
+    if (pr)
+    {
+        char base = pr->fetch_base(chrom, pos1-1);
+        if (!base)
+        {
+            fprintf(stderr, "[%s:%d %s] failure to extrac base from fasta file: %s:%d: >\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1-1);
+            exit(1);
+        }
+        return base;
+    }
+
     int ref_len = 0;
     char *refseq = faidx_fetch_uc_seq(fai, chrom, pos1-1, pos1-1, &ref_len);
     if (!refseq)
@@ -105,6 +120,8 @@ char ReferenceSequence::fetch_base(const char* chrom, int32_t pos1)
  */
 char ReferenceSequence::fetch_base(std::string& chrom, int32_t pos1)
 {
+    if (pr) return fetch_base(chrom.c_str(), pos1);
+
     int ref_len = 0;
     char *refseq = faidx_fetch_uc_seq(fai, chrom.c_str(), pos1-1, pos1-1, &ref_len);
     if (!refseq)
@@ -139,12 +156,7 @@ void ReferenceSequence::fetch_seq(std::string& chrom, int32_t start1, int32_t en
  */
 void ReferenceSequence::fetch_seq(std::string& chrom, int32_t beg1, int32_t end1, std::string& seq)
 {
-    char* temp_seq = fetch_seq(chrom.c_str(), beg1, end1);
-    if (temp_seq)
-    {
-        seq.assign(temp_seq);
-        free(temp_seq);
-    }
+    fetch_seq(chrom.c_str(), beg1, end1, seq);
 };
 
 /**
@@ -152,6 +164,17 @@ void ReferenceSequence::fetch_seq(std::string& chrom, int32_t beg1, int32_t end1
  */
 void ReferenceSequence::fetch_seq(const char* chrom, int32_t beg1, int32_t end1, std::string& seq)
 {
+    //decode in place, no intermediate buffer
+    if (pr)
+    {
+        if (pr->fetch(chrom, beg1-1, end1-1, seq)==-2)
+        {
+            fprintf(stderr, "[E:%s:%d %s] fatal error in extracting %s:%d-%d  reference sequence file: %s\n", __FILE__, __LINE__, __FUNCTION__, chrom, beg1, end1, ref_fasta_file.c_str());
+            exit(1);
+        }
+        return;
+    }
+
     char* temp_seq = fetch_seq(chrom, beg1, end1);
     if (temp_seq)
     {
@@ -164,10 +187,43 @@ void ReferenceSequence::fetch_seq(const char* chrom, int32_t beg1, int32_t end1,
  * Fetches sequence chrom:beg1-end1.
  */
 char* ReferenceSequence::fetch_seq(const char* chrom, int32_t beg1, int32_t end1)
+{
+    return fetch_seq(chrom, beg1, end1, true);
+}
+
+/**
+ * Fetches sequence chrom:beg1-end1 with soft masked bases in lower case.
+ */
+char* ReferenceSequence::fetch_masked_seq(const char* chrom, int32_t beg1, int32_t end1)
+{
+    return fetch_seq(chrom, beg1, end1, false);
+}
+
+/**
+ * Fetches sequence chrom:beg1-end1, in upper case if uc is set.
+ */
+char* ReferenceSequence::fetch_seq(const char* chrom, int32_t beg1, int32_t end1, bool uc)
 {
     char* seq = NULL;
     int32_t len = 0;
-    seq = faidx_fetch_uc_seq(fai, const_cast<char*>(chrom), beg1-1, end1-1, &len);
+    if (pr)
+    {
+        seq = (char*) malloc(end1>=beg1 ? end1-beg1+2 : 2);
+        len = pr->fetch(chrom, beg1-1, end1-1, seq, uc);
+        if (len<0)
+        {
+            free(seq);
+            seq = NULL;
+        }
+    }
+    else if (uc)
+    {
+        seq = faidx_fetch_uc_seq(fai, const_cast<char*>(chrom), beg1-1, end1-1, &len);
+    }
+    else
+    {
+        seq = faidx_fetch_seq(fai, const_cast<char*>(chrom), beg1-1, end1-1, &len);
+    }
 
     if (len==-1)
     {
@@ -238,6 +294,24 @@ void ReferenceSequence::set_reference(std::string& ref_fasta_file)
     this->ref_fasta_file = ref_fasta_file;
     if (ref_fasta_file!="")
     {
+        //a packed image given directly or next to the FASTA file as <ref>.pack,
+        //the latter only if it was made from the FASTA file as it is now
+        std::string packed_file = ref_fasta_file + ".pack";
+        if (PackedReference::is_packed(ref_fasta_file))
+        {
+            pr = PackedReference::acquire(ref_fasta_file);
+            return;
+        }
+        else if (PackedReference::is_current(packed_file, ref_fasta_file))
+        {
+            pr = PackedReference::acquire(packed_file);
+            return;
+        }
+        else if (PackedReference::is_packed(packed_file))
+        {
+            fprintf(stderr, "[%s:%d %s] Ignoring %s, it is not packed from the current %s, rerun vt seq --pack\n", __FILE__, __LINE__, __FUNCTION__, packed_file.c_str(), ref_fasta_file.c_str());
+        }
+
         fai = fai_load(ref_fasta_file.c_str());
         if (fai==NULL)
         {
@@ -26,6 +26,7 @@
 
 #include "utils.h"
 #include "hts_utils.h"
+#include "packed_reference.h"
 
 /**
  * A Reference Sequence object wrapping htslib's faidx.
@@ -39,6 +40,9 @@ class ReferenceSequence
     std::string ref_fasta_file;
     faidx_t *fai;
 
+    //packed image used in place of the FASTA file if present, see PackedReference
+    PackedReference *pr;
+
     uint32_t buffer_size;
     uint32_t buffer_size_mask;
     uint32_t window_size;
@@ -84,6 +88,11 @@ class ReferenceSequence
      */
     ReferenceSequence(std::string& ref_fasta_file, uint32_t k=10, uint32_t window_size=256);
 
+    /**
+     * Destructor.
+     */
+    ~ReferenceSequence();
+
     /**
      * Fetches the number of sequences.
      */
@@ -141,8 +150,18 @@ class ReferenceSequence
      */
     char* fetch_seq(std::string& chrom, int32_t beg1, int32_t end1);
 
+    /**
+     * Fetches sequence chrom:beg1-end1 with soft masked bases in lower case.
+     */
+    char* fetch_masked_seq(const char* chrom, int32_t beg1, int32_t end1);
+
     private:
 
+    /**
+     * Fetches sequence chrom:beg1-end1, in upper case if uc is set.
+     */
+    char* fetch_seq(const char* chrom, int32_t beg1, int32_t end1, bool uc);
+
     /**
      * Overloads subscript operator for accessing buffered sequence positions.
      */
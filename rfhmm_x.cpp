@@ -23,8 +23,8 @@
 
 #include "rfhmm_x.h"
 
-#define MAXLEN 1024
-#define MAXLEN_NBITS 10
+//positions and motif counts are held in the 12 bit fields of a track
+#define MAXLEN 4095
 
 //model states
 #define S       0
@@ -52,7 +52,7 @@
 #define MATCH 2
 
 /*for indexing single array*/
-#define index(i,j) (((i)<<MAXLEN_NBITS)+(j))
+#define index(i,j) (((i)*stride)+(j))
 
 /*functions for getting trace back information*/
 #define track_get_u(t)      (((t)&0xF8000000)>>27)
@@ -86,17 +86,20 @@ RFHMM_X::RFHMM_X(bool debug)
  */
 RFHMM_X::~RFHMM_X()
 {
-    delete optimal_path;
+    delete[] optimal_path;
+    delete[] motif_discordance;
 
-    //the best alignment V_ for subsequence (i,j)
+    //matrices go back to the alignment workspace of this thread
     for (size_t state=S; state<=E; ++state)
     {
-        delete V[state];
-        delete U[state];
+        AlignmentWorkspace::release(V[state], no_rows*stride);
+        AlignmentWorkspace::release(U[state], no_rows*stride);
+        delete[] moves[state];
     }
 
-    delete V;
-    delete U;
+    delete[] V;
+    delete[] U;
+    delete[] moves;
 };
 
 /**
@@ -106,7 +109,6 @@ void RFHMM_X::initialize()
 {
     initialize_structures();
     initialize_T();
-    initialize_UV();
 };
 
 /**
@@ -122,23 +124,22 @@ void RFHMM_X::initialize_structures()
     rflen = 0;
     mlen = 0;
 
-    motif_discordance = new int32_t[MAXLEN];
-    optimal_path = new int32_t[MAXLEN<<2];
+    motif_discordance = NULL;
+    optimal_path = NULL;
+    max_path_len = 0;
     optimal_path_traced = false;
 
     typedef int32_t (RFHMM_X::*move) (int32_t t, int32_t j);
+    //the matrices are sized by resize for the first alignment
+    no_rows = 0;
+    stride = 0;
     V = new float*[NSTATES];
     U = new int32_t*[NSTATES];
     moves = new move*[NSTATES];
     for (size_t state=S; state<=E; ++state)
     {
-        V[state] = new float[MAXLEN*MAXLEN];
-        U[state] = new int32_t[MAXLEN*MAXLEN];
-        moves[state] = new move[NSTATES];
-    }
-
-    for (size_t state=S; state<=E; ++state)
-    {
+        V[state] = NULL;
+        U[state] = NULL;
         moves[state] = new move[NSTATES];
     }
 
@@ -220,9 +221,9 @@ void RFHMM_X::initialize_T()
 void RFHMM_X::initialize_UV()
 {
     int32_t t=0;
-    for (size_t i=0; i<MAXLEN; ++i)
+    for (size_t i=0; i<no_rows; ++i)
     {
-        for (size_t j=0; j<MAXLEN; ++j)
+        for (size_t j=0; j<stride; ++j)
         {
             size_t c = index(i,j);
 
@@ -301,6 +302,38 @@ void RFHMM_X::initialize_UV()
     V[MR][index(0,0)] = -INFINITY;
 };
 
+/**
+ * Grows the matrices to at least rows x cols cells.
+ */
+void RFHMM_X::resize(size_t rows, size_t cols)
+{
+    if (rows<=no_rows && cols<=stride) return;
+
+    for (size_t state=S; state<=E; ++state)
+    {
+        AlignmentWorkspace::release(V[state], no_rows*stride);
+        AlignmentWorkspace::release(U[state], no_rows*stride);
+    }
+
+    no_rows = std::max(rows, no_rows);
+    stride = std::max(cols, stride);
+
+    for (size_t state=S; state<=E; ++state)
+    {
+        V[state] = AlignmentWorkspace::acquire<float>(no_rows*stride);
+        U[state] = AlignmentWorkspace::acquire<int32_t>(no_rows*stride);
+    }
+
+    //a path has at most a move per row and per column, motifs are counted from 1
+    delete[] optimal_path;
+    delete[] motif_discordance;
+    max_path_len = no_rows+stride;
+    optimal_path = new int32_t[max_path_len];
+    motif_discordance = new int32_t[no_rows+1];
+
+    initialize_UV();
+}
+
 /**
  * Sets a model.
  */
@@ -499,7 +532,7 @@ void RFHMM_X::proc_comp(int32_t A, int32_t B, int32_t index1, int32_t j, int32_t
     if (debug)
     {
         std::cerr << "\t" << state2string(A) << "=>" << state2string(B);
-        std::cerr << " (" << ((index1-j)>>MAXLEN_NBITS) << "," << j << ") ";
+        std::cerr << " (" << ((index1-j)/stride) << "," << j << ") ";
         std::cerr << track2string(U[A][index1]) << "=>";
         std::cerr << track2string(t) << " ";
         std::cerr << emission << " (e: " << (track_get_d(t)<=RFLANK?track_get_base(t):'N') << " vs " << (j!=rlen?read[j]:'N')  << ") + ";
@@ -534,11 +567,12 @@ void RFHMM_X::align(const char* read, const char* qual)
     rlen = strlen(read);
     plen = rlen + rflen;
 
-    if (rlen>MAXLEN)
+    if (plen>MAXLEN)
     {
-        fprintf(stderr, "[%s:%d %s] Sequence to be aligned is greater than %d currently supported: %d\n", __FILE__, __LINE__, __FUNCTION__, MAXLEN, rlen);
+        fprintf(stderr, "[%s:%d %s] Sequence to be aligned with its flanks is greater than %d currently supported: %d\n", __FILE__, __LINE__, __FUNCTION__, MAXLEN, plen);
         exit(1);
     }
+    resize(plen+1, rlen+1);
 
     float max = 0;
     char maxPath = 'Y';
@@ -548,7 +582,7 @@ void RFHMM_X::align(const char* read, const char* qual)
     //right to left alignment
     for (size_t i=0; i>=plen; ++i)
     {
-        for (size_t j=MAXLEN; j<=MAXLEN-rlen; --j)
+        for (size_t j=stride-1; j<=stride-1-rlen; --j)
         {
             size_t c = index(i,j);
             size_t d = index(i-1,j+1);
@@ -763,7 +797,7 @@ void RFHMM_X::trace_path()
     }
 
     //trace path
-    optimal_path_ptr = optimal_path+(MAXLEN<<2)-1;
+    optimal_path_ptr = optimal_path+max_path_len-1;
     int32_t i = optimal_probe_len, j = rlen;
     int32_t last_t = make_track(optimal_state, RFLANK, 0, rflen+1);
     optimal_path_len = 0;
@@ -1273,7 +1307,7 @@ void RFHMM_X::print_alignment(std::string& pad)
     std::cerr << "Model:  ";
     int32_t t = NULL_TRACK;
     int32_t j = 0;
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         int32_t u = track_get_u(*path);
         if (u==M || u==D || u==MR)
@@ -1291,7 +1325,7 @@ void RFHMM_X::print_alignment(std::string& pad)
     std::cerr << "       S";
     path = optimal_path_ptr;
     j=1;
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         std::cerr << track2cigarstring1(*path,j);
         int32_t u = track_get_u(*path);
@@ -1305,7 +1339,7 @@ void RFHMM_X::print_alignment(std::string& pad)
 
     path = optimal_path_ptr;
     std::cerr << "        ";
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         std::cerr << track2cigarstring2(*path);
         ++path;
@@ -1315,7 +1349,7 @@ void RFHMM_X::print_alignment(std::string& pad)
     path = optimal_path_ptr;
     j=1;
     std::cerr << "Read:   ";
-    while (path<optimal_path+(MAXLEN<<2))
+    while (path<optimal_path+max_path_len)
     {
         int32_t u = track_get_u(*path);
         if (u==Y || u==M || u==I || u==MR)
@@ -1478,7 +1512,6 @@ void RFHMM_X::print_track(int32_t t)
 }
 
 #undef MAXLEN
-#undef MAXLEN_NBITS
 #undef S
 #undef Y
 #undef M
@@ -0,0 +1,564 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "scatter.h"
+
+namespace
+{
+
+#define SCATTER_BCF 0
+#define SCATTER_VCF 1
+#define SCATTER_BAM 2
+
+//maximum extent of a contig in the BAI and TBI indices
+#define SCATTER_MAX_POS (1<<29)
+
+/**
+ * A cut between two shards, the next shard starts at pos1 of contig.
+ */
+struct cut_t
+{
+    int32_t contig;
+    int32_t pos1;
+};
+
+class Igor : Program
+{
+    public:
+
+    ///////////
+    //options//
+    ///////////
+    std::string input_file;
+    std::string ref_fasta_file;
+    std::string output_prefix;
+    int32_t no_shards;
+    int32_t tile_size;
+    int32_t max_mlen;
+    int32_t search_window;
+
+    ///////
+    //i/o//
+    ///////
+    htsFile *file;
+    int32_t format;
+    hts_idx_t *idx;
+    tbx_t *tbx;
+    bcf_hdr_t *hdr;
+    bam_hdr_t *bhdr;
+    faidx_t *fai;
+
+    //contigs with records in the order of the header
+    std::vector<std::string> contigs;
+    std::vector<int32_t> tids;
+    std::vector<int32_t> lens;
+    std::vector<int64_t> contig_records;
+
+    //compressed bytes of the records of each tile of size tile_size of each contig
+    std::vector<std::vector<int64_t> > weights;
+
+    std::vector<cut_t> cuts;
+
+    /////////
+    //stats//
+    /////////
+    int64_t total_weight;
+    int32_t no_moved_cuts;
+    std::vector<int64_t> shard_weights;
+    std::vector<int64_t> shard_records;
+    std::vector<int32_t> shard_intervals;
+
+    Igor(int argc, char **argv)
+    {
+        version = "0.5";
+
+        //////////////////////////
+        //options initialization//
+        //////////////////////////
+        try
+        {
+            std::string desc = "Splits the genome into interval lists of about the same amount of records\n"
+                 "              using the bins of the .csi/.tbi/.bai index of a VCF, BCF or BAM file.\n"
+                 "              The interval lists <prefix>.<i>.txt can be given to the -I option of the tools.\n"
+                 "              Shards are cut away from records and, if a reference is given, from short\n"
+                 "              tandem repeats so that indels are normalized within a shard.";
+
+            TCLAP::CmdLine cmd(desc, ' ', version);
+            VTOutput my; cmd.setOutput(&my);
+            TCLAP::ValueArg<int32_t> arg_no_shards("n", "n", "no. of shards [10]", false, 10, "int", cmd);
+            TCLAP::ValueArg<std::string> arg_output_prefix("o", "o", "output prefix of the interval lists [scatter]", false, "scatter", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_ref_fasta_file("r", "r", "reference sequence fasta file []", false, "", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_tile_size("w", "w", "size of the tiles the density of records is estimated in [16384]", false, 16384, "int", cmd);
+            TCLAP::ValueArg<int32_t> arg_max_mlen("m", "m", "maximum repeat unit length not to be cut [10]", false, 10, "int", cmd);
+            TCLAP::ValueArg<int32_t> arg_search_window("s", "s", "distance a cut is moved by at most [10000]", false, 10000, "int", cmd);
+            TCLAP::UnlabeledValueArg<std::string> arg_input_file("<in>", "input indexed VCF, BCF or BAM file", true, "", "file", cmd);
+
+            cmd.parse(argc, argv);
+
+            input_file = arg_input_file.getValue();
+            output_prefix = arg_output_prefix.getValue();
+            ref_fasta_file = arg_ref_fasta_file.getValue();
+            no_shards = std::max(arg_no_shards.getValue(), 1);
+            tile_size = std::max(arg_tile_size.getValue(), 1);
+            max_mlen = std::max(arg_max_mlen.getValue(), 0);
+            search_window = std::max(arg_search_window.getValue(), 0);
+        }
+        catch (TCLAP::ArgException &e)
+        {
+            std::cerr << "error: " << e.error() << " for arg " << e.argId() << "\n";
+            abort();
+        }
+    };
+
+    void initialize()
+    {
+        //////////////////////
+        //i/o initialization//
+        //////////////////////
+        file = hts_open(input_file.c_str(), "r");
+        if (!file)
+        {
+            fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, input_file.c_str());
+            exit(1);
+        }
+
+        idx = NULL;
+        tbx = NULL;
+        hdr = NULL;
+        bhdr = NULL;
+
+        const htsFormat* fmt = hts_get_format(file);
+        if (fmt->format==bcf)
+        {
+            format = SCATTER_BCF;
+            hdr = bcf_hdr_read(file);
+            idx = bcf_index_load(input_file.c_str());
+        }
+        else if (fmt->format==vcf && fmt->compression==bgzf)
+        {
+            format = SCATTER_VCF;
+            hdr = bcf_hdr_read(file);
+            tbx = tbx_index_load(input_file.c_str());
+            if (tbx) idx = tbx->idx;
+        }
+        else if (fmt->format==bam)
+        {
+            format = SCATTER_BAM;
+            bhdr = sam_hdr_read(file);
+            idx = sam_index_load(file, input_file.c_str());
+        }
+        else
+        {
+            fprintf(stderr, "[%s:%d %s] Not a BCF, bgzipped VCF or BAM file: %s\n", __FILE__, __LINE__, __FUNCTION__, input_file.c_str());
+            exit(1);
+        }
+
+        if (!idx)
+        {
+            fprintf(stderr, "[%s:%d %s] Cannot load index of %s\n", __FILE__, __LINE__, __FUNCTION__, input_file.c_str());
+            exit(1);
+        }
+
+        ////////////////////////
+        //tools initialization//
+        ////////////////////////
+        fai = NULL;
+        if (ref_fasta_file!="")
+        {
+            fai = fai_load(ref_fasta_file.c_str());
+            if (!fai)
+            {
+                fprintf(stderr, "[%s:%d %s] Cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
+                exit(1);
+            }
+        }
+
+        ////////////////////////
+        //stats initialization//
+        ////////////////////////
+        total_weight = 0;
+        no_moved_cuts = 0;
+    }
+
+    void scatter()
+    {
+        load_contigs();
+        measure();
+        plan();
+
+        for (size_t i=0; i<cuts.size(); ++i)
+        {
+            if (cuts[i].pos1>1)
+            {
+                int32_t pos1 = refine(cuts[i].contig, cuts[i].pos1);
+                if (pos1!=cuts[i].pos1) ++no_moved_cuts;
+                cuts[i].pos1 = pos1;
+            }
+        }
+
+        write();
+
+        if (tbx) tbx_destroy(tbx);
+        else hts_idx_destroy(idx);
+        if (hdr) bcf_hdr_destroy(hdr);
+        if (bhdr) bam_hdr_destroy(bhdr);
+        if (fai) fai_destroy(fai);
+        hts_close(file);
+    };
+
+    /**
+     * Lists the contigs with records in the order of the header, followed by
+     * those only found in the index, with their lengths if known.
+     */
+    void load_contigs()
+    {
+        std::vector<std::string> names;
+        std::vector<int32_t> lengths;
+        if (format==SCATTER_BAM)
+        {
+            for (int32_t i=0; i<bhdr->n_targets; ++i)
+            {
+                names.push_back(bhdr->target_name[i]);
+                lengths.push_back(bhdr->target_len[i]);
+            }
+        }
+        else
+        {
+            for (int32_t i=0; i<hdr->n[BCF_DT_CTG]; ++i)
+            {
+                names.push_back(bcf_hdr_id2name(hdr, i));
+                lengths.push_back(hdr->id[BCF_DT_CTG][i].val->info[0]);
+            }
+
+            if (tbx)
+            {
+                int32_t nseqs = 0;
+                const char** seqs = tbx_seqnames(tbx, &nseqs);
+                for (int32_t i=0; i<nseqs; ++i)
+                {
+                    if (bcf_hdr_name2id(hdr, seqs[i])<0)
+                    {
+                        names.push_back(seqs[i]);
+                        lengths.push_back(0);
+                    }
+                }
+                if (seqs) free(seqs);
+            }
+        }
+
+        for (size_t i=0; i<names.size(); ++i)
+        {
+            int32_t tid = tbx ? tbx_name2id(tbx, names[i].c_str()) : i;
+            if (tid<0 || !tile_offset(tid, 0, SCATTER_MAX_POS, NULL)) continue;
+
+            uint64_t mapped = 0, unmapped = 0;
+            contigs.push_back(names[i]);
+            tids.push_back(tid);
+            lens.push_back(lengths[i]>0 ? lengths[i] : extent(tid));
+            contig_records.push_back(hts_idx_get_stat(idx, tid, &mapped, &unmapped)==0 ? mapped : -1);
+        }
+    }
+
+    /**
+     * Gets the virtual offset of the first record overlapping [beg0,end0) of tid.
+     * Returns false if there are no such records.
+     */
+    bool tile_offset(int32_t tid, int64_t beg0, int64_t end0, uint64_t* offset)
+    {
+        hts_itr_t* itr = hts_itr_query(idx, tid, beg0, end0, NULL);
+        bool found = itr && !itr->finished && itr->n_off>0;
+        if (found && offset) *offset = itr->off[0].u;
+        if (itr) hts_itr_destroy(itr);
+        return found;
+    }
+
+    /**
+     * Returns the end of the last tile with records of a contig of unknown length.
+     */
+    int32_t extent(int32_t tid)
+    {
+        int32_t lo = 0, hi = SCATTER_MAX_POS/tile_size;
+        while (lo<hi)
+        {
+            int32_t mid = lo + (hi-lo+1)/2;
+            if (tile_offset(tid, (int64_t)mid*tile_size, SCATTER_MAX_POS, NULL))
+                lo = mid;
+            else
+                hi = mid-1;
+        }
+
+        return (lo+1)*tile_size;
+    }
+
+    /**
+     * Estimates the compressed bytes of each tile from the index.  The offsets of the tiles
+     * are sorted in file order so that the bytes of a tile extend to the next tile in the file.
+     */
+    void measure()
+    {
+        //offset, contig and tile
+        std::vector<std::pair<uint64_t, std::pair<int32_t, int32_t> > > offsets;
+        weights.resize(contigs.size());
+        for (size_t i=0; i<contigs.size(); ++i)
+        {
+            int32_t no_tiles = (lens[i]+tile_size-1)/tile_size;
+            weights[i].resize(no_tiles, 0);
+
+            for (int32_t j=0; j<no_tiles; ++j)
+            {
+                uint64_t offset = 0;
+                if (tile_offset(tids[i], (int64_t)j*tile_size, (int64_t)(j+1)*tile_size, &offset))
+                {
+                    offsets.push_back(std::make_pair(offset, std::make_pair((int32_t)i, j)));
+                }
+            }
+        }
+
+        std::sort(offsets.begin(), offsets.end());
+
+        //the end of the last tile is the end of the file
+        struct stat st;
+        uint64_t end = stat(input_file.c_str(), &st)==0 ? ((uint64_t)st.st_size)<<16 : 0;
+        for (int64_t k=(int64_t)offsets.size()-1; k>=0; --k)
+        {
+            uint64_t u = offsets[k].first;
+            int64_t w = end>u ? (int64_t)((end>>16)-(u>>16)) : 0;
+            weights[offsets[k].second.first][offsets[k].second.second] = w;
+            total_weight += w;
+            end = u;
+        }
+    }
+
+    /**
+     * Cuts the tiles into shards of about the same weight.
+     */
+    void plan()
+    {
+        int64_t weight = 0;
+        int32_t k = 1;
+        for (size_t i=0; i<contigs.size() && k<no_shards; ++i)
+        {
+            for (size_t j=0; j<weights[i].size() && k<no_shards; ++j)
+            {
+                weight += weights[i][j];
+                if (weight*no_shards>=total_weight*k)
+                {
+                    cut_t cut;
+                    if (j+1<weights[i].size())
+                    {
+                        cut.contig = i;
+                        cut.pos1 = (j+1)*tile_size+1;
+                    }
+                    else
+                    {
+                        cut.contig = i+1;
+                        cut.pos1 = 1;
+                    }
+
+                    //a tile heavier than a shard takes up several shards
+                    while (k<no_shards && weight*no_shards>=total_weight*k) ++k;
+
+                    if (cut.contig<(int32_t)contigs.size())
+                    {
+                        cuts.push_back(cut);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Moves a cut at pos1 to the right to the first position within the search window
+     * that no record overlaps and that is not within a short tandem repeat.
+     */
+    int32_t refine(int32_t contig, int32_t pos1)
+    {
+        int32_t tid = tids[contig];
+        int32_t n = search_window+1;
+
+        //blocked[i] is set if the cut before pos1+i is to be avoided
+        std::vector<bool> blocked(n, false);
+
+        if (format!=SCATTER_BAM)
+        {
+            bcf1_t* v = bcf_init();
+            kstring_t s = {0,0,0};
+            hts_itr_t* itr = format==SCATTER_BCF ? bcf_itr_queryi(idx, tid, pos1-2, pos1-1+n) : tbx_itr_queryi(tbx, tid, pos1-2, pos1-1+n);
+            while (itr)
+            {
+                if (format==SCATTER_BCF)
+                {
+                    if (bcf_itr_next(file, itr, v)<0) break;
+                }
+                else
+                {
+                    if (tbx_itr_next(file, tbx, itr, &s)<0) break;
+                    vcf_parse1(&s, hdr, v);
+                }
+
+                //the record spans pos1+1 to end1 inclusive
+                int64_t beg1 = v->pos+1;
+                int64_t end1 = v->pos+v->rlen;
+                for (int64_t q=std::max(beg1+1, (int64_t)pos1); q<=end1 && q<pos1+n; ++q)
+                {
+                    blocked[q-pos1] = true;
+                }
+            }
+            if (itr) hts_itr_destroy(itr);
+            if (s.m) free(s.s);
+            bcf_destroy(v);
+        }
+
+        if (fai && max_mlen)
+        {
+            int32_t beg0 = std::max(pos1-1-max_mlen, 0);
+            int32_t len = 0;
+            char* seq = faidx_fetch_uc_seq(fai, contigs[contig].c_str(), beg0, pos1-1+n+max_mlen, &len);
+            if (seq)
+            {
+                for (int32_t q=pos1; q<pos1+n; ++q)
+                {
+                    //a repeat unit of length k ends at q-1 and starts again at q
+                    for (int32_t k=1; k<=max_mlen && !blocked[q-pos1]; ++k)
+                    {
+                        int32_t l = q-1-k-beg0;
+                        int32_t r = q-1-beg0;
+                        if (l>=0 && r+k<=len && !strncmp(seq+l, seq+r, k))
+                        {
+                            blocked[q-pos1] = true;
+                        }
+                    }
+                }
+                free(seq);
+            }
+        }
+
+        for (int32_t i=0; i<n; ++i)
+        {
+            if (!blocked[i]) return pos1+i;
+        }
+
+        return pos1;
+    }
+
+    /**
+     * Writes the interval list of each shard.
+     */
+    void write()
+    {
+        int32_t no_written = cuts.size()+1;
+        int32_t width = 1;
+        for (int32_t i=no_written; i>=10; i/=10) ++width;
+
+        shard_weights.resize(no_written, 0);
+        shard_records.resize(no_written, 0);
+        shard_intervals.resize(no_written, 0);
+
+        for (int32_t i=0; i<no_written; ++i)
+        {
+            kstring_t fn = {0,0,0};
+            ksprintf(&fn, "%s.%0*d.txt", output_prefix.c_str(), width, i+1);
+            FILE* out = fopen(fn.s, "w");
+            if (!out)
+            {
+                fprintf(stderr, "[%s:%d %s] Cannot open %s\n", __FILE__, __LINE__, __FUNCTION__, fn.s);
+                exit(1);
+            }
+
+            cut_t beg = i ? cuts[i-1] : cut_t{0, 1};
+            cut_t end = i<(int32_t)cuts.size() ? cuts[i] : cut_t{(int32_t)contigs.size(), 1};
+            for (int32_t c=beg.contig; c<=end.contig && c<(int32_t)contigs.size(); ++c)
+            {
+                int32_t start1 = c==beg.contig ? beg.pos1 : 1;
+                int32_t end1 = c==end.contig ? end.pos1-1 : SCATTER_MAX_POS-1;
+                if (end1<start1) continue;
+
+                GenomeInterval interval(contigs[c], start1, end1);
+                fprintf(out, "%s\n", interval.to_string().c_str());
+                ++shard_intervals[i];
+
+                //weights of the tiles starting in the interval
+                int64_t weight = 0;
+                int64_t contig_weight = 0;
+                for (size_t j=0; j<weights[c].size(); ++j)
+                {
+                    int64_t tile_beg1 = (int64_t)j*tile_size+1;
+                    if (tile_beg1>=start1 && tile_beg1<=end1) weight += weights[c][j];
+                    contig_weight += weights[c][j];
+                }
+                shard_weights[i] += weight;
+                if (contig_records[c]>0 && contig_weight)
+                {
+                    shard_records[i] += contig_records[c]*weight/contig_weight;
+                }
+            }
+
+            fclose(out);
+            free(fn.s);
+        }
+    }
+
+    void print_options()
+    {
+        std::clog << "scatter v" << version << "\n";
+        std::clog << "\n";
+        std::clog << "options:     input file                " << input_file << "\n";
+        std::clog << "         [o] output prefix             " << output_prefix << "\n";
+        std::clog << "         [n] no. of shards             " << no_shards << "\n";
+        std::clog << "         [w] tile size                 " << tile_size << "\n";
+        print_ref_op("         [r] reference FASTA file      ", ref_fasta_file);
+        print_num_op("         [m] max repeat unit length    ", max_mlen);
+        print_num_op("         [s] search window             ", search_window);
+        std::clog << "\n";
+    }
+
+    void print_stats()
+    {
+        std::clog << "\n";
+        std::clog << "stats: no. of contigs with records        " << contigs.size() << "\n";
+        std::clog << "       estimated compressed bytes         " << total_weight << "\n";
+        std::clog << "       no. of shards                      " << shard_weights.size() << "\n";
+        std::clog << "       no. of cuts moved                  " << no_moved_cuts << "\n";
+        std::clog << "\n";
+        std::clog << "       shard  intervals        bytes      records\n";
+        for (size_t i=0; i<shard_weights.size(); ++i)
+        {
+            fprintf(stderr, "       %5zu %10d %12lld %12lld\n", i+1, shard_intervals[i], (long long)shard_weights[i], (long long)shard_records[i]);
+        }
+        std::clog << "\n";
+    };
+
+    ~Igor() {};
+
+    private:
+};
+
+}
+
+void scatter(int argc, char ** argv)
+{
+    Igor igor(argc, argv);
+    igor.print_options();
+    igor.initialize();
+    igor.scatter();
+    igor.print_stats();
+};
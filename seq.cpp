@@ -35,6 +35,8 @@ class Igor : Program
     ///////////
     std::vector<GenomeInterval> intervals;
     std::string ref_fasta_file;
+    std::string packed_file;
+    bool pack;
     bool print;
 
     ///////
@@ -44,6 +46,7 @@ class Igor : Program
     /////////
     //stats//
     /////////
+    int32_t no_sequences;
 
     /////////
     //tools//
@@ -68,12 +71,17 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_intervals("i", "i", "intervals []", false, "", "str", cmd);
             TCLAP::SwitchArg arg_quiet("q", "q", "quiet [false]", cmd, false);
             TCLAP::ValueArg<std::string> arg_interval_list("I", "I", "file containing list of intervals []", false, "", "file", cmd);
+            TCLAP::SwitchArg arg_pack("p", "pack", "pack the reference into a 2 bit memory mapped image that replaces the FASTA file in annotation tools [false]", cmd, false);
+            TCLAP::ValueArg<std::string> arg_packed_file("o", "o", "packed reference file [<ref>.pack]", false, "", "file", cmd);
 
             cmd.parse(argc, argv);
 
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
             ref_fasta_file = arg_ref_fasta_file.getValue();
             print = !arg_quiet.getValue();
+            pack = arg_pack.getValue();
+            packed_file = arg_packed_file.getValue();
+            if (packed_file=="") packed_file = ref_fasta_file + ".pack";
         }
         catch (TCLAP::ArgException &e)
         {
@@ -95,6 +103,9 @@ class Igor : Program
         ////////////////////////
         //tools initialization//
         ////////////////////////
+        no_sequences = 0;
+        if (pack) return;
+
         if (ref_fasta_file!="")
         {
             fai = fai_load(ref_fasta_file.c_str());
@@ -109,6 +120,12 @@ class Igor : Program
 
     void seq()
     {
+        if (pack)
+        {
+            no_sequences = PackedReference::pack(ref_fasta_file, packed_file);
+            return;
+        }
+
         if (print) std::clog << "\n";
         for (size_t i=0; i<intervals.size();++i)
         {
@@ -155,11 +172,17 @@ class Igor : Program
         std::clog << "\n";
         std::clog << "options: [r] reference FASTA file  " << ref_fasta_file << "\n";
         print_int_op("         [i] intervals             ", intervals);
+        print_boo_op("         [p] pack                  ", pack);
+        if (pack) print_str_op("         [o] packed reference file ", packed_file);
         std::clog << "\n";
     }
 
     void print_stats()
     {
+        if (!print || !pack) return;
+
+        std::clog << "stats: no. of sequences packed  " << no_sequences << "\n";
+        std::clog << "\n";
     };
 
     ~Igor() {};
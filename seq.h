@@ -25,6 +25,7 @@
 #define SEQ_H
 
 #include "program.h"
+#include "packed_reference.h"
 
 bool seq(int argc, char ** argv);
 
@@ -0,0 +1,616 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "serve.h"
+
+namespace
+{
+
+//maximum size of the command line of a job
+#define SERVE_MAX_REQUEST (1<<20)
+
+volatile sig_atomic_t stopped = 0;
+
+void stop(int sig)
+{
+    stopped = 1;
+}
+
+void wake(int sig)
+{
+}
+
+/**
+ * Fills in the address of a Unix socket.
+ * Returns false if the path is too long.
+ */
+bool get_address(std::string& socket_file, struct sockaddr_un* addr)
+{
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    if (socket_file.size()>=sizeof(addr->sun_path)) return false;
+    strcpy(addr->sun_path, socket_file.c_str());
+    return true;
+}
+
+/**
+ * Writes n bytes to fd.
+ * Returns false on failure.
+ */
+bool write_all(int fd, const char* buf, size_t n)
+{
+    while (n)
+    {
+        ssize_t k = write(fd, buf, n);
+        if (k<0)
+        {
+            if (errno==EINTR) continue;
+            return false;
+        }
+        buf += k;
+        n -= k;
+    }
+
+    return true;
+}
+
+/**
+ * Reads n bytes from fd.
+ * Returns false on failure or end of file.
+ */
+bool read_all(int fd, char* buf, size_t n)
+{
+    while (n)
+    {
+        ssize_t k = read(fd, buf, n);
+        if (k<0)
+        {
+            if (errno==EINTR) continue;
+            return false;
+        }
+        if (k==0) return false;
+        buf += k;
+        n -= k;
+    }
+
+    return true;
+}
+
+/**
+ * Submits the command in argv to the server listening on socket_file.
+ *
+ * A request is the length of the command line sent together with the
+ * standard input, output and error of the client, followed by the working
+ * directory and the arguments, each terminated by a null character.  The
+ * server replies with the exit status of the job.
+ */
+int submit(std::string& socket_file, int argc, char** argv)
+{
+    struct sockaddr_un addr;
+    if (!get_address(socket_file, &addr))
+    {
+        fprintf(stderr, "[%s:%d %s] Socket path too long: %s\n", __FILE__, __LINE__, __FUNCTION__, socket_file.c_str());
+        return 1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd<0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)))
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot connect to %s: %s\n", __FILE__, __LINE__, __FUNCTION__, socket_file.c_str(), strerror(errno));
+        return 1;
+    }
+
+    std::string request;
+    char* cwd = getcwd(NULL, 0);
+    if (cwd)
+    {
+        request.append(cwd);
+        free(cwd);
+    }
+    request.append(1, '\0');
+    request.append("vt");
+    request.append(1, '\0');
+    for (int32_t i=0; i<argc; ++i)
+    {
+        request.append(argv[i]);
+        request.append(1, '\0');
+    }
+
+    if (request.size()>SERVE_MAX_REQUEST)
+    {
+        fprintf(stderr, "[%s:%d %s] Command line too long\n", __FILE__, __LINE__, __FUNCTION__);
+        return 1;
+    }
+
+    uint32_t len = request.size();
+    int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    union
+    {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } control;
+
+    struct iovec iov;
+    iov.iov_base = &len;
+    iov.iov_len = sizeof(len);
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    int32_t status = 1;
+    if (sendmsg(fd, &msg, 0)!=sizeof(len) ||
+        !write_all(fd, request.c_str(), len) ||
+        !read_all(fd, (char*) &status, sizeof(status)))
+    {
+        fprintf(stderr, "[%s:%d %s] Lost connection to %s\n", __FILE__, __LINE__, __FUNCTION__, socket_file.c_str());
+        status = 1;
+    }
+
+    close(fd);
+    return status;
+}
+
+class Igor : Program
+{
+    public:
+
+    ///////////
+    //options//
+    ///////////
+    std::string socket_file;
+    int32_t no_workers;
+    std::vector<std::string> ref_fasta_files;
+    std::vector<std::string> gencode_index_files;
+    std::vector<std::string> bed_files;
+
+    ///////
+    //i/o//
+    ///////
+    int fd;
+
+    //signal mask of the server within pselect
+    sigset_t mask;
+
+    //client connection of each running job
+    std::map<pid_t, int> jobs;
+
+    /////////
+    //tools//
+    /////////
+    int (*run)(int argc, char **argv);
+    std::vector<PackedReference*> prs;
+    std::vector<GENCODEIndex*> gcis;
+    std::vector<BEDTrack*> tracks;
+
+    /////////
+    //stats//
+    /////////
+    uint32_t no_jobs;
+    uint32_t no_failed_jobs;
+
+    Igor(int argc, char **argv, int (*run)(int argc, char **argv))
+    {
+        version = "0.5";
+        this->run = run;
+
+        //////////////////////////
+        //options initialization//
+        //////////////////////////
+        try
+        {
+            std::string desc = "Keeps packed references, GENCODE indices and BED tracks resident and runs vt\n"
+                 "              commands submitted to a local Unix socket.  Each job runs in a forked worker\n"
+                 "              that shares the resident resources read only and uses the working directory\n"
+                 "              and standard streams of the client.  Only the user running the server may\n"
+                 "              submit jobs.\n"
+                 "\n"
+                 "              vt serve -s vt.sock -r hs37d5.fa -x gencode.idx -b cds.bed.gz\n"
+                 "              vt serve -c vt.sock normalize in.vcf -r hs37d5.fa -o out.vcf";
+
+            TCLAP::CmdLine cmd(desc, ' ', version);
+            VTOutput my; cmd.setOutput(&my);
+            TCLAP::ValueArg<std::string> arg_socket_file("s", "s", "Unix socket to listen on", true, "", "file", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_workers("t", "t", "maximum no. of jobs run at the same time [4]", false, 4, "int", cmd);
+            TCLAP::MultiArg<std::string> arg_ref_fasta_files("r", "r", "reference sequence fasta file packed with vt seq --pack, kept resident []", false, "str", cmd);
+            TCLAP::MultiArg<std::string> arg_gencode_index_files("x", "x", "GENCODE index file built with index_gencode or GENCODE GTF file indexed against the first FASTA file of -r, kept resident []", false, "str", cmd);
+            TCLAP::MultiArg<std::string> arg_bed_files("b", "b", "BED file indexed with tabix, kept resident for the overlap matching of jobs []", false, "str", cmd);
+
+            cmd.parse(argc, argv);
+
+            socket_file = arg_socket_file.getValue();
+            no_workers = std::max(arg_no_workers.getValue(), 1);
+            ref_fasta_files = arg_ref_fasta_files.getValue();
+            gencode_index_files = arg_gencode_index_files.getValue();
+            bed_files = arg_bed_files.getValue();
+        }
+        catch (TCLAP::ArgException &e)
+        {
+            std::cerr << "error: " << e.error() << " for arg " << e.argId() << "\n";
+            abort();
+        }
+    };
+
+    void initialize()
+    {
+        //the progress thread and statistics of the server would be copied into every job
+        if (Instrument::enabled)
+        {
+            fprintf(stderr, "[%s:%d %s] --stats-json and --progress are given to each submitted job\n", __FILE__, __LINE__, __FUNCTION__);
+            exit(1);
+        }
+
+        ////////////////////////
+        //tools initialization//
+        ////////////////////////
+        for (size_t i=0; i<ref_fasta_files.size(); ++i)
+        {
+            std::string packed_file = ref_fasta_files[i] + ".pack";
+            if (PackedReference::is_packed(ref_fasta_files[i]))
+            {
+                prs.push_back(PackedReference::acquire(ref_fasta_files[i]));
+            }
+            else if (PackedReference::is_current(packed_file, ref_fasta_files[i]))
+            {
+                prs.push_back(PackedReference::acquire(packed_file));
+            }
+            else if (PackedReference::is_packed(packed_file))
+            {
+                fprintf(stderr, "[%s:%d %s] %s is not packed from the current %s, run vt seq --pack again\n", __FILE__, __LINE__, __FUNCTION__, packed_file.c_str(), ref_fasta_files[i].c_str());
+                exit(1);
+            }
+            else
+            {
+                fprintf(stderr, "[%s:%d %s] Not a packed reference, run vt seq --pack first: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_files[i].c_str());
+                exit(1);
+            }
+        }
+
+        for (size_t i=0; i<gencode_index_files.size(); ++i)
+        {
+            if (GENCODEIndex::is_index(gencode_index_files[i]))
+            {
+                gcis.push_back(GENCODEIndex::acquire(gencode_index_files[i]));
+                continue;
+            }
+
+            //a GTF file is indexed here and jobs refer to it by the GTF file
+            std::string ref_fasta_file;
+            for (size_t j=0; j<ref_fasta_files.size() && ref_fasta_file==""; ++j)
+            {
+                if (!PackedReference::is_packed(ref_fasta_files[j])) ref_fasta_file = ref_fasta_files[j];
+            }
+            if (ref_fasta_file=="")
+            {
+                fprintf(stderr, "[%s:%d %s] A FASTA file is required with -r to index the GENCODE GTF file %s\n", __FILE__, __LINE__, __FUNCTION__, gencode_index_files[i].c_str());
+                exit(1);
+            }
+            gcis.push_back(GENCODEIndex::acquire(gencode_index_files[i], ref_fasta_file));
+        }
+
+        for (size_t i=0; i<bed_files.size(); ++i)
+        {
+            tracks.push_back(BEDTrack::acquire(bed_files[i]));
+        }
+
+        //////////////////////
+        //i/o initialization//
+        //////////////////////
+        struct sockaddr_un addr;
+        if (!get_address(socket_file, &addr))
+        {
+            fprintf(stderr, "[%s:%d %s] Socket path too long: %s\n", __FILE__, __LINE__, __FUNCTION__, socket_file.c_str());
+            exit(1);
+        }
+
+        //only a stale socket is replaced
+        struct stat st;
+        if (!lstat(socket_file.c_str(), &st))
+        {
+            if (!S_ISSOCK(st.st_mode))
+            {
+                fprintf(stderr, "[%s:%d %s] %s exists and is not a socket\n", __FILE__, __LINE__, __FUNCTION__, socket_file.c_str());
+                exit(1);
+            }
+
+            int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+            bool live = probe>=0 && !connect(probe, (struct sockaddr*) &addr, sizeof(addr));
+            if (probe>=0) close(probe);
+            if (live)
+            {
+                fprintf(stderr, "[%s:%d %s] A server is already listening on %s\n", __FILE__, __LINE__, __FUNCTION__, socket_file.c_str());
+                exit(1);
+            }
+
+            unlink(socket_file.c_str());
+        }
+
+        //the socket is created accessible to the user only
+        mode_t old_umask = umask(0177);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool bound = fd>=0 && !bind(fd, (struct sockaddr*) &addr, sizeof(addr));
+        umask(old_umask);
+        if (!bound || chmod(socket_file.c_str(), S_IRUSR|S_IWUSR) || listen(fd, 64))
+        {
+            fprintf(stderr, "[%s:%d %s] Cannot listen on %s: %s\n", __FILE__, __LINE__, __FUNCTION__, socket_file.c_str(), strerror(errno));
+            exit(1);
+        }
+
+        //the wait for connections is interrupted on termination and when a job finishes,
+        //SIGCHLD is only delivered within pselect so that no job is missed
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = stop;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        sa.sa_handler = wake;
+        sigaction(SIGCHLD, &sa, NULL);
+        signal(SIGPIPE, SIG_IGN);
+
+        sigset_t chld;
+        sigemptyset(&chld);
+        sigaddset(&chld, SIGCHLD);
+        sigprocmask(SIG_BLOCK, &chld, &mask);
+
+        ////////////////////////
+        //stats initialization//
+        ////////////////////////
+        no_jobs = 0;
+        no_failed_jobs = 0;
+    }
+
+    void serve()
+    {
+        while (!stopped)
+        {
+            reap(false);
+
+            fd_set fds;
+            FD_ZERO(&fds);
+            if (jobs.size()<(size_t)no_workers) FD_SET(fd, &fds);
+            if (pselect(fd+1, &fds, NULL, NULL, NULL, &mask)<0)
+            {
+                if (errno==EINTR) continue;
+                fprintf(stderr, "[%s:%d %s] Cannot wait for connections: %s\n", __FILE__, __LINE__, __FUNCTION__, strerror(errno));
+                break;
+            }
+            if (!FD_ISSET(fd, &fds)) continue;
+
+            int client = accept(fd, NULL, NULL);
+            if (client<0)
+            {
+                if (errno==EINTR || errno==ECONNABORTED) continue;
+                fprintf(stderr, "[%s:%d %s] Cannot accept connection: %s\n", __FILE__, __LINE__, __FUNCTION__, strerror(errno));
+                break;
+            }
+
+            if (!is_owner(client))
+            {
+                fprintf(stderr, "[%s:%d %s] Refused a connection from another user\n", __FILE__, __LINE__, __FUNCTION__);
+                close(client);
+                continue;
+            }
+
+            fflush(stdout);
+            fflush(stderr);
+            pid_t pid = fork();
+            if (pid==0)
+            {
+                close(fd);
+                for (std::map<pid_t, int>::iterator i=jobs.begin(); i!=jobs.end(); ++i) close(i->second);
+                sigprocmask(SIG_SETMASK, &mask, NULL);
+                exit(execute(client));
+            }
+            else if (pid<0)
+            {
+                fprintf(stderr, "[%s:%d %s] Cannot fork: %s\n", __FILE__, __LINE__, __FUNCTION__, strerror(errno));
+                int32_t status = 1;
+                write_all(client, (char*) &status, sizeof(status));
+                close(client);
+                ++no_failed_jobs;
+            }
+            else
+            {
+                jobs[pid] = client;
+                ++no_jobs;
+            }
+        }
+
+        while (jobs.size()) reap(true);
+
+        close(fd);
+        unlink(socket_file.c_str());
+
+        for (size_t i=0; i<prs.size(); ++i) PackedReference::release(prs[i]);
+        for (size_t i=0; i<gcis.size(); ++i) GENCODEIndex::release(gcis[i]);
+        for (size_t i=0; i<tracks.size(); ++i) BEDTrack::release(tracks[i]);
+    };
+
+    /**
+     * Checks that the client connected on fd runs as the user of the server.
+     */
+    bool is_owner(int fd)
+    {
+#ifdef SO_PEERCRED
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len)) return false;
+        return cred.uid==getuid();
+#else
+        //the mode of the socket restricts access to the user
+        return true;
+#endif
+    }
+
+    /**
+     * Collects finished jobs and replies to their clients with the exit status.
+     * Waits for a job to finish if block is true.
+     */
+    void reap(bool block)
+    {
+        int s;
+        pid_t pid;
+        while ((pid = waitpid(-1, &s, block ? 0 : WNOHANG))>0 || (pid<0 && errno==EINTR))
+        {
+            if (pid<0) continue;
+
+            std::map<pid_t, int>::iterator i = jobs.find(pid);
+            if (i==jobs.end()) continue;
+
+            int32_t status = WIFEXITED(s) ? WEXITSTATUS(s) : 128+WTERMSIG(s);
+            if (status) ++no_failed_jobs;
+            write_all(i->second, (char*) &status, sizeof(status));
+            close(i->second);
+            jobs.erase(i);
+
+            block = false;
+        }
+    }
+
+    /**
+     * Receives a job from a client and runs it in this worker.
+     * Returns the exit status of the job.
+     */
+    int execute(int client)
+    {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+
+        uint32_t len = 0;
+        int fds[3];
+        union
+        {
+            struct cmsghdr align;
+            char buf[CMSG_SPACE(sizeof(fds))];
+        } control;
+
+        struct iovec iov;
+        iov.iov_base = &len;
+        iov.iov_len = sizeof(len);
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        //a connection closed without a request checks for a live server
+        ssize_t k = recvmsg(client, &msg, 0);
+        if (k==0) return 1;
+
+        struct cmsghdr* cmsg;
+        if (k!=sizeof(len) ||
+            !(cmsg = CMSG_FIRSTHDR(&msg)) ||
+            cmsg->cmsg_type!=SCM_RIGHTS ||
+            cmsg->cmsg_len!=CMSG_LEN(sizeof(fds)) ||
+            len>SERVE_MAX_REQUEST)
+        {
+            fprintf(stderr, "[%s:%d %s] Invalid request\n", __FILE__, __LINE__, __FUNCTION__);
+            return 1;
+        }
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+        std::vector<char> request(len+1, '\0');
+        if (!read_all(client, request.data(), len))
+        {
+            fprintf(stderr, "[%s:%d %s] Invalid request\n", __FILE__, __LINE__, __FUNCTION__);
+            return 1;
+        }
+        close(client);
+
+        //working directory followed by the arguments
+        std::vector<char*> args;
+        for (uint32_t i=0; i<len; i+=strlen(&request[i])+1)
+        {
+            args.push_back(&request[i]);
+        }
+
+        for (int32_t i=0; i<3; ++i)
+        {
+            dup2(fds[i], i);
+            if (fds[i]>2) close(fds[i]);
+        }
+
+        if (args.size()<3 || chdir(args[0]))
+        {
+            fprintf(stderr, "[%s:%d %s] Invalid request\n", __FILE__, __LINE__, __FUNCTION__);
+            return 1;
+        }
+        args.push_back(NULL);
+
+        int status = run(args.size()-2, &args[1]);
+        fflush(stdout);
+        return status;
+    }
+
+    void print_options()
+    {
+        std::clog << "serve v" << version << "\n";
+        std::clog << "\n";
+        std::clog << "options:     socket                   " << socket_file << "\n";
+        std::clog << "         [t] no. of workers           " << no_workers << "\n";
+        print_strvec("         [r] reference FASTA files    ", ref_fasta_files);
+        print_strvec("         [x] GENCODE index files      ", gencode_index_files);
+        print_strvec("         [b] BED files                ", bed_files);
+        std::clog << "\n";
+    }
+
+    void print_stats()
+    {
+        std::clog << "\n";
+        std::clog << "stats: no. of jobs                    " << no_jobs << "\n";
+        std::clog << "       no. of failed jobs             " << no_failed_jobs << "\n";
+        std::clog << "\n";
+    };
+
+    ~Igor() {};
+
+    private:
+};
+
+}
+
+void serve(int argc, char ** argv, int (*run)(int argc, char **argv))
+{
+    if (argc>=3 && !strcmp(argv[1], "-c"))
+    {
+        std::string socket_file(argv[2]);
+        exit(submit(socket_file, argc-3, argv+3));
+    }
+
+    Igor igor(argc, argv, run);
+    igor.print_options();
+    igor.initialize();
+    igor.serve();
+    igor.print_stats();
+};
@@ -476,8 +476,6 @@ void SNPGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleInd
         int32_t cycle = 0;
 
         std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-        std::vector<std::string>& aug_ref = as.aug_ref;
-        std::vector<std::string>& aug_alt = as.aug_alt;
 
         int32_t vpos1 = pos1;
         int32_t cpos1 = bam_get_pos1(s);
@@ -512,7 +510,7 @@ void SNPGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleInd
             {
                 if (vpos1==cpos1)
                 {
-                    allele = (aug_alt[i].at(0) == v_alleles[1].at(0)) ? 1 : -1;
+                    allele = (as.get_alt_base(i, 0) == v_alleles[1].at(0)) ? 1 : -1;
                     q = qual[rpos0];
                     cycle = rpos0<(rlen>>1) ? (rpos0+1) : -(rlen - rpos0 + 1);
                     break;
@@ -564,8 +562,6 @@ void SNPGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleInd
         int32_t cycle = 0;
 
         std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-        std::vector<std::string>& aug_ref = as.aug_ref;
-        std::vector<std::string>& aug_alt = as.aug_alt;
 
         int32_t vpos1 = pos1;
         int32_t cpos1 = bam_get_pos1(s);
@@ -600,7 +596,7 @@ void SNPGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleInd
             {
                 if (vpos1==cpos1)
                 {
-                    allele = (aug_alt[i].at(0) == v_alleles[1].at(0)) ? 1 : -1;
+                    allele = (as.get_alt_base(i, 0) == v_alleles[1].at(0)) ? 1 : -1;
                     q = qual[rpos0];
                     cycle = rpos0<(rlen>>1) ? (rpos0+1) : -(rlen - rpos0 + 1);
                     break;
@@ -25,6 +25,22 @@
 
 namespace
 {
+
+/**
+ * A block of records scored by one thread.
+ */
+typedef struct
+{
+    std::vector<bcf1_t*> records;
+    std::vector<char> selected;
+    int32_t no_records;
+
+    //records passing the filter and their scores
+    std::vector<bcf1_t*> scored;
+    std::vector<float> scores;
+    SVMBlock* workspace;
+} block_t;
+
 class Igor : Program
 {
     public:
@@ -35,18 +51,20 @@ class Igor : Program
     //options//
     ///////////
     std::string input_vcf_file;
-    std::vector<std::string> input_vcf_files;
-    std::string ref_fasta_file;
-    std::string ref_data_sets_list;
+    std::string output_vcf_file;
+    std::string model_file;
+    std::vector<std::string> features;
+    std::string SCORE;
     std::vector<GenomeInterval> intervals;
     std::string interval_list;
+    int32_t no_threads;
+    int32_t block_size;
 
     ///////
     //i/o//
     ///////
     BCFOrderedReader *odr;
-    bcf1_t *v;
-    kstring_t line;
+    BCFOrderedWriter *odw;
 
     //////////
     //filter//
@@ -54,17 +72,20 @@ class Igor : Program
     std::string fexp;
     Filter filter;
     bool filter_exists;
-   
+
     /////////
     //stats//
     /////////
-    int32_t no_snps;
-    
+    int32_t no_variants;
+    int32_t no_variants_scored;
+
     ////////////////
     //common tools//
     ////////////////
     VariantManip *vm;
-   
+    SVMScorer *scorer;
+    std::vector<block_t> blocks;
+
     Igor(int argc, char ** argv)
     {
         //////////////////////////
@@ -72,21 +93,32 @@ class Igor : Program
         //////////////////////////
         try
         {
-            std::string desc = "svm_predict";
+            std::string desc = "Scores variants with a libsvm model using INFO fields as features.";
 
             version = "0.5";
             TCLAP::CmdLine cmd(desc, ' ', version);
             VTOutput my; cmd.setOutput(&my);
-            TCLAP::ValueArg<std::string> arg_model_file("r", "r", "reference sequence fasta file []", true, "", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_model_file("m", "m", "libsvm model file []", true, "", "file", cmd);
+            TCLAP::ValueArg<std::string> arg_features("u", "u", "INFO fields of the features 1,2,... of the model, comma separated []", true, "", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_score_tag("s", "s", "INFO tag of the score [SVM_SCORE]", false, "SVM_SCORE", "str", cmd);
             TCLAP::ValueArg<std::string> arg_intervals("i", "i", "intervals []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_interval_list("I", "I", "file containing list of intervals []", false, "", "file", cmd);
-            TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter expression []", false, "VTYPE==SNP", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "str", cmd);
+            TCLAP::ValueArg<std::string> arg_fexp("f", "f", "filter expression [VTYPE==SNP]", false, "VTYPE==SNP", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of scoring threads [1]", false, 1, "int", cmd);
+            TCLAP::ValueArg<int32_t> arg_block_size("b", "b", "no. of records scored in a block [1024]", false, 1024, "int", cmd);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
 
             cmd.parse(argc, argv);
 
+            model_file = arg_model_file.getValue();
+            split(features, ",", arg_features.getValue());
+            SCORE = arg_score_tag.getValue();
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
+            output_vcf_file = arg_output_vcf_file.getValue();
             fexp = arg_fexp.getValue();
+            no_threads = std::max(arg_no_threads.getValue(), 1);
+            block_size = std::max(arg_block_size.getValue(), 1);
             input_vcf_file = arg_input_vcf_file.getValue();
         }
         catch (TCLAP::ArgException &e)
@@ -108,30 +140,125 @@ class Igor : Program
         //i/o initialization//
         //////////////////////
         odr = new BCFOrderedReader(input_vcf_file, intervals);
+        odr->set_required_fields(BCF_UN_INFO);
+        odw = new BCFOrderedWriter(output_vcf_file);
+        odw->link_hdr(odr->hdr);
+        SCORE = bcf_hdr_append_info_with_backup_naming(odw->hdr, SCORE, "1", "Float", "SVM score.", true);
 
         ///////////////////////
         //tool initialization//
         ///////////////////////
-        vm = new VariantManip(ref_fasta_file);
-        
+        vm = new VariantManip("");
+        scorer = new SVMScorer(model_file, odr->hdr, features);
+
+        blocks.resize(no_threads);
+        for (int32_t i=0; i<no_threads; ++i)
+        {
+            block_t& b = blocks[i];
+            b.records.resize(block_size);
+            b.selected.resize(block_size);
+            b.scores.resize(block_size);
+            for (int32_t j=0; j<block_size; ++j)
+            {
+                b.records[j] = bcf_init1();
+            }
+            b.no_records = 0;
+            b.workspace = new SVMBlock(scorer, block_size);
+        }
+
         ////////////////////////
         //stats initialization//
         ////////////////////////
+        no_variants = 0;
+        no_variants_scored = 0;
+    }
+
+    /**
+     * Reads the next no_threads blocks of records.
+     * Returns false when there are no more records.
+     */
+    bool read_blocks()
+    {
+        Variant variant;
+        bool read = false;
+        for (int32_t i=0; i<no_threads; ++i)
+        {
+            block_t& b = blocks[i];
+            b.no_records = 0;
+            b.scored.clear();
 
+            while (b.no_records<block_size && odr->read(b.records[b.no_records]))
+            {
+                bcf1_t *v = b.records[b.no_records];
+                bool selected = true;
+                if (filter_exists)
+                {
+                    vm->classify_variant(odr->hdr, v, variant);
+                    selected = filter.apply(odr->hdr, v, &variant, false);
+                }
+
+                b.selected[b.no_records++] = selected;
+                if (selected) b.scored.push_back(v);
+            }
+
+            read = read || b.no_records;
+        }
+
+        return read;
+    }
+
+    /**
+     * Scores the records of a block.
+     */
+    void score_block(block_t* b)
+    {
+        scorer->score(b->scored.data(), b->scored.size(), b->scores.data(), b->workspace);
     }
 
     void svm_predict()
     {
-        Variant variant;
-        bcf1_t *v = bcf_init1();
-        while(odr->read(v))
+        odw->write_hdr();
+
+        while (read_blocks())
         {
-            //apply model
-            
-            //add SVM score
-         
-            //write out
+            if (no_threads==1)
+            {
+                score_block(&blocks[0]);
+            }
+            else
+            {
+                std::vector<std::thread> threads;
+                for (int32_t i=0; i<no_threads; ++i)
+                {
+                    threads.push_back(std::thread(&Igor::score_block, this, &blocks[i]));
+                }
+                for (int32_t i=0; i<no_threads; ++i)
+                {
+                    threads[i].join();
+                }
+            }
+
+            //the blocks are written out in the order they were read
+            for (int32_t i=0; i<no_threads; ++i)
+            {
+                block_t& b = blocks[i];
+                int32_t k = 0;
+                for (int32_t j=0; j<b.no_records; ++j)
+                {
+                    bcf1_t *v = b.records[j];
+                    if (b.selected[j])
+                    {
+                        bcf_update_info_float(odw->hdr, v, SCORE.c_str(), &b.scores[k++], 1);
+                        ++no_variants_scored;
+                    }
+                    odw->write(v);
+                    ++no_variants;
+                }
+            }
         }
+
+        odw->close();
+        odr->close();
     };
 
     void print_options()
@@ -139,19 +266,36 @@ class Igor : Program
         std::clog << "svm_predict v" << version << "\n\n";
         std::clog << "\n";
         std::clog << "Options:     input VCF File                 " << input_vcf_file << "\n";
+        std::clog << "         [o] output VCF file                " << output_vcf_file << "\n";
+        std::clog << "         [m] model file                     " << model_file << "\n";
+        print_strvec("         [u] features                       ", features);
+        print_str_op("         [s] score tag                      ", SCORE);
         print_str_op("         [f] filter                         ", fexp);
+        print_num_op("         [t] no. of threads                 ", no_threads);
+        print_num_op("         [b] block size                     ", block_size);
         print_int_op("         [i] intervals                      ", intervals);
         std::clog << "\n\n";
    }
 
     void print_stats()
     {
-      
-
+        std::clog << "\n";
+        std::clog << "stats: no. of variants scored   " << no_variants_scored << "\n";
+        std::clog << "       total no. of variants    " << no_variants << "\n";
+        std::clog << "\n";
     };
 
     ~Igor()
     {
+        for (size_t i=0; i<blocks.size(); ++i)
+        {
+            for (size_t j=0; j<blocks[i].records.size(); ++j)
+            {
+                bcf_destroy(blocks[i].records[j]);
+            }
+            delete blocks[i].workspace;
+        }
+        delete scorer;
     };
 
     private:
@@ -24,8 +24,9 @@
 #ifndef SVM_PREDICT_H
 #define SVM_PREDICT_H
 
+#include <thread>
 #include "program.h"
-#include "libsvm/svm.h"
+#include "svm_scorer.h"
 
 void svm_predict(int argc, char ** argv);
 
@@ -0,0 +1,367 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "svm_scorer.h"
+
+/**
+ * Allocates the matrices for blocks of up to capacity records.
+ */
+SVMBlock::SVMBlock(SVMScorer* scorer, int32_t capacity)
+{
+    this->capacity = capacity;
+    x = (double*) malloc(sizeof(double)*capacity*std::max(scorer->no_features, 1));
+    xn = (double*) malloc(sizeof(double)*capacity);
+    dec = (double*) malloc(sizeof(double)*capacity*scorer->no_decs);
+    if (posix_memalign((void**)&k, SVM_ALIGNMENT, sizeof(double)*SVM_TILE))
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot allocate memory\n", __FILE__, __LINE__, __FUNCTION__);
+        exit(1);
+    }
+}
+
+/**
+ * Frees the matrices.
+ */
+SVMBlock::~SVMBlock()
+{
+    free(x);
+    free(xn);
+    free(k);
+    free(dec);
+}
+
+/**
+ * Loads a model, the features are the INFO fields of h in the order of
+ * the feature indices of the model.
+ */
+SVMScorer::SVMScorer(std::string& model_file, bcf_hdr_t* h, std::vector<std::string>& features)
+{
+    model = svm_load_model(model_file.c_str());
+    if (!model)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot load SVM model %s\n", __FILE__, __LINE__, __FUNCTION__, model_file.c_str());
+        exit(1);
+    }
+
+    if (model->param.kernel_type==PRECOMPUTED)
+    {
+        fprintf(stderr, "[%s:%d %s] Precomputed kernels are not supported: %s\n", __FILE__, __LINE__, __FUNCTION__, model_file.c_str());
+        exit(1);
+    }
+
+    ////////////
+    //features//
+    ////////////
+    no_features = features.size();
+    int32_t info_types[3] = {BCF_HT_REAL, BCF_HT_INT, BCF_HT_FLAG};
+    for (int32_t i=0; i<no_features; ++i)
+    {
+        int32_t id = -1;
+        int32_t type = -1;
+        for (int32_t t=0; id<0 && t<3; ++t)
+        {
+            id = bcf_hdr_get_info_id(h, features[i].c_str(), info_types[t]);
+            type = info_types[t];
+        }
+
+        if (id<0)
+        {
+            fprintf(stderr, "[%s:%d %s] INFO field %s of type Float, Integer or Flag not found in header\n", __FILE__, __LINE__, __FUNCTION__, features[i].c_str());
+            exit(1);
+        }
+
+        ids.push_back(id);
+        types.push_back(type);
+    }
+
+    ///////////////////
+    //support vectors//
+    ///////////////////
+    no_svs = model->l;
+    no_svs_padded = ((no_svs+7)/8)*8;
+    svs = allocate((size_t)std::max(no_features, 1)*no_svs_padded);
+    svn = allocate(no_svs_padded);
+    for (int32_t j=0; j<no_svs; ++j)
+    {
+        for (struct svm_node* n = model->SV[j]; n->index!=-1; ++n)
+        {
+            if (n->index<1 || n->index>no_features)
+            {
+                fprintf(stderr, "[%s:%d %s] Feature %d of the model is not given, %d features specified\n", __FILE__, __LINE__, __FUNCTION__, n->index, no_features);
+                exit(1);
+            }
+
+            svs[(size_t)(n->index-1)*no_svs_padded+j] = n->value;
+            svn[j] += n->value*n->value;
+        }
+    }
+
+    /////////////////////////
+    //decision coefficients//
+    /////////////////////////
+    int32_t svm_type = model->param.svm_type;
+    if (svm_type==ONE_CLASS || svm_type==EPSILON_SVR || svm_type==NU_SVR)
+    {
+        no_decs = 1;
+        coefs = allocate(no_svs_padded);
+        for (int32_t j=0; j<no_svs; ++j)
+        {
+            coefs[j] = model->sv_coef[0][j];
+        }
+        rho.push_back(model->rho[0]);
+    }
+    else
+    {
+        //a support vector of class i contributes to the decision between classes i and j with coefficient sv_coef[j-1] if i<j and sv_coef[j] otherwise
+        int32_t nr_class = model->nr_class;
+        no_decs = nr_class*(nr_class-1)/2;
+        coefs = allocate((size_t)no_decs*no_svs_padded);
+
+        std::vector<int32_t> start(nr_class, 0);
+        for (int32_t i=1; i<nr_class; ++i)
+        {
+            start[i] = start[i-1]+model->nSV[i-1];
+        }
+
+        int32_t p = 0;
+        for (int32_t i=0; i<nr_class; ++i)
+        {
+            for (int32_t j=i+1; j<nr_class; ++j)
+            {
+                double* c = coefs + (size_t)p*no_svs_padded;
+                for (int32_t k=0; k<model->nSV[i]; ++k)
+                {
+                    c[start[i]+k] = model->sv_coef[j-1][start[i]+k];
+                }
+                for (int32_t k=0; k<model->nSV[j]; ++k)
+                {
+                    c[start[j]+k] = model->sv_coef[i][start[j]+k];
+                }
+                rho.push_back(model->rho[p]);
+                ++p;
+            }
+        }
+    }
+}
+
+/**
+ * Frees the model.
+ */
+SVMScorer::~SVMScorer()
+{
+    free(svs);
+    free(svn);
+    free(coefs);
+    svm_free_and_destroy_model(&model);
+}
+
+/**
+ * Scores n records, the records are unpacked up to BCF_UN_INFO.
+ */
+void SVMScorer::score(bcf1_t** v, int32_t n, float* scores, SVMBlock* block)
+{
+    int32_t d = no_features;
+    double* x = block->x;
+    double* xn = block->xn;
+    double* g = block->k;
+    double* dec = block->dec;
+
+    for (int32_t r=0; r<n; ++r)
+    {
+        extract(v[r], x+(size_t)r*d);
+        xn[r] = 0;
+        for (int32_t f=0; f<d; ++f)
+        {
+            xn[r] += x[r*d+f]*x[r*d+f];
+        }
+    }
+
+    for (int32_t i=0; i<n*no_decs; ++i)
+    {
+        dec[i] = 0;
+    }
+
+    //the support vectors of a tile stay in cache for all the records of the block
+    for (int32_t j0=0; j0<no_svs_padded; j0+=SVM_TILE)
+    {
+        int32_t m = std::min(SVM_TILE, no_svs_padded-j0);
+
+        for (int32_t r=0; r<n; ++r)
+        {
+            for (int32_t j=0; j<m; ++j)
+            {
+                g[j] = 0;
+            }
+
+            for (int32_t f=0; f<d; ++f)
+            {
+                double xf = x[r*d+f];
+                if (xf==0) continue;
+
+                const double* s = svs + (size_t)f*no_svs_padded + j0;
+                for (int32_t j=0; j<m; ++j)
+                {
+                    g[j] += xf*s[j];
+                }
+            }
+
+            kernel(g, m, xn[r], svn+j0);
+
+            for (int32_t p=0; p<no_decs; ++p)
+            {
+                const double* c = coefs + (size_t)p*no_svs_padded + j0;
+
+                //independent partial sums so that the reduction is vectorized, m is a multiple of 8
+                double sum[4] = {0, 0, 0, 0};
+                for (int32_t j=0; j<m; j+=4)
+                {
+                    sum[0] += c[j]*g[j];
+                    sum[1] += c[j+1]*g[j+1];
+                    sum[2] += c[j+2]*g[j+2];
+                    sum[3] += c[j+3]*g[j+3];
+                }
+                dec[r*no_decs+p] += (sum[0]+sum[1])+(sum[2]+sum[3]);
+            }
+        }
+    }
+
+    int32_t svm_type = model->param.svm_type;
+    for (int32_t r=0; r<n; ++r)
+    {
+        double* dv = dec + (size_t)r*no_decs;
+        for (int32_t p=0; p<no_decs; ++p)
+        {
+            dv[p] -= rho[p];
+        }
+
+        if (svm_type==ONE_CLASS || svm_type==EPSILON_SVR || svm_type==NU_SVR)
+        {
+            scores[r] = dv[0];
+        }
+        else if (model->nr_class==2)
+        {
+            scores[r] = model->label[0]>model->label[1] ? dv[0] : -dv[0];
+        }
+        else
+        {
+            int32_t nr_class = model->nr_class;
+            std::vector<int32_t> votes(nr_class, 0);
+            int32_t p = 0;
+            for (int32_t i=0; i<nr_class; ++i)
+            {
+                for (int32_t j=i+1; j<nr_class; ++j)
+                {
+                    ++votes[dv[p]>0 ? i : j];
+                    ++p;
+                }
+            }
+
+            int32_t max_i = 0;
+            for (int32_t i=1; i<nr_class; ++i)
+            {
+                if (votes[i]>votes[max_i]) max_i = i;
+            }
+            scores[r] = model->label[max_i];
+        }
+    }
+}
+
+/**
+ * Reads the features of a record into x.
+ */
+void SVMScorer::extract(bcf1_t* v, double* x)
+{
+    for (int32_t f=0; f<no_features; ++f)
+    {
+        if (types[f]==BCF_HT_REAL)
+        {
+            float value = bcf_get_info_flt(v, ids[f], 0);
+            x[f] = (bcf_float_is_missing(value) || std::isnan(value)) ? 0 : value;
+        }
+        else if (types[f]==BCF_HT_INT)
+        {
+            int32_t value = bcf_get_info_int(v, ids[f], 0);
+            x[f] = value==bcf_int32_missing ? 0 : value;
+        }
+        else
+        {
+            bcf_info_t* info = bcf_get_info_id(v, ids[f]);
+            x[f] = (info && info->vptr) ? 1 : 0;
+        }
+    }
+}
+
+/**
+ * Applies the kernel to the dot products g of a record of squared norm xn
+ * with the support vectors of squared norms sn.
+ */
+void SVMScorer::kernel(double* g, int32_t n, double xn, const double* sn)
+{
+    double gamma = model->param.gamma;
+    double coef0 = model->param.coef0;
+
+    switch (model->param.kernel_type)
+    {
+        case LINEAR:
+            break;
+        case POLY:
+            for (int32_t j=0; j<n; ++j)
+            {
+                double base = gamma*g[j]+coef0;
+                double k = 1;
+                for (int32_t t=model->param.degree; t>0; t/=2)
+                {
+                    if (t&1) k *= base;
+                    base *= base;
+                }
+                g[j] = k;
+            }
+            break;
+        case RBF:
+            for (int32_t j=0; j<n; ++j)
+            {
+                g[j] = exp(-gamma*std::max(xn+sn[j]-2*g[j], 0.0));
+            }
+            break;
+        case SIGMOID:
+            for (int32_t j=0; j<n; ++j)
+            {
+                g[j] = tanh(gamma*g[j]+coef0);
+            }
+            break;
+    }
+}
+
+/**
+ * Allocates a cache line aligned array of n doubles set to 0.
+ */
+double* SVMScorer::allocate(size_t n)
+{
+    double* p = NULL;
+    if (posix_memalign((void**)&p, SVM_ALIGNMENT, sizeof(double)*std::max(n, (size_t)8)))
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot allocate memory\n", __FILE__, __LINE__, __FUNCTION__);
+        exit(1);
+    }
+    memset(p, 0, sizeof(double)*std::max(n, (size_t)8));
+    return p;
+}
@@ -0,0 +1,147 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#ifndef SVM_SCORER_H
+#define SVM_SCORER_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include "hts_utils.h"
+#include "libsvm/svm.h"
+
+#define SVM_ALIGNMENT 64
+#define SVM_TILE 256
+
+class SVMScorer;
+
+/**
+ * Scratch matrices for scoring a block of records, each thread has its own.
+ */
+class SVMBlock
+{
+    public:
+
+    int32_t capacity;
+
+    //features of the records, a row per record
+    double* x;
+    //squared norms of the rows of x
+    double* xn;
+    //kernel values of a record against a tile of support vectors
+    double* k;
+    //decision values, a row per record
+    double* dec;
+
+    /**
+     * Allocates the matrices for blocks of up to capacity records.
+     */
+    SVMBlock(SVMScorer* scorer, int32_t capacity);
+
+    /**
+     * Frees the matrices.
+     */
+    ~SVMBlock();
+};
+
+/**
+ * Scores records with a libsvm model in blocks.
+ *
+ * The features of a block of records are read from INFO fields by ID
+ * into a matrix and the decision functions are evaluated for the whole
+ * block against the support vectors.  The support vectors are held as a
+ * dense feature major matrix with cache line aligned rows, so the kernel
+ * of a record is computed over a tile of support vectors with loops over
+ * contiguous memory that the compiler vectorizes, and the tile is reused
+ * for all the records of the block.  The linear, polynomial, RBF and
+ * sigmoid kernels are supported.
+ *
+ * The score of a record is
+ *
+ *  two class models     - the decision value, positive for the class with
+ *                         the larger label
+ *  multi class models   - the label predicted by voting as in libsvm
+ *  one class and
+ *  regression models    - the decision value
+ *
+ * A feature that is absent or missing in a record is 0, the features
+ * are not scaled.
+ */
+class SVMScorer
+{
+    public:
+
+    struct svm_model* model;
+
+    //INFO fields of the features 1 to no_features of the model
+    int32_t no_features;
+    std::vector<int32_t> ids;
+    std::vector<int32_t> types;
+
+    //support vectors, no_features rows of no_svs_padded values
+    int32_t no_svs;
+    int32_t no_svs_padded;
+    double* svs;
+    //squared norms of the support vectors
+    double* svn;
+
+    //coefficients of the support vectors in each decision function
+    int32_t no_decs;
+    double* coefs;
+    std::vector<double> rho;
+
+    /**
+     * Loads a model, the features are the INFO fields of h in the order of
+     * the feature indices of the model.
+     */
+    SVMScorer(std::string& model_file, bcf_hdr_t* h, std::vector<std::string>& features);
+
+    /**
+     * Frees the model.
+     */
+    ~SVMScorer();
+
+    /**
+     * Scores n records, the records are unpacked up to BCF_UN_INFO.
+     */
+    void score(bcf1_t** v, int32_t n, float* scores, SVMBlock* block);
+
+    private:
+
+    /**
+     * Reads the features of a record into x.
+     */
+    void extract(bcf1_t* v, double* x);
+
+    /**
+     * Applies the kernel to the dot products g of a record of squared norm xn
+     * with the support vectors of squared norms sn.
+     */
+    void kernel(double* g, int32_t n, double xn, const double* sn);
+
+    /**
+     * Allocates a cache line aligned array of n doubles set to 0.
+     */
+    static double* allocate(size_t n);
+};
+
+#endif
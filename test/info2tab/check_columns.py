@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""
+Checks a columnar export of vt info2tab against the VCF file it was made from.
+
+usage : check_columns.py <column directory> <in.vcf.gz>
+
+The export is expected to hold the columns of
+vt info2tab -c <dir> -t DP,OLD_MULTIALLELIC,AF,FL,X2,FQ -u PASS,q10 <in.vcf.gz>
+"""
+
+import array
+import ast
+import gzip
+import math
+import struct
+import sys
+
+MISSING = -2**31
+
+def npy(d, name):
+    b = open(d + '/' + name, 'rb').read()
+    assert b[:8] == b'\x93NUMPY\x01\x00', name
+    hl = struct.unpack('<H', b[8:10])[0]
+    h = ast.literal_eval(b[10:10+hl].decode())
+    t = {'<i4':'i', '<f4':'f', '|u1':'B', '<i8':'q'}[h['descr']]
+    a = array.array(t)
+    a.frombytes(b[10+hl:])
+    n = 1
+    for s in h['shape']:
+        n *= s
+    assert len(a) == n, (name, len(a), n)
+    return h['shape'], a
+
+def strings(d, name):
+    _, o = npy(d, name + '.offsets.npy')
+    b = open(d + '/' + name + '.bytes', 'rb').read()
+    assert o[0] == 0 and o[-1] == len(b), name
+    return [b[o[i]:o[i+1]].decode() for i in range(len(o)-1)]
+
+def ragged(d, name):
+    _, o = npy(d, name + '.offsets.npy')
+    _, v = npy(d, name + '.npy')
+    assert o[-1] == len(v), name
+    return [list(v[o[i]:o[i+1]]) for i in range(len(o)-1)]
+
+def main():
+    d = sys.argv[1]
+    contigs = open(d + '/CHROM.txt').read().split()
+    _, chrom = npy(d, 'CHROM.npy')
+    _, pos = npy(d, 'POS.npy')
+    ref = strings(d, 'REF')
+    alt = strings(d, 'ALT')
+    _, n_allele = npy(d, 'N_ALLELE.npy')
+    _, pass_ = npy(d, 'FILTER_PASS.npy')
+    _, q10 = npy(d, 'FILTER_q10.npy')
+    _, fl = npy(d, 'INFO_FL.npy')
+    shape, x2 = npy(d, 'INFO_X2.npy')
+    _, fq = npy(d, 'INFO_FQ.npy')
+    _, dp = npy(d, 'INFO_DP.npy')
+    af = ragged(d, 'INFO_AF')
+    om = strings(d, 'INFO_OLD_MULTIALLELIC')
+    assert shape[1] == 2
+
+    i = 0
+    no_bad = 0
+    for line in gzip.open(sys.argv[2], 'rt'):
+        if line[0] == '#':
+            continue
+        f = line.rstrip('\n').split('\t')
+        info = {}
+        for kv in f[7].split(';'):
+            if kv == '.':
+                continue
+            k, _, v = kv.partition('=')
+            info[k] = v
+        filters = f[6].split(';')
+
+        ok = contigs[chrom[i]] == f[0] and pos[i] == int(f[1])
+        ok = ok and ref[i] == f[3] and alt[i] == f[4] and n_allele[i] == 1 + len(f[4].split(','))
+        ok = ok and pass_[i] == (f[6] in ('PASS', '.')) and q10[i] == ('q10' in filters)
+        ok = ok and fl[i] == ('FL' in info)
+        ok = ok and dp[i] == (int(info['DP']) if 'DP' in info else MISSING)
+        ok = ok and om[i] == info.get('OLD_MULTIALLELIC', '')
+        e = [int(x) if x != '.' else MISSING for x in info['X2'].split(',')] if 'X2' in info else [MISSING, MISSING]
+        ok = ok and list(x2[2*i:2*i+2]) == e
+        ok = ok and ((math.isnan(fq[i]) and 'FQ' not in info) or ('FQ' in info and abs(fq[i] - float(info['FQ'])) < 1e-3))
+        e = info['AF'].split(',') if 'AF' in info else []
+        ok = ok and len(af[i]) == len(e)
+        ok = ok and all((x == '.' and math.isnan(y)) or (x != '.' and abs(float(x) - y) < 1e-4) for x, y in zip(e, af[i]))
+
+        if not ok:
+            no_bad += 1
+            if no_bad < 5:
+                print('mismatch at row %d: %s' % (i, '\t'.join(f[:8])))
+        i += 1
+
+    if i != len(pos):
+        no_bad += 1
+        print('%d rows exported, %d records' % (len(pos), i))
+
+    print('rows: %d' % i)
+    print('mismatches: %d' % no_bad)
+    return 1 if no_bad else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,133 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+
+#include "interval_tree.h"
+
+/**
+ * Compares IntervalTree::search against IntervalTree::search_brute.
+ *
+ * usage : test_interval_tree           runs the comparisons
+ *         test_interval_tree unindexed searches a tree that is not indexed
+ */
+
+namespace
+{
+
+uint64_t seed = 1;
+
+/**
+ * Returns a pseudo random number in [0,n), the same on every platform.
+ */
+int32_t draw(int32_t n)
+{
+    seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+    return (seed>>33)%n;
+}
+
+/**
+ * Builds a tree of n intervals starting in [1,span] and compares the two
+ * searches over queries covering the whole range, returns the number of
+ * queries that differ.
+ */
+int32_t compare(int32_t n, int32_t span, int32_t max_len)
+{
+    std::vector<Interval*> intervals;
+    IntervalTree tree;
+    for (int32_t i=0; i<n; ++i)
+    {
+        int32_t beg1 = 1 + draw(span);
+        intervals.push_back(new Interval(beg1, beg1 + draw(max_len)));
+        tree.insert(intervals.back());
+    }
+    tree.index();
+
+    int32_t no_differences = 0;
+    std::vector<Interval*> found;
+    std::vector<Interval*> expected;
+    for (int32_t start=0; start<=span+max_len+1; ++start)
+    {
+        int32_t end = start + draw(max_len+1);
+        tree.search(start, end, found);
+        tree.search_brute(start, end, expected);
+
+        if (found!=expected)
+        {
+            fprintf(stderr, "n=%d span=%d [%d,%d]: %d intervals found, %d expected\n", n, span, start, end, (int32_t)found.size(), (int32_t)expected.size());
+            ++no_differences;
+        }
+    }
+
+    for (int32_t i=0; i<n; ++i)
+    {
+        delete intervals[i];
+    }
+
+    return no_differences;
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc>1 && !strcmp(argv[1], "unindexed"))
+    {
+        Interval interval(1, 10);
+        IntervalTree tree;
+        tree.insert(&interval);
+        std::vector<Interval*> found;
+        tree.search(1, 10, found);
+        return 0;
+    }
+
+    int32_t no_trees = 0;
+    int32_t no_differences = 0;
+
+    //empty tree
+    no_differences += compare(0, 10, 10);
+    ++no_trees;
+
+    //sizes around powers of two
+    for (int32_t n=1; n<=130; ++n)
+    {
+        no_differences += compare(n, 4*n, 20);
+        ++no_trees;
+    }
+    int32_t sizes[] = {255, 256, 257, 1000, 1023, 1025};
+    for (size_t i=0; i<sizeof(sizes)/sizeof(int32_t); ++i)
+    {
+        no_differences += compare(sizes[i], 4*sizes[i], 50);
+        ++no_trees;
+    }
+
+    //many intervals sharing a start position
+    for (int32_t n=2; n<=300; n+=37)
+    {
+        no_differences += compare(n, 3, 30);
+        ++no_trees;
+    }
+
+    printf("trees: %d\n", no_trees);
+    printf("differences: %d\n", no_differences);
+
+    return no_differences ? 1 : 0;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+VT=${DIR}/../vt
+IN=${DIR}/info2tab/01_IN.vcf.gz
+OUT=${TMPDIR:-/tmp}/test_info2tab.$$
+mkdir -p ${OUT}
+
+. ${DIR}/ssshtest
+
+run info2tab_columns ${VT} info2tab -c ${OUT}/1 -t DP,OLD_MULTIALLELIC,AF,FL,X2,FQ -u PASS,q10 ${IN}
+assert_exit_code 0
+
+run info2tab_columns_check python3 ${DIR}/info2tab/check_columns.py ${OUT}/1 ${IN}
+assert_exit_code 0
+assert_in_stdout "mismatches: 0"
+
+run info2tab_columns_parallel ${VT} info2tab -c ${OUT}/3 -n 3 -t DP,OLD_MULTIALLELIC,AF,FL,X2,FQ -u PASS,q10 ${IN}
+assert_exit_code 0
+
+run info2tab_columns_parallel_check python3 ${DIR}/info2tab/check_columns.py ${OUT}/3 ${IN}
+assert_exit_code 0
+assert_in_stdout "mismatches: 0"
+
+#contigs missing from the header follow those of the header in the order of the file
+run info2tab_columns_contigs paste -s -d " " ${OUT}/3/CHROM.txt
+assert_in_stdout "20 21 X Y"
+
+run info2tab_columns_same diff -r ${OUT}/1 ${OUT}/3
+assert_exit_code 0
+assert_no_stdout
+
+rm -rf ${OUT}
@@ -0,0 +1,20 @@
+#!/bin/bash
+
+DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
+SRC=${DIR}/..
+BIN=${TMPDIR:-/tmp}/test_interval_tree.$$
+
+${CXX:-g++} -std=c++0x -O2 -I${SRC} -I${SRC}/lib -I${SRC}/lib/htslib -D__STDC_LIMIT_MACROS \
+    -o ${BIN} ${DIR}/interval_tree/test_interval_tree.cpp ${SRC}/interval_tree.cpp ${SRC}/interval.cpp
+
+. ${DIR}/ssshtest
+
+run interval_tree_search ${BIN}
+assert_exit_code 0
+assert_in_stdout "differences: 0"
+
+run interval_tree_unindexed_search ${BIN} unindexed
+assert_exit_code 1
+assert_in_stderr "interval tree searched before it was indexed"
+
+rm -f ${BIN}
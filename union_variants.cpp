@@ -41,12 +41,15 @@ class Igor : Program
     std::string output_vcf_file;
     std::vector<GenomeInterval> intervals;
     std::string interval_list;
+    int32_t no_threads;
     
     ///////
     //i/o//
     ///////
+    ParallelSyncedDriver *driver;
     BCFSyncedReader *sr;
     BCFOrderedWriter *odw;
+    int32_t out;
     bcf1_t *v;
 
     ///////////////
@@ -59,6 +62,8 @@ class Igor : Program
     /////////
     int32_t no_unique_variants;
     int32_t no_variants;
+    std::vector<int32_t> worker_no_unique_variants;
+    std::vector<int32_t> worker_no_variants;
 
     /////////
     //tools//
@@ -82,6 +87,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "", cmd);
             TCLAP::ValueArg<std::string> arg_input_vcf_file_list("L", "L", "file containing list of input VCF files", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_labels("l", "l", "Comma delimited labels for the files", true, "", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the inputs are indexed [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledMultiArg<std::string> arg_input_vcf_files("<in1.vcf>...", "Multiple VCF files",false, "files", cmd);
             
             cmd.parse(argc, argv);
@@ -90,7 +96,7 @@ class Igor : Program
             output_vcf_file = arg_output_vcf_file.getValue();
             split(labels, ",", arg_labels.getValue());
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
-            
+            no_threads = arg_no_threads.getValue();
         }
         catch (TCLAP::ArgException &e)
         {
@@ -104,7 +110,8 @@ class Igor : Program
         //////////////////////
         //i/o initialization//
         //////////////////////
-        sr = new BCFSyncedReader(input_vcf_files, intervals, false);
+        driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+        sr = driver->sr;
 
         odw = new BCFOrderedWriter(output_vcf_file, 0);
         bcf_hdr_set_version(odw->hdr, "VCFv4.1");
@@ -112,6 +119,7 @@ class Igor : Program
         bcf_hdr_append(odw->hdr, "##INFO=<ID=NCENTERS,Number=1,Type=Integer,Description=\"Number of centers with variant evidence.\">");
         bcf_hdr_append(odw->hdr, "##INFO=<ID=CENTERS,Number=.,Type=String,Description=\"List of centers where variant is found.\">");
         odw->write_hdr();
+        out = driver->add_writer(odw);
 
         ///////////////
         //general use//
@@ -132,6 +140,8 @@ class Igor : Program
         ////////////////////////
         no_unique_variants = 0;
         no_variants = 0;
+        worker_no_unique_variants.resize(driver->no_workers, 0);
+        worker_no_variants.resize(driver->no_workers, 0);
         
         /////////
         //tools//
@@ -140,12 +150,30 @@ class Igor : Program
     }
 
     void union_variants()
+    {
+        driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { union_variants(worker, region, sr); });
+
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            no_variants += worker_no_variants[i];
+            no_unique_variants += worker_no_unique_variants[i];
+        }
+
+        sr->close();
+        odw->close();
+    };
+
+    /**
+     * Unions the variants of a region.
+     */
+    void union_variants(int32_t worker, int32_t region, BCFSyncedReader* sr)
     {
         int32_t nfiles = sr->get_nfiles();
         kstring_t centers = {0,0,0};
         int32_t ncenter = 0;
         int32_t *presence = new int32_t[nfiles];
         int32_t pass_filter = 0;
+        bcf1_t* nv = bcf_init();
         
         std::vector<bcfptr*> current_recs;
         while(sr->read_next_position(current_recs))
@@ -167,7 +195,7 @@ class Igor : Program
                     kputs(labels[file_index].c_str(), &centers);     
                     presence[file_index] = true;
                     
-                    ++no_variants;  
+                    ++worker_no_variants[worker];
                     ++ncenter;            
                 }
             }
@@ -176,7 +204,7 @@ class Igor : Program
             bcf_hdr_t *h = current_recs[0]->h;  
             
             //update variant information
-            bcf1_t* nv = odw->get_bcf1_from_pool();
+            bcf_clear(nv);
             bcf_set_chrom(odw->hdr, nv, bcf_get_chrom(h, v));
             bcf_set_pos1(nv, bcf_get_pos1(v));
             bcf_update_alleles(odw->hdr, nv, const_cast<const char**>(bcf_get_allele(v)), bcf_get_n_allele(v));
@@ -184,13 +212,14 @@ class Igor : Program
             bcf_update_info_int32(odw->hdr, nv, "NCENTERS", &ncenter, 1);
             bcf_update_filter(odw->hdr, nv, &pass_filter, 1);
             
-            odw->write(nv);
+            driver->write(region, out, nv);
             
-            ++no_unique_variants;
+            ++worker_no_unique_variants[worker];
         }
 
-        sr->close();
-        odw->close();
+        bcf_destroy(nv);
+        delete [] presence;
+        if (centers.m) free(centers.s);
     };
 
     void print_options()
@@ -198,6 +227,7 @@ class Igor : Program
         std::clog << "union_variants v" << version << "\n\n";
         std::clog << "options: [L] input VCF file list   " << input_vcf_file_list << " (" << input_vcf_files.size() << " files)\n";
         std::clog << "         [o] output VCF file       " << output_vcf_file << "\n";
+        print_num_op("         [t] no. of threads        ", no_threads);
         print_int_op("         [i] intervals             ", intervals);
         std::clog << "\n";
     }
@@ -25,6 +25,7 @@
 #define UNION_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
 
 void union_variants(int argc, char ** argv);
 
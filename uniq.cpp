@@ -36,12 +36,15 @@ class Igor : Program
     std::string input_vcf_file;
     std::string output_vcf_file;
     std::vector<GenomeInterval> intervals;
-    
+    int32_t no_threads;
+
     ///////
     //i/o//
     ///////
+    ParallelSyncedDriver *driver;
     BCFSyncedReader *sr;
     BCFOrderedWriter *odw;
+    int32_t out;
 
     std::vector<bcf1_t*> pool;
 
@@ -50,6 +53,8 @@ class Igor : Program
     /////////
     uint32_t no_total_variants;
     uint32_t no_unique_variants;
+    std::vector<uint32_t> worker_no_total_variants;
+    std::vector<uint32_t> worker_no_unique_variants;
 
     /////////
     //tools//
@@ -73,6 +78,7 @@ class Igor : Program
             TCLAP::ValueArg<std::string> arg_intervals("i", "i", "intervals []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_interval_list("I", "I", "file containing list of intervals []", false, "", "file", cmd);
             TCLAP::ValueArg<std::string> arg_output_vcf_file("o", "o", "output VCF file [-]", false, "-", "str", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the input is indexed [1]", false, 1, "int", cmd);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
 
             cmd.parse(argc, argv);
@@ -80,6 +86,7 @@ class Igor : Program
             input_vcf_file = arg_input_vcf_file.getValue();
             output_vcf_file = arg_output_vcf_file.getValue();
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
+            no_threads = arg_no_threads.getValue();
         }
         catch (TCLAP::ArgException &e)
         {
@@ -95,16 +102,20 @@ class Igor : Program
         //////////////////////
         std::vector<std::string> input_vcf_files;
         input_vcf_files.push_back(input_vcf_file);  
-        sr = new BCFSyncedReader(input_vcf_files, intervals, SYNC_BY_VAR);
+        driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+        sr = driver->sr;
         odw = new BCFOrderedWriter(output_vcf_file, 0);
         odw->link_hdr(sr->hdrs[0]);
         odw->write_hdr();
+        out = driver->add_writer(odw);
 
         ////////////////////////
         //stats initialization//
         ////////////////////////
         no_total_variants = 0;
         no_unique_variants = 0;
+        worker_no_total_variants.resize(driver->no_workers, 0);
+        worker_no_unique_variants.resize(driver->no_workers, 0);
 
         ////////////////////////
         //tools initialization//
@@ -112,6 +123,23 @@ class Igor : Program
     }
 
     void uniq()
+    {
+        driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { uniq(worker, region, sr); });
+
+        for (int32_t i=0; i<driver->no_workers; ++i)
+        {
+            no_total_variants += worker_no_total_variants[i];
+            no_unique_variants += worker_no_unique_variants[i];
+        }
+
+        sr->close();
+        odw->close();
+    };
+
+    /**
+     * Drops duplicates in a region.
+     */
+    void uniq(int32_t worker, int32_t region, BCFSyncedReader* sr)
     {
         std::vector<bcfptr*> crecs;
         while (sr->read_next_position(crecs))
@@ -146,14 +174,11 @@ class Igor : Program
                 }   
             }
             
-            odw->write(crecs[0]->v);
+            driver->write(region, out, crecs[0]->v);
             
-            ++no_unique_variants;
-            no_total_variants += crecs.size();
+            ++worker_no_unique_variants[worker];
+            worker_no_total_variants[worker] += crecs.size();
         }
-
-        sr->close();
-        odw->close();
     };
 
     void print_options()
@@ -162,6 +187,7 @@ class Igor : Program
 
         std::clog << "options:     input VCF file        " << input_vcf_file << "\n";
         std::clog << "         [o] output VCF file       " << output_vcf_file << "\n";
+        print_num_op("         [t] no. of threads        ", no_threads);
         print_int_op("         [i] intervals             ", intervals);
     }
 
@@ -25,6 +25,7 @@
 #define UNIQ_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
 
 void uniq(int argc, char **argv);
 
@@ -240,5 +240,19 @@ bool append_cwd(std::string& path)
     return false;
 };
 
+/**
+ * Returns the absolute path of an existing file with symbolic links resolved.
+ * Returns path unchanged if it cannot be resolved.
+ */
+std::string canonical_path(std::string& path)
+{
+    char* resolved = realpath(path.c_str(), NULL);
+    if (resolved==NULL) return path;
+
+    std::string canonical(resolved);
+    free(resolved);
+    return canonical;
+};
+
 
 
@@ -89,4 +89,10 @@ std::string to_lower(std::string& s);
  */
 bool append_cwd(std::string& path);
 
+/**
+ * Returns the absolute path of an existing file with symbolic links resolved.
+ * Returns path unchanged if it cannot be resolved.
+ */
+std::string canonical_path(std::string& path);
+
 #endif
\ No newline at end of file
@@ -26,6 +26,39 @@
 namespace
 {
 
+#define REF_WINDOW_SIZE 1048576
+
+/**
+ * Per thread state of the checks.
+ */
+struct worker_t
+{
+    ReferenceSequence *rs;
+
+    //reference sequence window [ref_beg0,ref_end0) of the contig ref_rid
+    std::string ref_chrom;
+    char* ref;
+    int32_t ref_rid;
+    int32_t ref_beg0;
+    int32_t ref_end0;
+
+    //ploidy of each sample of the current record
+    std::vector<int32_t> ploidy;
+
+    //whether a FILTER, INFO or FORMAT id is defined in the header, -1 if not yet looked up
+    std::vector<int8_t> defined[3];
+
+    kstring_t var;
+
+    uint32_t no_variants;
+    uint32_t no_unordered;
+    uint32_t no_unordered_chrom;
+    uint32_t no_inconsistent_ref;
+    uint32_t no_undefined_fields;
+    uint32_t no_invalid_number;
+    uint32_t no_invalid_genotypes;
+};
+
 class Igor : Program
 {
     public:
@@ -34,14 +67,17 @@ class Igor : Program
     //options//
     ///////////
     std::string input_vcf_file;
+    std::vector<std::string> input_vcf_files;
     std::vector<GenomeInterval> intervals;
     std::string ref_fasta_file;
+    int32_t no_threads;
     bool print;
 
     ///////
     //i/o//
     ///////
     BCFOrderedReader *odr;
+    ParallelSyncedDriver *driver;
     bcf1_t *v;
 
     /////////
@@ -51,11 +87,20 @@ class Igor : Program
     uint32_t no_unordered;
     uint32_t no_unordered_chrom;
     uint32_t no_inconsistent_ref;
+    uint32_t no_undefined_fields;
+    uint32_t no_invalid_number;
+    uint32_t no_invalid_genotypes;
+
+    //first and last record of each region for checking the order across regions
+    std::vector<int32_t> region_beg_rid;
+    std::vector<int32_t> region_beg_pos1;
+    std::vector<int32_t> region_end_rid;
+    std::vector<int32_t> region_end_pos1;
 
     /////////
     //tools//
     /////////
-    faidx_t *fai;
+    std::vector<worker_t*> workers;
 
     Igor(int argc, char **argv)
     {
@@ -68,13 +113,17 @@ class Igor : Program
         {
             std::string desc = "Checks the following properties of a VCF file\n"
                  "              1. order\n"
-                 "              2. reference sequence consistency";
+                 "              2. reference sequence consistency\n"
+                 "              3. FILTER, INFO and FORMAT fields are defined in the header\n"
+                 "              4. number of values of Number=A,R,G and fixed length fields\n"
+                 "              5. genotype alleles and ploidy";
 
             TCLAP::CmdLine cmd(desc, ' ', version);
             VTOutput my; cmd.setOutput(&my);
             TCLAP::ValueArg<std::string> arg_ref_fasta_file("r", "r", "reference sequence fasta file []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_intervals("i", "i", "intervals []", false, "", "str", cmd);
             TCLAP::ValueArg<std::string> arg_interval_list("I", "I", "file containing list of intervals []", false, "", "file", cmd);
+            TCLAP::ValueArg<int32_t> arg_no_threads("t", "t", "no. of threads, used when the input is indexed [1]", false, 1, "int", cmd);
             TCLAP::SwitchArg arg_quiet("q", "q", "do not print invalid records [false]", cmd, false);
             TCLAP::UnlabeledValueArg<std::string> arg_input_vcf_file("<in.vcf>", "input VCF file", true, "","file", cmd);
 
@@ -82,6 +131,7 @@ class Igor : Program
 
             input_vcf_file = arg_input_vcf_file.getValue();
             parse_intervals(intervals, arg_interval_list.getValue(), arg_intervals.getValue());
+            no_threads = arg_no_threads.getValue();
             print = !arg_quiet.getValue();
             ref_fasta_file = arg_ref_fasta_file.getValue();
         }
@@ -97,7 +147,37 @@ class Igor : Program
         //////////////////////
         //i/o initialization//
         //////////////////////
-        odr = new BCFOrderedReader(input_vcf_file, intervals);
+        //indexed files are checked region by region in parallel,
+        //the order check falls back to the ordered reader otherwise
+        //as the synced reader requires ordered records.
+        odr = NULL;
+        driver = NULL;
+        int32_t no_workers = 1;
+        if (no_threads>1)
+        {
+            input_vcf_files.push_back(input_vcf_file);
+            driver = new ParallelSyncedDriver(input_vcf_files, intervals, SYNC_BY_VAR, no_threads);
+
+            if (driver->parallel())
+            {
+                no_workers = driver->no_workers;
+                region_beg_rid.resize(driver->regions.size(), -1);
+                region_beg_pos1.resize(driver->regions.size(), -1);
+                region_end_rid.resize(driver->regions.size(), -1);
+                region_end_pos1.resize(driver->regions.size(), -1);
+            }
+            else
+            {
+                driver->sr->close();
+                delete driver;
+                driver = NULL;
+            }
+        }
+
+        if (!driver)
+        {
+            odr = new BCFOrderedReader(input_vcf_file, intervals);
+        }
 
         ////////////////////////
         //stats initialization//
@@ -106,85 +186,408 @@ class Igor : Program
         no_unordered = 0;
         no_unordered_chrom = 0;
         no_inconsistent_ref = 0;
+        no_undefined_fields = 0;
+        no_invalid_number = 0;
+        no_invalid_genotypes = 0;
         v = bcf_init1();
 
         ////////////////////////
         //tools initialization//
         ////////////////////////
-        fai = NULL;
-        if (ref_fasta_file!="")
+        for (int32_t i=0; i<no_workers; ++i)
         {
-            fai = fai_load(ref_fasta_file.c_str());
-            if (fai==NULL)
+            worker_t* w = new worker_t();
+            w->rs = NULL;
+            if (ref_fasta_file!="")
             {
-                fprintf(stderr, "[%s:%d %s] Cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-                exit(1);
+                w->rs = new ReferenceSequence(ref_fasta_file);
             }
+            w->ref = NULL;
+            w->ref_rid = -1;
+            w->ref_beg0 = 0;
+            w->ref_end0 = 0;
+            w->var = {0,0,0};
+            workers.push_back(w);
         }
     }
 
     void validate()
     {
-        const char* last_chrom = NULL;
-        int32_t last_rid = -1;
-        int32_t last_pos1 = -1;
+        if (driver)
+        {
+            driver->run([this](int32_t worker, int32_t region, BCFSyncedReader* sr) { validate(workers[worker], region, sr); });
+
+            //check the order at the region boundaries
+            bcf_hdr_t* h = driver->sr->hdrs[0];
+            int32_t last_rid = -1;
+            int32_t last_pos1 = -1;
+            uint32_t no_unordered = 0;
+            uint32_t no_unordered_chrom = 0;
+            for (size_t i=0; i<driver->regions.size(); ++i)
+            {
+                if (region_beg_rid[i]==-1) continue;
 
-        while (odr->read(v))
+                check_order(h, region_beg_rid[i], region_beg_pos1[i], last_rid, last_pos1, no_unordered, no_unordered_chrom);
+                last_rid = region_end_rid[i];
+                last_pos1 = region_end_pos1[i];
+            }
+            this->no_unordered += no_unordered;
+            this->no_unordered_chrom += no_unordered_chrom;
+
+            driver->sr->close();
+        }
+        else
         {
-            bcf_unpack(v, BCF_UN_INFO);
+            worker_t* w = workers[0];
+            int32_t last_rid = -1;
+            int32_t last_pos1 = -1;
 
-            int32_t rid = bcf_get_rid(v);
-            const char* chrom = odr->get_seqname(v);
-            int32_t pos1 = bcf_get_pos1(v);
+            while (odr->read(v))
+            {
+                int32_t rid = bcf_get_rid(v);
+                int32_t pos1 = bcf_get_pos1(v);
+
+                check_order(odr->hdr, rid, pos1, last_rid, last_pos1, w->no_unordered, w->no_unordered_chrom);
+                check_record(w, odr->hdr, v);
+            }
+
+            odr->close();
+        }
 
-            if (rid==last_rid)
+        for (size_t i=0; i<workers.size(); ++i)
+        {
+            worker_t* w = workers[i];
+            no_variants += w->no_variants;
+            no_unordered += w->no_unordered;
+            no_unordered_chrom += w->no_unordered_chrom;
+            no_inconsistent_ref += w->no_inconsistent_ref;
+            no_undefined_fields += w->no_undefined_fields;
+            no_invalid_number += w->no_invalid_number;
+            no_invalid_genotypes += w->no_invalid_genotypes;
+        }
+    };
+
+    /**
+     * Checks the records of a region.
+     */
+    void validate(worker_t* w, int32_t region, BCFSyncedReader* sr)
+    {
+        std::vector<bcfptr*> crecs;
+        int32_t last_rid = -1;
+        int32_t last_pos1 = -1;
+
+        while (sr->read_next_position(crecs))
+        {
+            for (size_t i=0; i<crecs.size(); ++i)
             {
-                if (last_pos1>pos1)
+                bcf_hdr_t* h = crecs[i]->h;
+                bcf1_t* v = crecs[i]->v;
+                int32_t rid = bcf_get_rid(v);
+                int32_t pos1 = bcf_get_pos1(v);
+
+                if (region_beg_rid[region]==-1)
                 {
-                    if (print) fprintf(stderr, "[%s:%d %s] UNORDERED: %s: %d after %d\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, last_pos1);
-                    ++no_unordered;
+                    region_beg_rid[region] = rid;
+                    region_beg_pos1[region] = pos1;
                 }
+
+                check_order(h, rid, pos1, last_rid, last_pos1, w->no_unordered, w->no_unordered_chrom);
+                check_record(w, h, v);
             }
-            else if (last_rid>rid)
+        }
+
+        region_end_rid[region] = last_rid;
+        region_end_pos1[region] = last_pos1;
+    }
+
+    /**
+     * Checks that a record at rid:pos1 follows last_rid:last_pos1 and updates the latter.
+     */
+    void check_order(bcf_hdr_t* h, int32_t rid, int32_t pos1, int32_t& last_rid, int32_t& last_pos1, uint32_t& no_unordered, uint32_t& no_unordered_chrom)
+    {
+        if (rid==last_rid)
+        {
+            if (last_pos1>pos1)
             {
-                if (print) fprintf(stderr, "[%s:%d %s] UNORDERED CHROM: %s after %s\n", __FILE__, __LINE__, __FUNCTION__, chrom, last_chrom);
-                ++no_unordered_chrom;
+                if (print) fprintf(stderr, "[%s:%d %s] UNORDERED: %s: %d after %d\n", __FILE__, __LINE__, __FUNCTION__, bcf_hdr_id2name(h, rid), pos1, last_pos1);
+                ++no_unordered;
             }
+        }
+        else if (last_rid>rid)
+        {
+            if (print) fprintf(stderr, "[%s:%d %s] UNORDERED CHROM: %s after %s\n", __FILE__, __LINE__, __FUNCTION__, bcf_hdr_id2name(h, rid), bcf_hdr_id2name(h, last_rid));
+            ++no_unordered_chrom;
+        }
 
-            last_chrom = chrom;
-            last_rid = rid;
-            last_pos1 = pos1;
+        last_rid = rid;
+        last_pos1 = pos1;
+    }
+
+    /**
+     * Checks the reference allele, the header definitions, the number of values and the genotypes of a record.
+     */
+    void check_record(worker_t* w, bcf_hdr_t* h, bcf1_t* v)
+    {
+        bcf_unpack(v, BCF_UN_ALL);
 
-            if (fai)
+        const char* chrom = bcf_get_chrom(h, v);
+        int32_t pos1 = bcf_get_pos1(v);
+
+        if (w->rs)
+        {
+            char** alleles = bcf_get_allele(v);
+            int32_t len = strlen(alleles[0]);
+            int32_t ref_len = 0;
+            const char* ref = fetch_ref(w, v->rid, chrom, pos1-1, len, ref_len);
+
+            if (ref_len!=len || strncasecmp(ref, alleles[0], len))
             {
-                const char* chrom = odr->get_seqname(v);
+                w->var.l = 0;
+                bcf_variant2string(h, v, &w->var);
+                if (print) fprintf(stderr, "[%s:%d %s] INCONSISTENT REF: %s:%d %s!=%.*s(truth) for variant %s\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, alleles[0], ref_len, ref, w->var.s);
+                ++w->no_inconsistent_ref;
+            }
+        }
+
+        check_fields(w, h, v, chrom, pos1);
 
-                int32_t ref_len = 0;
-                char** alleles = bcf_get_allele(v);
-                int32_t len = strlen(alleles[0]);
+        ++w->no_variants;
+    }
 
-                char* ref = faidx_fetch_uc_seq(fai, chrom, pos1-1, pos1+len-2, &ref_len);
+    /**
+     * Returns the reference sequence at chrom:pos0 from the reference window of the worker,
+     * ref_len is set to the number of bases available up to len.
+     */
+    const char* fetch_ref(worker_t* w, int32_t rid, const char* chrom, int32_t pos0, int32_t len, int32_t& ref_len)
+    {
+        if (rid!=w->ref_rid || pos0<w->ref_beg0 || pos0+len>w->ref_end0)
+        {
+            if (w->ref) free(w->ref);
 
-                if (strcasecmp(ref, alleles[0]))
+            w->ref = NULL;
+            w->ref_rid = rid;
+            w->ref_beg0 = pos0;
+            w->ref_end0 = pos0;
+
+            //contigs absent from the reference leave the window empty
+            w->ref_chrom.assign(chrom);
+            int32_t chrom_len = w->rs->fetch_seq_len(w->ref_chrom);
+            if (pos0<chrom_len)
+            {
+                int32_t end0 = std::min(pos0+std::max(len, REF_WINDOW_SIZE), chrom_len);
+                w->ref = w->rs->fetch_seq(chrom, pos0+1, end0);
+                w->ref_end0 = w->ref ? pos0+(int32_t)strlen(w->ref) : pos0;
+            }
+        }
+
+        ref_len = std::max(0, std::min(len, w->ref_end0-pos0));
+        return w->ref ? w->ref+(pos0-w->ref_beg0) : "";
+    }
+
+    /**
+     * Returns true if a FILTER, INFO or FORMAT id is defined in the header,
+     * htslib adds a dummy definition for those found only in the records.
+     */
+    bool is_defined(worker_t* w, bcf_hdr_t* h, int32_t type, int32_t id)
+    {
+        std::vector<int8_t>& defined = w->defined[type];
+        if (id>=(int32_t)defined.size())
+        {
+            defined.resize(id+1, -1);
+        }
+
+        if (defined[id]==-1)
+        {
+            bcf_hrec_t* hrec = h->id[BCF_DT_ID][id].val ? h->id[BCF_DT_ID][id].val->hrec[type] : NULL;
+            int32_t i = hrec ? bcf_hrec_find_key(hrec, "Description") : -1;
+            defined[id] = hrec && !(i>=0 && !strcmp(hrec->vals[i], "\"Dummy\""));
+        }
+
+        return defined[id];
+    }
+
+    /**
+     * Returns the expected number of values of an INFO or FORMAT field, -1 if variable.
+     */
+    int32_t expected_number(bcf_hdr_t* h, int32_t type, int32_t id, int32_t n_allele, int32_t ploidy)
+    {
+        switch (bcf_hdr_id2length(h, type, id))
+        {
+            case BCF_VL_FIXED:
+                return bcf_hdr_id2number(h, type, id);
+            case BCF_VL_A:
+                return n_allele-1;
+            case BCF_VL_R:
+                return n_allele;
+            case BCF_VL_G:
+            {
+                //no. of unordered genotypes of ploidy alleles
+                int64_t n = 1;
+                for (int32_t i=1; i<=ploidy; ++i)
                 {
-                    kstring_t var = {0,0,0};
-                    bcf_variant2string(odr->hdr, v, &var);
-                    if (print) fprintf(stderr, "[%s:%d %s] INCONSISTENT REF: %s:%d %s!=%s(truth) for variant %s\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, alleles[0], ref, var.s);
-                    if (var.m) free(var.s);
-                    ++no_inconsistent_ref;
+                    n = n*(n_allele+i-1)/i;
                 }
+                return n;
+            }
+            default:
+                return -1;
+        }
+    }
+
+    /**
+     * Returns the number of values in a vector of at most n values of type,
+     * missing is set if the only value is missing.
+     */
+    int32_t count_values(uint8_t* p, int32_t type, int32_t n, bool& missing)
+    {
+        int32_t i = 0;
+        switch (type)
+        {
+            case BCF_BT_INT8:
+            {
+                int8_t* x = (int8_t*) p;
+                while (i<n && x[i]!=bcf_int8_vector_end) ++i;
+                missing = i==1 && x[0]==bcf_int8_missing;
+                break;
+            }
+            case BCF_BT_INT16:
+            {
+                int16_t* x = (int16_t*) p;
+                while (i<n && x[i]!=bcf_int16_vector_end) ++i;
+                missing = i==1 && x[0]==bcf_int16_missing;
+                break;
+            }
+            case BCF_BT_INT32:
+            {
+                int32_t* x = (int32_t*) p;
+                while (i<n && x[i]!=bcf_int32_vector_end) ++i;
+                missing = i==1 && x[0]==bcf_int32_missing;
+                break;
+            }
+            case BCF_BT_FLOAT:
+            {
+                float* x = (float*) p;
+                while (i<n && !bcf_float_is_vector_end(x[i])) ++i;
+                missing = i==1 && bcf_float_is_missing(x[0]);
+                break;
+            }
+            default:
+                missing = false;
+                return n;
+        }
+
+        return i;
+    }
+
+    /**
+     * Checks the FILTER, INFO and FORMAT fields and the genotypes of a record.
+     */
+    void check_fields(worker_t* w, bcf_hdr_t* h, bcf1_t* v, const char* chrom, int32_t pos1)
+    {
+        int32_t n_allele = bcf_get_n_allele(v);
+        bool missing = false;
+
+        for (int32_t i=0; i<v->d.n_flt; ++i)
+        {
+            if (!is_defined(w, h, BCF_HL_FLT, v->d.flt[i]))
+            {
+                if (print) fprintf(stderr, "[%s:%d %s] UNDEFINED FILTER: %s:%d %s\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, bcf_hdr_int2id(h, BCF_DT_ID, v->d.flt[i]));
+                ++w->no_undefined_fields;
+            }
+        }
+
+        for (int32_t i=0; i<v->n_info; ++i)
+        {
+            bcf_info_t* info = &v->d.info[i];
+            if (!info->vptr) continue;
+
+            if (!is_defined(w, h, BCF_HL_INFO, info->key))
+            {
+                if (print) fprintf(stderr, "[%s:%d %s] UNDEFINED INFO: %s:%d %s\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, bcf_hdr_int2id(h, BCF_DT_ID, info->key));
+                ++w->no_undefined_fields;
+                continue;
+            }
+
+            int32_t type = bcf_hdr_id2type(h, BCF_HL_INFO, info->key);
+            if (type==BCF_HT_STR || type==BCF_HT_FLAG) continue;
+
+            int32_t expected = expected_number(h, BCF_HL_INFO, info->key, n_allele, 2);
+            int32_t n = count_values(info->vptr, info->type, info->len, missing);
+            if (expected>=0 && n!=expected && !missing)
+            {
+                if (print) fprintf(stderr, "[%s:%d %s] INVALID NUMBER: %s:%d INFO/%s has %d values, expected %d\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, bcf_hdr_int2id(h, BCF_DT_ID, info->key), n, expected);
+                ++w->no_invalid_number;
+            }
+        }
+
+        if (!v->n_fmt) return;
+
+        //genotype alleles and ploidy, diploid is assumed for the samples without GT
+        int32_t no_samples = bcf_hdr_nsamples(h);
+        w->ploidy.assign(no_samples, 2);
+        int32_t gt_id = bcf_hdr_id2int(h, BCF_DT_ID, "GT");
+        for (int32_t i=0; i<v->n_fmt; ++i)
+        {
+            bcf_fmt_t* fmt = &v->d.fmt[i];
+            if (fmt->id!=gt_id || !fmt->p) continue;
+
+            int32_t invalid_sample = -1;
+            int32_t invalid_allele = 0;
+            for (int32_t j=0; j<no_samples; ++j)
+            {
+                uint8_t* p = fmt->p + j*fmt->size;
+                int32_t ploidy = count_values(p, fmt->type, fmt->n, missing);
+                if (ploidy) w->ploidy[j] = ploidy;
 
-                if (ref_len)
+                for (int32_t k=0; k<ploidy && invalid_sample==-1; ++k)
                 {
-                    free(ref);
+                    int32_t a = fmt->type==BCF_BT_INT8 ? ((int8_t*)p)[k] : fmt->type==BCF_BT_INT16 ? ((int16_t*)p)[k] : ((int32_t*)p)[k];
+                    if (!bcf_gt_is_missing(a) && bcf_gt_allele(a)>=n_allele)
+                    {
+                        invalid_sample = j;
+                        invalid_allele = bcf_gt_allele(a);
+                    }
                 }
             }
 
-            ++no_variants;
+            if (invalid_sample!=-1)
+            {
+                if (print) fprintf(stderr, "[%s:%d %s] INVALID GT: %s:%d sample %s has allele %d of %d alleles\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, h->samples[invalid_sample], invalid_allele, n_allele);
+                ++w->no_invalid_genotypes;
+            }
         }
 
-        odr->close();
-    };
+        for (int32_t i=0; i<v->n_fmt; ++i)
+        {
+            bcf_fmt_t* fmt = &v->d.fmt[i];
+            if (!fmt->p) continue;
+
+            if (!is_defined(w, h, BCF_HL_FMT, fmt->id))
+            {
+                if (print) fprintf(stderr, "[%s:%d %s] UNDEFINED FORMAT: %s:%d %s\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, bcf_hdr_int2id(h, BCF_DT_ID, fmt->id));
+                ++w->no_undefined_fields;
+                continue;
+            }
+
+            if (fmt->id==gt_id || bcf_hdr_id2type(h, BCF_HL_FMT, fmt->id)==BCF_HT_STR) continue;
+
+            int32_t length = bcf_hdr_id2length(h, BCF_HL_FMT, fmt->id);
+            if (length==BCF_VL_VAR) continue;
+
+            int32_t expected = expected_number(h, BCF_HL_FMT, fmt->id, n_allele, 2);
+            for (int32_t j=0; j<no_samples; ++j)
+            {
+                int32_t n = count_values(fmt->p + j*fmt->size, fmt->type, fmt->n, missing);
+                int32_t e = length==BCF_VL_G && w->ploidy[j]!=2 ? expected_number(h, BCF_HL_FMT, fmt->id, n_allele, w->ploidy[j]) : expected;
+                if (n!=e && n && !missing)
+                {
+                    if (print) fprintf(stderr, "[%s:%d %s] INVALID NUMBER: %s:%d FORMAT/%s of sample %s has %d values, expected %d\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1, bcf_hdr_int2id(h, BCF_DT_ID, fmt->id), h->samples[j], n, e);
+                    ++w->no_invalid_number;
+                    break;
+                }
+            }
+        }
+    }
 
     void print_options()
     {
@@ -192,6 +595,7 @@ class Igor : Program
         std::clog << "\n";
         std::clog << "options:     input VCF file        " << input_vcf_file << "\n";
         print_ref_op("         [r] reference FASTA file  ", ref_fasta_file);
+        print_num_op("         [t] no. of threads        ", no_threads);
         print_int_op("         [i] intervals             ", intervals);
         std::clog << "\n";
     }
@@ -202,7 +606,7 @@ class Igor : Program
         std::clog << "stats:    no. unordered                     : " << no_unordered << "\n";
         std::clog << "          no. unordered chrom               : " << no_unordered_chrom << "\n";
         std::clog << "\n";
-        if (fai)
+        if (workers[0]->rs)
         {
             std::clog << "          no. inconsistent REF              : " << no_inconsistent_ref << "\n";
             std::clog << "\n";
@@ -211,6 +615,10 @@ class Igor : Program
         {
             std::clog << "reference consistency not checked.\n\n"; 
         }
+        std::clog << "          no. undefined fields              : " << no_undefined_fields << "\n";
+        std::clog << "          no. fields with invalid number    : " << no_invalid_number << "\n";
+        std::clog << "          no. invalid genotypes             : " << no_invalid_genotypes << "\n";
+        std::clog << "\n";
         std::clog << "          no. variants                      : " << no_variants << "\n";
         std::clog << "\n";
     };
@@ -231,4 +639,4 @@ bool validate(int argc, char ** argv)
     igor.print_stats();
 
     return igor.print;
-};
\ No newline at end of file
+};
@@ -25,6 +25,8 @@
 #define VALIDATE_H
 
 #include "program.h"
+#include "parallel_synced_driver.h"
+#include "reference_sequence.h"
 
 bool validate(int argc, char ** argv);
 
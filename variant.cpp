@@ -23,6 +23,53 @@
 
 #include "variant.h"
 
+namespace
+{
+
+/**
+ * INFO fields of a VNTR, each is present for the motif, exact and fuzzy repeat tracts.
+ */
+enum
+{
+    VNTR_MOTIF,
+    VNTR_RU,
+    VNTR_BASIS,
+    VNTR_REPEAT_TRACT,
+    VNTR_COMP,
+    VNTR_ENTROPY,
+    VNTR_ENTROPY2,
+    VNTR_KL_DIVERGENCE,
+    VNTR_KL_DIVERGENCE2,
+    VNTR_RL,
+    VNTR_LL,
+    VNTR_RU_COUNTS,
+    VNTR_SCORE,
+    VNTR_TRF_SCORE
+};
+
+const char* vntr_info_tags[VNTR_NO_INFO_FIELDS] = {"MOTIF", "RU", "BASIS", "REPEAT_TRACT", "COMP", "ENTROPY", "ENTROPY2", "KL_DIVERGENCE", "KL_DIVERGENCE2", "RL", "LL", "RU_COUNTS", "SCORE", "TRF_SCORE"};
+const int32_t vntr_info_types[VNTR_NO_INFO_FIELDS] = {BCF_HT_STR, BCF_HT_STR, BCF_HT_STR, BCF_HT_INT, BCF_HT_INT, BCF_HT_REAL, BCF_HT_REAL, BCF_HT_REAL, BCF_HT_REAL, BCF_HT_INT, BCF_HT_INT, BCF_HT_INT, BCF_HT_REAL, BCF_HT_INT};
+const char* vntr_info_prefixes[3] = {"", "EX_", "FZ_"};
+
+}
+
+/**
+ * Constructor.
+ */
+VNTRInfoIDs::VNTRInfoIDs(bcf_hdr_t* h)
+{
+    std::string tag;
+    for (int32_t i=0; i<3; ++i)
+    {
+        for (int32_t j=0; j<VNTR_NO_INFO_FIELDS; ++j)
+        {
+            tag.assign(vntr_info_prefixes[i]);
+            tag.append(vntr_info_tags[j]);
+            id[i][j] = bcf_hdr_get_info_id(h, tag.c_str(), vntr_info_types[j]);
+        }
+    }
+}
+
 /**
  * Constructor.
  */
@@ -30,6 +77,7 @@ Variant::Variant(bcf_hdr_t* h, bcf1_t* v)
 {
     this->h = h;
     this->v = v;
+    vntr_attached = false;
 
     type = classify(h, v);
 
@@ -70,8 +118,6 @@ Variant::Variant(bcf_hdr_t* h, bcf1_t* v)
         end1 = bcf_get_info_int(h, v, "END", 0);
         if (!end1) end1 = bcf_get_end1(v);
 
-        update_vntr_from_info_fields(h, v);
-
         vs.push_back(v);
         vntr_vs.push_back(v);
     }
@@ -96,6 +142,7 @@ Variant::Variant(bcf_hdr_t* h, bcf1_t* v)
 Variant::Variant(Variant* v1, Variant* v2)
 {
     type = VT_UNDEFINED;
+    vntr_attached = false;
 
     chrom = v1->chrom;
     rid = v1->rid;
@@ -142,6 +189,7 @@ Variant::Variant(Variant* v1, Variant* v2)
  */
 Variant::Variant()
 {
+    vntr_attached = false;
     clear();
 }
 
@@ -162,6 +210,24 @@ Variant::~Variant()
  * Clears variant information.
  */
 void Variant::clear()
+{
+    reuse();
+    chrom.clear();
+    vntr.clear();
+    vs.clear();
+    snp_vs.clear();
+    indel_vs.clear();
+    vntr_vs.clear();
+    consolidated_vntr_vs.clear();
+};
+
+/**
+ * Clears variant information for the next record but keeps the contig
+ * name, so that it is only copied again when the contig changes.  The
+ * VNTR is detached and only cleared when it is requested again, and the
+ * linked records are only cleared when there are any.
+ */
+void Variant::reuse()
 {
     type = VT_REF;
 
@@ -173,7 +239,6 @@ void Variant::clear()
     associated_new_multiallelic = NULL;
     updated_multiallelic = false;
 
-    chrom.clear();
     rid = 0;
     pos1 = 0;
     beg1 = 0;
@@ -191,12 +256,16 @@ void Variant::clear()
 
     contains_N = false;
     alleles.clear();
-    vntr.clear();
-    vs.clear();
-    snp_vs.clear();
-    indel_vs.clear();
-    vntr_vs.clear();
-    consolidated_vntr_vs.clear();
+    vntr_attached = false;
+
+    if (!vs.empty())
+    {
+        vs.clear();
+        snp_vs.clear();
+        indel_vs.clear();
+        vntr_vs.clear();
+        consolidated_vntr_vs.clear();
+    }
 };
 
 /**
@@ -310,9 +379,6 @@ int32_t Variant::classify(bcf_hdr_t *h, bcf1_t *v)
         //explicit sequence of bases
         else
         {
-            kstring_t REF = {0,0,0};
-            kstring_t ALT = {0,0,0};
-
             ref = allele[0];
             char* alt = allele[i];
             int32_t alen = strlen(alt);
@@ -363,12 +429,8 @@ int32_t Variant::classify(bcf_hdr_t *h, bcf1_t *v)
                 }
             }
 
-            kputsn(ref, rl, &REF);
-            kputsn(alt, al, &ALT);
-
-            ref = REF.s;
-            alt = ALT.s;
-
+            //ref and alt now point to the trimmed alleles in place,
+            //only the first rl and al bases are examined below
             int32_t mlen = std::min(rl, al);
             int32_t dlen = al-rl;
             int32_t diff = 0;
@@ -456,17 +518,9 @@ int32_t Variant::classify(bcf_hdr_t *h, bcf1_t *v)
             tv += tv;
             ins = dlen>0?1:0;
             del = dlen<0?1:0;
-
-            if (REF.m) free(REF.s);
-            if (ALT.m) free(ALT.s);
         }
     }
 
-    if (type==VT_VNTR)
-    {
-        update_vntr_from_info_fields(h, v);
-    }
-
     //additionally define MNPs by length of all alleles
     if (!(type&(VT_VNTR|VT_SV)) && type!=VT_REF)
     {
@@ -479,102 +533,110 @@ int32_t Variant::classify(bcf_hdr_t *h, bcf1_t *v)
     return type;
 }
 
+/**
+ * Gets the VNTR of this variant, attaching it on the first request.
+ */
+VNTR& Variant::get_vntr()
+{
+    if (!vntr_attached)
+    {
+        vntr.clear();
+        vntr_attached = true;
+    }
+
+    return vntr;
+}
+
 /**
  * Updates VNTR related information from INFO fields.
  */
-void Variant::update_vntr_from_info_fields()
+void Variant::update_vntr_from_info_fields(const VNTRInfoIDs& ids)
 {
+    VNTR& vntr = get_vntr();
     vntr.motif = bcf_get_rid(v);
     char** allele = bcf_get_allele(v);
 //    vntr.exact_repeat_tract.assign(allele[0]);
 //   std::string tags[16] = {"MOTIF", "RU", "BASIS", "MLEN", "BLEN", "REPEAT_TRACT", "COMP", "ENTROPY", "ENTROPY2", "KL_DIVERGENCE", "KL_DIVERGENCE2", "RL", "LL", "RU_COUNTS", "SCORE", "TRF_SCORE"};
 
-    vntr.motif = bcf_get_info_str(h, v, "MOTIF");
-    vntr.ru = bcf_get_info_str(h, v, "RU");
-    vntr.basis = bcf_get_info_str(h, v, "BASIS");
+    int32_t i_vec[4];
+
+    const int32_t* id = ids.id[0];
+    bcf_get_info_str(v, id[VNTR_MOTIF], vntr.motif);
+    bcf_get_info_str(v, id[VNTR_RU], vntr.ru);
+    bcf_get_info_str(v, id[VNTR_BASIS], vntr.basis);
     if (vntr.basis=="") vntr.basis = VNTR::get_basis(vntr.motif);
     vntr.mlen = vntr.motif.size();
     vntr.blen = (int32_t) vntr.basis.size();
-    std::vector<int32_t> i_vec = bcf_get_info_int_vec(h, v, "REPEAT_TRACT", 2, 0);
+    bcf_get_info_int_vec(v, id[VNTR_REPEAT_TRACT], i_vec, 2, 0);
     vntr.beg1 = i_vec[0];
     vntr.end1 = i_vec[1];
-    i_vec = bcf_get_info_int_vec(h, v, "COMP", 4, 0);
-    vntr.comp[0] = i_vec[0];
-    vntr.comp[1] = i_vec[1];
-    vntr.comp[2] = i_vec[2];
-    vntr.comp[3] = i_vec[3];
-    vntr.entropy = bcf_get_info_flt(h, v, "ENTROPY");
-    vntr.entropy2 = bcf_get_info_flt(h, v, "ENTROPY2");
-    vntr.kl_divergence = bcf_get_info_flt(h, v, "KL_DIVERGENCE");
-    vntr.kl_divergence2 = bcf_get_info_flt(h, v, "KL_DIVERGENCE2");
-    vntr.rl = bcf_get_info_int(h, v, "RL");
-    vntr.ll = bcf_get_info_int(h, v, "LL");
-    i_vec = bcf_get_info_int_vec(h, v, "RU_COUNTS", 2, 0);
+    bcf_get_info_int_vec(v, id[VNTR_COMP], vntr.comp, 4, 0);
+    vntr.entropy = bcf_get_info_flt(v, id[VNTR_ENTROPY]);
+    vntr.entropy2 = bcf_get_info_flt(v, id[VNTR_ENTROPY2]);
+    vntr.kl_divergence = bcf_get_info_flt(v, id[VNTR_KL_DIVERGENCE]);
+    vntr.kl_divergence2 = bcf_get_info_flt(v, id[VNTR_KL_DIVERGENCE2]);
+    vntr.rl = bcf_get_info_int(v, id[VNTR_RL]);
+    vntr.ll = bcf_get_info_int(v, id[VNTR_LL]);
+    bcf_get_info_int_vec(v, id[VNTR_RU_COUNTS], i_vec, 2, 0);
     vntr.no_perfect_ru = i_vec[0];
     vntr.no_ru = i_vec[1];
-    vntr.score = bcf_get_info_flt(h, v, "SCORE");
-    vntr.trf_score = bcf_get_info_int(h, v, "TRF_SCORE");
+    vntr.score = bcf_get_info_flt(v, id[VNTR_SCORE]);
+    vntr.trf_score = bcf_get_info_int(v, id[VNTR_TRF_SCORE]);
 
-    vntr.exact_motif = bcf_get_info_str(h, v, "EX_MOTIF");
-    vntr.exact_ru = bcf_get_info_str(h, v, "EX_RU");
-    vntr.exact_basis = bcf_get_info_str(h, v, "EX_BASIS");
+    id = ids.id[1];
+    bcf_get_info_str(v, id[VNTR_MOTIF], vntr.exact_motif);
+    bcf_get_info_str(v, id[VNTR_RU], vntr.exact_ru);
+    bcf_get_info_str(v, id[VNTR_BASIS], vntr.exact_basis);
     vntr.exact_mlen = (int32_t) vntr.exact_motif.size();
     vntr.exact_blen = (int32_t) vntr.exact_basis.size();
-    i_vec = bcf_get_info_int_vec(h, v, "EX_REPEAT_TRACT", 2, 0);
+    bcf_get_info_int_vec(v, id[VNTR_REPEAT_TRACT], i_vec, 2, 0);
     vntr.exact_beg1 = i_vec[0];
     vntr.exact_end1 = i_vec[1];
-    i_vec = bcf_get_info_int_vec(h, v, "EX_COMP", 4, 0);
-    vntr.exact_comp[0] = i_vec[0];
-    vntr.exact_comp[1] = i_vec[1];
-    vntr.exact_comp[2] = i_vec[2];
-    vntr.exact_comp[3] = i_vec[3];
-    vntr.exact_entropy = bcf_get_info_flt(h, v, "EX_ENTROPY");
-    vntr.exact_entropy2 = bcf_get_info_flt(h, v, "EX_ENTROPY2");
-    vntr.exact_kl_divergence = bcf_get_info_flt(h, v, "EX_KL_DIVERGENCE");
-    vntr.exact_kl_divergence2 = bcf_get_info_flt(h, v, "EX_KL_DIVERGENCE2");
-    vntr.exact_rl = bcf_get_info_int(h, v, "EX_RL");
-    vntr.exact_ll = bcf_get_info_int(h, v, "EX_LL");
-    i_vec = bcf_get_info_int_vec(h, v, "EX_RU_COUNTS", 2, 0);
+    bcf_get_info_int_vec(v, id[VNTR_COMP], vntr.exact_comp, 4, 0);
+    vntr.exact_entropy = bcf_get_info_flt(v, id[VNTR_ENTROPY]);
+    vntr.exact_entropy2 = bcf_get_info_flt(v, id[VNTR_ENTROPY2]);
+    vntr.exact_kl_divergence = bcf_get_info_flt(v, id[VNTR_KL_DIVERGENCE]);
+    vntr.exact_kl_divergence2 = bcf_get_info_flt(v, id[VNTR_KL_DIVERGENCE2]);
+    vntr.exact_rl = bcf_get_info_int(v, id[VNTR_RL]);
+    vntr.exact_ll = bcf_get_info_int(v, id[VNTR_LL]);
+    bcf_get_info_int_vec(v, id[VNTR_RU_COUNTS], i_vec, 2, 0);
     vntr.exact_no_perfect_ru = i_vec[0];
     vntr.exact_no_ru = i_vec[1];
-    vntr.exact_score = bcf_get_info_flt(h, v, "EX_SCORE");
-    vntr.exact_trf_score = bcf_get_info_int(h, v, "EX_TRF_SCORE");
+    vntr.exact_score = bcf_get_info_flt(v, id[VNTR_SCORE]);
+    vntr.exact_trf_score = bcf_get_info_int(v, id[VNTR_TRF_SCORE]);
 
-    vntr.fuzzy_motif = bcf_get_info_str(h, v, "FZ_MOTIF");
-    vntr.fuzzy_ru = bcf_get_info_str(h, v, "FZ_RU");
-    vntr.fuzzy_basis = bcf_get_info_str(h, v, "FZ_BASIS");
+    id = ids.id[2];
+    bcf_get_info_str(v, id[VNTR_MOTIF], vntr.fuzzy_motif);
+    bcf_get_info_str(v, id[VNTR_RU], vntr.fuzzy_ru);
+    bcf_get_info_str(v, id[VNTR_BASIS], vntr.fuzzy_basis);
     vntr.fuzzy_mlen = (int32_t) vntr.fuzzy_motif.size();
     vntr.fuzzy_blen = (int32_t) vntr.fuzzy_basis.size();
-    i_vec = bcf_get_info_int_vec(h, v, "FZ_REPEAT_TRACT", 2, 0);
+    bcf_get_info_int_vec(v, id[VNTR_REPEAT_TRACT], i_vec, 2, 0);
     vntr.fuzzy_beg1 = i_vec[0];
     vntr.fuzzy_end1 = i_vec[1];
-    i_vec = bcf_get_info_int_vec(h, v, "FZ_COMP", 4, 0);
-    vntr.fuzzy_comp[0] = i_vec[0];
-    vntr.fuzzy_comp[1] = i_vec[1];
-    vntr.fuzzy_comp[2] = i_vec[2];
-    vntr.fuzzy_comp[3] = i_vec[3];
-    vntr.fuzzy_entropy = bcf_get_info_flt(h, v, "FZ_ENTROPY");
-    vntr.fuzzy_entropy2 = bcf_get_info_flt(h, v, "FZ_ENTROPY2");
-    vntr.fuzzy_kl_divergence = bcf_get_info_flt(h, v, "FZ_KL_DIVERGENCE");
-    vntr.fuzzy_kl_divergence2 = bcf_get_info_flt(h, v, "FZ_KL_DIVERGENCE2");
-    vntr.fuzzy_rl = bcf_get_info_int(h, v, "FZ_RL");
-    vntr.fuzzy_ll = bcf_get_info_int(h, v, "FZ_LL");
-    i_vec = bcf_get_info_int_vec(h, v, "FZ_RU_COUNTS", 2, 0);
+    bcf_get_info_int_vec(v, id[VNTR_COMP], vntr.fuzzy_comp, 4, 0);
+    vntr.fuzzy_entropy = bcf_get_info_flt(v, id[VNTR_ENTROPY]);
+    vntr.fuzzy_entropy2 = bcf_get_info_flt(v, id[VNTR_ENTROPY2]);
+    vntr.fuzzy_kl_divergence = bcf_get_info_flt(v, id[VNTR_KL_DIVERGENCE]);
+    vntr.fuzzy_kl_divergence2 = bcf_get_info_flt(v, id[VNTR_KL_DIVERGENCE2]);
+    vntr.fuzzy_rl = bcf_get_info_int(v, id[VNTR_RL]);
+    vntr.fuzzy_ll = bcf_get_info_int(v, id[VNTR_LL]);
+    bcf_get_info_int_vec(v, id[VNTR_RU_COUNTS], i_vec, 2, 0);
     vntr.fuzzy_no_perfect_ru = i_vec[0];
     vntr.fuzzy_no_ru = i_vec[1];
-    vntr.fuzzy_score = bcf_get_info_flt(h, v, "FZ_SCORE");
-    vntr.fuzzy_trf_score = bcf_get_info_int(h, v, "FZ_TRF_SCORE");
+    vntr.fuzzy_score = bcf_get_info_flt(v, id[VNTR_SCORE]);
+    vntr.fuzzy_trf_score = bcf_get_info_int(v, id[VNTR_TRF_SCORE]);
 }
 
 /**
  * Updates VNTR related information from INFO fields.
  */
-void Variant::update_vntr_from_info_fields(bcf_hdr_t *h, bcf1_t *v)
+void Variant::update_vntr_from_info_fields(bcf_hdr_t *h, bcf1_t *v, const VNTRInfoIDs& ids)
 {
     this->h = h;
     this->v = v;
 
-    update_vntr_from_info_fields();
+    update_vntr_from_info_fields(ids);
 }
 
 /**
@@ -582,6 +644,8 @@ void Variant::update_vntr_from_info_fields(bcf_hdr_t *h, bcf1_t *v)
  */
 void Variant::update_bcf_with_vntr_info(bcf_hdr_t *h, bcf1_t *v)
 {
+    VNTR& vntr = get_vntr();
+
     bcf_update_info_flag(h, v, "FUZZY", NULL, 1);
 
     //VNTR position and sequences
@@ -628,8 +692,11 @@ void Variant::print()
     std::cerr << "beg1  : " << beg1 << "\n";
     std::cerr << "end1  : " << end1 << "\n";
 
-    std::cerr << "motif: " << vntr.motif << "\n";
-    std::cerr << "rlen : " << vntr.motif.size() << "\n";
+    if (vntr_attached)
+    {
+        std::cerr << "motif: " << vntr.motif << "\n";
+        std::cerr << "rlen : " << vntr.motif.size() << "\n";
+    }
 
     for (int32_t i=0; i<alleles.size(); ++i)
     {
@@ -671,6 +738,8 @@ std::string Variant::get_variant_string()
  */
 void Variant::get_vntr_string(kstring_t* s)
 {
+    VNTR& vntr = get_vntr();
+
     s->l = 0;
     kputs(chrom.c_str(), s);
     kputc(':', s);
@@ -688,6 +757,8 @@ void Variant::get_vntr_string(kstring_t* s)
  */
 void Variant::get_fuzzy_vntr_string(kstring_t* s)
 {
+    VNTR& vntr = get_vntr();
+
     s->l = 0;
     kputs(chrom.c_str(), s);
     kputc(':', s);
@@ -29,6 +29,83 @@
 #ifndef VARIANT_H
 #define VARIANT_H
 
+#define VC_MAX_INLINE_ALLELES 8
+#define VNTR_NO_INFO_FIELDS 14
+
+/**
+ * Classification of an alternative allele.
+ */
+typedef struct
+{
+    int32_t type;  //allele type, VT_REF if the allele is not a variant
+    int32_t diff;  //number of difference bases when bases are compared
+    int32_t alen;  //length(alt)
+    int32_t dlen;  //length(alt)-length(ref)
+    int32_t mlen;  //min shared length
+    int32_t ts;    //no. of transitions
+    int32_t tv;    //no. of tranversions (mlen-ts)
+    bool bnd;      //breakend, other SV alleles are described by the allele itself
+    bool has_N;    //explicit allele contains N bases
+} vc_allele_t;
+
+/**
+ * Compact classification of a VCF record.
+ *
+ * This is the flat counterpart of Variant for tools that only need the
+ * variant type and allele characteristics.  It is filled without touching
+ * the heap: the contig is kept as its index in the header, symbolic
+ * alleles are read from the record itself, the first VC_MAX_INLINE_ALLELES
+ * alternative alleles are described inline and no VNTR or multiallelic
+ * information is attached.  The aggregate fields cover all alleles.
+ */
+class VariantClass
+{
+    public:
+
+    //aggegrated type from the alleles
+    int32_t type;
+
+    //location information
+    int32_t rid;
+    int32_t pos1;
+    int32_t end1;
+
+    //no. of alleles including the reference
+    int32_t n_allele;
+
+    //sum from all the alleles
+    int32_t ts;
+    int32_t tv;
+    int32_t ins;
+    int32_t del;
+    int32_t max_dlen;
+    int32_t min_dlen;
+
+    //contains N bases in alleles
+    bool contains_N;
+
+    //alternative allele i is described in alleles[i-1] for i<=VC_MAX_INLINE_ALLELES
+    vc_allele_t alleles[VC_MAX_INLINE_ALLELES];
+};
+
+/**
+ * IDs of the VNTR INFO fields of a header for the motif, exact and fuzzy
+ * repeat tracts.  A tool resolves them once for the header of the records
+ * it reads and passes them to Variant::update_vntr_from_info_fields.
+ */
+class VNTRInfoIDs
+{
+    public:
+
+    //IDs of the fields without a prefix, with EX_ and with FZ_
+    int32_t id[3][VNTR_NO_INFO_FIELDS];
+
+    /**
+     * Constructor.
+     */
+    VNTRInfoIDs(bcf_hdr_t* h);
+};
+
 /**
  * This represents a Variant and is augmented on top of VCF's record to handle the notion of variants as defined by us.
  *
@@ -58,7 +135,8 @@ class Variant
     bcf_hdr_t* h;
     bcf1_t* v;
 
-    //associated VCF records for merging into a multiallelic
+    //associated VCF records for merging into a multiallelic,
+    //only cleared by reuse() when records were linked
     std::vector<bcf1_t*> vs;
     std::vector<bcf1_t*> snp_vs;
     std::vector<bcf1_t*> indel_vs;
@@ -90,9 +168,6 @@ class Variant
     Variant* associated_new_multiallelic;
     bool updated_multiallelic;
 
-    //describes VNTR
-    VNTR vntr;
-
     //contains N bases in alleles
     bool contains_N;
 
@@ -122,20 +197,34 @@ class Variant
      */
     void clear();
 
+    /**
+     * Clears variant information for the next record but keeps the contig
+     * name, so that it is only copied again when the contig changes.
+     */
+    void reuse();
+
     /**
      * Classifies variants based on observed alleles in vcf record.
      */
     int32_t classify(bcf_hdr_t *h, bcf1_t *v);
 
     /**
-     * Updates VNTR related information from INFO fields.
+     * Gets the VNTR of this variant.  It is attached on the first request after
+     * the variant is classified or reused, and starts out cleared.
      */
-    void update_vntr_from_info_fields();
+    VNTR& get_vntr();
+
+    /**
+     * Updates VNTR related information from INFO fields.  This is not done when
+     * a record is classified, tools that read the VNTR of a VNTR record call it
+     * with the IDs of the fields in the header of the record.
+     */
+    void update_vntr_from_info_fields(const VNTRInfoIDs& ids);
 
     /**
      * Updates VNTR related information from INFO fields.
      */
-    void update_vntr_from_info_fields(bcf_hdr_t *h, bcf1_t *v);
+    void update_vntr_from_info_fields(bcf_hdr_t *h, bcf1_t *v, const VNTRInfoIDs& ids);
 
     /**
      * Updates a bcf1_t object with VNTR information.
@@ -166,6 +255,12 @@ class Variant
      * Converts VTYPE to string.
      */
     static std::string vtype2string(int32_t VTYPE);
+
+    private:
+
+    //describes VNTR, attached by get_vntr()
+    VNTR vntr;
+    bool vntr_attached;
 };
 
 #endif
@@ -23,6 +23,8 @@
 
 #include "variant_manip.h"
 
+VT_TIMER_STAT(classify_stat, "variant_manip.classify_variant");
+
 /**
  * Constructor.
  *
@@ -30,15 +32,12 @@
  */
 VariantManip::VariantManip(std::string ref_fasta_file)
 {
+    rs = NULL;
+    reference_present = false;
     if (ref_fasta_file!="")
     {
-        fai = fai_load(ref_fasta_file.c_str());
-        if (fai==NULL)
-        {
-            fprintf(stderr, "[%s:%d %s] Cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-            exit(1);
-        }
-        reference_present = (fai!=NULL);
+        rs = new ReferenceSequence(ref_fasta_file);
+        reference_present = true;
     }
 };
 
@@ -47,9 +46,18 @@ VariantManip::VariantManip(std::string ref_fasta_file)
  */
 VariantManip::VariantManip()
 {
+    rs = NULL;
     reference_present = false;
 }
 
+/**
+ * Destructor.
+ */
+VariantManip::~VariantManip()
+{
+    if (rs) delete rs;
+}
+
 /**
  * Checks if the REF sequence of a VCF entry is consistent.
  *
@@ -65,8 +73,8 @@ int32_t VariantManip::is_not_ref_consistent(bcf_hdr_t *h, bcf1_t *v)
     char* vcf_ref = bcf_get_ref(v);
     uint32_t rlen = strlen(vcf_ref);
 
-    int32_t ref_len = 0;
-    char *ref = faidx_fetch_seq(fai, chrom, pos0, pos0+rlen-1, &ref_len);
+    char *ref = rs->fetch_masked_seq(chrom, pos0+1, pos0+rlen);
+    int32_t ref_len = ref ? strlen(ref) : 0;
     if (!ref)
     {
         fprintf(stderr, "[%s:%d %s] failure to extract base from fasta file: %s:%d-%d\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos0, pos0+rlen-1);
@@ -222,277 +230,357 @@ bool VariantManip::contains_N(bcf1_t *v)
 }
 
 /**
- * Classifies variants.
+ * Classifies alternative allele alt against the reference allele ref of rlen bases.
  */
-int32_t VariantManip::classify_variant(bcf_hdr_t *h, bcf1_t *v, Variant& var)
+void VariantManip::classify_allele(const char* ref, int32_t rlen, const char* alt, vc_allele_t& a)
 {
-    var.clear(); // this sets the type to VT_REF by default.
-
-    var.h = h;
-    var.v = v;
-
-    bcf_unpack(v, BCF_UN_STR);
-    var.chrom.assign(bcf_get_chrom(h, v));
-    var.rid = bcf_get_rid(v);
-    var.pos1 = bcf_get_pos1(v);
-    var.beg1 = var.pos1;
-    var.end1 = bcf_get_end1(v);
-
-    char** allele = bcf_get_allele(v);
-    int32_t n_allele = bcf_get_n_allele(v);
-
-    uint32_t pos1 = var.pos1;
-    int32_t pos0 = pos1-1;
-
-    bool homogeneous_length = true;
-    char* ref = allele[0];
-    int32_t rlen = strlen(ref);
-
-    if (strchr(ref, 'N'))
+    int32_t type = VT_REF;
+
+    //a single pass over the allele gives its length and the
+    //characters that decide how it is classified
+    int32_t alen = 0;
+    bool symbolic = false;
+    bool breakend = false;
+    bool has_N = false;
+    for (const char* c=alt; *c; ++c, ++alen)
     {
-        var.contains_N = true;
+        switch (*c)
+        {
+            case '<': symbolic = true; break;
+            case '[':
+            case ']': breakend = true; break;
+            case 'N': has_N = true; break;
+        }
     }
 
-    //if only ref allele, skip this entire for loop
-    for (size_t i=1; i<n_allele; ++i)
+    a.type = VT_REF;
+    a.diff = 0;
+    a.alen = alen;
+    a.dlen = 0;
+    a.mlen = 0;
+    a.ts = 0;
+    a.tv = 0;
+    a.bnd = false;
+    a.has_N = false;
+
+    //check for symbolic alternative alleles
+    if (symbolic)
     {
-        int32_t type = VT_REF;
-
-        //check for symbolic alternative alleles
-        if (strchr(allele[i],'<'))
+        size_t len = alen;
+        if (len>=5)
         {
-            size_t len = strlen(allele[i]);
-            if (len>=5)
+            //VN/d+
+            if (alt[0]=='<' && alt[1]=='V' && alt[2]=='N' && alt[len-1]=='>' )
             {
-                //VN/d+
-                if (allele[i][0]=='<' && allele[i][1]=='V' && allele[i][2]=='N' && allele[i][len-1]=='>' )
+                for (size_t j=3; j<len-1; ++j)
                 {
-                    for (size_t j=3; j<len-1; ++j)
+                    if (alt[j]<'0' || alt[j]>'9')
                     {
-                        if (allele[i][j]<'0' || allele[i][j]>'9')
-                        {
-                            type = VT_VNTR;
-                        }
+                        type = VT_VNTR;
                     }
                 }
-                //VNTR
-                else if (len==6 &&
-                         allele[i][0]=='<' &&
-                         allele[i][1]=='V' && allele[i][2]=='N' && allele[i][3]=='T' && allele[i][4]=='R' &&
-                         allele[i][5]=='>' )
-                {
-                     type = VT_VNTR;
-                }
-                //STR
-                else if (len==5 &&
-                         allele[i][0]=='<' &&
-                         allele[i][1]=='S' && allele[i][2]=='T' && allele[i][3]=='R' &&
-                         allele[i][4]=='>' )
-                {
-                     type = VT_VNTR;
-                }
-                //ST/d+
-                else if (allele[i][0]=='<' && allele[i][1]=='S' && allele[i][2]=='T' && allele[i][len-1]=='>' )
-                {
-                    type = VT_VNTR;
+            }
+            //VNTR
+            else if (len==6 &&
+                     alt[0]=='<' &&
+                     alt[1]=='V' && alt[2]=='N' && alt[3]=='T' && alt[4]=='R' &&
+                     alt[5]=='>' )
+            {
+                 type = VT_VNTR;
+            }
+            //STR
+            else if (len==5 &&
+                     alt[0]=='<' &&
+                     alt[1]=='S' && alt[2]=='T' && alt[3]=='R' &&
+                     alt[4]=='>' )
+            {
+                 type = VT_VNTR;
+            }
+            //ST/d+
+            else if (alt[0]=='<' && alt[1]=='S' && alt[2]=='T' && alt[len-1]=='>' )
+            {
+                type = VT_VNTR;
 
-                    for (size_t j=3; j<len-1; ++j)
+                for (size_t j=3; j<len-1; ++j)
+                {
+                    if ((alt[j]<'0' || alt[j]>'9') && alt[j]!='.')
                     {
-                        if ((allele[i][j]<'0' || allele[i][j]>'9') && allele[i][j]!='.')
-                        {
-                            type = VT_SV;
-                        }
+                        type = VT_SV;
                     }
                 }
             }
+        }
 
-            if (type==VT_VNTR)
-            {
-                type = VT_VNTR;
-                var.type |= type;
-                var.alleles.push_back(Allele(type));
-            }
-            else
-            {
-                type = VT_SV;
-                var.type |= type;
-                std::string sv_type(allele[i]);
-                var.alleles.push_back(Allele(type, sv_type));
-            }
+        a.type = type==VT_VNTR ? VT_VNTR : VT_SV;
+        return;
+    }
+
+    //checks for chromosomal breakpoints
+    if (breakend)
+    {
+        a.type = VT_SV;
+        a.bnd = true;
+        return;
+    }
+
+    //non variant record
+    if (alt[0]=='.' || (alen==rlen && memcmp(alt,ref,alen)==0))
+    {
+        return;
+    }
+
+    //explicit sequence of bases
+    a.has_N = has_N;
+
+    //trimming
+    //this is required in particular for the
+    //characterization of multiallelics and
+    //in general, any unnormalized variant
+    int32_t rl = rlen;
+    int32_t al = alen;
+    //trim right
+    while (rl!=1 && al!=1)
+    {
+        if (ref[rl-1]==alt[al-1])
+        {
+            --rl;
+            --al;
         }
-        //checks for chromosomal breakpoints
-        else if (strchr(allele[i],'[')||strchr(allele[i],']'))
+        else
         {
-            type = VT_SV;
-            var.type |= type;
-            std::string sv_type("<BND>");
-            var.alleles.push_back(Allele(type, sv_type));
+            break;
         }
-        //non variant record
-        else if (allele[i][0]=='.' || strcmp(allele[i],allele[0])==0)
+    }
+
+    //trim left
+    while (rl !=1 && al!=1)
+    {
+        if (ref[0]==alt[0])
         {
-            type = VT_REF;
+            ++ref;
+            ++alt;
+            --rl;
+            --al;
         }
-        //explicit sequence of bases
         else
         {
-            kstring_t REF = {0,0,0};
-            kstring_t ALT = {0,0,0};
+            break;
+        }
+    }
 
-            ref = allele[0];
-            char* alt = allele[i];
-            int32_t alen = strlen(alt);
+    //ref and alt now point to the trimmed alleles in place,
+    //only the first rl and al bases are examined below
+    int32_t mlen = std::min(rl, al);
+    int32_t dlen = al-rl;
+    int32_t diff = 0;
+    int32_t ts = 0;
+    int32_t tv = 0;
 
-            if (strchr(alt, 'N'))
-            {
-                var.contains_N = true;
-            }
+    if (mlen==1 && dlen)
+    {
+        char ls, le, ss;
+
+        if (rl>al)
+        {
+             ls = ref[0];
+             le = ref[rl-1];
+             ss = alt[0];
+        }
+        else
+        {
+             ls = alt[0];
+             le = alt[al-1];
+             ss = ref[0];
+        }
+
+        if (ls!=ss && le!=ss)
+        {
+            ++diff;
 
-            if (rlen!=alen)
+            if ((ls=='G' && ss=='A') ||
+                (ls=='A' && ss=='G') ||
+                (ls=='C' && ss=='T') ||
+                (ls=='T' && ss=='C'))
             {
-                homogeneous_length = false;
+                ++ts;
             }
-
-            //trimming
-            //this is required in particular for the
-            //characterization of multiallelics and
-            //in general, any unnormalized variant
-            int32_t rl = rlen;
-            int32_t al = alen;
-            //trim right
-            while (rl!=1 && al!=1)
+            else
             {
-                if (ref[rl-1]==alt[al-1])
-                {
-                    --rl;
-                    --al;
-                }
-                else
-                {
-                    break;
-                }
+                ++tv;
             }
-
-            //trim left
-            while (rl !=1 && al!=1)
+        }
+    }
+    else
+    {
+        for (int32_t j=0; j<mlen; ++j)
+        {
+            if (ref[j]!=alt[j])
             {
-                if (ref[0]==alt[0])
+                ++diff;
+
+                if ((ref[j]=='G' && alt[j]=='A') ||
+                    (ref[j]=='A' && alt[j]=='G') ||
+                    (ref[j]=='C' && alt[j]=='T') ||
+                    (ref[j]=='T' && alt[j]=='C'))
                 {
-                    ++ref;
-                    ++alt;
-                    --rl;
-                    --al;
+                    ++ts;
                 }
                 else
                 {
-                    break;
+                    ++tv;
                 }
             }
+        }
+    }
 
-            kputsn(ref, rl, &REF);
-            kputsn(alt, al, &ALT);
+    //substitution variants
+    if (mlen==diff)
+    {
+        type |= mlen==1 ? VT_SNP : VT_MNP;
+    }
 
-            ref = REF.s;
-            alt = ALT.s;
+    //indel variants
+    if (dlen)
+    {
+        type |= VT_INDEL;
+    }
 
-            int32_t mlen = std::min(rl, al);
-            int32_t dlen = al-rl;
-            int32_t diff = 0;
-            int32_t ts = 0;
-            int32_t tv = 0;
+    //clumped SNPs and MNPs
+    if (diff && diff < mlen) //internal gaps
+    {
+        type |= VT_CLUMPED;
+    }
 
-            if (mlen==1 && dlen)
-            {
-                char ls, le, ss;
+    a.type = type;
+    a.diff = diff;
+    a.dlen = dlen;
+    a.mlen = mlen;
+    a.ts = ts;
+    a.tv = tv;
+}
 
-                if (rl>al)
-                {
-                     ls = ref[0];
-                     le = ref[rl-1];
-                     ss = alt[0];
-                }
-                else
-                {
-                     ls = alt[0];
-                     le = alt[al-1];
-                     ss = ref[0];
-                }
+/**
+ * Classifies variants into a compact result, see VariantClass.
+ */
+int32_t VariantManip::classify_variant(bcf_hdr_t *h, bcf1_t *v, VariantClass& vc)
+{
+    VT_TIME(classify_stat);
 
-                if (ls!=ss && le!=ss)
-                {
-                    ++diff;
+    bcf_unpack(v, BCF_UN_STR);
+    vc.type = VT_REF;
+    vc.rid = bcf_get_rid(v);
+    vc.pos1 = bcf_get_pos1(v);
+    vc.end1 = bcf_get_end1(v);
+    vc.n_allele = bcf_get_n_allele(v);
+    vc.ts = 0;
+    vc.tv = 0;
+    vc.ins = 0;
+    vc.del = 0;
+    vc.max_dlen = 0;
+    vc.min_dlen = 0;
+    vc.contains_N = false;
 
-                    if ((ls=='G' && ss=='A') ||
-                        (ls=='A' && ss=='G') ||
-                        (ls=='C' && ss=='T') ||
-                        (ls=='T' && ss=='C'))
-                    {
-                        ++ts;
-                    }
-                    else
-                    {
-                        ++tv;
-                    }
-                }
-            }
-            else
-            {
-                for (int32_t j=0; j<mlen; ++j)
-                {
-                    if (ref[j]!=alt[j])
-                    {
-                        ++diff;
-
-                        if ((ref[j]=='G' && alt[j]=='A') ||
-                            (ref[j]=='A' && alt[j]=='G') ||
-                            (ref[j]=='C' && alt[j]=='T') ||
-                            (ref[j]=='T' && alt[j]=='C'))
-                        {
-                            ++ts;
-                        }
-                        else
-                        {
-                            ++tv;
-                        }
-                    }
-                }
-            }
+    char** allele = bcf_get_allele(v);
+    char* ref = allele[0];
+    int32_t rlen = 0;
+    for (const char* c=ref; *c; ++c, ++rlen)
+    {
+        if (*c=='N') vc.contains_N = true;
+    }
 
-            //substitution variants
-            if (mlen==diff)
-            {
-                type |= mlen==1 ? VT_SNP : VT_MNP;
-            }
+    bool homogeneous_length = true;
+    vc_allele_t extra;
+    for (int32_t i=1; i<vc.n_allele; ++i)
+    {
+        vc_allele_t& a = i<=VC_MAX_INLINE_ALLELES ? vc.alleles[i-1] : extra;
+        classify_allele(ref, rlen, allele[i], a);
 
-            //indel variants
-            if (dlen)
-            {
-                type |= VT_INDEL;
-            }
+        vc.type |= a.type;
+        if (a.type&~(VT_VNTR|VT_SV))
+        {
+            if (a.has_N) vc.contains_N = true;
+            if (a.alen!=rlen) homogeneous_length = false;
+            vc.ts += a.ts;
+            vc.tv += a.tv;
+            vc.ins = a.dlen>0?1:0;
+            vc.del = a.dlen<0?1:0;
+            vc.max_dlen = vc.max_dlen<a.dlen ? a.dlen : vc.max_dlen;
+            vc.min_dlen = vc.min_dlen>a.dlen ? a.dlen : vc.min_dlen;
+        }
+    }
 
-            //clumped SNPs and MNPs
-            if (diff && diff < mlen) //internal gaps
-            {
-                type |= VT_CLUMPED;
-            }
+    //additionally define MNPs by length of all alleles
+    if (!(vc.type&(VT_VNTR|VT_SV)) && vc.type!=VT_REF)
+    {
+        if (homogeneous_length && rlen>1 && vc.n_allele>1)
+        {
+            vc.type |= VT_MNP;
+        }
+    }
+
+    return vc.type;
+}
+
+/**
+ * Classifies variants.
+ */
+int32_t VariantManip::classify_variant(bcf_hdr_t *h, bcf1_t *v, Variant& var)
+{
+    VT_TIME(classify_stat);
 
-            var.type |= type;
-            var.alleles.push_back(Allele(type, diff, alen, dlen, mlen, ts, tv));
-            var.ts += ts;
-            var.tv += tv;
-            var.ins = dlen>0?1:0;
-            var.del = dlen<0?1:0;
-            var.max_dlen = var.max_dlen<dlen ? dlen : var.max_dlen;
-            var.min_dlen = var.min_dlen>dlen ? dlen : var.min_dlen;
+    //the contig name is only copied when the contig changes
+    bool same_contig = var.h==h && var.rid==(uint32_t)bcf_get_rid(v) && !var.chrom.empty();
+    var.reuse(); // this sets the type to VT_REF by default.
 
-            if (REF.m) free(REF.s);
-            if (ALT.m) free(ALT.s);
-        }
+    var.h = h;
+    var.v = v;
+
+    bcf_unpack(v, BCF_UN_STR);
+    if (!same_contig) var.chrom.assign(bcf_get_chrom(h, v));
+    var.rid = bcf_get_rid(v);
+    var.pos1 = bcf_get_pos1(v);
+    var.beg1 = var.pos1;
+    var.end1 = bcf_get_end1(v);
+
+    char** allele = bcf_get_allele(v);
+    int32_t n_allele = bcf_get_n_allele(v);
+
+    bool homogeneous_length = true;
+    char* ref = allele[0];
+    int32_t rlen = 0;
+    for (const char* c=ref; *c; ++c, ++rlen)
+    {
+        if (*c=='N') var.contains_N = true;
     }
 
-    if (var.type==VT_VNTR)
+    //if only ref allele, skip this entire for loop
+    vc_allele_t a;
+    for (size_t i=1; i<n_allele; ++i)
     {
-        var.update_vntr_from_info_fields(h, v);
+        classify_allele(ref, rlen, allele[i], a);
+
+        var.type |= a.type;
+        if (a.type==VT_VNTR)
+        {
+            var.alleles.push_back(Allele(a.type));
+        }
+        else if (a.type==VT_SV)
+        {
+            std::string sv_type(a.bnd ? "<BND>" : allele[i]);
+            var.alleles.push_back(Allele(a.type, sv_type));
+        }
+        else if (a.type!=VT_REF)
+        {
+            if (a.has_N) var.contains_N = true;
+            if (a.alen!=rlen) homogeneous_length = false;
+            var.alleles.push_back(Allele(a.type, a.diff, a.alen, a.dlen, a.mlen, a.ts, a.tv));
+            var.ts += a.ts;
+            var.tv += a.tv;
+            var.ins = a.dlen>0?1:0;
+            var.del = a.dlen<0?1:0;
+            var.max_dlen = var.max_dlen<a.dlen ? a.dlen : var.max_dlen;
+            var.min_dlen = var.min_dlen>a.dlen ? a.dlen : var.min_dlen;
+        }
     }
 
     //additionally define MNPs by length of all alleles
@@ -560,17 +648,7 @@ void VariantManip::right_trim_or_left_extend(std::vector<std::string>& alleles,
         if (to_left_extend)
         {
             --pos1;
-            int ref_len = 0;
-
-            char *ref = faidx_fetch_uc_seq(fai, chrom, pos1-1, pos1-1, &ref_len);
-            if (!ref)
-            {
-                fprintf(stderr, "[%s:%d %s] failure to extract base from fasta file: %s:%d\n", __FILE__, __LINE__, __FUNCTION__, chrom, pos1-1);
-                fprintf(stderr, "FAQ: http://genome.sph.umich.edu/wiki/Vt#1._vt_cannot_retrieve_sequences_from_my_reference_sequence_file\n");
-                exit(1);
-            }
-            char base = ref[0];
-            free(ref);
+            char base = rs->fetch_base(chrom, pos1);
 
             for (size_t i=0; i<alleles.size(); ++i)
             {
@@ -643,15 +721,13 @@ void VariantManip::generate_probes(const char* chrom,
         std::map<char, uint32_t> bases;
         std::string preamble;
         std::string postamble;
-        char *base;
+        char base;
         uint32_t i = 1;
-        int32_t ref_len;
         while (bases.size()<4 || preamble.size()<min_flank_length)
         {
-            base = faidx_fetch_uc_seq(fai, const_cast<char*>(chrom), pos1-1, pos1-1, &ref_len);
-            preamble.append(1,base[0]);
-            bases[base[0]] = 1;
-            if (ref_len>0) free(base);
+            base = rs->fetch_base(chrom, pos1);
+            preamble.append(1,base);
+            bases[base] = 1;
             ++i;
         }
 
@@ -660,10 +736,9 @@ void VariantManip::generate_probes(const char* chrom,
         uint32_t alleleLength = alleles[0].size();
         while (bases.size()<4 || postamble.size()<min_flank_length)
         {
-            base = faidx_fetch_uc_seq(fai, const_cast<char*>(chrom), pos1+alleleLength+i, pos1+alleleLength+i, &ref_len);
-            postamble.append(1,base[0]);
-            bases[base[0]] = 1;
-            if (ref_len>0) free(base);
+            base = rs->fetch_base(chrom, pos1+alleleLength+i+1);
+            postamble.append(1,base);
+            bases[base] = 1;
             ++i;
         }
 
@@ -702,20 +777,18 @@ void VariantManip::generate_probes(const char* chrom,
         //append preamble
         std::map<char, uint32_t> bases;
         std::string preamble;
-        char* base;
+        char base;
         uint32_t i = 1;
-        int32_t ref_len = 0;
         while (bases.size()<4 && preamble.size()<min_flank_length)
         {
-            base = faidx_fetch_uc_seq(fai, const_cast<char*>(chrom), pos1-i-1, pos1-i-1, &ref_len);
-            preamble.append(1,base[0]);
-            bases[base[0]] = 1;
+            base = rs->fetch_base(chrom, pos1-i);
+            preamble.append(1,base);
+            bases[base] = 1;
             ++i;
-            if (base[0]=='N')
+            if (base=='N')
             {
                 break;
             }
-            if (ref_len>0) free(base);
         }
 
         preambleLength = preamble.size();
@@ -755,10 +828,7 @@ void VariantManip::generate_probes(const char* chrom,
                 else//copy from reference
                 {
                     int32_t start1 = (pos1+length-alleles[i].size()+alleles[0].size()-1);
-                    int32_t ref_len;
-                    char* base = faidx_fetch_uc_seq(fai, const_cast<char*>(chrom), start1 , start1, &ref_len);
-                    probes[i].append(1, base[0]);
-                    if (ref_len>0) free(base);
+                    probes[i].append(1, rs->fetch_base(chrom, start1+1));
                 }
             }
             probeHash[probes[i]] = 1;
@@ -28,6 +28,8 @@
 #include "hts_utils.h"
 #include "variant.h"
 #include "allele.h"
+#include "instrument.h"
+#include "reference_sequence.h"
 
 /**
  * Methods for manipulating variants
@@ -35,7 +37,7 @@
 class VariantManip
 {
     public:
-    faidx_t *fai;
+    ReferenceSequence *rs;
     bool reference_present;
 
     /**
@@ -51,10 +53,26 @@ class VariantManip
     VariantManip();
 
     /**
-     * Classifies variants.
+     * Destructor.
+     */
+    ~VariantManip();
+
+    /**
+     * Classifies variants.  The VNTR of variant is not read from the INFO
+     * fields, see Variant::get_vntr and Variant::update_vntr_from_info_fields.
      */
     int32_t classify_variant(bcf_hdr_t *h, bcf1_t *v, Variant& variant);
 
+    /**
+     * Classifies variants into a compact result without allocating, see VariantClass.
+     */
+    int32_t classify_variant(bcf_hdr_t *h, bcf1_t *v, VariantClass& vc);
+
+    /**
+     * Classifies alternative allele alt against the reference allele ref of rlen bases.
+     */
+    static void classify_allele(const char* ref, int32_t rlen, const char* alt, vc_allele_t& a);
+
     /**
      * Checks if the REF sequence of a VCF entry is consistent.
      *
@@ -0,0 +1,374 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "vcf_text_pool.h"
+
+int32_t VCFTextPool::no_threads = 1;
+
+/**
+ * Removes the --vcf-threads option from argv and returns the new argc.
+ */
+int32_t VCFTextPool::parse_args(int32_t argc, char** argv)
+{
+    int32_t j = 1;
+    for (int32_t i=1; i<argc; ++i)
+    {
+        if (!strcmp(argv[i], "--vcf-threads") && i+1<argc)
+        {
+            no_threads = atoi(argv[++i]);
+        }
+        else
+        {
+            argv[j++] = argv[i];
+        }
+    }
+    argv[j] = NULL;
+
+    return j;
+}
+
+/**
+ * Returns true if the BGZF streams of files are to be (de)compressed with threads.
+ */
+bool VCFTextPool::threaded()
+{
+    return no_threads>1;
+}
+
+/**
+ * Creates a pool that parses lines into records unpacked up to max_unpack
+ * if parse is true, otherwise a pool that formats records into lines.
+ * Returns NULL if threading is not enabled or if the header cannot be
+ * copied with the same contig and tag IDs.
+ */
+VCFTextPool* VCFTextPool::create(bcf_hdr_t* h, bool parse, int32_t max_unpack)
+{
+    if (!threaded()) return NULL;
+
+    bcf_hdr_t* copy = copy_hdr(h);
+    if (!copy) return NULL;
+
+    return new VCFTextPool(copy, parse, max_unpack, no_threads);
+}
+
+/**
+ * Starts no_workers threads over a copy of the header.
+ */
+VCFTextPool::VCFTextPool(bcf_hdr_t* hdr, bool parse, int32_t max_unpack, int32_t no_workers)
+{
+    this->hdr = hdr;
+    this->parse = parse;
+    this->max_unpack = max_unpack;
+    hdr_generation = 0;
+    batch_size = 1000;
+    batch_bytes = 1<<22;
+    depth = 2*no_workers;
+    closed = false;
+
+    for (int32_t i=0; i<no_workers; ++i)
+    {
+        workers.push_back(std::thread(&VCFTextPool::run, this));
+    }
+}
+
+/**
+ * Joins the workers and frees the batches.
+ */
+VCFTextPool::~VCFTextPool()
+{
+    {
+        std::unique_lock<std::mutex> l(lock);
+        closed = true;
+        job_ready.notify_all();
+    }
+
+    for (size_t i=0; i<workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+
+    recycled.insert(recycled.end(), batches.begin(), batches.end());
+    for (size_t i=0; i<recycled.size(); ++i)
+    {
+        VCFTextBatch* b = recycled[i];
+        for (int32_t j=0; j<batch_size; ++j)
+        {
+            if (b->lines[j].m) free(b->lines[j].s);
+            bcf_destroy(b->records[j]);
+        }
+        delete b;
+    }
+
+    bcf_hdr_destroy(hdr);
+}
+
+/**
+ * Gets an empty batch.
+ */
+VCFTextBatch* VCFTextPool::get_batch()
+{
+    VCFTextBatch* b = NULL;
+    {
+        std::unique_lock<std::mutex> l(lock);
+        if (!recycled.empty())
+        {
+            b = recycled.back();
+            recycled.pop_back();
+        }
+    }
+
+    if (!b)
+    {
+        b = new VCFTextBatch();
+        b->lines.resize(batch_size);
+        b->records.resize(batch_size);
+        b->failed.resize(batch_size, 0);
+        for (int32_t i=0; i<batch_size; ++i)
+        {
+            b->lines[i] = {0, 0, 0};
+            b->records[i] = bcf_init();
+        }
+    }
+
+    b->n = 0;
+    b->done = false;
+    return b;
+}
+
+/**
+ * Queues a batch for the workers.
+ */
+void VCFTextPool::submit(VCFTextBatch* b)
+{
+    std::unique_lock<std::mutex> l(lock);
+    batches.push_back(b);
+    jobs.push_back(b);
+    job_ready.notify_one();
+}
+
+/**
+ * Returns true if enough batches are queued to keep the workers busy.
+ */
+bool VCFTextPool::full()
+{
+    std::unique_lock<std::mutex> l(lock);
+    return (int32_t)batches.size()>=depth;
+}
+
+/**
+ * Returns the oldest submitted batch, blocking until it is processed.
+ * Returns NULL if there are no submitted batches.
+ */
+VCFTextBatch* VCFTextPool::next()
+{
+    std::unique_lock<std::mutex> l(lock);
+
+    if (batches.empty()) return NULL;
+
+    while (!batches.front()->done)
+    {
+        batch_done.wait(l);
+    }
+
+    VCFTextBatch* b = batches.front();
+    batches.pop_front();
+    return b;
+}
+
+/**
+ * Returns a batch to the pool.
+ */
+void VCFTextPool::recycle(VCFTextBatch* b)
+{
+    std::unique_lock<std::mutex> l(lock);
+    recycled.push_back(b);
+}
+
+/**
+ * Hands over the updated header of the caller, the parsing workers
+ * pick up the contigs and tags defined since.
+ */
+void VCFTextPool::update_hdr(bcf_hdr_t* h)
+{
+    bcf_hdr_t* copy = copy_hdr(h);
+    if (!copy) return;
+
+    std::unique_lock<std::mutex> l(lock);
+    bcf_hdr_destroy(hdr);
+    hdr = copy;
+    ++hdr_generation;
+}
+
+/**
+ * Copies a header with the same contig and tag IDs and the same sample subset.
+ * Returns NULL if the IDs differ.
+ */
+bcf_hdr_t* VCFTextPool::copy_hdr(bcf_hdr_t* h)
+{
+    bcf_hdr_t* copy = bcf_hdr_dup(h);
+    if (!copy) return NULL;
+
+    bool same = bcf_hdr_nsamples(copy)==bcf_hdr_nsamples(h);
+    int32_t types[2] = {BCF_DT_ID, BCF_DT_CTG};
+    for (int32_t t=0; same && t<2; ++t)
+    {
+        int32_t type = types[t];
+        same = copy->n[type]==h->n[type];
+        for (int32_t i=0; same && i<h->n[type]; ++i)
+        {
+            const char* a = h->id[type][i].key;
+            const char* b = copy->id[type][i].key;
+            same = (!a && !b) || (a && b && !strcmp(a, b));
+        }
+    }
+
+    if (!same)
+    {
+        bcf_hdr_destroy(copy);
+        return NULL;
+    }
+
+    //the records of a header with a sample subset still have all the sample columns
+    if (h->keep_samples)
+    {
+        int32_t size = h->nsamples_ori/8+1;
+        copy->nsamples_ori = h->nsamples_ori;
+        copy->keep_samples = (uint8_t*) malloc(size);
+        memcpy(copy->keep_samples, h->keep_samples, size);
+    }
+
+    return copy;
+}
+
+/**
+ * Returns true if a record only refers to contigs and tags in h.
+ */
+bool VCFTextPool::defined_in(bcf_hdr_t* h, bcf1_t* v)
+{
+    bcf_unpack(v, BCF_UN_ALL);
+
+    if (v->rid<0 || v->rid>=h->n[BCF_DT_CTG] || v->n_sample!=bcf_hdr_nsamples(h))
+    {
+        return false;
+    }
+
+    int32_t n = h->n[BCF_DT_ID];
+    for (int32_t i=0; i<v->d.n_flt; ++i)
+    {
+        int32_t id = v->d.flt[i];
+        if (id<0 || id>=n || !h->id[BCF_DT_ID][id].key) return false;
+    }
+    for (int32_t i=0; i<v->n_info; ++i)
+    {
+        int32_t id = v->d.info[i].key;
+        if (id<0 || id>=n || !h->id[BCF_DT_ID][id].key) return false;
+    }
+    for (int32_t i=0; i<v->n_fmt; ++i)
+    {
+        int32_t id = v->d.fmt[i].id;
+        if (id<0 || id>=n || !h->id[BCF_DT_ID][id].key) return false;
+    }
+
+    return true;
+}
+
+/**
+ * Worker thread loop.
+ */
+void VCFTextPool::run()
+{
+    //parsing workers own a copy of the header as htslib adds undefined contigs and tags to it
+    bcf_hdr_t* h = NULL;
+    int32_t generation = -1;
+    //vcf_parse splits the line in place, the line is kept intact for the caller
+    kstring_t line = {0,0,0};
+
+    while (true)
+    {
+        VCFTextBatch* b;
+        {
+            std::unique_lock<std::mutex> l(lock);
+            while (jobs.empty() && !closed)
+            {
+                job_ready.wait(l);
+            }
+
+            if (jobs.empty()) break;
+
+            b = jobs.front();
+            jobs.pop_front();
+
+            if (parse && generation!=hdr_generation)
+            {
+                if (h) bcf_hdr_destroy(h);
+                h = copy_hdr(hdr);
+                generation = hdr_generation;
+            }
+        }
+
+        for (int32_t i=0; i<b->n; ++i)
+        {
+            bcf1_t* v = b->records[i];
+            b->failed[i] = 0;
+
+            if (parse)
+            {
+                if (!h)
+                {
+                    b->failed[i] = 1;
+                    continue;
+                }
+
+                int32_t no_ids = h->n[BCF_DT_ID];
+                int32_t no_contigs = h->n[BCF_DT_CTG];
+                v->max_unpack = max_unpack;
+                line.l = 0;
+                kputsn(b->lines[i].s, b->lines[i].l, &line);
+                bool parsed = vcf_parse(&line, h, v)==0 && !v->errcode;
+
+                if (h->n[BCF_DT_ID]!=no_ids || h->n[BCF_DT_CTG]!=no_contigs)
+                {
+                    //the definitions added to the copy may not have the IDs the caller gives them
+                    std::unique_lock<std::mutex> l(lock);
+                    bcf_hdr_destroy(h);
+                    h = copy_hdr(hdr);
+                    generation = hdr_generation;
+                    parsed = false;
+                }
+
+                b->failed[i] = !parsed;
+            }
+            else
+            {
+                b->lines[i].l = 0;
+                b->failed[i] = !defined_in(hdr, v) || vcf_format(hdr, v, &b->lines[i])<0;
+            }
+        }
+
+        std::unique_lock<std::mutex> l(lock);
+        b->done = true;
+        batch_done.notify_all();
+    }
+
+    if (h) bcf_hdr_destroy(h);
+    if (line.m) free(line.s);
+}
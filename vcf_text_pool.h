@@ -0,0 +1,183 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#ifndef VCF_TEXT_POOL_H
+#define VCF_TEXT_POOL_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "hts_utils.h"
+
+/**
+ * A batch of VCF lines and the corresponding records.
+ *
+ * A line that could not be handled by a worker is flagged as failed
+ * and is left to the caller, this happens for lines with contigs or
+ * tags that are not defined in the header and for broken records.
+ */
+typedef struct
+{
+    std::vector<kstring_t> lines;
+    std::vector<bcf1_t*> records;
+    std::vector<char> failed;
+    int32_t n;
+    bool done;
+} VCFTextBatch;
+
+/**
+ * A pool of threads that parses VCF lines into records or formats records
+ * into VCF lines in batches, the batches are returned in the order they
+ * were submitted.  This takes the text conversion of VCF files off the
+ * thread of the tool in BCFOrderedReader and BCFOrderedWriter.
+ *
+ * The workers use copies of the header so that the header of the caller
+ * is never read or modified by them.  A parsing worker that meets an
+ * undefined contig or tag flags the line, the caller parses it again
+ * with its own header which is then updated by htslib, and hands the
+ * updated header to the pool with update_hdr.
+ *
+ * The pool is used when the global option --vcf-threads is more than 1,
+ * the BGZF streams of the files are then also (de)compressed with as
+ * many threads.
+ *
+ *  while (!pool->full() && more lines)
+ *  {
+ *      VCFTextBatch* b = pool->get_batch();
+ *      ... read up to pool->batch_size lines or pool->batch_bytes into b->lines, set b->n
+ *      pool->submit(b);
+ *  }
+ *  b = pool->next();
+ *  ... use b->records[0..b->n)
+ *  pool->recycle(b);
+ */
+class VCFTextPool
+{
+    public:
+
+    //no. of threads for text VCF and BGZF, set with the global option --vcf-threads
+    static int32_t no_threads;
+
+    //a batch is filled up to batch_size lines or about batch_bytes of text
+    int32_t batch_size;
+    size_t batch_bytes;
+
+    /**
+     * Removes the --vcf-threads option from argv and returns the new argc.
+     */
+    static int32_t parse_args(int32_t argc, char** argv);
+
+    /**
+     * Returns true if the BGZF streams of files are to be (de)compressed with threads.
+     */
+    static bool threaded();
+
+    /**
+     * Creates a pool that parses lines into records unpacked up to max_unpack
+     * if parse is true, otherwise a pool that formats records into lines.
+     * Returns NULL if threading is not enabled or if the header cannot be
+     * copied with the same contig and tag IDs.
+     */
+    static VCFTextPool* create(bcf_hdr_t* h, bool parse, int32_t max_unpack=0);
+
+    /**
+     * Joins the workers and frees the batches.
+     */
+    ~VCFTextPool();
+
+    /**
+     * Gets an empty batch.
+     */
+    VCFTextBatch* get_batch();
+
+    /**
+     * Queues a batch for the workers.
+     */
+    void submit(VCFTextBatch* b);
+
+    /**
+     * Returns true if enough batches are queued to keep the workers busy.
+     */
+    bool full();
+
+    /**
+     * Returns the oldest submitted batch, blocking until it is processed.
+     * Returns NULL if there are no submitted batches.
+     */
+    VCFTextBatch* next();
+
+    /**
+     * Returns a batch to the pool.
+     */
+    void recycle(VCFTextBatch* b);
+
+    /**
+     * Hands over the updated header of the caller, the parsing workers
+     * pick up the contigs and tags defined since.
+     */
+    void update_hdr(bcf_hdr_t* h);
+
+    private:
+
+    bool parse;
+    int32_t max_unpack;
+    int32_t depth;
+    bool closed;
+
+    //copy of the header of the caller, copied by the parsing workers under lock and read by the formatting workers
+    bcf_hdr_t* hdr;
+    int32_t hdr_generation;
+
+    std::deque<VCFTextBatch*> batches;
+    std::deque<VCFTextBatch*> jobs;
+    std::vector<VCFTextBatch*> recycled;
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable job_ready;
+    std::condition_variable batch_done;
+
+    /**
+     * Starts no_workers threads over a copy of the header.
+     */
+    VCFTextPool(bcf_hdr_t* hdr, bool parse, int32_t max_unpack, int32_t no_workers);
+
+    /**
+     * Copies a header with the same contig and tag IDs and the same sample subset.
+     * Returns NULL if the IDs differ.
+     */
+    static bcf_hdr_t* copy_hdr(bcf_hdr_t* h);
+
+    /**
+     * Returns true if a record only refers to contigs and tags in h.
+     */
+    static bool defined_in(bcf_hdr_t* h, bcf1_t* v);
+
+    /**
+     * Worker thread loop.
+     */
+    void run();
+};
+
+#endif
@@ -30,16 +30,10 @@ VNTRAnnotator::VNTRAnnotator(std::string& ref_fasta_file, bool debug)
 {
     vm = new VariantManip(ref_fasta_file.c_str());
 
-    fai = fai_load(ref_fasta_file.c_str());
-    if (fai==NULL)
-    {
-        fprintf(stderr, "[%s:%d %s] Cannot load genome index: %s\n", __FILE__, __LINE__, __FUNCTION__, ref_fasta_file.c_str());
-        exit(1);
-    }
-
     cre = new CandidateRegionExtractor(ref_fasta_file, debug);
     cmp = new CandidateMotifPicker(debug);
     fd = new FlankDetector(ref_fasta_file, debug);
+    cache = NULL;
 
     this->debug = debug;
 };
@@ -50,7 +44,6 @@ VNTRAnnotator::VNTRAnnotator(std::string& ref_fasta_file, bool debug)
 VNTRAnnotator::~VNTRAnnotator()
 {
     delete vm;
-    fai_destroy(fai);
 }
 
 /**
@@ -61,7 +54,7 @@ VNTRAnnotator::~VNTRAnnotator()
  */
 void VNTRAnnotator::annotate(Variant& variant, int32_t amode)
 {
-    VNTR& vntr = variant.vntr;
+    VNTR& vntr = variant.get_vntr();
 
     bcf_hdr_t* h = variant.h;
     bcf1_t* v = variant.v;
@@ -115,7 +108,7 @@ void VNTRAnnotator::annotate(Variant& variant, int32_t amode)
         if (!cmp->next_motif(variant, CHECK_MOTIF_PRESENCE_IN_ALLELE))
         {
             //fall back on exact motif chosen.
-            VNTR& vntr = variant.vntr;
+            VNTR& vntr = variant.get_vntr();
             vntr.fuzzy_motif = vntr.exact_motif;
             vntr.fuzzy_ru = vntr.exact_ru;
             vntr.fuzzy_basis = vntr.exact_basis;
@@ -125,13 +118,27 @@ void VNTRAnnotator::annotate(Variant& variant, int32_t amode)
             if (debug) std::cerr << "updating fuzzy motif with exact motifs\n";
         }
 
-        fd->detect_flanks(variant, EXACT);
-        fd->compute_purity_score(variant, EXACT);
-        fd->compute_composition_and_entropy(variant, EXACT);
+        //3. detect repeat region, indels in the same reference VNTR
+        //   share the region and motifs and reuse earlier results
+        std::string key;
+        if (cache) VNTRCache::make_key(variant, key);
 
-        fd->detect_flanks(variant, FUZZY);
-        fd->compute_purity_score(variant, FUZZY);
-        fd->compute_composition_and_entropy(variant, FUZZY);
+        if (cache && cache->lookup(variant, key))
+        {
+            if (debug) std::cerr << "repeat tract found in cache : " << key << "\n";
+        }
+        else
+        {
+            fd->detect_flanks(variant, EXACT);
+            fd->compute_purity_score(variant, EXACT);
+            fd->compute_composition_and_entropy(variant, EXACT);
+
+            fd->detect_flanks(variant, FUZZY);
+            fd->compute_purity_score(variant, FUZZY);
+            fd->compute_composition_and_entropy(variant, FUZZY);
+
+            if (cache) cache->insert(variant, key);
+        }
 
         //introduce reiteration based on concordance and exact concordance.
 
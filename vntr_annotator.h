@@ -27,6 +27,7 @@
 #include "candidate_region_extractor.h"
 #include "candidate_motif_picker.h"
 #include "flank_detector.h"
+#include "vntr_cache.h"
 
 /**
  * Class for determining basic traits of an indel
@@ -52,11 +53,13 @@ class VNTRAnnotator
     //tools
     ///////
     VariantManip *vm;
-    faidx_t* fai;
     CandidateRegionExtractor* cre;
     CandidateMotifPicker* cmp;
     FlankDetector* fd;
 
+    //optional cache of repeat tract annotations, not owned and may be shared between annotators
+    VNTRCache* cache;
+
     //for retrieving sequences
     int8_t* seq;
 
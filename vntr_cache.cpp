@@ -0,0 +1,388 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#include "vntr_cache.h"
+
+/**
+ * Constructor.
+ */
+VNTRCache::VNTRCache(uint32_t capacity)
+{
+    this->capacity = capacity;
+    no_hits = 0;
+    no_misses = 0;
+};
+
+/**
+ * Destructor.
+ */
+VNTRCache::~VNTRCache()
+{
+};
+
+/**
+ * Computes the cache key of a variant whose candidate region and motifs have been chosen.
+ */
+void VNTRCache::make_key(Variant& variant, std::string& key)
+{
+    VNTR& vntr = variant.get_vntr();
+
+    kstring_t s = {0,0,0};
+    ksprintf(&s, "%s:%d-%d:%s:%s:%s:%s:%d",
+             variant.chrom.c_str(), vntr.exact_beg1, vntr.exact_end1,
+             vntr.exact_motif.c_str(), vntr.exact_ru.c_str(),
+             vntr.fuzzy_motif.c_str(), vntr.motif.c_str(), vntr.mlen);
+    key.assign(s.s, s.l);
+    if (s.m) free(s.s);
+}
+
+/**
+ * Updates the exact and fuzzy characteristics of variant.vntr if
+ * key has been seen before.
+ * Returns true if found.
+ */
+bool VNTRCache::lookup(Variant& variant, std::string& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::map<std::string, std::list<VNTRCacheEntry>::iterator>::iterator i = index.find(key);
+    if (i==index.end())
+    {
+        ++no_misses;
+        return false;
+    }
+
+    ++no_hits;
+
+    //move to front as the most recently used
+    entries.splice(entries.begin(), entries, i->second);
+    VNTRCacheEntry& e = *i->second;
+    VNTR& vntr = variant.get_vntr();
+
+    vntr.exact_beg1 = e.exact_beg1;
+    vntr.exact_end1 = e.exact_end1;
+    vntr.exact_repeat_tract = e.exact_repeat_tract;
+    vntr.exact_ru = e.exact_ru;
+    for (int32_t j=0; j<4; ++j) vntr.exact_comp[j] = e.exact_comp[j];
+    vntr.exact_entropy = e.exact_entropy;
+    vntr.exact_entropy2 = e.exact_entropy2;
+    vntr.exact_kl_divergence = e.exact_kl_divergence;
+    vntr.exact_kl_divergence2 = e.exact_kl_divergence2;
+    vntr.exact_ref = e.exact_ref;
+    vntr.exact_rl = e.exact_rl;
+    vntr.exact_ll = e.exact_rl + variant.max_dlen;
+    vntr.exact_no_perfect_ru = e.exact_no_perfect_ru;
+    vntr.exact_no_ru = e.exact_no_ru;
+    vntr.exact_score = e.exact_score;
+    vntr.exact_trf_score = e.exact_trf_score;
+
+    vntr.fuzzy_beg1 = e.fuzzy_beg1;
+    vntr.fuzzy_end1 = e.fuzzy_end1;
+    vntr.fuzzy_repeat_tract = e.fuzzy_repeat_tract;
+    vntr.fuzzy_ru = e.fuzzy_ru;
+    for (int32_t j=0; j<4; ++j) vntr.fuzzy_comp[j] = e.fuzzy_comp[j];
+    vntr.fuzzy_entropy = e.fuzzy_entropy;
+    vntr.fuzzy_entropy2 = e.fuzzy_entropy2;
+    vntr.fuzzy_kl_divergence = e.fuzzy_kl_divergence;
+    vntr.fuzzy_kl_divergence2 = e.fuzzy_kl_divergence2;
+    vntr.fuzzy_ref = e.fuzzy_ref;
+    vntr.fuzzy_rl = e.fuzzy_rl;
+    vntr.fuzzy_ll = e.fuzzy_rl + variant.max_dlen;
+    vntr.fuzzy_no_perfect_ru = e.fuzzy_no_perfect_ru;
+    vntr.fuzzy_no_ru = e.fuzzy_no_ru;
+    vntr.fuzzy_score = e.fuzzy_score;
+    vntr.fuzzy_trf_score = e.fuzzy_trf_score;
+
+    if (e.is_large_repeat_tract) vntr.is_large_repeat_tract = true;
+
+    return true;
+}
+
+/**
+ * Inserts the exact and fuzzy characteristics of variant.vntr under key.
+ */
+void VNTRCache::insert(Variant& variant, std::string& key)
+{
+    if (!capacity) return;
+
+    VNTR& vntr = variant.get_vntr();
+    VNTRCacheEntry e;
+
+    e.key = key;
+
+    e.exact_beg1 = vntr.exact_beg1;
+    e.exact_end1 = vntr.exact_end1;
+    e.exact_repeat_tract = vntr.exact_repeat_tract;
+    e.exact_ru = vntr.exact_ru;
+    for (int32_t j=0; j<4; ++j) e.exact_comp[j] = vntr.exact_comp[j];
+    e.exact_entropy = vntr.exact_entropy;
+    e.exact_entropy2 = vntr.exact_entropy2;
+    e.exact_kl_divergence = vntr.exact_kl_divergence;
+    e.exact_kl_divergence2 = vntr.exact_kl_divergence2;
+    e.exact_ref = vntr.exact_ref;
+    e.exact_rl = vntr.exact_rl;
+    e.exact_no_perfect_ru = vntr.exact_no_perfect_ru;
+    e.exact_no_ru = vntr.exact_no_ru;
+    e.exact_score = vntr.exact_score;
+    e.exact_trf_score = vntr.exact_trf_score;
+
+    e.fuzzy_beg1 = vntr.fuzzy_beg1;
+    e.fuzzy_end1 = vntr.fuzzy_end1;
+    e.fuzzy_repeat_tract = vntr.fuzzy_repeat_tract;
+    e.fuzzy_ru = vntr.fuzzy_ru;
+    for (int32_t j=0; j<4; ++j) e.fuzzy_comp[j] = vntr.fuzzy_comp[j];
+    e.fuzzy_entropy = vntr.fuzzy_entropy;
+    e.fuzzy_entropy2 = vntr.fuzzy_entropy2;
+    e.fuzzy_kl_divergence = vntr.fuzzy_kl_divergence;
+    e.fuzzy_kl_divergence2 = vntr.fuzzy_kl_divergence2;
+    e.fuzzy_ref = vntr.fuzzy_ref;
+    e.fuzzy_rl = vntr.fuzzy_rl;
+    e.fuzzy_no_perfect_ru = vntr.fuzzy_no_perfect_ru;
+    e.fuzzy_no_ru = vntr.fuzzy_no_ru;
+    e.fuzzy_score = vntr.fuzzy_score;
+    e.fuzzy_trf_score = vntr.fuzzy_trf_score;
+
+    e.is_large_repeat_tract = vntr.is_large_repeat_tract;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    add(e);
+}
+
+/**
+ * Adds an entry as the most recently used, evicting as required.
+ * Assumes the lock is held.
+ */
+void VNTRCache::add(VNTRCacheEntry& entry)
+{
+    std::map<std::string, std::list<VNTRCacheEntry>::iterator>::iterator i = index.find(entry.key);
+    if (i!=index.end())
+    {
+        //another thread got here first, the entries are identical
+        entries.splice(entries.begin(), entries, i->second);
+        return;
+    }
+
+    entries.push_front(entry);
+    index[entry.key] = entries.begin();
+
+    while (entries.size()>capacity)
+    {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+/**
+ * Returns the identity of a reference, the number of its sequences and
+ * a hash of their names and lengths in the reference index.
+ */
+std::string VNTRCache::reference_id(std::string& ref_fasta_file)
+{
+    ReferenceSequence* rs = new ReferenceSequence(ref_fasta_file);
+
+    //64 bit FNV-1a over name\0length\0 of each sequence
+    uint64_t h = 14695981039346656037ULL;
+    int32_t nseq = rs->fetch_nseq();
+    kstring_t s = {0,0,0};
+    for (int32_t i=0; i<nseq; ++i)
+    {
+        std::string name = rs->fetch_iseq_name(i);
+        s.l = 0;
+        ksprintf(&s, "%s%c%d%c", name.c_str(), 0, rs->fetch_seq_len(name), 0);
+        for (size_t j=0; j<s.l; ++j)
+        {
+            h ^= (uint8_t) s.s[j];
+            h *= 1099511628211ULL;
+        }
+    }
+    delete rs;
+
+    s.l = 0;
+    ksprintf(&s, "%d:%016llx", nseq, (unsigned long long) h);
+    std::string id(s.s);
+    if (s.m) free(s.s);
+
+    return id;
+}
+
+/**
+ * Loads entries computed against ref_fasta_file from a file, a missing
+ * file is not an error.  A file of another version or reference is
+ * ignored, a file that is not a VNTR cache is an error.
+ * Returns the number of entries loaded.
+ */
+int32_t VNTRCache::load(std::string& file, std::string& ref_fasta_file)
+{
+    htsFile *hts = hts_open(file.c_str(), "r");
+    if (hts==NULL)
+    {
+        return 0;
+    }
+
+    int32_t no_entries = 0;
+    kstring_t s = {0,0,0};
+    int32_t *fields = NULL;
+    int32_t no_fields = 0;
+
+    //magic, version, reference
+    if (hts_getline(hts, '\n', &s)<0)
+    {
+        if (s.m) free(s.s);
+        hts_close(hts);
+        return 0;
+    }
+    fields = ksplit(&s, '\t', &no_fields);
+    if (no_fields!=3 || strcmp(s.s+fields[0], VNTR_CACHE_MAGIC))
+    {
+        fprintf(stderr, "[%s:%d %s] Not a VNTR cache file: %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str());
+        exit(1);
+    }
+    if (atoi(s.s+fields[1])!=VNTR_CACHE_VERSION)
+    {
+        fprintf(stderr, "[%s:%d %s] Ignoring VNTR cache file %s of version %s, version %d is supported\n", __FILE__, __LINE__, __FUNCTION__, file.c_str(), s.s+fields[1], VNTR_CACHE_VERSION);
+        free(fields);
+        if (s.m) free(s.s);
+        hts_close(hts);
+        return 0;
+    }
+    std::string ref_id = reference_id(ref_fasta_file);
+    if (strcmp(s.s+fields[2], ref_id.c_str()))
+    {
+        fprintf(stderr, "[%s:%d %s] Ignoring VNTR cache file %s computed against another reference: %s, expected %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str(), s.s+fields[2], ref_id.c_str());
+        free(fields);
+        if (s.m) free(s.s);
+        hts_close(hts);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    while (hts_getline(hts, '\n', &s)>=0)
+    {
+        if (s.l==0 || s.s[0]=='#')
+            continue;
+
+        free(fields);
+        fields = ksplit(&s, '\t', &no_fields);
+        if (no_fields!=38)
+        {
+            fprintf(stderr, "[%s:%d %s] Skipping malformed VNTR cache entry in %s: %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str(), s.s);
+            continue;
+        }
+
+        char* vec[38];
+        for (int32_t j=0; j<no_fields; ++j) vec[j] = s.s + fields[j];
+
+        VNTRCacheEntry e;
+        int32_t k = 0;
+        e.key = vec[k++];
+
+        e.exact_beg1 = atoi(vec[k++]);
+        e.exact_end1 = atoi(vec[k++]);
+        e.exact_repeat_tract = vec[k++];
+        e.exact_ru = vec[k++];
+        for (int32_t j=0; j<4; ++j) e.exact_comp[j] = atoi(vec[k++]);
+        e.exact_entropy = strtof(vec[k++], NULL);
+        e.exact_entropy2 = strtof(vec[k++], NULL);
+        e.exact_kl_divergence = strtof(vec[k++], NULL);
+        e.exact_kl_divergence2 = strtof(vec[k++], NULL);
+        e.exact_ref = strtof(vec[k++], NULL);
+        e.exact_rl = atoi(vec[k++]);
+        e.exact_no_perfect_ru = atoi(vec[k++]);
+        e.exact_no_ru = atoi(vec[k++]);
+        e.exact_score = strtof(vec[k++], NULL);
+        e.exact_trf_score = atoi(vec[k++]);
+
+        e.fuzzy_beg1 = atoi(vec[k++]);
+        e.fuzzy_end1 = atoi(vec[k++]);
+        e.fuzzy_repeat_tract = vec[k++];
+        e.fuzzy_ru = vec[k++];
+        for (int32_t j=0; j<4; ++j) e.fuzzy_comp[j] = atoi(vec[k++]);
+        e.fuzzy_entropy = strtof(vec[k++], NULL);
+        e.fuzzy_entropy2 = strtof(vec[k++], NULL);
+        e.fuzzy_kl_divergence = strtof(vec[k++], NULL);
+        e.fuzzy_kl_divergence2 = strtof(vec[k++], NULL);
+        e.fuzzy_ref = strtof(vec[k++], NULL);
+        e.fuzzy_rl = atoi(vec[k++]);
+        e.fuzzy_no_perfect_ru = atoi(vec[k++]);
+        e.fuzzy_no_ru = atoi(vec[k++]);
+        e.fuzzy_score = strtof(vec[k++], NULL);
+        e.fuzzy_trf_score = atoi(vec[k++]);
+
+        e.is_large_repeat_tract = vec[k++][0]=='1';
+
+        add(e);
+        ++no_entries;
+    }
+
+    free(fields);
+    if (s.m) free(s.s);
+    hts_close(hts);
+
+    return no_entries;
+}
+
+/**
+ * Saves entries computed against ref_fasta_file to a file, least
+ * recently used entries first.
+ */
+void VNTRCache::save(std::string& file, std::string& ref_fasta_file)
+{
+    std::string ref_id = reference_id(ref_fasta_file);
+
+    FILE* out = fopen(file.c_str(), "w");
+    if (out==NULL)
+    {
+        fprintf(stderr, "[%s:%d %s] Cannot write VNTR cache file: %s\n", __FILE__, __LINE__, __FUNCTION__, file.c_str());
+        exit(1);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fprintf(out, "%s\t%d\t%s\n", VNTR_CACHE_MAGIC, VNTR_CACHE_VERSION, ref_id.c_str());
+    fprintf(out, "#key\texact\tfuzzy\tlarge\n");
+    for (std::list<VNTRCacheEntry>::reverse_iterator i=entries.rbegin(); i!=entries.rend(); ++i)
+    {
+        VNTRCacheEntry& e = *i;
+        fprintf(out, "%s", e.key.c_str());
+        fprintf(out, "\t%d\t%d\t%s\t%s\t%d\t%d\t%d\t%d\t%.9g\t%.9g\t%.9g\t%.9g\t%.9g\t%d\t%d\t%d\t%.9g\t%d",
+                e.exact_beg1, e.exact_end1, e.exact_repeat_tract.c_str(), e.exact_ru.c_str(),
+                e.exact_comp[0], e.exact_comp[1], e.exact_comp[2], e.exact_comp[3],
+                e.exact_entropy, e.exact_entropy2, e.exact_kl_divergence, e.exact_kl_divergence2,
+                e.exact_ref, e.exact_rl, e.exact_no_perfect_ru, e.exact_no_ru, e.exact_score, e.exact_trf_score);
+        fprintf(out, "\t%d\t%d\t%s\t%s\t%d\t%d\t%d\t%d\t%.9g\t%.9g\t%.9g\t%.9g\t%.9g\t%d\t%d\t%d\t%.9g\t%d",
+                e.fuzzy_beg1, e.fuzzy_end1, e.fuzzy_repeat_tract.c_str(), e.fuzzy_ru.c_str(),
+                e.fuzzy_comp[0], e.fuzzy_comp[1], e.fuzzy_comp[2], e.fuzzy_comp[3],
+                e.fuzzy_entropy, e.fuzzy_entropy2, e.fuzzy_kl_divergence, e.fuzzy_kl_divergence2,
+                e.fuzzy_ref, e.fuzzy_rl, e.fuzzy_no_perfect_ru, e.fuzzy_no_ru, e.fuzzy_score, e.fuzzy_trf_score);
+        fprintf(out, "\t%d\n", e.is_large_repeat_tract ? 1 : 0);
+    }
+
+    fclose(out);
+}
+
+/**
+ * Number of entries in the cache.
+ */
+uint32_t VNTRCache::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
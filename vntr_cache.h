@@ -0,0 +1,175 @@
+/* The MIT License
+
+   Copyright (c) 2018 Adrian Tan <atks@umich.edu>
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to deal
+   in the Software without restriction, including without limitation the rights
+   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+   copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+   THE SOFTWARE.
+*/
+#ifndef VNTR_CACHE_H
+#define VNTR_CACHE_H
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include "hts_utils.h"
+#include "reference_sequence.h"
+#include "variant.h"
+
+#define VNTR_CACHE_MAGIC "#VTVNTRCACHE"
+#define VNTR_CACHE_VERSION 1
+
+/**
+ * Exact and fuzzy repeat tract characteristics computed for a
+ * reference repeat region and motif.
+ */
+class VNTRCacheEntry
+{
+    public:
+
+    std::string key;
+
+    int32_t exact_beg1;
+    int32_t exact_end1;
+    std::string exact_repeat_tract;
+    std::string exact_ru;
+    int32_t exact_comp[4];
+    float exact_entropy;
+    float exact_entropy2;
+    float exact_kl_divergence;
+    float exact_kl_divergence2;
+    float exact_ref;
+    int32_t exact_rl;
+    int32_t exact_no_perfect_ru;
+    int32_t exact_no_ru;
+    float exact_score;
+    int32_t exact_trf_score;
+
+    int32_t fuzzy_beg1;
+    int32_t fuzzy_end1;
+    std::string fuzzy_repeat_tract;
+    std::string fuzzy_ru;
+    int32_t fuzzy_comp[4];
+    float fuzzy_entropy;
+    float fuzzy_entropy2;
+    float fuzzy_kl_divergence;
+    float fuzzy_kl_divergence2;
+    float fuzzy_ref;
+    int32_t fuzzy_rl;
+    int32_t fuzzy_no_perfect_ru;
+    int32_t fuzzy_no_ru;
+    float fuzzy_score;
+    int32_t fuzzy_trf_score;
+
+    bool is_large_repeat_tract;
+};
+
+/**
+ * Bounded LRU cache of repeat tract annotations.
+ *
+ * Indels that fall in the same reference VNTR share the candidate region
+ * and motifs, the flank detection, purity and entropy computations that
+ * follow depend only on these and are looked up here instead of being
+ * recomputed.  The key is (chrom, candidate region, exact motif, exact
+ * repeat unit, fuzzy motif), the allele dependent longest tract lengths
+ * are recomputed on a hit.
+ *
+ * The cache may be shared between threads and can be saved to and loaded
+ * from a text file so that repeated annotation of a growing call set
+ * reuses the earlier work.  The file starts with a line holding the magic
+ * string, the format version and the identity of the reference the
+ * entries were computed against.
+ */
+class VNTRCache
+{
+    public:
+
+    uint32_t capacity;
+    uint32_t no_hits;
+    uint32_t no_misses;
+
+    /**
+     * Constructor.
+     *
+     * @capacity - maximum number of entries held, least recently used entries are evicted first.
+     */
+    VNTRCache(uint32_t capacity=100000);
+
+    /**
+     * Destructor.
+     */
+    ~VNTRCache();
+
+    /**
+     * Updates the exact and fuzzy characteristics of variant.vntr if
+     * key has been seen before.
+     * Returns true if found.
+     */
+    bool lookup(Variant& variant, std::string& key);
+
+    /**
+     * Inserts the exact and fuzzy characteristics of variant.vntr under
+     * key, which is computed by make_key before flank detection moves the
+     * repeat tract boundaries.
+     */
+    void insert(Variant& variant, std::string& key);
+
+    /**
+     * Computes the cache key of a variant whose candidate region and motifs have been chosen.
+     */
+    static void make_key(Variant& variant, std::string& key);
+
+    /**
+     * Loads entries computed against ref_fasta_file from a file, a missing
+     * file is not an error.  A file of another version or reference is
+     * ignored, a file that is not a VNTR cache is an error.
+     * Returns the number of entries loaded.
+     */
+    int32_t load(std::string& file, std::string& ref_fasta_file);
+
+    /**
+     * Saves entries computed against ref_fasta_file to a file, least
+     * recently used entries first.
+     */
+    void save(std::string& file, std::string& ref_fasta_file);
+
+    /**
+     * Returns the identity of a reference, the number of its sequences and
+     * a hash of their names and lengths in the FASTA index.
+     */
+    static std::string reference_id(std::string& ref_fasta_file);
+
+    /**
+     * Number of entries in the cache.
+     */
+    uint32_t size();
+
+    private:
+
+    std::list<VNTRCacheEntry> entries;
+    std::map<std::string, std::list<VNTRCacheEntry>::iterator> index;
+    std::mutex mutex;
+
+    /**
+     * Adds an entry as the most recently used, evicting as required.
+     * Assumes the lock is held.
+     */
+    void add(VNTRCacheEntry& entry);
+};
+
+#endif
@@ -47,6 +47,14 @@ VNTRConsolidator::VNTRConsolidator(std::string& input_vcf_file, std::vector<Geno
     overlap_vntr = const_cast<char*>("overlap_vntr");
     overlap_vntr_id = bcf_hdr_id2int(odw->hdr, BCF_DT_ID, "overlap_vntr");
 
+    ru_id = bcf_hdr_get_info_id(odr->hdr, "RU", BCF_HT_STR);
+    basis_id = bcf_hdr_get_info_id(odr->hdr, "BASIS", BCF_HT_STR);
+    concordance_id = bcf_hdr_get_info_id(odr->hdr, "CONCORDANCE", BCF_HT_REAL);
+    repeat_tract_id = bcf_hdr_get_info_id(odr->hdr, "REPEAT_TRACT", BCF_HT_INT);
+    score_id = bcf_hdr_get_info_id(odw->hdr, "SCORE", BCF_HT_REAL);
+    associated_indel_id = bcf_hdr_get_info_id(odw->hdr, "ASSOCIATED_INDEL", BCF_HT_STR);
+    vntr_info_ids = new VNTRInfoIDs(odw->hdr);
+
     buffer_window_allowance = 5000;
 
     ////////////////////////
@@ -329,7 +337,7 @@ void VNTRConsolidator::detect_VNTR_overlapping_class(Variant* variant, bool& con
             std::cerr << "==================================\n";
         }
         
-        VNTR& vntr = variant->vntr;
+        VNTR& vntr = variant->get_vntr();
 
         std::map<std::string, int32_t> rus;
         std::map<std::string, int32_t> bases;
@@ -340,16 +348,20 @@ void VNTRConsolidator::detect_VNTR_overlapping_class(Variant* variant, bool& con
 
         std::map<std::string, int32_t> motifs;
 
+        std::string ru;
+        std::string basis;
+        int32_t repeat_tract[2];
+
         for (uint32_t i=0; i<variant->vntr_vs.size(); ++i)
         {
             bcf1_t* vntr_v = variant->vntr_vs[i];
             std::string cbasis = vntr.basis;
 
-            std::string ru = bcf_get_info_str(odr->hdr, vntr_v, "RU");;
+            bcf_get_info_str(vntr_v, ru_id, ru);
             ru = vntr.canonicalize(ru);
-            std::string basis = bcf_get_info_str(odr->hdr, vntr_v, "BASIS");;
-            float concordance = bcf_get_info_flt(odr->hdr, vntr_v, "CONCORDANCE");
-            std::vector<int32_t> repeat_tract = bcf_get_info_int_vec(odr->hdr, vntr_v, "REPEAT_TRACT");
+            bcf_get_info_str(vntr_v, basis_id, basis);
+            float concordance = bcf_get_info_flt(vntr_v, concordance_id);
+            bcf_get_info_int_vec(vntr_v, repeat_tract_id, repeat_tract, 2);
 
             basis = vntr.get_basis(ru);
 
@@ -397,34 +409,38 @@ void VNTRConsolidator::merge_consistent_ru_overlapping_VNTR(Variant* variant)
     }
 
     bcf_hdr_t *h = odw->hdr;
-    VNTR& vntr = variant->vntr;
+    VNTR& vntr = variant->get_vntr();
     int32_t merged_beg1 = vntr.beg1;
     int32_t merged_end1 = vntr.end1;
     std::map<std::string, int32_t> unique_indels;
     std::vector<std::string> splitted_indels;
     int32_t max_dlen = 0;
     
+    std::string ru;
+    std::string vntr_associated_indels;
+    int32_t vntr_repeat_tract[2];
+
     //merge the regions
     for (uint32_t i=0; i<variant->vntr_vs.size(); ++i)
     {
         bcf1_t* vntr_v = variant->vntr_vs[i];
-        std::vector<int32_t> repeat_tract = bcf_get_info_int_vec(odr->hdr, vntr_v, "REPEAT_TRACT");
+        bcf_get_info_int_vec(vntr_v, repeat_tract_id, vntr_repeat_tract, 2);
         
         if (debug)
         {
-            std::string ru = bcf_get_info_str(odr->hdr, vntr_v, "RU");;
+            bcf_get_info_str(vntr_v, ru_id, ru);
             ru = vntr.canonicalize(ru);
-            float score = bcf_get_info_flt(h, vntr_v, "SCORE");
-            std::cerr << (i+1) << ") " << ru << "\t" << score << "\t" << repeat_tract[0] << "," << repeat_tract[1] << "\t" << "\n";
+            float score = bcf_get_info_flt(vntr_v, score_id);
+            std::cerr << (i+1) << ") " << ru << "\t" << score << "\t" << vntr_repeat_tract[0] << "," << vntr_repeat_tract[1] << "\t" << "\n";
             std::cerr << "\t" << bcf_get_ref(vntr_v) << "\n";
             bcf_print(odw->hdr, vntr_v);
         }
 
-        merged_beg1 = std::min(merged_beg1, repeat_tract[0]);
-        merged_end1 = std::max(merged_end1, repeat_tract[1]);
+        merged_beg1 = std::min(merged_beg1, vntr_repeat_tract[0]);
+        merged_end1 = std::max(merged_end1, vntr_repeat_tract[1]);
 
-        std::string associated_indels = bcf_get_info_str(h, vntr_v, "ASSOCIATED_INDEL");
-        split(splitted_indels, ",", associated_indels);
+        bcf_get_info_str(vntr_v, associated_indel_id, vntr_associated_indels);
+        split(splitted_indels, ",", vntr_associated_indels);
 
         for (uint32_t j=0; j<splitted_indels.size(); ++j)
         {
@@ -513,7 +529,7 @@ void VNTRConsolidator::merge_consistent_basis_overlapping_VNTR(Variant* variant)
 //        std::cerr << "================================\n";
 //    }
 //
-//    VNTR& vntr = variant->vntr;
+//    VNTR& vntr = variant->get_vntr();
 //
 //    std::map<std::string, int32_t>::iterator it;
 //
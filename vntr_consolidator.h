@@ -89,6 +89,17 @@ class VNTRConsolidator
     int32_t overlap_indel_id;
     int32_t overlap_vntr_id;
 
+    ////////////////
+    //info field ids
+    ////////////////
+    int32_t ru_id;
+    int32_t basis_id;
+    int32_t concordance_id;
+    int32_t repeat_tract_id;
+    int32_t score_id;
+    int32_t associated_indel_id;
+    VNTRInfoIDs* vntr_info_ids;
+
     /////////
     //stats//
     /////////
@@ -99,6 +99,7 @@ VNTRExtractor::VNTRExtractor(std::string& input_vcf_file, std::vector<GenomeInte
     //tools initialization//
     ////////////////////////
     refseq = new ReferenceSequence(ref_fasta_file);
+    vntr_info_ids = new VNTRInfoIDs(odr->hdr);
 }
 
 /**
@@ -142,10 +143,10 @@ void VNTRExtractor::insert(Variant* var)
                     if (nvar.type==VT_VNTR && cvar.type==VT_VNTR)
                     {
                         //duplicate, do not print
-                        if (cvar.vntr.motif == nvar.vntr.motif)
+                        if (cvar.get_vntr().motif == nvar.get_vntr().motif)
                         {
                             std::string nvar_associated_indel = bcf_get_info_str(nvar.h, nvar.v, "ASSOCIATED_INDEL", "");
-                            cvar.vntr.add_associated_indel(nvar_associated_indel);
+                            cvar.get_vntr().add_associated_indel(nvar_associated_indel);
 
                             ++no_duplicate_vntrs;
                             bcf_destroy(var->v);
@@ -256,6 +257,7 @@ void VNTRExtractor::process()
     while (odr->read(v))
     {
         Variant* var = new Variant(h, v);
+        if (var->type==VT_VNTR) var->update_vntr_from_info_fields(*vntr_info_ids);
 
         if (filter_exists)
         {
@@ -287,7 +289,7 @@ void VNTRExtractor::process_exit(Variant* var)
 {
     if (var->type==VT_VNTR)
     {
-        std::string indels = var->vntr.get_associated_indels();
+        std::string indels = var->get_vntr().get_associated_indels();
         if (indels!="")
         {
             bcf_update_info_string(var->h, var->v, ASSOCIATED_INDEL.c_str(), indels.c_str());
@@ -378,8 +380,8 @@ void VNTRExtractor::create_and_insert_vntr(Variant& nvar)
     }
     
     bool insert_vntr = false;
-    VNTR& vntr = nvar.vntr;
-    nvar.update_vntr_from_info_fields();
+    VNTR& vntr = nvar.get_vntr();
+    nvar.update_vntr_from_info_fields(*vntr_info_ids);
 
 //    bcf_print(nvar.h, nvar.v);
 
@@ -549,9 +551,10 @@ void VNTRExtractor::create_and_insert_vntr(Variant& nvar)
         bcf_update_info_int32(h, nv, TRF_SCORE.c_str(), &vntr.trf_score, 1);
 
         Variant *nvntr = new Variant(h, nv);
+        nvntr->update_vntr_from_info_fields(*vntr_info_ids);
 //        bcf_print(h, nv);
         std::string indel = bcf_variant2string(nvar.h, nvar.v);
-        nvntr->vntr.add_associated_indel(indel);
+        nvntr->get_vntr().add_associated_indel(indel);
 
         insert(nvntr);
     }
@@ -113,6 +113,7 @@ class VNTRExtractor
     //tools
     ///////
     ReferenceSequence *refseq;
+    VNTRInfoIDs *vntr_info_ids;
 
     /**
      * Constructor.
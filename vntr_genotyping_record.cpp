@@ -475,8 +475,6 @@ void VNTRGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleIn
             int32_t cycle = 0;
 
             std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-            std::vector<std::string>& aug_ref = as.aug_ref;
-            std::vector<std::string>& aug_alt = as.aug_alt;
 
             int32_t vpos1 = pos1;
             int32_t cpos1 = bam_get_pos1(s);
@@ -511,7 +509,7 @@ void VNTRGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleIn
                 {
                     if (vpos1==cpos1)
                     {
-                        allele = (aug_alt[i].at(0) == v_alleles[1].at(0)) ? 1 : -1;
+                        allele = (as.get_alt_base(i, 0) == v_alleles[1].at(0)) ? 1 : -1;
                         q = qual[rpos0];
                         cycle = rpos0<(rlen>>1) ? (rpos0+1) : -(rlen - rpos0 + 1);
                         break;
@@ -573,8 +571,6 @@ void VNTRGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleIn
                 uint32_t cycle = 10;
 
                 std::vector<uint32_t>& aug_cigar = as.aug_cigar;
-                std::vector<std::string>& aug_ref = as.aug_ref;
-                std::vector<std::string>& aug_alt = as.aug_alt;
 
                 int32_t vpos1 = pos1;
 
@@ -612,14 +608,14 @@ void VNTRGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleIn
                     {
                         if (dlen>0 && cpos1-1==vpos1)
                         {
-                            if (indel==aug_alt[i])
+                            if (as.alt_equals(i, indel))
                             {
                                 q = len*30;
                                 allele = 1;
                             }
                             else
                             {
-                                q = abs(len-(int32_t)aug_ref[i].size())*30;
+                                q = abs(len-(int32_t)as.get_ref_len(i))*30;
                                 allele = -1;
                             }
 
@@ -640,14 +636,14 @@ void VNTRGenotypingRecord::process_read(AugmentedBAMRecord& as, int32_t sampleIn
                     {
                         if (dlen<0 && cpos1-1==vpos1)
                         {
-                            if (indel==aug_ref[i])
+                            if (as.ref_equals(i, indel))
                             {
                                 q = len*30;
                                 allele = 1;
                             }
                             else
                             {
-                                q = abs(len-(int32_t)aug_ref[i].size())*30;
+                                q = abs(len-(int32_t)as.get_ref_len(i))*30;
                                 allele = -1;
                             }
 
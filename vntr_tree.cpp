@@ -100,7 +100,7 @@ void VNTRTree::count(Variant& variant)
 {
     if (variant.type == VT_VNTR)
     {
-        VNTR& vntr = variant.vntr;
+        VNTR& vntr = variant.get_vntr();
 
         VNTRNode* node = NULL;
         if (motif_map.find(vntr.motif)==motif_map.end())
@@ -23,9 +23,8 @@
 
 #include "wdp_ahmm.h"
 
-#define MAXLEN 1024
-#define MAX_MOTIF_LEN 20
-#define MAXLEN_NBITS 10
+//positions and motif counts are held in the 12 bit fields of a track
+#define MAXLEN 4095
 
 #define S       0
 #define M       1
@@ -36,7 +35,7 @@
 #define NSTATES 6
 
 /*for indexing single array*/
-#define index(i,j) (((i)<<MAXLEN_NBITS)+(j))
+#define index(i,j) (((i)*stride)+(j))
 
 /**
  * Constructor.
@@ -61,16 +60,18 @@ WDP_AHMM::WDP_AHMM(LogTool *lt, bool debug)
  */
 WDP_AHMM::~WDP_AHMM()
 {
-    delete optimal_path;
+    delete[] optimal_path;
+    delete[] motif_discordance;
 
+    //matrices go back to the alignment workspace of this thread
     for (size_t state=S; state<=E; ++state)
     {
-        delete V[state];
-        delete U[state];
+        AlignmentWorkspace::release(V[state], no_rows*stride);
+        AlignmentWorkspace::release(U[state], no_rows*stride);
     }
 
-    delete V;
-    delete U;
+    delete[] V;
+    delete[] U;
 };
 
 /**
@@ -80,7 +81,6 @@ void WDP_AHMM::initialize()
 {
     initialize_structures();
     initialize_T();
-    initialize_UV();
 };
 
 /**
@@ -92,18 +92,21 @@ void WDP_AHMM::initialize_structures()
     motif = NULL;
     mlen = 0;
 
-    motif_discordance = new int32_t[MAXLEN];
-    optimal_path = new int32_t[MAXLEN<<2];
+    motif_discordance = NULL;
+    optimal_path = NULL;
+    max_path_len = 0;
     optimal_path_traced = false;
 
     typedef int32_t (WDP_AHMM::*move) (int32_t t, int32_t j);
     V = new float*[NSTATES];
     U = new int32_t*[NSTATES];
 //    moves = new move*[NSTATES];
+    no_rows = 0;
+    stride = 0;
     for (size_t state=S; state<=E; ++state)
     {
-        V[state] = new float[MAX_MOTIF_LEN*MAXLEN];
-        U[state] = new int32_t[MAX_MOTIF_LEN*MAXLEN];
+        V[state] = NULL;
+        U[state] = NULL;
     }
 };
 
@@ -143,9 +146,9 @@ void WDP_AHMM::initialize_T()
  */
 void WDP_AHMM::initialize_UV()
 {
-    for (size_t i=0; i<MAXLEN; ++i)
+    for (size_t i=0; i<no_rows; ++i)
     {
-        for (size_t j=0; j<MAXLEN; ++j)
+        for (size_t j=0; j<stride; ++j)
         {
             size_t c = index(i,j);
         }
@@ -157,6 +160,41 @@ void WDP_AHMM::initialize_UV()
     V[M][index(0,0)] = -INFINITY;
 };
 
+/**
+ * Grows the matrices to at least rows x cols cells.
+ */
+void WDP_AHMM::resize(size_t rows, size_t cols)
+{
+    if (rows<=no_rows && cols<=stride)
+    {
+        return;
+    }
+
+    for (size_t state=S; state<=E; ++state)
+    {
+        AlignmentWorkspace::release(V[state], no_rows*stride);
+        AlignmentWorkspace::release(U[state], no_rows*stride);
+    }
+
+    no_rows = std::max(rows, no_rows);
+    stride = std::max(cols, stride);
+
+    for (size_t state=S; state<=E; ++state)
+    {
+        V[state] = AlignmentWorkspace::acquire<float>(no_rows*stride);
+        U[state] = AlignmentWorkspace::acquire<int32_t>(no_rows*stride);
+    }
+
+    //a path has at most a move per row and per column, motifs are counted from 1
+    delete[] optimal_path;
+    delete[] motif_discordance;
+    max_path_len = no_rows+stride;
+    optimal_path = new int32_t[max_path_len];
+    motif_discordance = new int32_t[no_rows+1];
+
+    initialize_UV();
+}
+
 /**
  * Sets a model.
  */
@@ -283,11 +321,12 @@ void WDP_AHMM::align(const char* read, const char* qual)
     this->qual = qual;
     rlen = strlen(read);
 
-    if (rlen>=MAXLEN)
+    if (rlen>MAXLEN)
     {
-        fprintf(stderr, "[%s:%d %s] Sequence to be aligned is greater than %d currently supported, subsetting string to first 1023 characters: %d\n", __FILE__, __LINE__, __FUNCTION__, MAXLEN, rlen);
-        rlen = MAXLEN - 1;
+        fprintf(stderr, "[%s:%d %s] Sequence to be aligned is greater than %d currently supported, subsetting string to first %d characters: %d\n", __FILE__, __LINE__, __FUNCTION__, MAXLEN, MAXLEN, rlen);
+        rlen = MAXLEN;
     }
+    resize(mlen+1, rlen+1);
 //    plen = rlen;
 
 //    float max = 0;
@@ -427,7 +466,7 @@ void WDP_AHMM::trace_path()
 //    }
 //
 //    //trace path
-//    optimal_path_ptr = optimal_path+(MAXLEN<<2)-1;
+//    optimal_path_ptr = optimal_path+max_path_len-1;
 //    int32_t i = optimal_probe_len, j = rlen;
 //    int32_t last_t = make_track(optimal_state, UNMODELED, 0, 0); //dummy end track for E
 //    optimal_path_len = 0;
@@ -838,7 +877,7 @@ void WDP_AHMM::print_alignment(std::string& pad)
 //    std::cerr << "Model:  ";
 //    int32_t t = NULL_TRACK;
 //    int32_t j = 0;
-//    while (path<optimal_path+(MAXLEN<<2))
+//    while (path<optimal_path+max_path_len)
 //    {
 //        int32_t u = track_get_u(*path);
 //        if (u==M || u==D)
@@ -856,7 +895,7 @@ void WDP_AHMM::print_alignment(std::string& pad)
 //    std::cerr << "       S";
 //    path = optimal_path_ptr;
 //    j=1;
-//    while (path<optimal_path+(MAXLEN<<2))
+//    while (path<optimal_path+max_path_len)
 //    {
 //        std::cerr << track2cigarstring1(*path,j);
 //        int32_t u = track_get_u(*path);
@@ -870,7 +909,7 @@ void WDP_AHMM::print_alignment(std::string& pad)
 //
 //    path = optimal_path_ptr;
 //    std::cerr << "        ";
-//    while (path<optimal_path+(MAXLEN<<2))
+//    while (path<optimal_path+max_path_len)
 //    {
 //        std::cerr << track2cigarstring2(*path);
 //        ++path;
@@ -880,7 +919,7 @@ void WDP_AHMM::print_alignment(std::string& pad)
 //    path = optimal_path_ptr;
 //    j=1;
 //    std::cerr << "Read:   ";
-//    while (path<optimal_path+(MAXLEN<<2))
+//    while (path<optimal_path+max_path_len)
 //    {
 //        int32_t u = track_get_u(*path);
 //        if (u==M || u==I || u==Z)
@@ -1025,8 +1064,6 @@ void WDP_AHMM::print_track(int32_t t)
 }
 
 #undef MAXLEN
-#undef MAX_MOTIF_LEN
-#undef MAXLEN_NBITS
 #undef S
 #undef M
 #undef I
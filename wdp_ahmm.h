@@ -26,6 +26,7 @@
 #include "hts_utils.h"
 #include "utils.h"
 #include "log_tool.h"
+#include "align_workspace.h"
 
 #define NSTATES 6
 
@@ -90,13 +91,18 @@ class WDP_AHMM
     int32_t optimal_track;
     int32_t optimal_probe_len;
     int32_t *optimal_path;     // for storage
+    int32_t max_path_len;
     int32_t *optimal_path_ptr; //just a pointer
     int32_t optimal_path_len;
 
     float T[NSTATES][NSTATES];
 
+    //matrices of no_rows rows of stride cells from the alignment workspace,
+    //grown to the motif and read lengths of the alignments
     float **V;
     int32_t **U;
+    size_t no_rows;
+    size_t stride;
 
     LogTool *lt;
 
@@ -137,6 +143,11 @@ class WDP_AHMM
      */
     void initialize_UV();
 
+    /**
+     * Grows the matrices to at least rows x cols cells.
+     */
+    void resize(size_t rows, size_t cols);
+
     /**
      * Sets a model.
      */